@@ -147,6 +147,15 @@
  */
 - (NSArray<AWSCognitoRecord *> *)getAllRecords;
 
+/**
+ Enumerates the records in the dataset in key order, including deleted records.
+ Records are read from local storage a page at a time, so large datasets are never
+ held in memory all at once.
+ 
+ @param block called for each record, set stop to YES to end the enumeration early
+ */
+- (void)enumerateRecordsUsingBlock:(void (^)(AWSCognitoRecord *record, BOOL *stop))block;
+
 /**
  Returns all the key value pairs in the dataset, ignore any deleted data.
  
@@ -234,18 +234,44 @@
     return allRecords;
 }
 
+- (void)enumerateRecordsUsingBlock:(void (^)(AWSCognitoRecord *record, BOOL *stop))block
+{
+    NSString *lastRecordId = nil;
+    BOOL stop = NO;
+    while (!stop) {
+        NSError *error = nil;
+        NSArray<AWSCognitoRecord *> *records = [self.sqliteManager records:self.name
+                                                             afterRecordId:lastRecordId
+                                                                     limit:AWSCognitoRecordEnumerationPageSize
+                                                                     error:&error];
+        if (error) {
+            AWSDDLogDebug(@"Error: %@", error);
+        }
+        for (AWSCognitoRecord *record in records) {
+            @autoreleasepool {
+                block(record, &stop);
+            }
+            if (stop) {
+                break;
+            }
+        }
+        if (records.count < AWSCognitoRecordEnumerationPageSize) {
+            break;
+        }
+        lastRecordId = [records lastObject].recordId;
+    }
+}
+
 - (NSDictionary<NSString *, NSString *> *)getAll
 {
-    NSArray *allRecords = nil;
     NSMutableDictionary *recordsAsDictionary = [NSMutableDictionary dictionary];
     
-    allRecords = [self.sqliteManager allRecords:self.name];
-    for (AWSCognitoRecord *record in allRecords) {
+    [self enumerateRecordsUsingBlock:^(AWSCognitoRecord *record, BOOL *stop) {
         if ([record isDeleted]) {
-            continue;
+            return;
         }
         [recordsAsDictionary setObject:record.data.string forKey:record.recordId];
-    }
+    }];
     
     return recordsAsDictionary;
 }
@@ -275,13 +301,10 @@
 #pragma mark - Size operations
 
 - (long) size {
-    NSArray * allRecords = [self getAllRecords];
-    long size = 0;
-    if(allRecords != nil){
-        for (AWSCognitoRecord *record in allRecords) {
-            size += [self sizeForRecord:record];
-        }
-    }
+    __block long size = 0;
+    [self enumerateRecordsUsingBlock:^(AWSCognitoRecord *record, BOOL *stop) {
+        size += [self sizeForRecord:record];
+    }];
     return size;
 }
 
@@ -349,13 +372,6 @@
                 return task;
             }
         }else {
-            NSError *error = nil;
-            NSMutableArray *conflicts = [NSMutableArray new];
-            // collect updates to write in a transaction
-            NSMutableArray *nonConflictRecords = [NSMutableArray new];
-            NSMutableArray *existingRecords = [NSMutableArray new];
-            // keep track of record names for notificaiton
-            NSMutableArray *changedRecordNames = [NSMutableArray new];
             AWSCognitoSyncListRecordsResponse *response = task.result;
             self.syncSessionToken = response.syncSessionToken;
             
@@ -392,83 +408,141 @@
                 });
             }
             
-            if(response.records){
-                // get the dataset sync count for updating the last sync count
-                self.lastSyncCount = response.datasetSyncCount;
-                for(AWSCognitoSyncRecord *record in response.records){
-                    [existingRecords addObject:record.key];
-                    [changedRecordNames addObject:record.key];
-                    
-                    //overlay local with remote if local isn't dirty
-                    AWSCognitoRecord * existing = [self.sqliteManager getRecordById:record.key datasetName:self.name error:&error];
-                    
-                    AWSCognitoRecordValueType recordType = AWSCognitoRecordValueTypeString;
-                    if (record.value == nil) {
-                        recordType = AWSCognitoRecordValueTypeDeleted;
-                    }
-                    AWSCognitoRecord * newRecord = [[AWSCognitoRecord alloc] initWithId:record.key data:[[AWSCognitoRecordValue alloc]initWithString:record.value type:recordType]];
-                    newRecord.syncCount = [record.syncCount longLongValue];
-                    newRecord.lastModifiedBy = record.lastModifiedBy;
-                    newRecord.lastModified = record.lastModifiedDate;
-                    if(newRecord.lastModifiedBy == nil){
-                        newRecord.lastModifiedBy = @"Unknown";
-                    }
-                    
-                    // separate conflicts from non-conflicts
-                    if(!existing || existing.isDirty==NO || [existing.data.string isEqualToString:record.value]){
-                        [nonConflictRecords addObject: [[AWSCognitoRecordTuple alloc] initWithLocalRecord:existing remoteRecord:newRecord]];
-                    }
-                    else{
-                        //conflict resolution
-                        AWSDDLogInfo(@"Record %@ is dirty with value: %@ and can't be overwritten, flagging for conflict resolution",existing.recordId,existing.data.string);
-                        [conflicts addObject: [[AWSCognitoConflict alloc] initWithLocalRecord:existing remoteRecord:newRecord]];
-                    }
-                }
-                
-                NSMutableArray *resolvedConflicts = [NSMutableArray arrayWithCapacity:[conflicts count]];
-                //if there are conflicts start conflict resolution
-                if([conflicts count] > 0){
-                    if(self.conflictHandler == nil) {
-                        self.conflictHandler = [AWSCognito defaultConflictHandler];
-                    }
-                    
-                    for (AWSCognitoConflict *conflict in conflicts) {
-                        AWSCognitoResolvedConflict *resolved = self.conflictHandler(self.name,conflict);
-                        
-                        // no resolution to conflict abort synchronization
-                        if (resolved == nil) {
-                            NSError *error = [NSError errorWithDomain:AWSCognitoErrorDomain code:AWSCognitoErrorTaskCanceled userInfo:nil];
-                            [self postDidFailToSynchronizeNotification:error];
-                            return [AWSTask taskWithError:error];
-                        }
-                        
-                        [resolvedConflicts addObject:resolved];
-                    }
-                }
-                
-                if (nonConflictRecords.count > 0 || resolvedConflicts.count > 0) {
-                    // attempt to write all remote changes
-                    if([self.sqliteManager updateWithRemoteChanges:self.name nonConflicts:nonConflictRecords resolvedConflicts:resolvedConflicts error:&error]) {
-                        // successfully wrote data, notify interested parties
-                        [self postDidChangeLocalValueFromRemoteNotification:changedRecordNames];
-                    }
-                    else {
-                        [self postDidFailToSynchronizeNotification:error];
-                        return [AWSTask taskWithError:error];
-                    }
-                }
+            return [self syncPullMergePage:response request:request];
+        }
+    }];
+    
+}
+
+/**
+ * Builds the request for the page following the given one.
+ */
+- (AWSCognitoSyncListRecordsRequest *)listRecordsRequest:(AWSCognitoSyncListRecordsRequest *)request
+                                           withNextToken:(NSString *)nextToken {
+    AWSCognitoSyncListRecordsRequest *nextRequest = [AWSCognitoSyncListRecordsRequest new];
+    nextRequest.identityPoolId = request.identityPoolId;
+    nextRequest.identityId = request.identityId;
+    nextRequest.datasetName = request.datasetName;
+    nextRequest.lastSyncCount = request.lastSyncCount;
+    nextRequest.maxResults = request.maxResults;
+    nextRequest.syncSessionToken = self.syncSessionToken;
+    nextRequest.nextToken = nextToken;
+    return nextRequest;
+}
+
+/**
+ * Merges one page of list records into the local store.
+ * The next page, if any, is requested before this one is merged so the round trip
+ * overlaps the local writes. The sync count is only advanced once the last page is merged,
+ * so a sync that fails part way through starts over from the same point.
+ */
+- (AWSTask *)syncPullMergePage:(AWSCognitoSyncListRecordsResponse *)response
+                       request:(AWSCognitoSyncListRecordsRequest *)request {
+    AWSCognitoSyncListRecordsRequest *nextRequest = nil;
+    AWSTask *nextPage = nil;
+    if (response.nextToken.length > 0) {
+        nextRequest = [self listRecordsRequest:request withNextToken:response.nextToken];
+        nextPage = [self.cognitoService listRecords:nextRequest];
+    }
+    
+    NSError *error = nil;
+    NSMutableArray *conflicts = [NSMutableArray new];
+    // collect updates to write in a transaction
+    NSMutableArray *nonConflictRecords = [NSMutableArray new];
+    // keep track of record names for notificaiton
+    NSMutableArray *changedRecordNames = [NSMutableArray new];
+    
+    if(response.records){
+        // get the dataset sync count for updating the last sync count
+        self.lastSyncCount = response.datasetSyncCount;
+        NSDictionary<NSString *, AWSCognitoRecord *> *localRecords = [self.sqliteManager getRecordsByIds:[response.records valueForKey:@"key"]
+                                                                                            datasetName:self.name
+                                                                                                  error:&error];
+        for(AWSCognitoSyncRecord *record in response.records){
+            [changedRecordNames addObject:record.key];
+            
+            //overlay local with remote if local isn't dirty
+            AWSCognitoRecord * existing = localRecords[record.key];
+            
+            AWSCognitoRecordValueType recordType = AWSCognitoRecordValueTypeString;
+            if (record.value == nil) {
+                recordType = AWSCognitoRecordValueTypeDeleted;
+            }
+            AWSCognitoRecord * newRecord = [[AWSCognitoRecord alloc] initWithId:record.key data:[[AWSCognitoRecordValue alloc]initWithString:record.value type:recordType]];
+            newRecord.syncCount = [record.syncCount longLongValue];
+            newRecord.lastModifiedBy = record.lastModifiedBy;
+            newRecord.lastModified = record.lastModifiedDate;
+            if(newRecord.lastModifiedBy == nil){
+                newRecord.lastModifiedBy = @"Unknown";
+            }
+            
+            // separate conflicts from non-conflicts
+            if(!existing || existing.isDirty==NO || [existing.data.string isEqualToString:record.value]){
+                [nonConflictRecords addObject: [[AWSCognitoRecordTuple alloc] initWithLocalRecord:existing remoteRecord:newRecord]];
+            }
+            else{
+                //conflict resolution
+                AWSDDLogInfo(@"Record %@ is dirty with value: %@ and can't be overwritten, flagging for conflict resolution",existing.recordId,existing.data.string);
+                [conflicts addObject: [[AWSCognitoConflict alloc] initWithLocalRecord:existing remoteRecord:newRecord]];
+            }
+        }
+        
+        NSMutableArray *resolvedConflicts = [NSMutableArray arrayWithCapacity:[conflicts count]];
+        //if there are conflicts start conflict resolution
+        if([conflicts count] > 0){
+            if(self.conflictHandler == nil) {
+                self.conflictHandler = [AWSCognito defaultConflictHandler];
+            }
+            
+            for (AWSCognitoConflict *conflict in conflicts) {
+                AWSCognitoResolvedConflict *resolved = self.conflictHandler(self.name,conflict);
                 
-                // update our local sync count
-                if(self.currentSyncCount < self.lastSyncCount){
-                    [self.sqliteManager updateLastSyncCount:self.name syncCount:self.lastSyncCount lastModifiedBy:response.lastModifiedBy];
+                // no resolution to conflict abort synchronization
+                if (resolved == nil) {
+                    NSError *error = [NSError errorWithDomain:AWSCognitoErrorDomain code:AWSCognitoErrorTaskCanceled userInfo:nil];
+                    [self postDidFailToSynchronizeNotification:error];
+                    return [AWSTask taskWithError:error];
                 }
                 
+                [resolvedConflicts addObject:resolved];
             }
         }
         
-        return nil;
-    }];
+        if (nonConflictRecords.count > 0 || resolvedConflicts.count > 0) {
+            // attempt to write all remote changes
+            if([self.sqliteManager updateWithRemoteChanges:self.name nonConflicts:nonConflictRecords resolvedConflicts:resolvedConflicts error:&error]) {
+                // successfully wrote data, notify interested parties
+                [self postDidChangeLocalValueFromRemoteNotification:changedRecordNames];
+            }
+            else {
+                [self postDidFailToSynchronizeNotification:error];
+                return [AWSTask taskWithError:error];
+            }
+        }
+    }
+    
+    if (nextPage) {
+        return [nextPage continueWithBlock:^id(AWSTask *task) {
+            if (task.isCancelled) {
+                NSError *error = [NSError errorWithDomain:AWSCognitoErrorDomain code:AWSCognitoErrorTaskCanceled userInfo:nil];
+                [self postDidFailToSynchronizeNotification:error];
+                return [AWSTask taskWithError:error];
+            } else if (task.error) {
+                AWSDDLogError(@"Unable to list records: %@", task.error);
+                return task;
+            }
+            AWSCognitoSyncListRecordsResponse *nextResponse = task.result;
+            self.syncSessionToken = nextResponse.syncSessionToken;
+            return [self syncPullMergePage:nextResponse request:nextRequest];
+        }];
+    }
     
+    // update our local sync count
+    if(response.records && self.currentSyncCount < self.lastSyncCount){
+        [self.sqliteManager updateLastSyncCount:self.name syncCount:self.lastSyncCount lastModifiedBy:response.lastModifiedBy];
+    }
+    
+    return nil;
 }
 
 
@@ -164,6 +164,12 @@ typedef NS_ENUM(NSInteger, AWSCognitoErrorType) {
  */
 @property (nonatomic, assign) BOOL synchronizeOnWiFiOnly;
 
+/**
+ The maximum number of datasets synchronized at the same time by `synchronizeDatasets:`
+ and `synchronizeAllDatasets`. Defaults to 4 if not set.
+ */
+@property (nonatomic, assign) NSUInteger maxConcurrentDatasetSynchronizations;
+
 /**
  Returns the singleton service client. If the singleton object does not exist, the SDK instantiates the default service client with `defaultServiceConfiguration` from `[AWSServiceManager defaultServiceManager]`. The reference to this object is maintained by the SDK, and you do not need to retain it manually. Returns `nil` if the credentials provider is not an instance of `AWSCognitoCredentials` provider.
 
@@ -324,6 +330,19 @@ typedef NS_ENUM(NSInteger, AWSCognitoErrorType) {
  */
 - (AWSTask<NSArray<AWSCognitoDatasetMetadata *> *> *)refreshDatasetMetadata;
 
+/**
+ Synchronizes the given datasets, running at most `maxConcurrentDatasetSynchronizations`
+ of them at a time. The result of the task is an array of the synchronized AWSCognitoDataset
+ objects in the same order as the names. If any synchronization fails the task fails.
+ */
+- (AWSTask<NSArray<AWSCognitoDataset *> *> *)synchronizeDatasets:(NSArray<NSString *> *)datasetNames;
+
+/**
+ Refreshes the dataset metadata and synchronizes every dataset the client is aware of.
+ See `synchronizeDatasets:`.
+ */
+- (AWSTask<NSArray<AWSCognitoDataset *> *> *)synchronizeAllDatasets;
+
 /**
  Wipe all cached data.
  */
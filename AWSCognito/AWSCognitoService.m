@@ -184,6 +184,7 @@ static AWSSynchronizedMutableDictionary *_serviceClients = nil;
         _deviceId = (serviceDeviceId) == nil ? @"LOCAL" : serviceDeviceId;
         _synchronizeRetries = AWSCognitoMaxSyncRetries;
         _synchronizeOnWiFiOnly = AWSCognitoSynchronizeOnWiFiOnly;
+        _maxConcurrentDatasetSynchronizations = AWSCognitoMaxConcurrentDatasetSynchronizations;
         
         _conflictHandler = [AWSCognito defaultConflictHandler];
         _sqliteManager = [[AWSCognitoSQLiteManager alloc] initWithIdentityId:_cognitoCredentialsProvider.identityId deviceId:_deviceId];
@@ -245,6 +246,80 @@ static AWSSynchronizedMutableDictionary *_serviceClients = nil;
     }];
 }
 
+- (AWSTask<NSArray<AWSCognitoDataset *> *> *)synchronizeDatasets:(NSArray<NSString *> *)datasetNames {
+    NSMutableArray<AWSCognitoDataset *> *datasets = [NSMutableArray arrayWithCapacity:datasetNames.count];
+    for (NSString *datasetName in datasetNames) {
+        [datasets addObject:[self openOrCreateDataset:datasetName]];
+    }
+    
+    // each worker takes the next pending dataset when its current one finishes,
+    // so no more than maxConcurrentDatasetSynchronizations are in flight
+    NSMutableArray<AWSCognitoDataset *> *pending = [datasets mutableCopy];
+    NSUInteger workerCount = MIN(MAX(self.maxConcurrentDatasetSynchronizations, 1), datasets.count);
+    NSMutableArray *workers = [NSMutableArray arrayWithCapacity:workerCount];
+    for (NSUInteger i = 0; i < workerCount; i++) {
+        [workers addObject:[self synchronizeNextPendingDataset:pending errors:nil]];
+    }
+    
+    return [[AWSTask taskForCompletionOfAllTasks:workers] continueWithBlock:^id(AWSTask *task) {
+        if (task.error) {
+            return task;
+        }
+        NSMutableArray *errors = [NSMutableArray new];
+        for (AWSTask *worker in workers) {
+            if (worker.result) {
+                [errors addObjectsFromArray:worker.result];
+            }
+        }
+        if (errors.count == 1) {
+            return [AWSTask taskWithError:errors.firstObject];
+        } else if (errors.count > 1) {
+            return [AWSTask taskWithError:[NSError errorWithDomain:AWSTaskErrorDomain
+                                                              code:kAWSMultipleErrorsError
+                                                          userInfo:@{AWSTaskMultipleErrorsUserInfoKey : errors}]];
+        }
+        return [AWSTask taskWithResult:datasets];
+    }];
+}
+
+/**
+ * Synchronizes pending datasets one after another until none are left.
+ * A failed dataset doesn't stop the worker; its error is collected in the result.
+ */
+- (AWSTask *)synchronizeNextPendingDataset:(NSMutableArray<AWSCognitoDataset *> *)pending errors:(NSArray<NSError *> *)errors {
+    AWSCognitoDataset *dataset = nil;
+    @synchronized(pending) {
+        dataset = pending.firstObject;
+        if (dataset) {
+            [pending removeObjectAtIndex:0];
+        }
+    }
+    if (!dataset) {
+        return [AWSTask taskWithResult:errors];
+    }
+    
+    return [[dataset synchronize] continueWithBlock:^id(AWSTask *task) {
+        NSArray<NSError *> *workerErrors = errors;
+        if (task.isCancelled) {
+            NSError *error = [NSError errorWithDomain:AWSCognitoErrorDomain code:AWSCognitoErrorTaskCanceled userInfo:nil];
+            workerErrors = errors ? [errors arrayByAddingObject:error] : @[error];
+        } else if (task.error) {
+            workerErrors = errors ? [errors arrayByAddingObject:task.error] : @[task.error];
+        }
+        return [self synchronizeNextPendingDataset:pending errors:workerErrors];
+    }];
+}
+
+- (AWSTask<NSArray<AWSCognitoDataset *> *> *)synchronizeAllDatasets {
+    return [[self refreshDatasetMetadata] continueWithSuccessBlock:^id(AWSTask *task) {
+        NSMutableArray *datasetNames = [NSMutableArray new];
+        for (AWSCognitoDatasetMetadata *dataset in [self listDatasets]) {
+            [datasetNames addObject:dataset.name];
+        }
+        return [self synchronizeDatasets:datasetNames];
+    }];
+}
+
 - (NSArray<AWSCognitoDatasetMetadata *> *)listDatasets {
     return [self.sqliteManager getDatasets:nil];
 }
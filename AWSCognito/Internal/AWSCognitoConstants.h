@@ -23,6 +23,7 @@ FOUNDATION_EXPORT NSString *const AWSCognitoDatasetCreationDateFieldName;
 FOUNDATION_EXPORT NSString *const AWSCognitoDirtyFieldName;
 FOUNDATION_EXPORT NSString *const AWSCognitoSyncCountFieldName;
 FOUNDATION_EXPORT NSString *const AWSCognitoDefaultSqliteMetadataTableName;
+FOUNDATION_EXPORT NSString *const AWSCognitoDefaultSqliteDirtyRecordIndexName;
 FOUNDATION_EXPORT NSString *const AWSCognitoDatasetFieldName;
 FOUNDATION_EXPORT NSString *const AWSCognitoLastSyncCount;
 
@@ -32,12 +33,14 @@ FOUNDATION_EXPORT NSString *const AWSCognitoUserDefaultsUserAgentPrefix;
 
 FOUNDATION_EXPORT uint32_t const AWSCognitoMaxSyncRetries;
 FOUNDATION_EXPORT BOOL const AWSCognitoSynchronizeOnWiFiOnly;
+FOUNDATION_EXPORT NSUInteger const AWSCognitoMaxConcurrentDatasetSynchronizations;
 
 FOUNDATION_EXPORT uint32_t const AWSCognitoMaxDatasetSize;
 FOUNDATION_EXPORT uint32_t const AWSCognitoMinKeySize;
 FOUNDATION_EXPORT uint32_t const AWSCognitoMaxKeySize;
 FOUNDATION_EXPORT uint32_t const AWSCognitoMaxRecordValueSize;
 FOUNDATION_EXPORT uint32_t const AWSCognitoMaxNumRecords;
+FOUNDATION_EXPORT NSUInteger const AWSCognitoRecordEnumerationPageSize;
 
 FOUNDATION_EXPORT NSString *const AWSCognitoSyncPushApns;
 FOUNDATION_EXPORT NSString *const AWSCognitoSyncPushApnsSandbox;
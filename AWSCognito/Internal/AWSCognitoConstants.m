@@ -24,6 +24,7 @@ NSString *const AWSCognitoDirtyFieldName = @"Dirty";
 NSString *const AWSCognitoDatasetFieldName = @"Dataset";
 NSString *const AWSCognitoSyncCountFieldName = @"SyncCount";
 NSString *const AWSCognitoDefaultSqliteMetadataTableName = @"CognitoMetadata";
+NSString *const AWSCognitoDefaultSqliteDirtyRecordIndexName = @"CognitoDirtyData";
 NSString *const AWSCognitoLastSyncCount = @"LastSyncCount";
 int64_t const AWSCognitoNotSyncedDeletedRecordDirty = -1;
 NSString* const AWSCognitoDeletedRecord = @"\0";
@@ -34,12 +35,14 @@ NSString *const AWSCognitoSyncPushApnsSandbox = @"APNS_SANDBOX";
 
 uint32_t const AWSCognitoMaxSyncRetries = 5;
 BOOL const AWSCognitoSynchronizeOnWiFiOnly = NO;
+NSUInteger const AWSCognitoMaxConcurrentDatasetSynchronizations = 4;
 
 uint32_t const AWSCognitoMaxDatasetSize = 1024*1024;
 uint32_t const AWSCognitoMinKeySize = 1;
 uint32_t const AWSCognitoMaxKeySize = 128;
 uint32_t const AWSCognitoMaxRecordValueSize = AWSCognitoMaxDatasetSize-1;
 uint32_t const AWSCognitoMaxNumRecords = 1024;
+NSUInteger const AWSCognitoRecordEnumerationPageSize = 256;
 
 
 #pragma mark - Standard error messages
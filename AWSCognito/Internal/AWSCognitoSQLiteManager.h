@@ -26,6 +26,7 @@
 - (BOOL)putDatasetMetadata:(NSArray *)datasets error:(NSError **)error;
 - (BOOL)updateDatasetMetadata:(AWSCognitoDatasetMetadata *)dataset error:(NSError **)error;
 - (AWSCognitoRecord *)getRecordById:(NSString *)recordId datasetName:(NSString *)datasetName error:(NSError **)error;
+- (NSDictionary<NSString *, AWSCognitoRecord *> *)getRecordsByIds:(NSArray<NSString *> *)recordIds datasetName:(NSString *)datasetName error:(NSError **)error;
 - (BOOL)putRecord:(AWSCognitoRecord *)record datasetName:(NSString *)datasetName  error:(NSError **)error;
 - (BOOL)flagRecordAsDeletedById:(NSString *)recordId datasetName:(NSString *)datasetName  error:(NSError **)error;
 - (BOOL)deleteRecordById:(NSString *)recordId datasetName:(NSString *)datasetName error:(NSError **)error;
@@ -41,6 +42,7 @@
 - (BOOL)reparentDatasets:(NSString *)oldId withNewId:(NSString *)newId error:(NSError **)error;
 
 - (NSArray<AWSCognitoRecord *> *)allRecords:(NSString *)datasetName;
+- (NSArray<AWSCognitoRecord *> *)records:(NSString *)datasetName afterRecordId:(NSString *)recordId limit:(NSUInteger)limit error:(NSError **)error;
 - (NSDictionary *)recordsUpdatedAfterLastSync:(NSString *)datasetName error:(NSError **)error;
 
 - (NSNumber *)lastSyncCount:(NSString *)datasetName;
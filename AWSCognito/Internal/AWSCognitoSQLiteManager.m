@@ -18,11 +18,109 @@
 #import "AWSCognitoConflict_Internal.h"
 #import "AWSCognitoSyncService.h"
 
+// Number of read-only connections kept alongside the writer connection.
+static NSUInteger const AWSCognitoSQLiteReaderConnectionCount = 4;
+// How long a connection waits on a lock held by another connection before failing with SQLITE_BUSY.
+static int const AWSCognitoSQLiteBusyTimeoutMillis = 5000;
+
+/**
+ * A SQLite connection and the statements prepared on it. A connection is used by one thread at a time.
+ **/
+@interface AWSCognitoSQLiteConnection : NSObject
+
+@property (nonatomic, assign, readonly) sqlite3 *sqlite;
+@property (nonatomic, assign, readonly) NSUInteger generation;
+
+- (instancetype)initWithPath:(NSString *)path queryOnly:(BOOL)queryOnly generation:(NSUInteger)generation;
+- (sqlite3_stmt *)cachedStatement:(NSString *)sqlString;
+- (void)finalizeCachedStatements;
+- (void)close;
+
+@end
+
+@interface AWSCognitoSQLiteConnection()
+
+// Prepared statements keyed by their SQL, reused across calls.
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSValue *> *cachedStatements;
+
+@end
+
+@implementation AWSCognitoSQLiteConnection
+
+- (instancetype)initWithPath:(NSString *)path queryOnly:(BOOL)queryOnly generation:(NSUInteger)generation {
+    if (self = [super init]) {
+        _cachedStatements = [NSMutableDictionary new];
+        _generation = generation;
+        
+        if(sqlite3_open([path UTF8String], &_sqlite) != SQLITE_OK)
+        {
+            sqlite3_close(_sqlite);
+            _sqlite = NULL;
+            AWSDDLogInfo(@"SQLite setup failed.");
+            return nil;
+        }
+        
+        sqlite3_busy_timeout(_sqlite, AWSCognitoSQLiteBusyTimeoutMillis);
+        if (queryOnly) {
+            sqlite3_exec(_sqlite, "PRAGMA query_only = 1", NULL, NULL, NULL);
+        } else {
+            // WAL lets the reader connections keep reading while this connection writes. The mode is persistent.
+            if (sqlite3_exec(_sqlite, "PRAGMA journal_mode = WAL", NULL, NULL, NULL) != SQLITE_OK) {
+                AWSDDLogInfo(@"Unable to enable WAL: %s", sqlite3_errmsg(_sqlite));
+            }
+            sqlite3_exec(_sqlite, "PRAGMA synchronous = NORMAL", NULL, NULL, NULL);
+        }
+    }
+    return self;
+}
+
+/**
+ * Returns the prepared statement for the SQL, preparing and caching it on first use. The statement keeps the bindings
+ * of its previous use, so callers bind every parameter, and must be reset once the caller is done stepping it.
+ **/
+- (sqlite3_stmt *)cachedStatement:(NSString *)sqlString {
+    NSValue *cachedStatement = self.cachedStatements[sqlString];
+    if (cachedStatement) {
+        return [cachedStatement pointerValue];
+    }
+    
+    sqlite3_stmt *statement = NULL;
+    if(sqlite3_prepare_v2(self.sqlite, [sqlString UTF8String], -1, &statement, NULL) != SQLITE_OK) {
+        sqlite3_finalize(statement);
+        return NULL;
+    }
+    self.cachedStatements[sqlString] = [NSValue valueWithPointer:statement];
+    return statement;
+}
+
+- (void)finalizeCachedStatements {
+    for (NSValue *cachedStatement in [self.cachedStatements allValues]) {
+        sqlite3_finalize([cachedStatement pointerValue]);
+    }
+    [self.cachedStatements removeAllObjects];
+}
+
+- (void)close {
+    [self finalizeCachedStatements];
+    sqlite3_close(_sqlite);
+    _sqlite = NULL;
+}
+
+@end
+
 @interface AWSCognitoSQLiteManager()
 {
 }
 
-@property (nonatomic, assign) sqlite3 *sqlite;
+// The connection all writes go through. Only used on the dispatch queue.
+@property (nonatomic, strong) AWSCognitoSQLiteConnection *writer;
+@property (nonatomic, readonly) sqlite3 *sqlite;
+
+// Idle read-only connections, and the number that may be checked out at once.
+@property (nonatomic, strong) NSMutableArray<AWSCognitoSQLiteConnection *> *readers;
+@property (nonatomic, strong) dispatch_semaphore_t readerSlots;
+// Bumped when the database file is deleted so connections to the old file are not reused.
+@property (nonatomic, assign) NSUInteger readerGeneration;
 
 // iOS 6 and later, dispatch_queue_t is an Objective-C object.
 #if OS_OBJECT_USE_OBJC
@@ -44,6 +142,8 @@
         _identityId = identityId;
         _deviceId = deviceId;
         _dispatchQueue = dispatch_queue_create("com.amazon.cognito.SerialDispatchQueue", DISPATCH_QUEUE_SERIAL);
+        _readers = [NSMutableArray new];
+        _readerSlots = dispatch_semaphore_create(AWSCognitoSQLiteReaderConnectionCount);
 
         [self setupSQL];
         [self initializeTables];
@@ -52,16 +152,56 @@
     return self;
 }
 
+- (void)dealloc {
+    // Closing the last connection to the database checkpoints the WAL into it and removes the -wal file.
+    [self.writer close];
+    for (AWSCognitoSQLiteConnection *reader in self.readers) {
+        [reader close];
+    }
+}
+
 - (void)setupSQL {
+    self.writer = [[AWSCognitoSQLiteConnection alloc] initWithPath:[self filePath] queryOnly:NO generation:0];
+}
+
+- (sqlite3 *)sqlite {
+    return self.writer.sqlite;
+}
+
+/**
+ * Runs a read on one of the pooled read-only connections, so reads don't queue behind writes on the dispatch queue.
+ * Falls back to the writer connection if a reader can't be opened.
+ **/
+- (void)performRead:(void (^)(AWSCognitoSQLiteConnection *connection))read {
+    dispatch_semaphore_wait(self.readerSlots, DISPATCH_TIME_FOREVER);
     
+    AWSCognitoSQLiteConnection *reader = nil;
+    NSUInteger generation = 0;
+    @synchronized(self.readers) {
+        reader = [self.readers lastObject];
+        [self.readers removeLastObject];
+        generation = self.readerGeneration;
+    }
+    if (!reader) {
+        reader = [[AWSCognitoSQLiteConnection alloc] initWithPath:[self filePath] queryOnly:YES generation:generation];
+    }
     
-    if(sqlite3_open([[self filePath] UTF8String], &_sqlite) != SQLITE_OK)
-    {
-        sqlite3_close(_sqlite);
-        AWSDDLogInfo(@"SQLite setup failed.");
-
-        return;
+    if (reader) {
+        read(reader);
+        @synchronized(self.readers) {
+            if (reader.generation == self.readerGeneration) {
+                [self.readers addObject:reader];
+                reader = nil;
+            }
+        }
+        [reader close];
+    } else {
+        dispatch_sync(self.dispatchQueue, ^{
+            read(self.writer);
+        });
     }
+    
+    dispatch_semaphore_signal(self.readerSlots);
 }
 
 - (void)deleteAllData {
@@ -133,9 +273,9 @@
                                   AWSCognitoTableRecordKeyName];
         
         char *error;
-        if(sqlite3_exec(self->_sqlite, [createString UTF8String], NULL, NULL, &error) != SQLITE_OK)
+        if(sqlite3_exec(self.sqlite, [createString UTF8String], NULL, NULL, &error) != SQLITE_OK)
         {
-            sqlite3_close(self->_sqlite);
+            sqlite3_close(self.sqlite);
             AWSDDLogInfo(@"SQLite setup failed: %s", error);
             
             return;
@@ -162,14 +302,29 @@
                                    AWSCognitoRecordCountFieldName,
                                    AWSCognitoTableIdentityKeyName,
                                    AWSCognitoTableDatasetKeyName ];
-        if(sqlite3_exec(self->_sqlite, [createString2 UTF8String], NULL, NULL, &error) != SQLITE_OK)
+        if(sqlite3_exec(self.sqlite, [createString2 UTF8String], NULL, NULL, &error) != SQLITE_OK)
         {
-            sqlite3_close(self->_sqlite);
+            sqlite3_close(self.sqlite);
             AWSDDLogInfo(@"SQLite setup failed: %s", error);
             
             return;
         }
         
+        // Partial index over only the dirty rows. SQLite keeps it up to date on every write,
+        // so the push phase finds local changes without scanning the whole dataset.
+        NSString *createIndexString = [NSString stringWithFormat:@"CREATE INDEX IF NOT EXISTS %@ ON %@(%@,%@) WHERE %@ != 0",
+                                       AWSCognitoDefaultSqliteDirtyRecordIndexName,
+                                       AWSCognitoDefaultSqliteDataTableName,
+                                       AWSCognitoTableIdentityKeyName,
+                                       AWSCognitoTableDatasetKeyName,
+                                       AWSCognitoDirtyFieldName];
+        if(sqlite3_exec(self.sqlite, [createIndexString UTF8String], NULL, NULL, &error) != SQLITE_OK)
+        {
+            // not fatal, recordsUpdatedAfterLastSync falls back to scanning the dataset
+            AWSDDLogInfo(@"Unable to create dirty record index: %s", error);
+            sqlite3_free(error);
+        }
+        
     });
 }
 
@@ -221,7 +376,7 @@
 - (NSArray<AWSCognitoDatasetMetadata *> *)getDatasets:(NSError * __autoreleasing *)error {
     __block NSMutableArray<AWSCognitoDatasetMetadata *> *datasets = [NSMutableArray array];
     
-    dispatch_sync(self.dispatchQueue, ^{
+    [self performRead:^(AWSCognitoSQLiteConnection *connection) {
         NSString *query = [NSString stringWithFormat:@"SELECT %@, %@, %@, %@, %@, %@, %@ FROM %@ WHERE %@ = ?",
                            AWSCognitoTableDatasetKeyName,
                            AWSCognitoLastSyncCount,
@@ -236,7 +391,7 @@
         AWSDDLogDebug(@"query = '%@'", query);
         
         sqlite3_stmt *statement;
-        if(sqlite3_prepare_v2(self.sqlite, [query UTF8String], -1, &statement, NULL) == SQLITE_OK)
+        if(sqlite3_prepare_v2(connection.sqlite, [query UTF8String], -1, &statement, NULL) == SQLITE_OK)
         {
             NSString * identityId = [self identityId];
             
@@ -266,23 +421,23 @@
         }
         else
         {
-            AWSDDLogInfo(@"Error creating query statement: %s", sqlite3_errmsg(self.sqlite));
+            AWSDDLogInfo(@"Error creating query statement: %s", sqlite3_errmsg(connection.sqlite));
             if(error != nil)
             {
-                *error = [AWSCognitoUtil errorLocalDataStorageFailed:[NSString stringWithFormat:@"%s", sqlite3_errmsg(self.sqlite)]];
+                *error = [AWSCognitoUtil errorLocalDataStorageFailed:[NSString stringWithFormat:@"%s", sqlite3_errmsg(connection.sqlite)]];
             }
         }
         
         sqlite3_reset(statement);
         sqlite3_finalize(statement);
-    });
+    }];
     
     return datasets;
 }
 
 - (BOOL)loadDatasetMetadata:(AWSCognitoDatasetMetadata *)metadata error:(NSError * __autoreleasing *)error {
     __block BOOL success = YES;
-    dispatch_sync(self.dispatchQueue, ^{
+    [self performRead:^(AWSCognitoSQLiteConnection *connection) {
         NSString *query = [NSString stringWithFormat:@"SELECT %@, %@, %@, %@, %@, %@ FROM %@ WHERE %@ = ? and %@ = ?",
                            AWSCognitoLastSyncCount,
                            AWSCognitoLastModifiedFieldName,
@@ -297,7 +452,7 @@
         AWSDDLogDebug(@"query = '%@'", query);
         
         sqlite3_stmt *statement;
-        if(sqlite3_prepare_v2(self.sqlite, [query UTF8String], -1, &statement, NULL) == SQLITE_OK)
+        if(sqlite3_prepare_v2(connection.sqlite, [query UTF8String], -1, &statement, NULL) == SQLITE_OK)
         {
             sqlite3_bind_text(statement, 1, [self.identityId UTF8String], -1, SQLITE_TRANSIENT);
             sqlite3_bind_text(statement, 2, [metadata.name UTF8String], -1, SQLITE_TRANSIENT);
@@ -321,17 +476,17 @@
         }
         else
         {
-            AWSDDLogInfo(@"Error creating query statement: %s", sqlite3_errmsg(self.sqlite));
+            AWSDDLogInfo(@"Error creating query statement: %s", sqlite3_errmsg(connection.sqlite));
             if(error != nil)
             {
-                *error = [AWSCognitoUtil errorLocalDataStorageFailed:[NSString stringWithFormat:@"%s", sqlite3_errmsg(self.sqlite)]];
+                *error = [AWSCognitoUtil errorLocalDataStorageFailed:[NSString stringWithFormat:@"%s", sqlite3_errmsg(connection.sqlite)]];
             }
             success = NO;
         }
         
         sqlite3_reset(statement);
         sqlite3_finalize(statement);
-    });
+    }];
     return success;
 }
 
@@ -437,24 +592,13 @@
 
 - (AWSCognitoRecord *)getRecordById_internal:(NSString *)recordId datasetName:(NSString *)datasetName error:(NSError * __autoreleasing *)error sync:(BOOL) sync{
     __block AWSCognitoRecord *record = nil;
-    void (^getRecord)(void) = ^{
-        NSString *query = [NSString stringWithFormat:@"SELECT %@, %@, %@, %@, %@, %@ FROM %@ WHERE %@ = ? AND %@ = ? AND %@ = ?",
-                           AWSCognitoLastModifiedFieldName,
-                           AWSCognitoModifiedByFieldName,
-                           AWSCognitoRecordValueName,
-                           AWSCognitoTypeFieldName,
-                           AWSCognitoSyncCountFieldName,
-                           AWSCognitoDirtyFieldName,
-                           AWSCognitoDefaultSqliteDataTableName,
-                           AWSCognitoTableRecordKeyName,
-                           AWSCognitoTableIdentityKeyName,
-                           AWSCognitoTableDatasetKeyName
-                           ];
+    void (^getRecord)(AWSCognitoSQLiteConnection *) = ^(AWSCognitoSQLiteConnection *connection) {
+        NSString *query = [AWSCognitoSQLiteManager selectRecordSQL];
         
         AWSDDLogDebug(@"query = '%@'", query);
         
-        sqlite3_stmt *statement;
-        if(sqlite3_prepare_v2(self.sqlite, [query UTF8String], -1, &statement, NULL) == SQLITE_OK)
+        sqlite3_stmt *statement = [connection cachedStatement:query];
+        if(statement != NULL)
         {
             sqlite3_bind_text(statement, 1, [recordId UTF8String], -1, SQLITE_TRANSIENT);
             
@@ -465,40 +609,25 @@
             
             if (sqlite3_step(statement) == SQLITE_ROW)
             {
-                int64_t lastMod = sqlite3_column_int64(statement, 0);
-                char *modByChars = (char *) sqlite3_column_text(statement, 1);
-                char *dataChars = (char *)sqlite3_column_text(statement, 2);
-                int64_t type = sqlite3_column_int64(statement, 3);
-                int64_t syncCount = sqlite3_column_int64(statement, 4);
-                int64_t dirtyInt = sqlite3_column_int64(statement, 5);
-                
-                NSString *modBy = [[NSString alloc] initWithUTF8String:modByChars];
-                NSString *data = [[NSString alloc] initWithUTF8String:dataChars];
-                
-                record = [[AWSCognitoRecord alloc] initWithId:recordId
-                                                         data:[[AWSCognitoRecordValue alloc]initWithJson:data type:(int)type]];
-                record.lastModifiedBy = modBy;
-                record.lastModified = [AWSCognitoUtil millisSinceEpochToDate:[NSNumber numberWithLongLong:lastMod]];
-                record.dirtyCount = dirtyInt;
-                record.syncCount = syncCount;
+                record = [self recordFromStatement:statement recordId:recordId];
             }
         }
         else
         {
-            AWSDDLogInfo(@"Error creating query statement: %s", sqlite3_errmsg(self.sqlite));
+            AWSDDLogInfo(@"Error creating query statement: %s", sqlite3_errmsg(connection.sqlite));
             if(error != nil)
             {
-                *error = [AWSCognitoUtil errorLocalDataStorageFailed:[NSString stringWithFormat:@"%s", sqlite3_errmsg(self.sqlite)]];
+                *error = [AWSCognitoUtil errorLocalDataStorageFailed:[NSString stringWithFormat:@"%s", sqlite3_errmsg(connection.sqlite)]];
             }
         }
         
-        sqlite3_reset(statement);
-        sqlite3_finalize(statement);
+        [self resetStatement:statement];
     };
     if(sync){
-        dispatch_sync(self.dispatchQueue, getRecord);
+        [self performRead:getRecord];
     }else{
-        getRecord();
+        // already on the dispatch queue, likely inside a write transaction
+        getRecord(self.writer);
     }
     
     return record;
@@ -508,6 +637,58 @@
     return [self getRecordById_internal:recordId datasetName:datasetName error:error sync:YES];
 }
 
+- (NSDictionary<NSString *, AWSCognitoRecord *> *)getRecordsByIds:(NSArray<NSString *> *)recordIds datasetName:(NSString *)datasetName error:(NSError * __autoreleasing *)error {
+    NSMutableDictionary<NSString *, AWSCognitoRecord *> *records = [NSMutableDictionary dictionaryWithCapacity:[recordIds count]];
+    [self performRead:^(AWSCognitoSQLiteConnection *connection) {
+        sqlite3_stmt *statement = [connection cachedStatement:[AWSCognitoSQLiteManager selectRecordSQL]];
+        if(statement == NULL)
+        {
+            AWSDDLogInfo(@"Error creating query statement: %s", sqlite3_errmsg(connection.sqlite));
+            if(error != nil)
+            {
+                *error = [AWSCognitoUtil errorLocalDataStorageFailed:[NSString stringWithFormat:@"%s", sqlite3_errmsg(connection.sqlite)]];
+            }
+            return;
+        }
+        
+        // The identity and dataset bindings stay in place across resets, only the record id changes per row.
+        sqlite3_bind_text(statement, 2, [[self identityId] UTF8String], -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(statement, 3, [datasetName UTF8String], -1, SQLITE_TRANSIENT);
+        for(NSString *recordId in recordIds)
+        {
+            sqlite3_bind_text(statement, 1, [recordId UTF8String], -1, SQLITE_TRANSIENT);
+            if (sqlite3_step(statement) == SQLITE_ROW)
+            {
+                records[recordId] = [self recordFromStatement:statement recordId:recordId];
+            }
+            sqlite3_reset(statement);
+        }
+        [self resetStatement:statement];
+    }];
+    
+    return records;
+}
+
+- (AWSCognitoRecord *)recordFromStatement:(sqlite3_stmt *)statement recordId:(NSString *)recordId {
+    int64_t lastMod = sqlite3_column_int64(statement, 0);
+    char *modByChars = (char *) sqlite3_column_text(statement, 1);
+    char *dataChars = (char *)sqlite3_column_text(statement, 2);
+    int64_t type = sqlite3_column_int64(statement, 3);
+    int64_t syncCount = sqlite3_column_int64(statement, 4);
+    int64_t dirtyInt = sqlite3_column_int64(statement, 5);
+    
+    NSString *modBy = [[NSString alloc] initWithUTF8String:modByChars];
+    NSString *data = [[NSString alloc] initWithUTF8String:dataChars];
+    
+    AWSCognitoRecord *record = [[AWSCognitoRecord alloc] initWithId:recordId
+                                                               data:[[AWSCognitoRecordValue alloc]initWithJson:data type:(int)type]];
+    record.lastModifiedBy = modBy;
+    record.lastModified = [AWSCognitoUtil millisSinceEpochToDate:[NSNumber numberWithLongLong:lastMod]];
+    record.dirtyCount = dirtyInt;
+    record.syncCount = syncCount;
+    return record;
+}
+
 - (NSString *) identityId {
     if(_identityId == nil) {
         _identityId = AWSCognitoUnknownIdentity;
@@ -519,24 +700,15 @@
 {
     __block NSMutableDictionary *newRecords = [NSMutableDictionary new];
 
-    dispatch_sync(self.dispatchQueue, ^{
-        NSString *query = [NSString stringWithFormat:@"SELECT %@, %@, %@, %@, %@, %@, %@ FROM %@ WHERE %@ != 0 AND %@ = ? AND %@ = ?",
-                           AWSCognitoTableRecordKeyName,
-                           AWSCognitoLastModifiedFieldName,
-                           AWSCognitoModifiedByFieldName,
-                           AWSCognitoRecordValueName,
-                           AWSCognitoTypeFieldName,
-                           AWSCognitoSyncCountFieldName,
-                           AWSCognitoDirtyFieldName,
-                           AWSCognitoDefaultSqliteDataTableName,
-                           AWSCognitoDirtyFieldName,
-                           AWSCognitoTableIdentityKeyName,
-                           AWSCognitoTableDatasetKeyName];
-
-        sqlite3_stmt *statement;
-        
+    [self performRead:^(AWSCognitoSQLiteConnection *connection) {
+        sqlite3_stmt *statement = [connection cachedStatement:[AWSCognitoSQLiteManager selectDirtyRecordsSQL:YES]];
+        if(statement == NULL)
+        {
+            // the dirty record index is missing, likely an SQLite without partial index support
+            statement = [connection cachedStatement:[AWSCognitoSQLiteManager selectDirtyRecordsSQL:NO]];
+        }
         
-        if(sqlite3_prepare_v2(self.sqlite, [query UTF8String], -1, &statement, NULL) == SQLITE_OK)
+        if(statement != NULL)
         {
             NSString * identityId = [self identityId];
             sqlite3_bind_text(statement, 1, [identityId UTF8String], -1, SQLITE_TRANSIENT);
@@ -544,46 +716,66 @@
       
             while (sqlite3_step(statement) == SQLITE_ROW)
             {
-                char *recordIDChars = (char *) sqlite3_column_text(statement, 0);
-                int64_t lastMod = sqlite3_column_int64(statement, 1);
-                char *modByChars = (char *) sqlite3_column_text(statement, 2);
-                char *dataChars = (char *)sqlite3_column_text(statement, 3);
-                int64_t type = sqlite3_column_int64(statement, 4);
-                int64_t syncCount = sqlite3_column_int64(statement, 5);
-                int64_t dirtyInt = sqlite3_column_int64(statement, 6);
-                
-                NSString *recordId = [[NSString alloc] initWithUTF8String:recordIDChars];
-                NSString *modBy = [[NSString alloc] initWithUTF8String:modByChars];
-                NSString *data = [[NSString alloc] initWithUTF8String:dataChars];
-
-                AWSCognitoRecord *record = [[AWSCognitoRecord alloc] initWithId:recordId
-                                                          data:[[AWSCognitoRecordValue alloc] initWithJson:data type:(int)type]];
-                record.lastModifiedBy = modBy;
-                record.lastModified = [AWSCognitoUtil millisSinceEpochToDate:[NSNumber numberWithLongLong:lastMod]];
-                record.dirtyCount = dirtyInt;
-                record.syncCount = syncCount;
-
-                [newRecords setObject:record forKey:record.recordId];
+                NSString *recordId = [[NSString alloc] initWithUTF8String:(char *) sqlite3_column_text(statement, 6)];
+                [newRecords setObject:[self recordFromStatement:statement recordId:recordId] forKey:recordId];
             }
         }
         else
         {
-            AWSDDLogInfo(@"Error creating query statement: %s", sqlite3_errmsg(self.sqlite));
+            AWSDDLogInfo(@"Error creating query statement: %s", sqlite3_errmsg(connection.sqlite));
             if(error != nil)
             {
-                *error = [AWSCognitoUtil errorLocalDataStorageFailed:[NSString stringWithFormat:@"%s", sqlite3_errmsg(self.sqlite)]];
+                *error = [AWSCognitoUtil errorLocalDataStorageFailed:[NSString stringWithFormat:@"%s", sqlite3_errmsg(connection.sqlite)]];
             }
         }
-    });
+        
+        [self resetStatement:statement];
+    }];
 
     return [NSDictionary dictionaryWithDictionary:newRecords];
 }
 
+- (NSArray<AWSCognitoRecord *> *)records:(NSString *)datasetName
+                           afterRecordId:(NSString *)recordId
+                                   limit:(NSUInteger)limit
+                                   error:(NSError * __autoreleasing *)error
+{
+    NSMutableArray<AWSCognitoRecord *> *records = [NSMutableArray arrayWithCapacity:limit];
+
+    [self performRead:^(AWSCognitoSQLiteConnection *connection) {
+        sqlite3_stmt *statement = [connection cachedStatement:[AWSCognitoSQLiteManager selectRecordPageSQL]];
+        if(statement == NULL)
+        {
+            AWSDDLogInfo(@"Error creating query statement: %s", sqlite3_errmsg(connection.sqlite));
+            if(error != nil)
+            {
+                *error = [AWSCognitoUtil errorLocalDataStorageFailed:[NSString stringWithFormat:@"%s", sqlite3_errmsg(connection.sqlite)]];
+            }
+            return;
+        }
+        
+        sqlite3_bind_text(statement, 1, [[self identityId] UTF8String], -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(statement, 2, [datasetName UTF8String], -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(statement, 3, [(recordId ?: @"") UTF8String], -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(statement, 4, limit);
+        
+        while (sqlite3_step(statement) == SQLITE_ROW)
+        {
+            NSString *pageRecordId = [[NSString alloc] initWithUTF8String:(char *) sqlite3_column_text(statement, 6)];
+            [records addObject:[self recordFromStatement:statement recordId:pageRecordId]];
+        }
+        
+        [self resetStatement:statement];
+    }];
+
+    return records;
+}
+
 - (NSArray<AWSCognitoRecord *> *)allRecords:(NSString*)datasetName
 {
     __block NSMutableArray *allRecords = nil;
 
-    dispatch_sync(self.dispatchQueue, ^{
+    [self performRead:^(AWSCognitoSQLiteConnection *connection) {
 
         NSString *query = [NSString stringWithFormat:@"SELECT %@, %@, %@, %@, %@, %@, %@ FROM %@ WHERE %@ = ? AND %@ = ?",
                            AWSCognitoTableRecordKeyName,
@@ -600,7 +792,7 @@
         AWSCognitoRecord *record = nil;
 
         sqlite3_stmt *statement;
-        if(sqlite3_prepare_v2(self.sqlite, [query UTF8String], -1, &statement, NULL) == SQLITE_OK)
+        if(sqlite3_prepare_v2(connection.sqlite, [query UTF8String], -1, &statement, NULL) == SQLITE_OK)
         {
             NSString * identityId = [self identityId];
             sqlite3_bind_text(statement, 1, [identityId UTF8String], -1, SQLITE_TRANSIENT);
@@ -638,12 +830,12 @@
         }
         else
         {
-            AWSDDLogInfo(@"Error creating query statement: %s", sqlite3_errmsg(self.sqlite));
+            AWSDDLogInfo(@"Error creating query statement: %s", sqlite3_errmsg(connection.sqlite));
         }
 
         sqlite3_reset(statement);
         sqlite3_finalize(statement);
-    });
+    }];
 
     return allRecords;
 }
@@ -747,7 +939,203 @@
     return result;
 }
 
+#pragma mark - Cached statements
+
++ (NSString *)selectRecordSQL {
+    static NSString *sqlString = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sqlString = [NSString stringWithFormat:@"SELECT %@, %@, %@, %@, %@, %@ FROM %@ WHERE %@ = ? AND %@ = ? AND %@ = ?",
+                     AWSCognitoLastModifiedFieldName,
+                     AWSCognitoModifiedByFieldName,
+                     AWSCognitoRecordValueName,
+                     AWSCognitoTypeFieldName,
+                     AWSCognitoSyncCountFieldName,
+                     AWSCognitoDirtyFieldName,
+                     AWSCognitoDefaultSqliteDataTableName,
+                     AWSCognitoTableRecordKeyName,
+                     AWSCognitoTableIdentityKeyName,
+                     AWSCognitoTableDatasetKeyName];
+    });
+    return sqlString;
+}
+
+/**
+ * Selects the records in a dataset with local changes. The columns match selectRecordSQL, followed by the record id.
+ * When indexed is YES the query is forced onto the partial dirty record index.
+ **/
++ (NSString *)selectDirtyRecordsSQL:(BOOL)indexed {
+    static NSString *indexedSqlString = nil;
+    static NSString *sqlString = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSString *format = @"SELECT %@, %@, %@, %@, %@, %@, %@ FROM %@%@ WHERE %@ = ? AND %@ = ? AND %@ != 0";
+        NSString *(^build)(NSString *) = ^NSString *(NSString *indexClause) {
+            return [NSString stringWithFormat:format,
+                    AWSCognitoLastModifiedFieldName,
+                    AWSCognitoModifiedByFieldName,
+                    AWSCognitoRecordValueName,
+                    AWSCognitoTypeFieldName,
+                    AWSCognitoSyncCountFieldName,
+                    AWSCognitoDirtyFieldName,
+                    AWSCognitoTableRecordKeyName,
+                    AWSCognitoDefaultSqliteDataTableName,
+                    indexClause,
+                    AWSCognitoTableIdentityKeyName,
+                    AWSCognitoTableDatasetKeyName,
+                    AWSCognitoDirtyFieldName];
+        };
+        indexedSqlString = build([NSString stringWithFormat:@" INDEXED BY %@", AWSCognitoDefaultSqliteDirtyRecordIndexName]);
+        sqlString = build(@"");
+    });
+    return indexed ? indexedSqlString : sqlString;
+}
+
+/**
+ * Selects up to a limit of records with ids after the given one, in id order, walking the primary key.
+ * The columns match selectRecordSQL, followed by the record id.
+ **/
++ (NSString *)selectRecordPageSQL {
+    static NSString *sqlString = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sqlString = [NSString stringWithFormat:@"SELECT %@, %@, %@, %@, %@, %@, %@ FROM %@ WHERE %@ = ? AND %@ = ? AND %@ > ? ORDER BY %@ LIMIT ?",
+                     AWSCognitoLastModifiedFieldName,
+                     AWSCognitoModifiedByFieldName,
+                     AWSCognitoRecordValueName,
+                     AWSCognitoTypeFieldName,
+                     AWSCognitoSyncCountFieldName,
+                     AWSCognitoDirtyFieldName,
+                     AWSCognitoTableRecordKeyName,
+                     AWSCognitoDefaultSqliteDataTableName,
+                     AWSCognitoTableIdentityKeyName,
+                     AWSCognitoTableDatasetKeyName,
+                     AWSCognitoTableRecordKeyName,
+                     AWSCognitoTableRecordKeyName];
+    });
+    return sqlString;
+}
+
+/**
+ * Updates a record only if it still matches the state it was read in, so a local write made since then is not lost.
+ **/
++ (NSString *)conditionalUpdateRecordSQL {
+    static NSString *sqlString = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sqlString = [NSString stringWithFormat:
+                     @"UPDATE %@ SET \
+                     %@ = ?, \
+                     %@ = ?, \
+                     %@ = ?, \
+                     %@ = ?, \
+                     %@ = ?, \
+                     %@ = ? \
+                     WHERE %@ = ? \
+                     AND %@ = ? \
+                     AND %@ = ? \
+                     AND %@ = ? \
+                     AND %@ = ? \
+                     AND %@ = ? \
+                     AND %@ = ? \
+                     AND %@ = ? \
+                     ",
+                     
+                     AWSCognitoDefaultSqliteDataTableName,
+                     AWSCognitoLastModifiedFieldName,
+                     AWSCognitoModifiedByFieldName,
+                     AWSCognitoRecordValueName,
+                     AWSCognitoTypeFieldName,
+                     AWSCognitoSyncCountFieldName,
+                     AWSCognitoDirtyFieldName,
+                     
+                     AWSCognitoTableRecordKeyName,
+                     AWSCognitoLastModifiedFieldName,
+                     AWSCognitoModifiedByFieldName,
+                     AWSCognitoRecordValueName,
+                     AWSCognitoSyncCountFieldName,
+                     AWSCognitoDirtyFieldName,
+                     AWSCognitoTableIdentityKeyName,
+                     AWSCognitoTableDatasetKeyName];
+    });
+    return sqlString;
+}
+
++ (NSString *)insertRemoteRecordSQL {
+    static NSString *sqlString = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sqlString = [NSString stringWithFormat:
+                     @"INSERT INTO %@ ( \
+                     %@, \
+                     %@, \
+                     %@, \
+                     %@, \
+                     %@, \
+                     %@, \
+                     %@, \
+                     %@, \
+                     %@ \
+                     ) VALUES ( \
+                     ?, \
+                     ?, \
+                     ?, \
+                     ?, \
+                     ?, \
+                     ?, \
+                     ?, \
+                     ?, \
+                     ? \
+                     )",
+                     
+                     AWSCognitoDefaultSqliteDataTableName,
+                     
+                     AWSCognitoTableRecordKeyName,
+                     AWSCognitoLastModifiedFieldName,
+                     AWSCognitoModifiedByFieldName,
+                     AWSCognitoRecordValueName,
+                     AWSCognitoTypeFieldName,
+                     AWSCognitoSyncCountFieldName,
+                     AWSCognitoTableIdentityKeyName,
+                     AWSCognitoTableDatasetKeyName,
+                     AWSCognitoDirtyFieldName];
+    });
+    return sqlString;
+}
+
+/**
+ * Returns the writer's cached statement for the SQL. Must be called on the dispatch queue and handed back with
+ * resetStatement: once the caller is done stepping it.
+ **/
+- (sqlite3_stmt *)cachedStatement:(NSString *)sqlString {
+    return [self.writer cachedStatement:sqlString];
+}
+
+/**
+ * Resets a cached statement so it releases its locks and can be reused
+ **/
+- (void)resetStatement:(sqlite3_stmt *) statement {
+    sqlite3_reset(statement);
+}
+
+#pragma mark -
+
 - (BOOL)conditionallyPutRecord:(AWSCognitoRecord *)record datasetName:(NSString*)datasetName withCurrentState:(AWSCognitoRecord *)currentState error:(NSError **)error {
+    const char *datasetNameChars = [datasetName UTF8String];
+    const char *identityIdChars = [[self identityId] UTF8String];
+    
+    return [self conditionallyPutRecord:record
+                       withCurrentState:currentState
+                       datasetNameChars:datasetNameChars
+                        identityIdChars:identityIdChars
+                                  error:error];
+}
+
+- (BOOL)conditionallyPutRecord:(AWSCognitoRecord *)record
+              withCurrentState:(AWSCognitoRecord *)currentState
+              datasetNameChars:(const char *)datasetNameChars
+               identityIdChars:(const char *)identityIdChars
+                         error:(NSError **)error {
     sqlite3_stmt *statement;
     
     const char *recordID = [record.recordId UTF8String];
@@ -755,50 +1143,13 @@
     int64_t lastModified = [AWSCognitoUtil getTimeMillisForDate:record.lastModified];
     const char *modifiedBy = [record.lastModifiedBy UTF8String];
     const char *data = [[record.data toJsonString] UTF8String];
-    const char *datasetNameChars = [datasetName UTF8String];
-    const char *identityIdChars = [[self identityId] UTF8String];
     
     if(currentState) { // Updates the local data with the new data from the remote.
         int64_t currentLastModified = [AWSCognitoUtil getTimeMillisForDate:currentState.lastModified];
         const char *currentModifiedBy = [currentState.lastModifiedBy UTF8String];
         const char *currentData = [[currentState.data toJsonString] UTF8String];
         
-        NSString *sqlString = [NSString stringWithFormat:
-                               @"UPDATE %@ SET \
-                               %@ = ?, \
-                               %@ = ?, \
-                               %@ = ?, \
-                               %@ = ?, \
-                               %@ = ?, \
-                               %@ = ? \
-                               WHERE %@ = ? \
-                               AND %@ = ? \
-                               AND %@ = ? \
-                               AND %@ = ? \
-                               AND %@ = ? \
-                               AND %@ = ? \
-                               AND %@ = ? \
-                               AND %@ = ? \
-                               ",
-                               
-                               AWSCognitoDefaultSqliteDataTableName,
-                               AWSCognitoLastModifiedFieldName,
-                               AWSCognitoModifiedByFieldName,
-                               AWSCognitoRecordValueName,
-                               AWSCognitoTypeFieldName,
-                               AWSCognitoSyncCountFieldName,
-                               AWSCognitoDirtyFieldName,
-                               
-                               AWSCognitoTableRecordKeyName,
-                               AWSCognitoLastModifiedFieldName,
-                               AWSCognitoModifiedByFieldName,
-                               AWSCognitoRecordValueName,
-                               AWSCognitoSyncCountFieldName,
-                               AWSCognitoDirtyFieldName,
-                               AWSCognitoTableIdentityKeyName,
-                               AWSCognitoTableDatasetKeyName];
-        
-        if(sqlite3_prepare_v2(self.sqlite, [sqlString UTF8String], -1, &statement, NULL) == SQLITE_OK) {
+        if((statement = [self cachedStatement:[AWSCognitoSQLiteManager conditionalUpdateRecordSQL]]) != NULL) {
             sqlite3_bind_int64(statement, 1, lastModified);
             
             sqlite3_bind_text(statement, 2, modifiedBy, -1, SQLITE_TRANSIENT);
@@ -842,47 +1193,11 @@
             if(error != nil) {
                 *error = [AWSCognitoUtil errorLocalDataStorageFailed:[NSString stringWithFormat:@"%s", sqlite3_errmsg(self.sqlite)]];
             }
-            [self resetStatement:statement];
             return NO;
         }
     }
     else { // Inserts the new data from the remote.
-        NSString *sqlString = [NSString stringWithFormat:
-                               @"INSERT INTO %@ ( \
-                               %@, \
-                               %@, \
-                               %@, \
-                               %@, \
-                               %@, \
-                               %@, \
-                               %@, \
-                               %@, \
-                               %@ \
-                               ) VALUES ( \
-                               ?, \
-                               ?, \
-                               ?, \
-                               ?, \
-                               ?, \
-                               ?, \
-                               ?, \
-                               ?, \
-                               ? \
-                               )",
-                               
-                               AWSCognitoDefaultSqliteDataTableName,
-                               
-                               AWSCognitoTableRecordKeyName,
-                               AWSCognitoLastModifiedFieldName,
-                               AWSCognitoModifiedByFieldName,
-                               AWSCognitoRecordValueName,
-                               AWSCognitoTypeFieldName,
-                               AWSCognitoSyncCountFieldName,
-                               AWSCognitoTableIdentityKeyName,
-                               AWSCognitoTableDatasetKeyName,
-                               AWSCognitoDirtyFieldName];
-        
-        if(sqlite3_prepare_v2(self.sqlite, [sqlString UTF8String], -1, &statement, NULL) == SQLITE_OK) {
+        if((statement = [self cachedStatement:[AWSCognitoSQLiteManager insertRemoteRecordSQL]]) != NULL) {
             sqlite3_bind_text(statement, 1, recordID, -1, SQLITE_TRANSIENT);
             sqlite3_bind_int64(statement, 2, lastModified);
             sqlite3_bind_text(statement, 3, modifiedBy, -1, SQLITE_TRANSIENT);
@@ -908,7 +1223,6 @@
             if(error != nil) {
                 *error = [AWSCognitoUtil errorLocalDataStorageFailed:[NSString stringWithFormat:@"%s", sqlite3_errmsg(self.sqlite)]];
             }
-            [self resetStatement:statement];
             return NO;
         }
     }
@@ -918,68 +1232,56 @@
 }
 
 /**
- * Resets and finalizes a statement
+ * Compare-and-swap upserts a batch of remote records against the local state each was read in. Runs inside the
+ * caller's transaction and stops at the first record that fails.
  **/
-- (void)resetStatement:(sqlite3_stmt *) statement {
-    sqlite3_reset(statement);
-    sqlite3_finalize(statement);
+- (BOOL)conditionallyPutRecords:(NSArray *)recordTuples datasetName:(NSString*)datasetName error:(NSError **)error {
+    const char *datasetNameChars = [datasetName UTF8String];
+    const char *identityIdChars = [[self identityId] UTF8String];
+    
+    for (AWSCognitoRecordTuple *tuple in recordTuples) {
+        @autoreleasepool {
+            if (![self conditionallyPutRecord:tuple.remoteRecord
+                             withCurrentState:tuple.localRecord
+                             datasetNameChars:datasetNameChars
+                              identityIdChars:identityIdChars
+                                        error:error]) {
+                return NO;
+            }
+        }
+    }
+    return YES;
 }
 
 - (BOOL)conditionallyPutResolvedRecords:(NSArray *) resolvedRecords datasetName:(NSString*)datasetName error:(NSError **)error {
-    sqlite3_stmt *statement = nil;
-    NSString *sqlString = [NSString stringWithFormat:
-                           @"UPDATE %@ SET \
-                           %@ = ?, \
-                           %@ = ?, \
-                           %@ = ?, \
-                           %@ = ?, \
-                           %@ = ?, \
-                           %@ = ? \
-                           WHERE %@ = ? \
-                           AND %@ = ? \
-                           AND %@ = ? \
-                           AND %@ = ? \
-                           AND %@ = ? \
-                           AND %@ = ? \
-                           AND %@ = ? \
-                           AND %@ = ? \
-                           ",
-                           
-                           AWSCognitoDefaultSqliteDataTableName,
-                           AWSCognitoLastModifiedFieldName,
-                           AWSCognitoModifiedByFieldName,
-                           AWSCognitoRecordValueName,
-                           AWSCognitoTypeFieldName,
-                           AWSCognitoSyncCountFieldName,
-                           AWSCognitoDirtyFieldName,
-                           
-                           AWSCognitoTableRecordKeyName,
-                           AWSCognitoLastModifiedFieldName,
-                           AWSCognitoModifiedByFieldName,
-                           AWSCognitoRecordValueName,
-                           AWSCognitoSyncCountFieldName,
-                           AWSCognitoDirtyFieldName,
-                           AWSCognitoTableIdentityKeyName,
-                           AWSCognitoTableDatasetKeyName];
+    if ([resolvedRecords count] == 0) {
+        return YES;
+    }
+    
+    sqlite3_stmt *statement = [self cachedStatement:[AWSCognitoSQLiteManager conditionalUpdateRecordSQL]];
+    if (statement == NULL) {
+        return YES;
+    }
+    
+    const char *datasetNameChars = [datasetName UTF8String];
+    const char *identityIdChars = [[self identityId] UTF8String];
+    sqlite3_bind_text(statement, 13, identityIdChars, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(statement, 14, datasetNameChars, -1, SQLITE_TRANSIENT);
     
     for(AWSCognitoResolvedConflict *resolved in resolvedRecords){
-        AWSCognitoRecord * currentState = resolved.conflict.localRecord;
-        AWSCognitoRecord * record = resolved.resolvedConflict;
-        const char *recordID = [record.recordId UTF8String];
-        
-        int64_t lastModified = [AWSCognitoUtil getTimeMillisForDate:record.lastModified];
-        const char *modifiedBy = [record.lastModifiedBy UTF8String];
-        const char *data = [[record.data toJsonString] UTF8String];
-        const char *datasetNameChars = [datasetName UTF8String];
-        const char *identityIdChars = [[self identityId] UTF8String];
-        
-        
-        int64_t currentLastModified = [AWSCognitoUtil getTimeMillisForDate:currentState.lastModified];
-        const char *currentModifiedBy = [currentState.lastModifiedBy UTF8String];
-        const char *currentData = [[currentState.data toJsonString] UTF8String];
-        
-        if(sqlite3_prepare_v2(self.sqlite, [sqlString UTF8String], -1, &statement, NULL) == SQLITE_OK)
-        {
+        @autoreleasepool {
+            AWSCognitoRecord * currentState = resolved.conflict.localRecord;
+            AWSCognitoRecord * record = resolved.resolvedConflict;
+            const char *recordID = [record.recordId UTF8String];
+            
+            int64_t lastModified = [AWSCognitoUtil getTimeMillisForDate:record.lastModified];
+            const char *modifiedBy = [record.lastModifiedBy UTF8String];
+            const char *data = [[record.data toJsonString] UTF8String];
+            
+            int64_t currentLastModified = [AWSCognitoUtil getTimeMillisForDate:currentState.lastModified];
+            const char *currentModifiedBy = [currentState.lastModifiedBy UTF8String];
+            const char *currentData = [[currentState.data toJsonString] UTF8String];
+            
             sqlite3_bind_int64(statement, 1, lastModified);
             
             sqlite3_bind_text(statement, 2, modifiedBy, -1, SQLITE_TRANSIENT);
@@ -994,8 +1296,6 @@
             sqlite3_bind_text(statement, 10, currentData, -1, SQLITE_TRANSIENT);
             sqlite3_bind_int64(statement, 11, currentState.syncCount);
             sqlite3_bind_int64(statement, 12, currentState.dirtyCount);
-            sqlite3_bind_text(statement, 13, identityIdChars, -1, SQLITE_TRANSIENT);
-            sqlite3_bind_text(statement, 14, datasetNameChars, -1, SQLITE_TRANSIENT);
             
             if(SQLITE_DONE != sqlite3_step(statement)){
                 AWSDDLogInfo(@"Error while updating data: %s", sqlite3_errmsg(self.sqlite));
@@ -1006,11 +1306,10 @@
                 [self resetStatement:statement];
                 return NO;
             }
+            
+            sqlite3_reset(statement);
         }
-        
-        sqlite3_reset(statement);
     }
-    sqlite3_finalize(statement);
     return YES;
 }
 
@@ -1148,12 +1447,7 @@
         sqlite3_exec(self.sqlite, "BEGIN EXCLUSIVE TRANSACTION", 0, 0, 0);
         
         // put the non-conflicts
-        for (AWSCognitoRecordTuple *tuple in nonConflictRecords) {
-            if (![self conditionallyPutRecord:tuple.remoteRecord datasetName:datasetName withCurrentState:tuple.localRecord error:error]) {
-                result = NO;
-                break;
-            }
-        }
+        result = [self conditionallyPutRecords:nonConflictRecords datasetName:datasetName error:error];
         
         // put the conflicts if non-conflicts wrote
         if (result) {
@@ -1228,7 +1522,7 @@
 {
     __block int64_t numRecords = 0;
     
-    dispatch_sync(self.dispatchQueue, ^{
+    [self performRead:^(AWSCognitoSQLiteConnection *connection) {
         NSString *query = [NSString stringWithFormat:@"SELECT COUNT(*) FROM %@ WHERE %@=? AND %@ = ?",
                            AWSCognitoDefaultSqliteDataTableName,
                            AWSCognitoTableDatasetKeyName,
@@ -1236,7 +1530,7 @@
         
         sqlite3_stmt *statement;
         
-        if(sqlite3_prepare_v2(self.sqlite, [query UTF8String], -1, &statement, NULL) == SQLITE_OK)
+        if(sqlite3_prepare_v2(connection.sqlite, [query UTF8String], -1, &statement, NULL) == SQLITE_OK)
         {
             sqlite3_bind_text(statement, 1, [datasetName UTF8String], -1, SQLITE_TRANSIENT);
             sqlite3_bind_text(statement, 2, [[self identityId] UTF8String], -1, SQLITE_TRANSIENT);
@@ -1248,12 +1542,12 @@
         }
         else
         {
-            AWSDDLogInfo(@"Error creating num records count statement: %s", sqlite3_errmsg(self.sqlite));
+            AWSDDLogInfo(@"Error creating num records count statement: %s", sqlite3_errmsg(connection.sqlite));
         }
         
         sqlite3_reset(statement);
         sqlite3_finalize(statement);
-    });
+    }];
     
     return [NSNumber numberWithLongLong:numRecords];
 }
@@ -1265,7 +1559,7 @@
 {
     __block int64_t lastSyncCount = 0;
 
-    dispatch_sync(self.dispatchQueue, ^{
+    [self performRead:^(AWSCognitoSQLiteConnection *connection) {
         NSString *query = [NSString stringWithFormat:@"SELECT %@ FROM %@ WHERE %@=? AND %@ = ?",
                            AWSCognitoLastSyncCount,
                            AWSCognitoDefaultSqliteMetadataTableName,
@@ -1274,7 +1568,7 @@
 
         sqlite3_stmt *statement;
 
-        if(sqlite3_prepare_v2(self.sqlite, [query UTF8String], -1, &statement, NULL) == SQLITE_OK)
+        if(sqlite3_prepare_v2(connection.sqlite, [query UTF8String], -1, &statement, NULL) == SQLITE_OK)
         {
             sqlite3_bind_text(statement, 1, [datasetName UTF8String], -1, SQLITE_TRANSIENT);
             sqlite3_bind_text(statement, 2, [[self identityId] UTF8String], -1, SQLITE_TRANSIENT);
@@ -1286,12 +1580,12 @@
         }
         else
         {
-            AWSDDLogInfo(@"Error creating query sync count statement: %s", sqlite3_errmsg(self.sqlite));
+            AWSDDLogInfo(@"Error creating query sync count statement: %s", sqlite3_errmsg(connection.sqlite));
         }
 
         sqlite3_reset(statement);
         sqlite3_finalize(statement);
-    });
+    }];
 
     return [NSNumber numberWithLongLong:lastSyncCount];
 }
@@ -1759,12 +2053,25 @@
 - (void)deleteSQLiteDatabase
 {
     dispatch_sync(self.dispatchQueue, ^{
-        if([[NSFileManager defaultManager] fileExistsAtPath:[self filePath]])
-        {
-            NSError *error;
-            [[NSFileManager defaultManager] removeItemAtPath:[self filePath] error:&error];
-            if (error) {
-                AWSDDLogDebug(@"Error deleting DB file %@", error);
+        [self.writer close];
+        self.writer = nil;
+        @synchronized(self.readers) {
+            for (AWSCognitoSQLiteConnection *reader in self.readers) {
+                [reader close];
+            }
+            [self.readers removeAllObjects];
+            self.readerGeneration++;
+        }
+        
+        NSString *filePath = [self filePath];
+        for (NSString *path in @[filePath, [filePath stringByAppendingString:@"-wal"], [filePath stringByAppendingString:@"-shm"]]) {
+            if([[NSFileManager defaultManager] fileExistsAtPath:path])
+            {
+                NSError *error;
+                [[NSFileManager defaultManager] removeItemAtPath:path error:&error];
+                if (error) {
+                    AWSDDLogDebug(@"Error deleting DB file %@", error);
+                }
             }
         }
     });
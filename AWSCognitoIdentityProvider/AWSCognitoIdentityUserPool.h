@@ -60,6 +60,15 @@ NS_ASSUME_NONNULL_BEGIN
 
 + (void)removeCognitoIdentityUserPoolForKey:(NSString *)key;
 
+/**
+ The number of SRP key pairs generated ahead of sign in on a background queue, so the first
+ authentication request doesn't wait on the key generation. Each pair is used for one sign in only.
+ Set to 0 to generate key pairs on demand. Defaults to 2.
+ */
++ (NSUInteger)srpKeyPoolSize;
+
++ (void)setSrpKeyPoolSize:(NSUInteger)srpKeyPoolSize;
+
 /**
  Sign up a new user
  */
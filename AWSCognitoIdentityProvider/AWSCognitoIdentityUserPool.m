@@ -12,6 +12,7 @@
 #import <CommonCrypto/CommonHMAC.h>
 #import "NSData+AWSCognitoIdentityProvider.h"
 #import "AWSCognitoIdentityProviderModel.h"
+#import "AWSCognitoIdentityProviderSrpKeyPool.h"
 #import <AWSCognitoIdentityProviderASF/AWSCognitoIdentityProviderASF.h>
 
 static const NSString * AWSCognitoIdentityUserPoolCurrentUser = @"currentUser";
@@ -128,6 +129,16 @@ static NSString *const AWSPinpointContextKeychainUniqueIdKey = @"com.amazonaws.A
     [_serviceClients removeObjectForKey:key];
 }
 
++ (NSUInteger)srpKeyPoolSize {
+    return [AWSCognitoIdentityProviderSrpKeyPool sharedPool].size;
+}
+
++ (void)setSrpKeyPoolSize:(NSUInteger)srpKeyPoolSize {
+    AWSCognitoIdentityProviderSrpKeyPool *keyPool = [AWSCognitoIdentityProviderSrpKeyPool sharedPool];
+    keyPool.size = srpKeyPoolSize;
+    [keyPool refill];
+}
+
 - (instancetype)init {
     @throw [NSException exceptionWithName:NSInternalInconsistencyException
                                    reason:@"`- init` is not a valid initializer. Use `+ defaultCognitoIdentityProvider` or `+ CognitoIdentityProviderForKey:` instead."
@@ -156,6 +167,9 @@ static NSString *const AWSPinpointContextKeychainUniqueIdKey = @"com.amazonaws.A
         _userPoolConfiguration = userPoolConfiguration;
 
         _keychain = [AWSUICKeyChainStore keyChainStoreWithService:[NSString stringWithFormat:@"%@.%@", [NSBundle mainBundle].bundleIdentifier, [AWSCognitoIdentityUserPool class]]];
+
+        // a sign in usually follows, so start generating SRP key pairs now
+        [[AWSCognitoIdentityProviderSrpKeyPool sharedPool] refill];
         
         
         //If Pinpoint is setup, get the endpoint or create one.
@@ -0,0 +1,489 @@
+//
+// Copyright 2014-2016 Amazon.com,
+// Inc. or its affiliates. All Rights Reserved.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "AWSCognitoIdentityProviderSrpCore.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <CommonCrypto/CommonHMAC.h>
+
+#pragma mark - Fixed base exponentiation
+
+/*
+ * g and N are fixed for the Cognito group, so g^e mod N uses a comb table built once.
+ * The exponent is laid out as AWS_SRP_COMB_TEETH rows of AWS_SRP_COMB_SPACING bits. Entry j of
+ * the table holds the product of g^(2^(i*spacing)) for every bit i set in j, in Montgomery form,
+ * so each column of the exponent costs one squaring and one multiplication.
+ *
+ * The exponent is secret, so the comb doesn't use the LibTomMath arithmetic, whose running time
+ * depends on the digits in use. Values are kept as exactly table->digits digits and multiplied
+ * with a fixed-width Montgomery multiplication whose final subtraction is applied under a mask,
+ * and entries are read with a scan of the whole table. Every exponent in range then runs the same
+ * instructions on the same addresses; only the number of digits X occupies is read unmasked.
+ */
+#define AWS_SRP_COMB_TEETH 6
+#define AWS_SRP_COMB_ENTRIES (1 << AWS_SRP_COMB_TEETH)
+#define AWS_SRP_COMB_MAX_EXPONENT_BITS 256
+#define AWS_SRP_COMB_SPACING ((AWS_SRP_COMB_MAX_EXPONENT_BITS + AWS_SRP_COMB_TEETH - 1) / AWS_SRP_COMB_TEETH)
+#define AWS_SRP_COMB_EXPONENT_BITS (AWS_SRP_COMB_TEETH * AWS_SRP_COMB_SPACING)
+#define AWS_SRP_COMB_EXPONENT_DIGITS ((AWS_SRP_COMB_EXPONENT_BITS + AWS_DIGIT_BIT - 1) / AWS_DIGIT_BIT)
+#define AWS_SRP_COMB_MAX_DIGITS ((AWS_SRP_MAX_VALUE_BYTES * 8 + AWS_DIGIT_BIT - 1) / AWS_DIGIT_BIT)
+
+// out = a * b / R mod N for a, b < N, with R = 2^(AWS_DIGIT_BIT * digits). out may alias a or b.
+static void awsSrpCombMultiply(AWSSrpCombTable *table, aws_mp_digit *out, const aws_mp_digit *a, const aws_mp_digit *b) {
+    const int n = table->digits;
+    const aws_mp_digit *N = table->N.dp;
+    aws_mp_digit t[AWS_SRP_COMB_MAX_DIGITS + 2];
+    aws_mp_digit difference[AWS_SRP_COMB_MAX_DIGITS + 1];
+    aws_mp_word carry;
+
+    memset(t, 0, sizeof(aws_mp_digit) * (n + 2));
+    for (int i = 0; i < n; i++) {
+        // t += a[i] * b
+        carry = 0;
+        for (int j = 0; j < n; j++) {
+            carry += (aws_mp_word)t[j] + (aws_mp_word)a[i] * b[j];
+            t[j] = (aws_mp_digit)(carry & AWS_MP_MASK);
+            carry >>= AWS_DIGIT_BIT;
+        }
+        carry += t[n];
+        t[n] = (aws_mp_digit)(carry & AWS_MP_MASK);
+        t[n + 1] = (aws_mp_digit)(carry >> AWS_DIGIT_BIT);
+
+        // t = (t + m * N) / 2^AWS_DIGIT_BIT, with m chosen to clear the low digit
+        aws_mp_digit m = (aws_mp_digit)((t[0] * table->rho) & AWS_MP_MASK);
+        carry = ((aws_mp_word)t[0] + (aws_mp_word)m * N[0]) >> AWS_DIGIT_BIT;
+        for (int j = 1; j < n; j++) {
+            carry += (aws_mp_word)t[j] + (aws_mp_word)m * N[j];
+            t[j - 1] = (aws_mp_digit)(carry & AWS_MP_MASK);
+            carry >>= AWS_DIGIT_BIT;
+        }
+        carry += t[n];
+        t[n - 1] = (aws_mp_digit)(carry & AWS_MP_MASK);
+        t[n] = t[n + 1] + (aws_mp_digit)(carry >> AWS_DIGIT_BIT);
+    }
+
+    // t < 2N: subtract N and keep the difference unless it borrowed
+    aws_mp_digit borrow = 0;
+    for (int j = 0; j < n; j++) {
+        aws_mp_digit digit = t[j] - N[j] - borrow;
+        borrow = digit >> (CHAR_BIT * sizeof(aws_mp_digit) - 1);
+        difference[j] = digit & AWS_MP_MASK;
+    }
+    borrow = (t[n] - borrow) >> (CHAR_BIT * sizeof(aws_mp_digit) - 1);
+    aws_mp_digit keep = (aws_mp_digit)0 - borrow;
+    for (int j = 0; j < n; j++) {
+        out[j] = (t[j] & keep) | (difference[j] & ~keep);
+    }
+    memset(t, 0, sizeof(t));
+    memset(difference, 0, sizeof(difference));
+}
+
+static aws_mp_digit *awsSrpCombEntry(AWSSrpCombTable *table, int index) {
+    return table->entries + (index * table->digits);
+}
+
+// Reads every entry and keeps the one at index under a mask, so the memory access pattern is the same for any index.
+static void awsSrpCombSelect(AWSSrpCombTable *table, unsigned int index, aws_mp_digit *value) {
+    memset(value, 0, sizeof(aws_mp_digit) * table->digits);
+    for (unsigned int j = 0; j < AWS_SRP_COMB_ENTRIES; j++) {
+        aws_mp_digit mask = (aws_mp_digit)0 - (aws_mp_digit)((((j ^ index) - 1) >> 31) & 1);
+        aws_mp_digit *entry = awsSrpCombEntry(table, j);
+        for (int k = 0; k < table->digits; k++) {
+            value[k] |= entry[k] & mask;
+        }
+    }
+}
+
+// Copies value, which is less than N, into a fixed-width buffer of table->digits digits.
+static void awsSrpCombLoad(AWSSrpCombTable *table, aws_mp_int *value, aws_mp_digit *digits) {
+    memset(digits, 0, sizeof(aws_mp_digit) * table->digits);
+    memcpy(digits, value->dp, sizeof(aws_mp_digit) * value->used);
+}
+
+void awsSrpCombTableClear(AWSSrpCombTable *table) {
+    aws_mp_clear_multi(&table->N, &table->g, NULL);
+    free(table->entries);
+    table->entries = NULL;
+}
+
+int awsSrpCombTableInit(AWSSrpCombTable *table, aws_mp_int *N, aws_mp_int *g) {
+    aws_mp_digit power[AWS_SRP_COMB_MAX_DIGITS];
+    aws_mp_int R, base, montgomeryBase;
+    int res;
+
+    memset(table, 0, sizeof(AWSSrpCombTable));
+    if (N->sign == AWS_MP_NEG || N->used > AWS_SRP_COMB_MAX_DIGITS) {
+        return AWS_MP_VAL;
+    }
+    if ((res = aws_mp_init_copy(&table->N, N)) != AWS_MP_OKAY) {
+        return res;
+    }
+    if ((res = aws_mp_init_copy(&table->g, g)) != AWS_MP_OKAY) {
+        aws_mp_clear(&table->N);
+        return res;
+    }
+    if ((res = aws_mp_init_multi(&R, &base, &montgomeryBase, NULL)) != AWS_MP_OKAY) {
+        awsSrpCombTableClear(table);
+        return res;
+    }
+
+    table->digits = N->used;
+    table->entries = calloc((size_t)AWS_SRP_COMB_ENTRIES * table->digits, sizeof(aws_mp_digit));
+    if (table->entries == NULL) {
+        res = AWS_MP_MEM;
+        goto cleanup;
+    }
+    if ((res = aws_mp_montgomery_setup(N, &table->rho)) != AWS_MP_OKAY) {
+        goto cleanup;
+    }
+    // R mod N is 1 in Montgomery form
+    if ((res = aws_mp_montgomery_calc_normalization(&R, N)) != AWS_MP_OKAY) {
+        goto cleanup;
+    }
+    awsSrpCombLoad(table, &R, awsSrpCombEntry(table, 0));
+
+    // g and N are public, so the table is built with the LibTomMath arithmetic
+    if ((res = aws_mp_mod(g, N, &base)) != AWS_MP_OKAY) {
+        goto cleanup;
+    }
+    for (int i = 0; i < AWS_SRP_COMB_TEETH; i++) {
+        // power = g^(2^(i*spacing)) in Montgomery form
+        if ((res = aws_mp_mulmod(&base, &R, N, &montgomeryBase)) != AWS_MP_OKAY) {
+            goto cleanup;
+        }
+        awsSrpCombLoad(table, &montgomeryBase, power);
+        for (int j = 0; j < (1 << i); j++) {
+            awsSrpCombMultiply(table, awsSrpCombEntry(table, (1 << i) + j), awsSrpCombEntry(table, j), power);
+        }
+        for (int k = 0; k < AWS_SRP_COMB_SPACING; k++) {
+            if ((res = aws_mp_sqrmod(&base, N, &base)) != AWS_MP_OKAY) {
+                goto cleanup;
+            }
+        }
+    }
+
+cleanup:
+    aws_mp_clear_multi(&R, &base, &montgomeryBase, NULL);
+    if (res != AWS_MP_OKAY) {
+        awsSrpCombTableClear(table);
+    }
+    return res;
+}
+
+// Y = g^X mod N for 0 <= X < 2^AWS_SRP_COMB_EXPONENT_BITS
+int awsSrpCombExptmod(AWSSrpCombTable *table, aws_mp_int *X, aws_mp_int *Y) {
+    aws_mp_digit exponent[AWS_SRP_COMB_EXPONENT_DIGITS];
+    aws_mp_digit acc[AWS_SRP_COMB_MAX_DIGITS];
+    aws_mp_digit entry[AWS_SRP_COMB_MAX_DIGITS];
+    const int n = table->digits;
+    int res;
+
+    if (X->sign == AWS_MP_NEG || X->used > AWS_SRP_COMB_EXPONENT_DIGITS) {
+        return AWS_MP_VAL;
+    }
+    memset(exponent, 0, sizeof(exponent));
+    memcpy(exponent, X->dp, sizeof(aws_mp_digit) * X->used);
+    if ((exponent[AWS_SRP_COMB_EXPONENT_DIGITS - 1] >> (AWS_SRP_COMB_EXPONENT_BITS - (AWS_SRP_COMB_EXPONENT_DIGITS - 1) * AWS_DIGIT_BIT)) != 0) {
+        memset(exponent, 0, sizeof(exponent));
+        return AWS_MP_VAL;
+    }
+
+    memcpy(acc, awsSrpCombEntry(table, 0), sizeof(aws_mp_digit) * n);
+    for (int column = AWS_SRP_COMB_SPACING - 1; column >= 0; column--) {
+        unsigned int index = 0;
+        for (int tooth = 0; tooth < AWS_SRP_COMB_TEETH; tooth++) {
+            int bit = tooth * AWS_SRP_COMB_SPACING + column;
+            index |= (unsigned int)((exponent[bit / AWS_DIGIT_BIT] >> (bit % AWS_DIGIT_BIT)) & 1) << tooth;
+        }
+        awsSrpCombMultiply(table, acc, acc, acc);
+        awsSrpCombSelect(table, index, entry);
+        awsSrpCombMultiply(table, acc, acc, entry);
+    }
+
+    // leave Montgomery form
+    memset(entry, 0, sizeof(aws_mp_digit) * n);
+    entry[0] = 1;
+    awsSrpCombMultiply(table, acc, acc, entry);
+
+    if ((res = aws_mp_grow(Y, n)) == AWS_MP_OKAY) {
+        memset(Y->dp, 0, sizeof(aws_mp_digit) * Y->alloc);
+        memcpy(Y->dp, acc, sizeof(aws_mp_digit) * n);
+        Y->used = n;
+        Y->sign = AWS_MP_ZPOS;
+        aws_mp_clamp(Y);
+    }
+
+    memset(exponent, 0, sizeof(exponent));
+    memset(acc, 0, sizeof(acc));
+    memset(entry, 0, sizeof(entry));
+    return res;
+}
+
+int awsSrpExptmodBase(AWSSrpCombTable *table, aws_mp_int *g, aws_mp_int *X, aws_mp_int *N, aws_mp_int *Y) {
+    if (table != NULL
+        && aws_mp_cmp(N, &table->N) == AWS_MP_EQ
+        && aws_mp_cmp(g, &table->g) == AWS_MP_EQ
+        && awsSrpCombExptmod(table, X, Y) == AWS_MP_OKAY) {
+        return AWS_MP_OKAY;
+    }
+    return aws_mp_exptmod(g, X, N, Y);
+}
+
+#pragma mark - Serialization
+
+/*
+ * Writes the signed encoding of value into buffer and points bytes at it. Matches
+ * +[NSData aws_dataWithSignedBigInteger:] byte for byte, including its handling of negative values.
+ */
+static int awsSrpSignedBytes(aws_mp_int *value, uint8_t *buffer, size_t capacity, const uint8_t **bytes, size_t *length) {
+    size_t count = (size_t)aws_mp_unsigned_bin_size(value);
+    if (count + 1 > capacity) {
+        return AWS_MP_VAL;
+    }
+    buffer[0] = 0;
+    int res = aws_mp_to_unsigned_bin(value, buffer + 1);
+    if (res != AWS_MP_OKAY) {
+        return res;
+    }
+
+    if (count > 1 && value->sign == AWS_MP_NEG) {
+        // two's complement of the magnitude, then drop leading zero bytes
+        int carry = 1;
+        for (size_t i = count; i > 0; i--) {
+            unsigned int byte = (uint8_t)~buffer[i] + carry;
+            buffer[i] = (uint8_t)byte;
+            carry = byte >> 8;
+        }
+        size_t skip = 1;
+        while (skip <= count && buffer[skip] == 0) {
+            skip++;
+        }
+        *bytes = buffer + skip;
+        *length = count + 1 - skip;
+    } else if (count > 1 && (buffer[1] & 0x80) == 0x80) {
+        // keep the zero sign byte so the value reads back as positive
+        *bytes = buffer;
+        *length = count + 1;
+    } else {
+        *bytes = buffer + 1;
+        *length = count;
+    }
+    return AWS_MP_OKAY;
+}
+
+#pragma mark - Hashing
+
+int awsSrpHashUpdateSigned(CC_SHA256_CTX *ctx, aws_mp_int *value) {
+    uint8_t stackBuffer[AWS_SRP_MAX_VALUE_BYTES + 1];
+    uint8_t *buffer = stackBuffer;
+    size_t capacity = sizeof(stackBuffer);
+    size_t required = (size_t)aws_mp_unsigned_bin_size(value) + 1;
+    if (required > capacity) {
+        buffer = malloc(required);
+        if (buffer == NULL) {
+            return AWS_MP_MEM;
+        }
+        capacity = required;
+    }
+
+    const uint8_t *bytes = NULL;
+    size_t length = 0;
+    int res = awsSrpSignedBytes(value, buffer, capacity, &bytes, &length);
+    if (res == AWS_MP_OKAY) {
+        CC_SHA256_Update(ctx, bytes, (CC_LONG)length);
+    }
+
+    if (buffer != stackBuffer) {
+        free(buffer);
+    }
+    return res;
+}
+
+int awsSrpHashUpdateUnsigned(CC_SHA256_CTX *ctx, aws_mp_int *value) {
+    uint8_t stackBuffer[AWS_SRP_MAX_VALUE_BYTES];
+    uint8_t *buffer = stackBuffer;
+    size_t length = (size_t)aws_mp_unsigned_bin_size(value);
+    if (length > sizeof(stackBuffer)) {
+        buffer = malloc(length);
+        if (buffer == NULL) {
+            return AWS_MP_MEM;
+        }
+    }
+
+    int res = aws_mp_to_unsigned_bin(value, buffer);
+    if (res == AWS_MP_OKAY) {
+        CC_SHA256_Update(ctx, buffer, (CC_LONG)length);
+    }
+
+    if (buffer != stackBuffer) {
+        free(buffer);
+    }
+    return res;
+}
+
+int awsSrpHashFinalUnsigned(CC_SHA256_CTX *ctx, aws_mp_int *result) {
+    uint8_t hash[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256_Final(hash, ctx);
+    return aws_mp_read_unsigned_bin(result, hash, CC_SHA256_DIGEST_LENGTH);
+}
+
+int awsSrpHashFinalSigned(CC_SHA256_CTX *ctx, aws_mp_int *result) {
+    uint8_t hash[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256_Final(hash, ctx);
+    int res = aws_mp_read_unsigned_bin(result, hash, CC_SHA256_DIGEST_LENGTH);
+    if (res != AWS_MP_OKAY || (hash[0] & 0x80) == 0) {
+        return res;
+    }
+
+    // the hash is a negative two's complement value, so subtract 2^256
+    aws_mp_int modulus;
+    if ((res = aws_mp_init(&modulus)) != AWS_MP_OKAY) {
+        return res;
+    }
+    if ((res = aws_mp_2expt(&modulus, CC_SHA256_DIGEST_LENGTH * 8)) == AWS_MP_OKAY) {
+        res = aws_mp_sub(result, &modulus, result);
+    }
+    aws_mp_clear(&modulus);
+    return res;
+}
+
+#pragma mark - SRP values
+
+int awsSrpCalculateK(aws_mp_int *N, aws_mp_int *g, aws_mp_int *k) {
+    uint8_t buffer[AWS_SRP_MAX_VALUE_BYTES + 1];
+    size_t length = (size_t)aws_mp_signed_bin_size(N);
+    if (length > sizeof(buffer)) {
+        return AWS_MP_VAL;
+    }
+
+    // N is hashed with its sign byte, always
+    int res = aws_mp_to_signed_bin(N, buffer);
+    if (res != AWS_MP_OKAY) {
+        return res;
+    }
+    CC_SHA256_CTX ctx;
+    CC_SHA256_Init(&ctx);
+    CC_SHA256_Update(&ctx, buffer, (CC_LONG)length);
+    if ((res = awsSrpHashUpdateUnsigned(&ctx, g)) != AWS_MP_OKAY) {
+        return res;
+    }
+    return awsSrpHashFinalUnsigned(&ctx, k);
+}
+
+int awsSrpCalculateX(const char *poolName, size_t poolNameLength,
+                     const char *userName, size_t userNameLength,
+                     const char *password, size_t passwordLength,
+                     aws_mp_int *salt, aws_mp_int *x) {
+    uint8_t identityHash[CC_SHA256_DIGEST_LENGTH];
+    const uint8_t delim = ':';
+
+    CC_SHA256_CTX identityHashCtx;
+    CC_SHA256_Init(&identityHashCtx);
+    CC_SHA256_Update(&identityHashCtx, poolName, (CC_LONG)poolNameLength);
+    CC_SHA256_Update(&identityHashCtx, userName, (CC_LONG)userNameLength);
+    CC_SHA256_Update(&identityHashCtx, &delim, sizeof(delim));
+    CC_SHA256_Update(&identityHashCtx, password, (CC_LONG)passwordLength);
+    CC_SHA256_Final(identityHash, &identityHashCtx);
+
+    CC_SHA256_CTX ctx;
+    CC_SHA256_Init(&ctx);
+    int res = awsSrpHashUpdateSigned(&ctx, salt);
+    if (res != AWS_MP_OKAY) {
+        return res;
+    }
+    CC_SHA256_Update(&ctx, identityHash, sizeof(identityHash));
+    memset(identityHash, 0, sizeof(identityHash));
+    return awsSrpHashFinalUnsigned(&ctx, x);
+}
+
+int awsSrpCalculateU(aws_mp_int *A, aws_mp_int *B, aws_mp_int *u) {
+    CC_SHA256_CTX ctx;
+    CC_SHA256_Init(&ctx);
+    int res;
+    if ((res = awsSrpHashUpdateSigned(&ctx, A)) != AWS_MP_OKAY ||
+        (res = awsSrpHashUpdateSigned(&ctx, B)) != AWS_MP_OKAY) {
+        return res;
+    }
+    return awsSrpHashFinalUnsigned(&ctx, u);
+}
+
+int awsSrpCalculateS(AWSSrpCombTable *table, aws_mp_int *N, aws_mp_int *g, aws_mp_int *k,
+                     aws_mp_int *a, aws_mp_int *B, aws_mp_int *x, aws_mp_int *u, aws_mp_int *S) {
+    aws_mp_int exponent, base;
+    int res;
+
+    if ((res = aws_mp_init_multi(&exponent, &base, NULL)) != AWS_MP_OKAY) {
+        return res;
+    }
+
+    // exponent = a + u * x
+    if ((res = aws_mp_mul(u, x, &exponent)) != AWS_MP_OKAY ||
+        (res = aws_mp_add(a, &exponent, &exponent)) != AWS_MP_OKAY) {
+        goto cleanup;
+    }
+
+    // base = (B - k * g^x) mod N, which is never negative
+    if ((res = awsSrpExptmodBase(table, g, x, N, &base)) != AWS_MP_OKAY ||
+        (res = aws_mp_mul(k, &base, &base)) != AWS_MP_OKAY ||
+        (res = aws_mp_sub(B, &base, &base)) != AWS_MP_OKAY ||
+        (res = aws_mp_mod(&base, N, &base)) != AWS_MP_OKAY) {
+        goto cleanup;
+    }
+
+    res = aws_mp_exptmod(&base, &exponent, N, S);
+
+cleanup:
+    aws_mp_clear_multi(&exponent, &base, NULL);
+    return res;
+}
+
+int awsSrpDeriveKey(aws_mp_int *S, aws_mp_int *u, const uint8_t *info, size_t infoLength, uint8_t *key, size_t keyLength) {
+    uint8_t sBuffer[AWS_SRP_MAX_VALUE_BYTES + 1];
+    uint8_t uBuffer[AWS_SRP_MAX_VALUE_BYTES + 1];
+    const uint8_t *sBytes = NULL, *uBytes = NULL;
+    size_t sLength = 0, uLength = 0;
+    int res;
+
+    if ((res = awsSrpSignedBytes(S, sBuffer, sizeof(sBuffer), &sBytes, &sLength)) != AWS_MP_OKAY ||
+        (res = awsSrpSignedBytes(u, uBuffer, sizeof(uBuffer), &uBytes, &uLength)) != AWS_MP_OKAY) {
+        return res;
+    }
+    if (keyLength > 255 * CC_SHA256_DIGEST_LENGTH) {
+        return AWS_MP_VAL;
+    }
+
+    // https://tools.ietf.org/html/rfc5869 extract
+    uint8_t prk[CC_SHA256_DIGEST_LENGTH];
+    CCHmac(kCCHmacAlgSHA256, uBytes, uLength, sBytes, sLength, prk);
+
+    // expand
+    uint8_t t[CC_SHA256_DIGEST_LENGTH];
+    size_t tLength = 0;
+    for (uint8_t i = 1; keyLength > 0; i++) {
+        CCHmacContext ctx;
+        CCHmacInit(&ctx, kCCHmacAlgSHA256, prk, sizeof(prk));
+        CCHmacUpdate(&ctx, t, tLength);
+        if (info != NULL) {
+            CCHmacUpdate(&ctx, info, infoLength);
+        }
+        CCHmacUpdate(&ctx, &i, sizeof(i));
+        CCHmacFinal(&ctx, t);
+        tLength = sizeof(t);
+
+        size_t copy = keyLength < tLength ? keyLength : tLength;
+        memcpy(key, t, copy);
+        key += copy;
+        keyLength -= copy;
+    }
+
+    memset(prk, 0, sizeof(prk));
+    memset(t, 0, sizeof(t));
+    memset(sBuffer, 0, sizeof(sBuffer));
+    return AWS_MP_OKAY;
+}
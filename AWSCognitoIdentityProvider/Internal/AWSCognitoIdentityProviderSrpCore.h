@@ -0,0 +1,65 @@
+//
+// Copyright 2014-2016 Amazon.com,
+// Inc. or its affiliates. All Rights Reserved.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#ifndef AWSCognitoIdentityProviderSrpCore_h
+#define AWSCognitoIdentityProviderSrpCore_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <CommonCrypto/CommonDigest.h>
+#include "aws_tommath.h"
+
+/*
+ * The client side SRP math on aws_mp_int values. Byte serialization, hashing and key derivation
+ * use fixed stack buffers, so no intermediate objects or heap buffers are created for values up
+ * to AWS_SRP_MAX_VALUE_BYTES. All functions return AWS_MP_OKAY or a LibTomMath error code.
+ *
+ * Values are hashed in the same encodings AWSCognitoIdentityProviderSrpHelper has always used:
+ * "signed" is the big endian two's complement form with a leading zero byte only when needed,
+ * as produced by +[NSData aws_dataWithSignedBigInteger:].
+ */
+
+#define AWS_SRP_MAX_VALUE_BYTES 512
+
+typedef struct {
+    aws_mp_int N;
+    aws_mp_int g;
+    aws_mp_digit rho;
+    int digits;
+    aws_mp_digit *entries;
+} AWSSrpCombTable;
+
+/* fixed base comb table for g^e mod N */
+int awsSrpCombTableInit(AWSSrpCombTable *table, aws_mp_int *N, aws_mp_int *g);
+void awsSrpCombTableClear(AWSSrpCombTable *table);
+/* constant time in the exponent; AWS_MP_VAL if the exponent is out of the table's range */
+int awsSrpCombExptmod(AWSSrpCombTable *table, aws_mp_int *X, aws_mp_int *Y);
+/* Y = g^X mod N, from the table when it covers N, g and X, otherwise aws_mp_exptmod. table may be NULL. */
+int awsSrpExptmodBase(AWSSrpCombTable *table, aws_mp_int *g, aws_mp_int *X, aws_mp_int *N, aws_mp_int *Y);
+
+/* hashing of big integers */
+int awsSrpHashUpdateSigned(CC_SHA256_CTX *ctx, aws_mp_int *value);
+int awsSrpHashUpdateUnsigned(CC_SHA256_CTX *ctx, aws_mp_int *value);
+int awsSrpHashFinalUnsigned(CC_SHA256_CTX *ctx, aws_mp_int *result);
+int awsSrpHashFinalSigned(CC_SHA256_CTX *ctx, aws_mp_int *result);
+
+/* k = H(N, g) */
+int awsSrpCalculateK(aws_mp_int *N, aws_mp_int *g, aws_mp_int *k);
+/* x = H(salt, H(poolName | userName | ":" | password)) */
+int awsSrpCalculateX(const char *poolName, size_t poolNameLength,
+                     const char *userName, size_t userNameLength,
+                     const char *password, size_t passwordLength,
+                     aws_mp_int *salt, aws_mp_int *x);
+/* u = H(A, B) */
+int awsSrpCalculateU(aws_mp_int *A, aws_mp_int *B, aws_mp_int *u);
+/* S = (B - k * g^x) ^ (a + u * x) mod N */
+int awsSrpCalculateS(AWSSrpCombTable *table, aws_mp_int *N, aws_mp_int *g, aws_mp_int *k,
+                     aws_mp_int *a, aws_mp_int *B, aws_mp_int *x, aws_mp_int *u, aws_mp_int *S);
+/* HKDF-SHA256 with S as the input keying material and u as the salt */
+int awsSrpDeriveKey(aws_mp_int *S, aws_mp_int *u, const uint8_t *info, size_t infoLength, uint8_t *key, size_t keyLength);
+
+#endif /* AWSCognitoIdentityProviderSrpCore_h */
@@ -6,7 +6,8 @@
 //
 
 #import "AWSCognitoIdentityProviderSrpHelper.h"
-#import "AWSCognitoIdentityProviderHKDF.h"
+#import "AWSCognitoIdentityProviderSrpCore.h"
+#import "AWSCognitoIdentityProviderSrpKeyPool.h"
 #import "AWSJKBigInteger.h"
 #import <AWSCore/AWSCocoaLumberjack.h>
 #import <CommonCrypto/CommonCrypto.h>
@@ -16,13 +17,44 @@
 
 #import "NSData+AWSCognitoIdentityProvider.h"
 
-void updateHashWithUnsignedBigInt(CC_SHA256_CTX *ctx, AWSJKBigInteger *bigInt, uint8_t *buffer, size_t bufferSize);
-void updateHashWithSignedBigInt(CC_SHA256_CTX *ctx, AWSJKBigInteger *bigInt, uint8_t *buffer, size_t bufferSize);
-AWSJKBigInteger* finalizeUnsignedBigIntHash(CC_SHA256_CTX *ctx);
-AWSJKBigInteger* finalizeSignedBigIntHash(CC_SHA256_CTX *ctx);
-
 static NSString* N_IN_HEX = @"FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD129024E088A67CC74020BBEA63B139B22514A08798E3404DDEF9519B3CD3A431B302B0A6DF25F14374FE1356D6D51C245E485B576625E7EC6F44C42E9A637ED6B0BFF5CB6F406B7EDEE386BFB5A899FA5AE9F24117C4B1FE649286651ECE45B3DC2007CB8A163BF0598DA48361C55D39A69163FA8FD24CF5F83655D23DCA3AD961C62F356208552BB9ED529077096966D670C354E4ABC9804F1746C08CA18217C32905E462E36CE3BE39E772C180E86039B2783A2EC07A28FB5C55DF06F4C52C9DE2BCBF6955817183995497CEA956AE515D2261898FA051015728E5A8AAAC42DAD33170D04507A33A85521ABDF1CBA64ECFB850458DBEF0A8AEA71575D060C7DB3970F85A6E1E4C7ABF5AE8CDB0933D71E8C94E04A25619DCEE3D2261AD2EE6BF12FFA06D98A0864D87602733EC86A64521F2B18177B200CBBE117577A615D6C770988C0BAD946E208E24FA074E5AB3143DB5BFCE0FD108E4B82D120A93AD2CAFFFFFFFFFFFFFFFF";
 
+#pragma mark - Core bridging
+
+// Wraps a result of the C core, which only fails on allocation or on values beyond AWS_SRP_MAX_VALUE_BYTES.
+static AWSJKBigInteger *awsSrpBigInteger(int res, aws_mp_int *value) {
+    if (res != AWS_MP_OKAY) {
+        // this situation is irrecoverable and we don't want to return something corrupted, so we raise an exception (avoiding NSAssert that may be disabled)
+        [NSException raise:@"NSInternalInconsistencyException" format:@"SRP computation failed: %s", aws_mp_error_to_string(res)];
+        return nil;
+    }
+    return [[AWSJKBigInteger alloc] initWithValue:value];
+}
+
+// The comb table for the Cognito group, built on first use. NULL if it couldn't be built.
+static AWSSrpCombTable *awsSrpGroupTable(void) {
+    static AWSSrpCombTable table;
+    static AWSSrpCombTable *groupTable = NULL;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        aws_mp_int N, g;
+        int res = aws_mp_init_multi(&N, &g, NULL);
+        if (res == AWS_MP_OKAY) {
+            if ((res = aws_mp_read_radix(&N, N_IN_HEX.UTF8String, 16)) == AWS_MP_OKAY &&
+                (res = aws_mp_set_int(&g, 2)) == AWS_MP_OKAY) {
+                res = awsSrpCombTableInit(&table, &N, &g);
+            }
+            aws_mp_clear_multi(&N, &g, NULL);
+        }
+        if (res != AWS_MP_OKAY) {
+            AWSDDLogError(@"Unable to build the SRP fixed base table: %s", aws_mp_error_to_string(res));
+        } else {
+            groupTable = &table;
+        }
+    });
+    return groupTable;
+}
+
 #pragma mark - Srp State
 @implementation AWSCognitoIdentityProviderSrpCommonState
 - (instancetype)init {
@@ -55,25 +87,11 @@ static NSString* N_IN_HEX = @"FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD129
 }
 
 - (AWSJKBigInteger*)calculateK:(AWSJKBigInteger*)N g:(AWSJKBigInteger*)g {
-
-    // + 1 to allow for a sign byte
-    unsigned int maxNumBytes = [N countBytes] + 1;
-
-    uint8_t *bytes = malloc(sizeof(uint8_t) * maxNumBytes);
-    if (bytes == NULL) {
-        // this situation is irrecoverable and we don't want to return something corrupted, so we raise an exception (avoiding NSAssert that may be disabled)
-        [NSException raise:@"NSInternalInconsistencyException" format:@"failed malloc" arguments:nil];
-        return nil;
-    }
-
-    CC_SHA256_CTX ctx;
-    CC_SHA256_Init(&ctx);
-    updateHashWithSignedBigInt(&ctx, N, bytes, maxNumBytes);
-    updateHashWithUnsignedBigInt(&ctx, g, bytes, maxNumBytes);
-
-    free(bytes);
-
-    return finalizeUnsignedBigIntHash(&ctx);
+    aws_mp_int k;
+    aws_mp_init(&k);
+    AWSJKBigInteger *result = awsSrpBigInteger(awsSrpCalculateK([N value], [g value], &k), &k);
+    aws_mp_clear(&k);
+    return result;
 }
 @end
 
@@ -156,11 +174,10 @@ static NSString* N_IN_HEX = @"FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD129
     if (self = [super init]) {
         self.commonState = [[AWSCognitoIdentityProviderSrpCommonState alloc] init];
 
-        AWSJKBigInteger *privateA = [AWSCognitoIdentityProviderSrpHelper generatePrivateABigInt:self.commonState.N];
-        AWSJKBigInteger *publicA = [AWSCognitoIdentityProviderSrpHelper generatePublicABigInt:privateA N:self.commonState.N g:self.commonState.g];
+        AWSCognitoIdentityProviderSrpKeyPair *keyPair = [[AWSCognitoIdentityProviderSrpKeyPool sharedPool] takeKeyPair];
 
         self.clientState = [AWSCognitoIdentityProviderSrpClientState
-                clientStateForUserName:userName password:password privateA:privateA publicA:publicA];
+                clientStateForUserName:userName password:password privateA:keyPair.privateA publicA:keyPair.publicA];
     }
     return self;
 }
@@ -188,7 +205,10 @@ static NSString* N_IN_HEX = @"FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD129
         AWSJKBigInteger *g = [[AWSJKBigInteger alloc] initWithUnsignedLong:2l];
         
         //calculate v
-        self.v = [g pow:x andMod:N];
+        self.v = [AWSCognitoIdentityProviderSrpHelper fixedBasePow:x N:N g:g];
+        if (self.v == nil) {
+            self.v = [g pow:x andMod:N];
+        }
     }
     return self;
 }
@@ -246,13 +266,14 @@ static NSString* N_IN_HEX = @"FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD129
 }
 
 - (NSData*)generatePasswordAuthenticationKey {
+    NSData *info = [self.serverState.derivedKeyInfo dataUsingEncoding:NSUTF8StringEncoding];
+    NSMutableData *key = [NSMutableData dataWithLength:(NSUInteger) self.serverState.derivedKeyLength];
+    int res = awsSrpDeriveKey([self.S value], [self.u value], info.bytes, info.length, key.mutableBytes, key.length);
+    if (res != AWS_MP_OKAY) {
+        [NSException raise:@"NSInternalInconsistencyException" format:@"SRP key derivation failed: %s", aws_mp_error_to_string(res)];
+    }
+    self.authenticationKey = [NSData dataWithData:key];
 
-    self.authenticationKey = [AWSCognitoIdentityProviderHKDF
-            deriveKeyWithInputKeyingMaterial:[NSData aws_dataWithSignedBigInteger:self.S]
-                                        salt:[NSData aws_dataWithSignedBigInteger:self.u]
-                                        info:[self.serverState.derivedKeyInfo dataUsingEncoding:NSUTF8StringEncoding]
-                                outputLength:(NSUInteger) self.serverState.derivedKeyLength];
-    
     return self.authenticationKey;
 }
 
@@ -269,21 +290,20 @@ static NSString* N_IN_HEX = @"FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD129
     
     self.u = [AWSCognitoIdentityProviderSrpHelper hashBigInts:@[self.clientState.publicA, B]];
 
-    AWSJKBigInteger *k = self.commonState.k;
-    AWSJKBigInteger *g = self.commonState.g;
-    AWSJKBigInteger *N = self.commonState.N;
-
-    AWSJKBigInteger *a = self.clientState.privateA;
-    AWSJKBigInteger *exp = [a add:[self.u multiply:self.x]];
-    AWSJKBigInteger *base = [B subtract:[k multiply:[g pow:self.x andMod:N]]];
-
-    //Need this for negative base #s
-    base = [AWSCognitoIdentityProviderSrpHelper mod:base divisor:N];
-
-    AWSJKBigInteger *S = [base pow:exp andMod:N];
-    S = [AWSCognitoIdentityProviderSrpHelper mod:S divisor:N];
-    
-    return S;
+    aws_mp_int S;
+    aws_mp_init(&S);
+    int res = awsSrpCalculateS(awsSrpGroupTable(),
+                               [self.commonState.N value],
+                               [self.commonState.g value],
+                               [self.commonState.k value],
+                               [self.clientState.privateA value],
+                               [B value],
+                               [self.x value],
+                               [self.u value],
+                               &S);
+    AWSJKBigInteger *result = awsSrpBigInteger(res, &S);
+    aws_mp_clear(&S);
+    return result;
 }
 
 + (NSString *)generateDateString:(NSDate *)date {
@@ -301,10 +321,38 @@ static NSString* N_IN_HEX = @"FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD129
 }
 
 + (AWSJKBigInteger*) generatePublicABigInt:(AWSJKBigInteger*)privateA N:(AWSJKBigInteger*)N g:(AWSJKBigInteger*)g {
-    AWSJKBigInteger *publicA = [g pow:privateA andMod:N];
+    AWSJKBigInteger *publicA = [self fixedBasePow:privateA N:N g:g];
+    if (publicA == nil) {
+        publicA = [g pow:privateA andMod:N];
+    }
     return publicA;
 }
 
+/**
+ Computes g^exponent mod N from the cached comb table. Returns nil when N and g aren't the
+ Cognito group parameters or the exponent is out of the table's range, in which case callers
+ should fall back to the generic exponentiation.
+ */
++ (AWSJKBigInteger*) fixedBasePow:(AWSJKBigInteger*)exponent N:(AWSJKBigInteger*)N g:(AWSJKBigInteger*)g {
+    AWSSrpCombTable *table = awsSrpGroupTable();
+    if (table == NULL
+        || aws_mp_cmp([N value], &table->N) != AWS_MP_EQ
+        || aws_mp_cmp([g value], &table->g) != AWS_MP_EQ) {
+        return nil;
+    }
+
+    aws_mp_int result;
+    if (aws_mp_init(&result) != AWS_MP_OKAY) {
+        return nil;
+    }
+    AWSJKBigInteger *power = nil;
+    if (awsSrpCombExptmod(table, [exponent value], &result) == AWS_MP_OKAY) {
+        power = [[AWSJKBigInteger alloc] initWithValue:&result];
+    }
+    aws_mp_clear(&result);
+    return power;
+}
+
 + (AWSJKBigInteger*) mod:(AWSJKBigInteger*)dividend divisor:(AWSJKBigInteger*) divisor {
     return [[divisor add:[dividend remainder:divisor]] remainder:divisor];
 }
@@ -314,94 +362,24 @@ static NSString* N_IN_HEX = @"FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD129
 + (AWSJKBigInteger*) hashSignedBigInts:(NSArray*)bigInts {
     CC_SHA256_CTX ctx;
     CC_SHA256_Init(&ctx);
-    
-    for (AWSJKBigInteger *i in bigInts) {
-        NSData *data = [NSData aws_dataWithSignedBigInteger:i];
-        CC_SHA256_Update(&ctx, data.bytes, (CC_LONG)data.length);        
-    }
-    
-    return finalizeSignedBigIntHash(&ctx);
-}
-
-void updateHashWithUnsignedBigInt(CC_SHA256_CTX *ctx, AWSJKBigInteger *bigInt, uint8_t *buffer, size_t bufferSize) {
-    unsigned int byteCount = [bigInt countBytes];
-    uint8_t *targetBuffer = buffer;
-    
-    if (byteCount <= bufferSize) {
-        targetBuffer = malloc(sizeof(uint8_t) * byteCount);
-    }
-    
-    [bigInt toByteArrayUnsigned:targetBuffer];
-    CC_SHA256_Update(ctx, targetBuffer, byteCount);
-    
-    if (targetBuffer != buffer) {
-        free(targetBuffer);
-    }
-}
-
-void updateHashWithSignedBigInt(CC_SHA256_CTX *ctx, AWSJKBigInteger *bigInt, uint8_t *buffer, size_t bufferSize) {
-    // + 1 to allow for a sign byte TODO: add a function to JKBigInteger to provide a countBytesForSigned
-    unsigned int byteCount = [bigInt countBytes] + 1;
-    uint8_t *targetBuffer = buffer;
 
-    if (byteCount <= bufferSize) {
-        targetBuffer = malloc(sizeof(uint8_t) * byteCount);
+    int res = AWS_MP_OKAY;
+    for (AWSJKBigInteger *i in bigInts) {
+        if ((res = awsSrpHashUpdateSigned(&ctx, [i value])) != AWS_MP_OKAY) {
+            break;
+        }
     }
 
-    [bigInt toByteArraySigned:targetBuffer];
-    CC_SHA256_Update(ctx, targetBuffer, byteCount);
-
-    if (targetBuffer != buffer) {
-        free(targetBuffer);
+    aws_mp_int hash;
+    aws_mp_init(&hash);
+    if (res == AWS_MP_OKAY) {
+        res = awsSrpHashFinalSigned(&ctx, &hash);
     }
-}
-
-AWSJKBigInteger* finalizeUnsignedBigIntHash(CC_SHA256_CTX *ctx) {
-    uint8_t hash[CC_SHA256_DIGEST_LENGTH];
-    CC_SHA256_Final(hash, ctx);
-
-    aws_mp_int hashBigInt;
-    aws_mp_init(&hashBigInt);
-    aws_mp_read_unsigned_bin(&hashBigInt, hash, CC_SHA256_DIGEST_LENGTH);
-
-    AWSJKBigInteger *result = [[AWSJKBigInteger alloc] initWithValue:&hashBigInt];
-    aws_mp_clear(&hashBigInt);
-
+    AWSJKBigInteger *result = awsSrpBigInteger(res, &hash);
+    aws_mp_clear(&hash);
     return result;
 }
 
-AWSJKBigInteger* finalizeSignedBigIntHash(CC_SHA256_CTX *ctx) {
-    int bufferLength = CC_SHA256_DIGEST_LENGTH+1;
-    uint8_t hash[bufferLength];
-    // hash goes in [1..CC_SHA256_DIGEST_LENGTH; keep hash[0] for the sign byte required by AWSJKBigInteger
-    CC_SHA256_Final(hash+1, ctx);
-    
-    AWSJKBigInteger *twosComplementMinusOneMaybe = nil;
-    hash[0] = (hash[1] & 0x80) == 0x80;
-    if (hash[0]) { //two's complement; need to convert to unsigned
-        
-        twosComplementMinusOneMaybe = [[AWSJKBigInteger alloc] initWithString:@"-1"];
-        
-        for( int i = 1; i < bufferLength; i++) {
-            hash[i] = ~hash[i];
-        }
-    } else {
-        twosComplementMinusOneMaybe = [[AWSJKBigInteger alloc] initWithString:@"0"];
-    }
-    
-    aws_mp_int hashBigInt;
-    aws_mp_init(&hashBigInt);
-    aws_mp_read_signed_bin(&hashBigInt, hash, bufferLength);
-    
-    AWSJKBigInteger *result = [[AWSJKBigInteger alloc] initWithValue:&hashBigInt];
-    result = [result add:twosComplementMinusOneMaybe];
-    
-    aws_mp_clear(&hashBigInt);
-    
-    return result;
-
-}
-
 + (NSData*)calculateXHash:(NSString*)userPool userName:(NSString*)userName password:(NSString*)password salt:(AWSJKBigInteger*)salt {
     uint8_t identityHash[CC_SHA256_DIGEST_LENGTH];
     
@@ -426,38 +404,36 @@ AWSJKBigInteger* finalizeSignedBigIntHash(CC_SHA256_CTX *ctx) {
 }
 
 + (AWSJKBigInteger*) calculateX:(NSString*)userPool userName:(NSString*)userName password:(NSString*)password salt:(AWSJKBigInteger*)salt {
-    
-    uint8_t identityHash[CC_SHA256_DIGEST_LENGTH];
-    
-    CC_SHA256_CTX identityHashCtx;
-    CC_SHA256_Init(&identityHashCtx);
-    CC_SHA256_Update(&identityHashCtx, userPool.UTF8String, (CC_LONG)[userPool lengthOfBytesUsingEncoding:NSUTF8StringEncoding]);
-    CC_SHA256_Update(&identityHashCtx, userName.UTF8String, (CC_LONG)[userName lengthOfBytesUsingEncoding:NSUTF8StringEncoding]);
-    const uint8_t delim = ':';
-    CC_SHA256_Update(&identityHashCtx, &delim, sizeof(delim));
-    CC_SHA256_Update(&identityHashCtx, password.UTF8String, (CC_LONG)[password lengthOfBytesUsingEncoding:NSUTF8StringEncoding]);
-    CC_SHA256_Final(identityHash, &identityHashCtx);
-    
-    NSData *saltData = [NSData aws_dataWithSignedBigInteger:salt];
-    CC_SHA256_CTX ctx;
-    CC_SHA256_Init(&ctx);
-    CC_SHA256_Update(&ctx, saltData.bytes, (CC_LONG)saltData.length);
-    CC_SHA256_Update(&ctx, identityHash, sizeof(identityHash));
-    
-
-    return finalizeUnsignedBigIntHash(&ctx);
+    aws_mp_int x;
+    aws_mp_init(&x);
+    int res = awsSrpCalculateX(userPool.UTF8String, [userPool lengthOfBytesUsingEncoding:NSUTF8StringEncoding],
+                               userName.UTF8String, [userName lengthOfBytesUsingEncoding:NSUTF8StringEncoding],
+                               password.UTF8String, [password lengthOfBytesUsingEncoding:NSUTF8StringEncoding],
+                               [salt value], &x);
+    AWSJKBigInteger *result = awsSrpBigInteger(res, &x);
+    aws_mp_clear(&x);
+    return result;
 }
 
 + (AWSJKBigInteger*) hashBigInts:(NSArray*)bigInts {
     CC_SHA256_CTX ctx;
     CC_SHA256_Init(&ctx);
-    
+
+    int res = AWS_MP_OKAY;
     for (AWSJKBigInteger *i in bigInts) {
-        NSData *data = [NSData aws_dataWithSignedBigInteger:i];
-        CC_SHA256_Update(&ctx, data.bytes, (CC_LONG)data.length);
+        if ((res = awsSrpHashUpdateSigned(&ctx, [i value])) != AWS_MP_OKAY) {
+            break;
+        }
     }
-    
-    return finalizeUnsignedBigIntHash(&ctx);
+
+    aws_mp_int hash;
+    aws_mp_init(&hash);
+    if (res == AWS_MP_OKAY) {
+        res = awsSrpHashFinalUnsigned(&ctx, &hash);
+    }
+    AWSJKBigInteger *result = awsSrpBigInteger(res, &hash);
+    aws_mp_clear(&hash);
+    return result;
 }
 
 @end
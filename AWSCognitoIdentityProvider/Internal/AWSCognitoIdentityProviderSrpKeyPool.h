@@ -0,0 +1,48 @@
+//
+// Copyright 2014-2016 Amazon.com,
+// Inc. or its affiliates. All Rights Reserved.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class AWSJKBigInteger;
+
+FOUNDATION_EXPORT const NSUInteger AWSCognitoIdentityProviderSrpKeyPoolDefaultSize;
+
+/* A single use SRP ephemeral key pair, A = g^a mod N */
+@interface AWSCognitoIdentityProviderSrpKeyPair : NSObject
+
+@property (nonatomic, readonly) AWSJKBigInteger *privateA;
+@property (nonatomic, readonly) AWSJKBigInteger *publicA;
+
+@end
+
+/*
+ Keeps up to `size` key pairs for the Cognito group generated ahead of sign in, so the
+ modular exponentiation for A isn't on the path to the first InitiateAuth request.
+ Pairs are refilled on a utility queue and each pair is handed out exactly once.
+ */
+@interface AWSCognitoIdentityProviderSrpKeyPool : NSObject
+
++ (instancetype)sharedPool;
+
+- (instancetype)initWithSize:(NSUInteger)size;
+
+/* Setting 0 disables pre-generation and drops any pairs already generated */
+@property (atomic, assign) NSUInteger size;
+
+@property (nonatomic, readonly) NSUInteger count;
+
+/* Removes a pair from the pool, or generates one on the calling thread if the pool is empty */
+- (AWSCognitoIdentityProviderSrpKeyPair *)takeKeyPair;
+
+/* Starts generating pairs in the background until the pool is full */
+- (void)refill;
+
+@end
+
+NS_ASSUME_NONNULL_END
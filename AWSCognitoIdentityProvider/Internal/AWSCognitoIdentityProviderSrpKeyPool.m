@@ -0,0 +1,137 @@
+//
+// Copyright 2014-2016 Amazon.com,
+// Inc. or its affiliates. All Rights Reserved.
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#import "AWSCognitoIdentityProviderSrpKeyPool.h"
+#import "AWSCognitoIdentityProviderSrpHelper.h"
+#import "AWSJKBigInteger.h"
+
+const NSUInteger AWSCognitoIdentityProviderSrpKeyPoolDefaultSize = 2;
+
+@interface AWSCognitoIdentityProviderSrpKeyPair()
+
+@property (nonatomic, strong) AWSJKBigInteger *privateA;
+@property (nonatomic, strong) AWSJKBigInteger *publicA;
+
+@end
+
+@implementation AWSCognitoIdentityProviderSrpKeyPair
+
++ (instancetype)keyPairWithCommonState:(AWSCognitoIdentityProviderSrpCommonState *)commonState {
+    AWSCognitoIdentityProviderSrpKeyPair *keyPair = [AWSCognitoIdentityProviderSrpKeyPair new];
+    keyPair.privateA = [AWSCognitoIdentityProviderSrpHelper generatePrivateABigInt:commonState.N];
+    keyPair.publicA = [AWSCognitoIdentityProviderSrpHelper generatePublicABigInt:keyPair.privateA
+                                                                               N:commonState.N
+                                                                               g:commonState.g];
+    return keyPair;
+}
+
+@end
+
+@interface AWSCognitoIdentityProviderSrpKeyPool()
+
+@property (nonatomic, strong) AWSCognitoIdentityProviderSrpCommonState *commonState;
+@property (nonatomic, strong) NSMutableArray<AWSCognitoIdentityProviderSrpKeyPair *> *keyPairs;
+@property (nonatomic, strong) dispatch_queue_t refillQueue;
+@property (nonatomic, assign) BOOL refillScheduled;
+
+@end
+
+@implementation AWSCognitoIdentityProviderSrpKeyPool
+
+@synthesize size = _size;
+
++ (instancetype)sharedPool {
+    static AWSCognitoIdentityProviderSrpKeyPool *_sharedPool = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        _sharedPool = [[AWSCognitoIdentityProviderSrpKeyPool alloc] initWithSize:AWSCognitoIdentityProviderSrpKeyPoolDefaultSize];
+    });
+    return _sharedPool;
+}
+
+- (instancetype)init {
+    return [self initWithSize:AWSCognitoIdentityProviderSrpKeyPoolDefaultSize];
+}
+
+- (instancetype)initWithSize:(NSUInteger)size {
+    if (self = [super init]) {
+        _size = size;
+        _commonState = [AWSCognitoIdentityProviderSrpCommonState new];
+        _keyPairs = [NSMutableArray new];
+        dispatch_queue_attr_t attributes = dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0);
+        _refillQueue = dispatch_queue_create("com.amazonaws.AWSCognitoIdentityProviderSrpKeyPool", attributes);
+    }
+    return self;
+}
+
+- (NSUInteger)size {
+    @synchronized(self) {
+        return _size;
+    }
+}
+
+- (void)setSize:(NSUInteger)size {
+    @synchronized(self) {
+        _size = size;
+        if (self.keyPairs.count > size) {
+            [self.keyPairs removeObjectsInRange:NSMakeRange(size, self.keyPairs.count - size)];
+        }
+    }
+}
+
+- (NSUInteger)count {
+    @synchronized(self) {
+        return self.keyPairs.count;
+    }
+}
+
+- (AWSCognitoIdentityProviderSrpKeyPair *)takeKeyPair {
+    AWSCognitoIdentityProviderSrpKeyPair *keyPair = nil;
+    @synchronized(self) {
+        keyPair = self.keyPairs.firstObject;
+        if (keyPair) {
+            [self.keyPairs removeObjectAtIndex:0];
+        }
+    }
+    [self refill];
+
+    if (keyPair == nil) {
+        keyPair = [AWSCognitoIdentityProviderSrpKeyPair keyPairWithCommonState:self.commonState];
+    }
+    return keyPair;
+}
+
+- (void)refill {
+    @synchronized(self) {
+        if (self.refillScheduled || self.keyPairs.count >= _size) {
+            return;
+        }
+        self.refillScheduled = YES;
+    }
+
+    __weak AWSCognitoIdentityProviderSrpKeyPool *weakSelf = self;
+    dispatch_async(self.refillQueue, ^{
+        AWSCognitoIdentityProviderSrpKeyPool *strongSelf = weakSelf;
+        while (strongSelf) {
+            @synchronized(strongSelf) {
+                if (strongSelf.keyPairs.count >= strongSelf->_size) {
+                    strongSelf.refillScheduled = NO;
+                    return;
+                }
+            }
+            // generated outside the lock so takeKeyPair never waits on a modular exponentiation
+            AWSCognitoIdentityProviderSrpKeyPair *keyPair = [AWSCognitoIdentityProviderSrpKeyPair keyPairWithCommonState:strongSelf.commonState];
+            @synchronized(strongSelf) {
+                if (strongSelf.keyPairs.count < strongSelf->_size) {
+                    [strongSelf.keyPairs addObject:keyPair];
+                }
+            }
+        }
+    });
+}
+
+@end
@@ -45,9 +45,14 @@ extern "C" {
 #endif
 
 
-/* detect 64-bit mode if possible */
-#if defined(__x86_64__) 
-   #if !(defined(AWS_MP_64BIT) && defined(AWS_MP_16BIT) && defined(AWS_MP_8BIT))
+/* detect 64-bit mode if possible
+ *
+ * 60-bit digits with a 128-bit mp_word roughly halve the digit count of the 3072-bit SRP
+ * modulus compared to the 28-bit default, and the comba kernels do about a quarter of the
+ * work. Define AWS_MP_32BIT to force the portable 28-bit build.
+ */
+#if defined(__x86_64__) || defined(__aarch64__) || defined(__arm64__)
+   #if !(defined(AWS_MP_32BIT) || defined(AWS_MP_16BIT) || defined(AWS_MP_8BIT))
       #define AWS_MP_64BIT
    #endif
 #endif
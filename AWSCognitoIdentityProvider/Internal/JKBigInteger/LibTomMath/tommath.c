@@ -668,11 +668,21 @@ int aws_mp_reduce_is_2k(aws_mp_int *a)
 -------------------------------------------------------------
  Intel P4 Northwood     /GCC v3.4.1   /        88/       128/LTM 0.32 ;-)
  AMD Athlon64           /GCC v3.4.4   /        80/       120/LTM 0.35
+ x86-64, 60-bit digits  /GCC -O2      /       256/       120
  
+ With 60-bit digits the comba multiplier stays ahead of Karatsuba on x86-64 until it runs
+ out of columns at 256 digits, and the comba squarer is limited to 127 digits. arm64 also
+ uses 60-bit digits but has not been measured, so it keeps the defaults below until
+ testKaratsubaCutoffs in the unit tests reports its crossover on a device.
 */
 
+#if defined(AWS_MP_64BIT) && defined(__x86_64__)
+int     AWS_KARATSUBA_MUL_CUTOFF = 256,     /* Min. number of digits before Karatsuba multiplication is used. */
+        AWS_KARATSUBA_SQR_CUTOFF = 120,     /* Min. number of digits before Karatsuba squaring is used. */
+#else
 int     AWS_KARATSUBA_MUL_CUTOFF = 80,      /* Min. number of digits before Karatsuba multiplication is used. */
         AWS_KARATSUBA_SQR_CUTOFF = 120,     /* Min. number of digits before Karatsuba squaring is used. */
+#endif
         
         AWS_TOOM_MUL_CUTOFF = 350,      /* no optimal values of these are known yet so set em high */
         AWS_TOOM_SQR_CUTOFF = 400;
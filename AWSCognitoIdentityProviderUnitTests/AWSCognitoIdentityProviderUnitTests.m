@@ -14,6 +14,24 @@
 //
 
 #import <XCTest/XCTest.h>
+#import <CommonCrypto/CommonDigest.h>
+#import "AWSCognitoIdentityProviderSrpHelper.h"
+#import "AWSCognitoIdentityProviderSrpKeyPool.h"
+#import "AWSCognitoIdentityProviderHKDF.h"
+#import "AWSJKBigInteger.h"
+#import "NSData+AWSCognitoIdentityProvider.h"
+
+@interface AWSCognitoIdentityProviderSrpHelper()
+
++ (AWSJKBigInteger*) fixedBasePow:(AWSJKBigInteger*)exponent N:(AWSJKBigInteger*)N g:(AWSJKBigInteger*)g;
+
+@end
+
+@interface AWSCognitoIdentityProviderSrpKeyPool()
+
+@property (nonatomic, strong) dispatch_queue_t refillQueue;
+
+@end
 
 @interface AWSCognitoIdentityProviderUnitTests : XCTestCase
 
@@ -31,4 +49,213 @@
     [super tearDown];
 }
 
+- (void)testFixedBasePowMatchesGenericPow {
+    AWSCognitoIdentityProviderSrpCommonState *commonState = [AWSCognitoIdentityProviderSrpCommonState new];
+    for (int i = 0; i < 50; i++) {
+        AWSJKBigInteger *privateA = [AWSCognitoIdentityProviderSrpHelper generatePrivateABigInt:commonState.N];
+        AWSJKBigInteger *expected = [commonState.g pow:privateA andMod:commonState.N];
+        AWSJKBigInteger *publicA = [AWSCognitoIdentityProviderSrpHelper fixedBasePow:privateA N:commonState.N g:commonState.g];
+        XCTAssertNotNil(publicA);
+        XCTAssertEqualObjects([expected stringValueWithRadix:16], [publicA stringValueWithRadix:16]);
+    }
+    
+    AWSJKBigInteger *zero = [[AWSJKBigInteger alloc] initWithUnsignedLong:0];
+    XCTAssertEqualObjects(@"1", [[AWSCognitoIdentityProviderSrpHelper fixedBasePow:zero N:commonState.N g:commonState.g] stringValue]);
+    AWSJKBigInteger *small = [[AWSJKBigInteger alloc] initWithUnsignedLong:65537];
+    XCTAssertEqualObjects([[commonState.g pow:small andMod:commonState.N] stringValueWithRadix:16],
+                          [[AWSCognitoIdentityProviderSrpHelper fixedBasePow:small N:commonState.N g:commonState.g] stringValueWithRadix:16]);
+    
+    // other groups and oversized exponents aren't covered by the table
+    AWSJKBigInteger *otherG = [[AWSJKBigInteger alloc] initWithUnsignedLong:5];
+    XCTAssertNil([AWSCognitoIdentityProviderSrpHelper fixedBasePow:zero N:commonState.N g:otherG]);
+    XCTAssertNil([AWSCognitoIdentityProviderSrpHelper fixedBasePow:commonState.N N:commonState.N g:commonState.g]);
+}
+
+- (void)testPublicAGenerationThroughput {
+    AWSCognitoIdentityProviderSrpCommonState *commonState = [AWSCognitoIdentityProviderSrpCommonState new];
+    // build the table outside the timed loop
+    [AWSCognitoIdentityProviderSrpHelper generatePublicABigInt:commonState.g N:commonState.N g:commonState.g];
+    
+    const int iterations = 200;
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (int i = 0; i < iterations; i++) {
+        AWSJKBigInteger *privateA = [AWSCognitoIdentityProviderSrpHelper generatePrivateABigInt:commonState.N];
+        [commonState.g pow:privateA andMod:commonState.N];
+    }
+    CFAbsoluteTime genericTime = CFAbsoluteTimeGetCurrent() - start;
+    
+    start = CFAbsoluteTimeGetCurrent();
+    for (int i = 0; i < iterations; i++) {
+        AWSJKBigInteger *privateA = [AWSCognitoIdentityProviderSrpHelper generatePrivateABigInt:commonState.N];
+        [AWSCognitoIdentityProviderSrpHelper generatePublicABigInt:privateA N:commonState.N g:commonState.g];
+    }
+    CFAbsoluteTime combTime = CFAbsoluteTimeGetCurrent() - start;
+    
+    NSLog(@"SRP A generation: generic %.0f/s, fixed base %.0f/s", iterations / genericTime, iterations / combTime);
+}
+
+#pragma mark - SRP core
+
+static NSString *const AWSSrpTestDerivedKeyInfo = @"Caldera Derived Key";
+
+static AWSJKBigInteger *AWSSrpTestHash(NSArray<NSData *> *parts) {
+    CC_SHA256_CTX ctx;
+    CC_SHA256_Init(&ctx);
+    for (NSData *part in parts) {
+        CC_SHA256_Update(&ctx, part.bytes, (CC_LONG)part.length);
+    }
+    uint8_t hash[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256_Final(hash, &ctx);
+    NSMutableString *hex = [NSMutableString string];
+    for (int i = 0; i < CC_SHA256_DIGEST_LENGTH; i++) {
+        [hex appendFormat:@"%02x", hash[i]];
+    }
+    return [[AWSJKBigInteger alloc] initWithString:hex andRadix:16];
+}
+
+// The object based computation the helper used before moving to the C core.
+- (NSData *)referenceAuthenticationKey:(AWSCognitoIdentityProviderSrpHelper *)helper
+                           serverState:(AWSCognitoIdentityProviderSrpServerState *)serverState {
+    AWSCognitoIdentityProviderSrpCommonState *commonState = helper.commonState;
+    AWSJKBigInteger *N = commonState.N;
+    NSString *identity = [NSString stringWithFormat:@"%@%@:%@", serverState.poolName, helper.clientState.userName, helper.clientState.password];
+    NSData *identityData = [identity dataUsingEncoding:NSUTF8StringEncoding];
+    uint8_t identityHash[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256(identityData.bytes, (CC_LONG)identityData.length, identityHash);
+
+    AWSJKBigInteger *x = AWSSrpTestHash(@[[NSData aws_dataWithSignedBigInteger:serverState.salt],
+                                          [NSData dataWithBytes:identityHash length:sizeof(identityHash)]]);
+    AWSJKBigInteger *u = AWSSrpTestHash(@[[NSData aws_dataWithSignedBigInteger:helper.clientState.publicA],
+                                          [NSData aws_dataWithSignedBigInteger:serverState.publicB]]);
+    XCTAssertEqualObjects([x stringValueWithRadix:16], [helper.x stringValueWithRadix:16]);
+    XCTAssertEqualObjects([u stringValueWithRadix:16], [helper.u stringValueWithRadix:16]);
+
+    AWSJKBigInteger *exp = [helper.clientState.privateA add:[u multiply:x]];
+    AWSJKBigInteger *base = [serverState.publicB subtract:[commonState.k multiply:[commonState.g pow:x andMod:N]]];
+    base = [[N add:[base remainder:N]] remainder:N];
+    AWSJKBigInteger *S = [base pow:exp andMod:N];
+    XCTAssertEqualObjects([S stringValueWithRadix:16], [helper.S stringValueWithRadix:16]);
+
+    return [AWSCognitoIdentityProviderHKDF deriveKeyWithInputKeyingMaterial:[NSData aws_dataWithSignedBigInteger:S]
+                                                                       salt:[NSData aws_dataWithSignedBigInteger:u]
+                                                                       info:[AWSSrpTestDerivedKeyInfo dataUsingEncoding:NSUTF8StringEncoding]
+                                                               outputLength:16];
+}
+
+- (AWSCognitoIdentityProviderSrpServerState *)serverStateWithCommonState:(AWSCognitoIdentityProviderSrpCommonState *)commonState {
+    AWSJKBigInteger *b = [AWSCognitoIdentityProviderSrpHelper generatePrivateABigInt:commonState.N];
+    AWSJKBigInteger *B = [commonState.g pow:b andMod:commonState.N];
+    AWSJKBigInteger *salt = [AWSCognitoIdentityProviderSrpHelper generatePrivateABigInt:commonState.N];
+    return [AWSCognitoIdentityProviderSrpServerState serverStateForPoolName:@"us-east-1_pool"
+                                                           publicBHexString:[B stringValueWithRadix:16]
+                                                              saltHexString:[[salt shiftRight:128] stringValueWithRadix:16]
+                                                             derivedKeyInfo:AWSSrpTestDerivedKeyInfo
+                                                             derivedKeySize:16
+                                                         serviceSecretBlock:[NSData data]];
+}
+
+- (void)testSrpCoreMatchesObjectComputation {
+    AWSCognitoIdentityProviderSrpCommonState *commonState = [AWSCognitoIdentityProviderSrpCommonState new];
+    XCTAssertEqualObjects(@"538282C4354742D7CBBDE2359FCF67F9F5B3A6B08791E5011B43B8A5B66D9EE6", [[commonState.k stringValueWithRadix:16] uppercaseString]);
+
+    for (int i = 0; i < 20; i++) {
+        AWSCognitoIdentityProviderSrpHelper *helper = [[AWSCognitoIdentityProviderSrpHelper alloc] init:@"user" password:@"p\u00e4ssword"];
+        AWSCognitoIdentityProviderSrpServerState *serverState = [self serverStateWithCommonState:commonState];
+        [helper completeAuthentication:serverState];
+        XCTAssertEqualObjects([self referenceAuthenticationKey:helper serverState:serverState], helper.authenticationKey);
+    }
+}
+
+- (void)testSrpCompletionThroughput {
+    AWSCognitoIdentityProviderSrpCommonState *commonState = [AWSCognitoIdentityProviderSrpCommonState new];
+    const int iterations = 50;
+    NSMutableArray *helpers = [NSMutableArray array];
+    NSMutableArray *serverStates = [NSMutableArray array];
+    for (int i = 0; i < iterations; i++) {
+        [helpers addObject:[[AWSCognitoIdentityProviderSrpHelper alloc] init:@"user" password:@"password"]];
+        [serverStates addObject:[self serverStateWithCommonState:commonState]];
+    }
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (int i = 0; i < iterations; i++) {
+        [helpers[i] completeAuthentication:serverStates[i]];
+    }
+    CFAbsoluteTime coreTime = CFAbsoluteTimeGetCurrent() - start;
+
+    start = CFAbsoluteTimeGetCurrent();
+    for (int i = 0; i < iterations; i++) {
+        [self referenceAuthenticationKey:helpers[i] serverState:serverStates[i]];
+    }
+    CFAbsoluteTime referenceTime = CFAbsoluteTimeGetCurrent() - start;
+
+    NSLog(@"SRP completion: object path %.0f/s, C core %.0f/s", iterations / referenceTime, iterations / coreTime);
+}
+
+#pragma mark - SRP key pool
+
+- (void)waitForRefill:(AWSCognitoIdentityProviderSrpKeyPool *)keyPool {
+    dispatch_sync(keyPool.refillQueue, ^{});
+}
+
+- (void)testKeyPoolHandsOutEachPairOnce {
+    AWSCognitoIdentityProviderSrpCommonState *commonState = [AWSCognitoIdentityProviderSrpCommonState new];
+    AWSCognitoIdentityProviderSrpKeyPool *keyPool = [[AWSCognitoIdentityProviderSrpKeyPool alloc] initWithSize:4];
+    [keyPool refill];
+    [self waitForRefill:keyPool];
+    XCTAssertEqual(4, keyPool.count);
+
+    const size_t takes = 16;
+    NSMutableArray *keyPairs = [NSMutableArray array];
+    dispatch_apply(takes, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+        AWSCognitoIdentityProviderSrpKeyPair *keyPair = [keyPool takeKeyPair];
+        @synchronized(keyPairs) {
+            [keyPairs addObject:keyPair];
+        }
+    });
+
+    NSMutableSet *privateKeys = [NSMutableSet set];
+    for (AWSCognitoIdentityProviderSrpKeyPair *keyPair in keyPairs) {
+        [privateKeys addObject:[keyPair.privateA stringValueWithRadix:16]];
+        XCTAssertEqualObjects([[commonState.g pow:keyPair.privateA andMod:commonState.N] stringValueWithRadix:16],
+                              [keyPair.publicA stringValueWithRadix:16]);
+    }
+    XCTAssertEqual(takes, privateKeys.count);
+
+    [self waitForRefill:keyPool];
+    XCTAssertEqual(4, keyPool.count);
+    keyPool.size = 1;
+    XCTAssertEqual(1, keyPool.count);
+    keyPool.size = 0;
+    XCTAssertEqual(0, keyPool.count);
+    XCTAssertNotNil([keyPool takeKeyPair]);
+    [self waitForRefill:keyPool];
+    XCTAssertEqual(0, keyPool.count);
+}
+
+- (void)testKeyPoolTimeToFirstRequest {
+    const int iterations = 20;
+    AWSCognitoIdentityProviderSrpKeyPool *keyPool = [[AWSCognitoIdentityProviderSrpKeyPool alloc] initWithSize:0];
+    // build the fixed base table outside the timed loops
+    [keyPool takeKeyPair];
+
+    CFAbsoluteTime coldTime = 0;
+    for (int i = 0; i < iterations; i++) {
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        [[keyPool takeKeyPair].publicA stringValueWithRadix:16];
+        coldTime += CFAbsoluteTimeGetCurrent() - start;
+    }
+
+    keyPool.size = 1;
+    CFAbsoluteTime warmTime = 0;
+    for (int i = 0; i < iterations; i++) {
+        [keyPool refill];
+        [self waitForRefill:keyPool];
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        [[keyPool takeKeyPair].publicA stringValueWithRadix:16];
+        warmTime += CFAbsoluteTimeGetCurrent() - start;
+    }
+
+    NSLog(@"SRP_A ready after: cold pool %.3f ms, warm pool %.3f ms", coldTime * 1000 / iterations, warmTime * 1000 / iterations);
+}
+
 @end
@@ -0,0 +1,131 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import "AWSJKBigInteger.h"
+
+static NSString *const AWSJKBigIntegerTestsNHex = @"FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD129024E088A67CC74020BBEA63B139B22514A08798E3404DDEF9519B3CD3A431B302B0A6DF25F14374FE1356D6D51C245E485B576625E7EC6F44C42E9A637ED6B0BFF5CB6F406B7EDEE386BFB5A899FA5AE9F24117C4B1FE649286651ECE45B3DC2007CB8A163BF0598DA48361C55D39A69163FA8FD24CF5F83655D23DCA3AD961C62F356208552BB9ED529077096966D670C354E4ABC9804F1746C08CA18217C32905E462E36CE3BE39E772C180E86039B2783A2EC07A28FB5C55DF06F4C52C9DE2BCBF6955817183995497CEA956AE515D2261898FA051015728E5A8AAAC42DAD33170D04507A33A85521ABDF1CBA64ECFB850458DBEF0A8AEA71575D060C7DB3970F85A6E1E4C7ABF5AE8CDB0933D71E8C94E04A25619DCEE3D2261AD2EE6BF12FFA06D98A0864D87602733EC86A64521F2B18177B200CBBE117577A615D6C770988C0BAD946E208E24FA074E5AB3143DB5BFCE0FD108E4B82D120A93AD2CAFFFFFFFFFFFFFFFF";
+
+// base, exponent, base^exponent mod N for the SRP modulus, generated with the 28-bit digit build
+static NSArray<NSArray<NSString *> *> *AWSJKBigIntegerTestsExptmodVectors(void) {
+    return @[
+        @[@"2", @"6DB24C4DFA4B55B6C42E7217312D41277707E4FEB05F6A0A1A821C6B8D9CCFFA", @"F1145AA5504E345B2968E0CF4C772AA3E7CF1F7781C73B990184EE3F7754DAC26D3099B83F9FF0082D1253E83A4A6E388F8D951094D9760C6C5D21D0C2B496F376A43113349E3873EB055848ABA8E6B285C54A3E6CCE80D52843FF2AA884EF7269CA1900EC0206974C97BE7F6914A4C324E944A919459A0DE4E51B3A8DA3C7635F178776CE430B1140297612FEA8ADFC3A6B19457395B19FBFA516E0E0F77241FF80B798FAC22639372E7D7B55E0C1CD2184B112BFF64707A88B110A74280A8BF1292D41808615FD4004E1A3E8D77E31FF52B50986A5234B3C4B84139A6AD7F0B1582B907E1AB6A4C53E074183942E85A2128B69C62362ACC5F40B4FBCB953250704644B6A6DA2FA728E3AAC2AC97C31574794176DAC2D43DBDCC837D94CF845AD5BD4A03220B92241EE0537A5953D75362C7F6277E655551291010A1733CA754366D4964164815A541D59E41E8EB4DF75E229C837D02C581274EAAB96758C6EDC62CC545A2ACE8ADEF3F53B7F5A56C3C0592BE473ED997CFF6400631969FDE2"],
+        @[@"2", @"4F1C4749679DFF2BCB7142FC9E8423168B07143C667F46800162EC8EFFBB894E", @"D4C9298379BA5F6442013962530B983A3D22DE69D1061108757240016DC0B1CA49326F9B1250FE8778DF17E032CD331CA6E53A762182A5F24CAE765631B526726481EC2A59113B36D325333F33955EA1DB02A7FCDB27BCD2F02AE2960A356BA3EA7C799C3639B4CB5652B0AA7C5278F8F8D9029577ADB726105B514BA6662CD08B1189095650E2984C69F8341A1FF4DB155FE16D17C7F8FDCB2636A42444FE5921580D1813CE43950D1F8D169AD933C0BEF9D9814CFD0B2110B13566AD4C29FD0F2B7A9D0B6EEACF1FCC0FCD10368426D319D45F89F52463AC0A680E9BD2CB5789262A074AD916902FBAB46508675FA5BB678286BEBF18C85B3AF35C937D1F3F6E3421FF5D3E2EEBCA1A7A949B336A2E9B3E405DC2DA47AE7A93059BEAD220F6FAD311FFAFE88317F71DDBF43F724DD25046474A6528DFEC813C559513C922523AFA5E645C7336243AC7CAD21A3CCBD38718B8383121C8F90807FBA0BD89CB1FDD98367C8AA87251BFC317CE38C89638B1032DC32418CDD69166E9A78690263B"],
+        @[@"2", @"D7D0973E6D96693807AC35A53058BBBB60D0F7C64F3D4750A033DE9FEE67EDC6", @"287257621B054576519F3E1D495F54CB248EE81658B93726EC998568883A9431E0B5AE7D7EBAA277EDDD2F709EEDD222A9C6C837F3AD87ABE274E4892A0F01999E869A3E6E024EC6FAD6D8C494DD1EF9D15B39F4B42CEF8A8C5BC10BA133EF2B638CB1B764402B81BAB5070C2D29C8D0A1EB9FD9B8C1AC42F972BEBE5F297001416326CF023142FD478D530C78753EFD9B2C96E2AD0A02B7CE5DD5C870E36479E076B05EBDAF5D257AEF4F5E81B2E1E49E7F7E0B818CCB61A81AC9FA63757CFCFFE1FEE1645E3C24F6F6EF3F455529BACEC4D3C34262A03776729D8A0980C35B7399CFAD03A69B9CB282CCC25DEC289DAEF5FB7E44D0BD91003A8CAEA03D69851AB77B8BBAE3FF198C375829A53763E495653F3873F42A794641FB6A5E336F13DB42C9F68A8D66D9ABE42FA10615929EFA000EF4F91F0D03C5078D6F671ED11DE810D2A703305C3CD220EF0819FAFBCBD489115AEC11BD71F646FD5026EAE15662C841A212F07F29F0355CAD807A8825437BBDF5CB567DB2C6241E51F575D445"],
+        @[@"2", @"388404A51A6EDE211A13C64A6B8205CB52FD92A13AD9F1DA0CCF79FA3766C06F", @"92F1B7E776683D61AE4169AA4C809665AF5E2E6D170E21D2B17E8CAFF5BEDDEB97339C1EF5C13D702AE73F9CE17234227897CFFB31B3C978FE1C89F16112F4C74570CB856D693A1FCCF0297B1131F5B0FF60BBBA0512416647DB03255909AF73FC930394352FC74C6DA399CFD4FF8CF5965F47C8E2EBF9C2CA7A570DEE03F149248B023C6B0B49449490B697A0DBC4099205BAF6BC2C5E3F1FF8B64C4E4A5C6BCB0F5B4E64312394295AFF85C1DEC1ACBFA17B8614C001633B518EA9ACD2D132728E7CFA0496EA7ACCE86F5F9D4099DBF6F1F4CA22A01300DFF875969CB84A8565FAD885807A837B193914D7E0FCF4C13EC432CFFF029C3B15E5628D78550245FCCD93924716374029445345BE9FEBA5928FB4FE1B92237BE69E2C103420D1FB6490CFC14D7D1540CCD44BB5CC55D4FEE2BC2A2DAA4943CF8ED7587AB518BD039B16D1A72A184C67D15A39E4772FFA01657F8BDB0B02E76464309FC4939B73A92D529F0E2710BBE9A535D35051BFF3F4699635DA163B38A512CE29A28DC32DEF"],
+        @[@"EAC5140433F2254D05EC97716E9C3CC099CE61D4A752AEB32128AE588E6EC77933DC7D66CEA3B3D48F4A45FDE781BD80501E54F77003AB912B59EAB9C7B132FB8DB0615C531530E25F75DF46F69CC746BA1B3E2A1EE9BB4942A50309573504E4E56640387B701ADAE5F921DC95E8224F0360792249356B8BDA6E9531A4991689FF56C27AC7DC55ACD676886B5EABBB610B34835569EFE0445D7575010F8B8B0EE24D89A929DE55FF54DE6BB2892613945A97E9C486CA08E33F7DE54E09705DEBBDE694E6C4E9E618C751CA5077DDE5D174CE95FA989DDED81BC3262433830FF069A3D62D8CBC45540D0FA484ED89566158EB5CF0893AC8A4FDEFC83072D720DC7AF60906B34F5AC05EFF454B889BADE08609D10F4399B340887B70FB5290D7CC86E0D3392F2DFA8E2C3FD9B5DA8695608F6670D2002312889F8283F1125ABE993B91D26ABECCF8EB0BD2A0E5583546E89CB6BA9CD9CD24784FA86A620228FB3DB9CDA8779AA062A572028BCB38D1B3D4876D70603A94D98A3C43EC3F6BE77C24", @"B4249B4EC5FEF437007F023850B50CD7237C375D1110E74D53D38CBEBA09E26F2D7EBDF27CB12A7C302CB580E2C157053E8F624F9F4A9CF31D29B1D83294475F", @"D0D7392B0E7CFEF5004AB59392461E126483D8EC3A46A070D92F2795223DF80164B410E96E711BE60AF9E47C0BF470B1266A604FE293143BFE7A31E929AAFA80F14BA9F1505D117F3988D596F50C9EAE925F0E9B6B5B57803B0F03C9E9FCC4F40540C5A258CC3C1B66D8FA0BC6538D736FA1D8E860E569D347175F2967E5E6750BADD6EFA23EC5042AA816FFFFDF7E00B02F4B6105A08418C48DE8DF4EC7042F23BC8F20C18483AA02AC7F9BF6C5760F577086C46EE3C3FC4EC87DC561AAA3C66CAE1BDC4037813DAFFDCA66FCF85F1F71E5102E2EBE0D5A1D530DF3524AE2E6B2AECE979B17342094CD61E5696C5874B5EDA4E98991D8930E4F330D5A9F3F3BC3CED42F1CC87EE9B2014D66416AFAB5269958AF0177BF6570639754A3FE437C4B71853441B0B963CECB38926D02EF7422BD6BEC1998A4E04C5990017528ECBF5D0C0FABBB4ADAEA3BFD87E7185C386CE0AEBDCB0D9166C317A2EE9866D01A0E4C1DF3D182ED2B28D0C965111912EAD389010AC14563528EB7F8517DB4958140"],
+        @[@"1204528EB67C0AE6A8BF678A81BE8FBF4DF20EED3CAAE059D3913105257865377DB7C53333D019DB8F8066103FF5CF8CE7DD792388597D5BEBAE611027C648A47D0DD7B0DDF08B6D71F17DB0E74D3CCE2AB6F2B20F6F0EFA1D6F0B443553E8B260BF623EB0EDAB21DF28D1C6750D94A0C38652D3F560CD13CFD857042B40B68CFF18CAAF0675D0E59DA1AB13AF3FB372C60545BB6613CE35EB263A1766F0A365096D150FE2E5F47F879F9236DE45A8A44BEE60B1012EE6EC542003BA11A6201A133529F51A1D75A1BC07D79A4D803F986E9F496FCD2F5B22505FDC6105FC7B1931A40E4CC183ED7D8BC517D8455670B3F5B922C3E87DE538DCC199E2BE14FBEFB8093B798D29F618EE0EF0336460E65A19081D0185023A62C3D34481E83F71A048AC1AD5D510EDC31EDDF6833DDCDD56E4FA586AFC92CCBF6510414D4FB2EE975E086D34185AF73738EEBA75CA97CCAF9124198DB6E54C1BF58D69443F57DB9E5F48D277A3C9AEDBB7685082FF1C3190404A1DF62F6A1224F77B6837D243D531", @"8CA7A82F70570A28BF5AAABF77DB4FB7256DAE54D7C078CE3BE0050D23DA3EAF81E6DEF23DE81AFD43C4BCBA9F0B71C4781F184FDF901E1A70232793FE65437F", @"321040A5A93DB03186248271165FC69B123CCDC965B589BF3E594F600A94BD3D313DC4C3C91FF0C34B879342DD730F8291C33711620DF8A453A78FAA439C36367E742ED203E92792BA369CE4FE038F22D069543C63BEAED74DBA4C02CEEBC93EBDFE27D89F51DBAB1DAD7772A25BFE7B8A2E52D0A6E65CA55C6E3FDBE33430180B75B2762DC0FA158059FF6544AA2BD1212614FF9D398E62DDDA6DEFC1674A5A2381DD3DBB24B40989082E0810F7DE6555E59C596717E5A06F128CB261764B66E59198FC6110EAAD0E4287741345B79A16783FF01FD7973B826A5AF0ED452F5D3FA459595E3C4658196F0072A7020ACE41138253A9724D8CE7A378EB8FE1CAE97E93147C07C59D4C5A57521B9DEB2BEB124EF9C2415A11068C14B76E1304AA7E188CB9D47F5777167BBEF1C792B633FBEF7F8CB1D8AA56649684FA6BDA0EDAF6D33CF3ECC58B6C9FB8E7814B54C8A5530CDED0065335DC304EFDE2BA449A89E80CFA9717053398B8AE0427C8E3BFC1BBE8FE5C2C88BBB119FF7D6892B048F98E"],
+        @[@"4C2171890A8B864D4F4207EE4E78B2C698CA16775A3492CA57B95E551FA1D56BC246F4CCD27B1921BD20100B99C2D2318DE8A8E71C3AB273F410C913B19E7E73E47240B6ED59D8AB7AE8B613AA88443770EC1F8C27D1001BE1C92E9267AC054B1E45020C9FDAB719C26D2C6CF670A4665CC3F38394F39E75BCCC0723780C6E975270A3F14A5A0A0CC73679BDA61D2402E01786740A24E9C6F1F0E969FC57004EC8A33F12FD491FC57F988225B5A62895BDAE09C7D2F28DC3E2762DDECE2D2D96D16CA8CEB6C793355F165B14BC83A97A31B24103A4CFC78645F465132192A9F2FE52C1B41954EA796A458D27C837A1F9E9E2FC8EB1C314F7B7790AD90BB4CB0A068CBE1FE1A8984BED2672B55D13AE46F6ABD4A76EE99E2662A9FF6E5DCA786357368238DF1B83CC41F6829E0930E4FFDBB9A74AA2457004EE6F724B39EAAE902131C8004C4CCC8D424E2B4B7F0F4B5AC8F2A46A37146F2683E171BDCC204DED5116ED9D62B92AA40855EF87643AE12D2C8697649A068A1EE8FBDBB41B28A16C", @"3E8E09A04733444F8834D6ED6EB81A9B3EB1FFD8B889F6A084D154A0FAF50C388316D9CA491D1AD251F0BFC0A8D95BE68A5ABF42E3B5E267873607812B14B9AE", @"E608C89FF4C9EB14CE96A257B9EC2940376A25327F72A43B18D97069BD969D4E1D4C42FD2538CBD78D2651F5DEE0CB4893ACEF5A3BB528E9D1A30EC168D80BD58E0DBD84A03379055C02516AA4178A39FB65402F547D54E730292A0D51BF83F69828A69F2F798802C4DFAC66ACD65A1D9746538D41146B8065B3FB360D2F2BF7A9392EE69B190E8786FDDDC178441EE7005312953B33AA71E2EB480368AAAE4829E36B2387DDE51EBAB21CA1127B1E2BF18C1316239C42C98792C792D66898CE26A0762A4409CAF53ACE6E9C5977133DCB4E7728C608FD470D8F0D0B87B9D3AB7C1EF69665381B98E43FF8737B43DCEEC525D6EDEDBAED8B7CE0D8B0948FA1BACAFAEA8D092575A69694AE5CA8C9D2A2EE1B81D04AC29167BE5EBCB4D5CF273582E6917510D793FF84B1A4DA01D7EC1348A81C810BC5B48F867D01DDD01F63C6DE3E2FDB005791906E00B0E476995D665CFB4B6E3E7CF88287398AC8FBD0C6A6F9276D1F5AE1AF98A4D90AC8E0F5A550E3B50350B2E29538F0D24844620F8761"],
+        @[@"2A927973B09345018304C12CDD1C126876D1AA59878DC10EC3C88FEFDC489D06DB167A8BA9BF8C2DC44E59A16A6B09E13DB43AC441FBD204C461F3A0A991A784A7210F51E09C7EA4EAD74654424F357F037043446B15492F763CD020CD77A47598B4C67850441D3A1B638E5DB2C4DDB63420FA9F3643CFAC809FCC4D1671C2AE25882675CC43AFE7A63D455901220F354209D5784DA425CD43F11A5962DD0787652DFC3271AB1917E95E70EA807F20C389F53BD69960A3DC52BD35B49A3C3C00693832DAE44BF2CDAA62B72AE2D7ED6BCC29416589E441DBA176903CB2CC3C1C046EF6E8B9E8B5634B6D8E2D447B9811A4D9762EBDB8095E2E999AE165D6FD6A44F352FEDC08612775EF54B96BECCA0FC5413D82F947E027E07B08465105B096F90294D50AF5FC7FE55039503C035F01449D833DE46365C4DE6D0A3073BAC66CBD5A41C74F3D47348D8084C983E4CAC8814D0565B06A298FD834BF4BEE85B7ABDFF8732E35BA63C23AE78BBDCB55854CA28BB152F5DBE1CD0FA018FD25CFA904", @"C71C33FCD696BE107D49CD499E539540DE4793D32274A13115B92E3A89D73F50F3724DC9080BD98555A7CEF3FA6434D8ABC7ABCD3B4CFE50062C8B8F04CADFF7", @"3D4509EAAF9BBC3F50B09FCF21FB795FAC522061D6AC5888E601FC992366D2A42A70E4B167FEA4B407D887F586B58D790FC646DF664C218E7950CAAE87C96516261FC93CE880E3BBA3E13266407582BC540161DB05AA60D3D21429F781E51048F6E71F738934870DDF35E6D2301C5F6F5A62C4BEAD31A6DBBF8861DDE670046AE0178FC063F38E06B5045DC4710237425E8948992E76556C770DF9FF47E3914FBE905BA04EA8A6779568A83D5B0B06B6AE27364B8AAD005F678B3B7A97FD1D8211A0F7E925ED56B14CE578A42F120BD6CEF0A4FF0A8F4DB022E73E1BC871ACB451D54573E7C97C77F8A6765C6BCADA167B9326AE4EEC6D80F12FF496A950EBD76020FDFFF01E10086B3E23AFBB76285AD809CC19E231E70E877FA1EC1346264B1D82BA6F26AC8F712493E3A9DF32993F2482020D529FA626A705B66CC989F551A2A75ADF7716D0A31E6214AC7DB853FD5508EB5F4F6CD337E2F493EE89D87DFB884029C977147323771B1DDA09929515E9B20E537F1B8B7C63DD47493CB4CA97"]
+    ];
+}
+
+// a, b, a * b, generated with the 28-bit digit build
+static NSArray<NSArray<NSString *> *> *AWSJKBigIntegerTestsMulVectors(void) {
+    return @[
+        @[@"3C2CC144389AC98D4198803BFCB413A77BBF74B70B7207119E92A0A25C809A98AC5BDCE4F5A671373EF2723AA686E1224555D950C7E06265730208CF82A2682FFD4413F2EA852928779C621D22433F679818B75FF919C56C1CCD3B9E6FA3CD6CE8E15ED26688FBDD245DFA46A13AAD395264994B7E5EB79A2BF3389A9606067EE764514DEC4C2A10A924564A5E0384B1681DFCE67BB480A6A7B8403DBE46BCA5AA0DF297591CA70241FE4D9F01D15069EE4D4F6901CF0FA8884FE54695A1EC3FAEDED607FB7E0A3C7C57DB7D282CE71679367F7A068E228EDD07D472A9C0B1579F885F9A0669D682C0B1FFE8DDE6FE561D7DD0230BF2B1E8FA855AA3460BFAE593597F99C2551B82061B6AE401683A1EE50B41F0FDF2D8F778329ABE3E95A3D1EE226BB17786337DA19E61A3069CC1ECA703DCA4F5B59C6DE7362B25CBCEF7BAF0626B67E89EE58A3C462D43E2EE2F89F10B2EE7C0CA54A80080CDCC4EC4863F26F1A60F8F8B99CCD2C60FB4B43E3EA6496C8D0A36E1B236617F02B04488EF6A", @"799579092112D5F3D8E4A78D22E5336B51C07587A127BE03A7C0B3EB49A255C237CFCB58E1A04BBA84F347A6D87A122A3A87B1DBAF6FDE563091417933963B6B6507C347A70F012C0248D2DAC2E404FC6CB6D71B25B6715547B2CE7B480AE6AE11A9F5B8B8F6E4BA3EB795009B99FC074FD322758993CAD145994C8EA3323CB4DB316C9427514E6508E365A37D61ABCC34CD41BE610C8FA6A5DB34480D70FCE8A1687CC8B9CB2DC1AE92652BF310F828DD39E63E4575E5EA5019325D8A2E452B97C2F4508D21123BB47767A7875FCF6498B5A3DE2A88C87AA1FBD72B291D57C0DF4B116C6C23A7209A0EC8216D9785064D28E477B0ACF252A7C97DD1E6D491C51FA2318CC5D9AC5FE77480550C065B592E3FD0DFEBC231938CAE647283F538A298692E5D42DBBD2A4F3D7F5B43DAB47219855104478297D330FB46B3F17E5689E784E62A5FA354AFE1D30A24ADBF96C644E7CA8B69625F9A5DA54D4E23A3D70A28BE3487618836425B41670800FDCE44E599CF4EFB2EE858D336A7F6D97E0101", @"1C9449D9082857DC2A49C45F55C9F5C56DB13358D1F4A92620A9C59DF993583EA28A043390CEF7DEAC4B7CCA9963F7595A7F259613430A7BF07FF74CCB5FA34E74599402D666A797809B83C49C89365756F17FA278D18EC1173145752880F64C2FAD15540B495578F4431F5C7CD3F57E7830E640CECCE28F2D773A054858848DBAAB3E3EDF41CADB6389B152D5D724DE9812D9CAF174941ED317D8DB8421A0625FD18D1E130782447062D34885E311205F709C422B49DCB99F41A2B8AD101DC86E639E623603C2F1AFFB41CA99A8AEA4909A3CF2F7D8D15ED862A3718EF4B2CF62D2CAA33F500ADC897D376EEB930B5FDD1D769C8F15A2D8AE97B5E6A0CA06BDC8F7533B2A27E888D1CED3AD76FA4BCDF5BBCAFC7B9701D6419E93F4248CC03EE921CFE29D9BCE65184352334346B9CF83850EB233201A1659F6980D77558FC31A967C1D3873EE231A9569034F9826D323DA6A48D6B3314B46DD0AAD959B7A41F05EE9B7C120480F585431497E3DB6B23FDC75EA9CF07B3E344E8D8BFA4621C22D6A90143B4FC735AA3E65AAF7EF9CF4DA6CEE5904543A3D94CAA6925E425FC5FF64F5F047FE5B9AAAFF5ECAEC98BCF77DA349443675CC37B9D221A4DCDD042295196AF978E73A6677996631935A73BC1497937EE21B463B2C326B9C64C097039B6BD9013A88B2C6E1CE9E8C69B9193FFC9E82536A4882DDB31BBD9DC5E33A375F453E2AF6F844099BAD6DF87B0FAA5C6E0182114A86417F895C5EEF1A5026BD80C77EDDFBE1D3BD3F40F49F10CEA4966269906E6A1EA28AD849F4CA30F8B9983B63A2F9B4A093E08B2A73EC9F928B53B75C1792F6AF1F9C8B4F62D16BB9081BBE8F83EDB222C99E92BD3B18DFC99123186C45E674D9D4D213C1A42F46CE5C2340EFDE9CA452137DA4B93BBA53542532A0558329FF81AC37942B1990890552C3ABAA0FF3603660BA20CA9135ECB7E1B02A767CCF3212C91FE388A9CEC06D2A64A5EF302968543424DA83B1894BF3D6D379DCD60DEA16444A6761929801BB97145D9C25365F9CB96763D156D9B60A1FD19C1DCA9BE78BCF20AB7BB7277DA4596A"],
+        @[@"3C35899EBEBFE0190047220045F0442A891478844261DD1697840C70020D723F43FBDD01BABD1ABB053CBB4A2D0074B614EC3B564D186CE49C79559E86C7DDC9C2BACA7C78E5377D21F3C74EF33B050727405D7558CA59F443AE92C9757093372A5DB4A242EB1F64DEE6B2D121B7D849F736BE4F00174343C6D60C3B469F7370FD27133F1232A3F11956C23A0D9B8305D14154D15998141F6E205AB4C0CD24BDF437FC076AA0F883F6BABD0355410826825DF7DBF50BFA632C5517EC223BA91773A51EDD4516603BD01D3F265E474CE1A444BC994FB7FC7B0C13672E4F1045C2B6639FFB79FF374A1C76707BBDBC5C620018FB50CFF8CBDB0B330A5A434F1CF9B3BBF52CBA2C76D7A2E6525FA3AEC1A3C6BDF396B5BF71C0F27B1B35CB372F7EF324AAAD502184F207D651AA84134E4BD041E185005245F2CE6028999857178B7BC138CBE2BDBDEA930E941821E263F12444762496BC17641C3FFDB496143F11D678DCB83599A2C8A737E0C91943BA3D8731621EED798209B880BE4E94FD5F6A", @"753B23AAD4C5737BFC53441697FF531E30B53C1D2EBF26E63FE434D3E2933E57CE6102A226751E23C862395F618C7E9142BAAE7079D557B8B98B8C9B1FCAF3ED2BF590516AAE743210AD92723A10037CCAB2EC448743FC40CF88DCEE52CFDB7DC46BCF2E1943602AF1F29C2B029FA7CD519311D8D70D19A696F594E8C46F6688DB35B6F478161E6909BA940B5A3BD8ABCFE984A6F79D4C8D92E075564FDBDE2A10941F89AA3DF2B3F887BF52C297FD91818137781E8305B0637A06B356E4DD6678FCEF233AE2D6326995842B2D81BDAE03F42621782BD2DBA5D88EFBBD6C6235685158A2332FD49CC458C8F1DA859FDD79C5FEF1F0D0CD96A95B9166C7F39B3045F4D27823A715E7FFDDD9D96278B6DB3EB5CD2E859AC42EF55694BD4930ED8E24BF0747661C2E66F9073F5B80F636BEAB03EC309DB15F9307F35050233DDF47FCE68E6302BDC9FBC4085644FE8C02A990EFDA2DA039C0A72C10F7504DD6974ABC26ADBEE376B9A77E0FEC7D9CEE262CDD00597D391A24662A1CB678F24DC2AF", @"1B92609FC42C85768CF5359C4961E978B948BAFB7CCF6FCC02047514AE33625C9E6B398DEF940A25E28155F82169ED31DD71F03B138EFC0FF9419B45EAF1FE562E83B080FD437CBA05D8A89A6F9031B204139F3D7644CF872658C64A33AC9F95B8D381E675A355EB097FC3B1A7B9223712E06353B6A1DB3CE67ECF4A9BF1443D9B359F21AF6301C38B60FEF9609E2D4BA1E09DC335D441526F99566CF29F028843CB76985867B159AF95607B7E7BA39DBE6F74CDC3AA1F5F602CB461472CB6755C8124A5999B6500AAF1A8BBC4D15CD07BF0DC70CE4D9C6279ED0D4166ACBBC4F37706F64B4AA5085CB472E879463ACECD5D0D09781ED974A2083DE21C3BC85CF791237384C4643E880B6DA7CB62053BBE1BE0348E6377DF6FA0C009C623E50FD1B5E6D4B502D9E5F70EBF77304FA10F456758EF15B8875328BEA1ED1A9C525D7B21274F990708B450FAB0774207E56CDFBBD360B6D79D12B79FD9C70B23EAB612DEE1E35BA2BFF26E41DA9D70976CC798F13B86977BFFCFB66A1D978275A0C12C79E7496CC343C8353482F3C67FEA5C9B55B170FF52BDFFC866D4FB180F23235FC78471A1A655E011447579BE6CBC6CF1AB23819FB05766AD683066EA9D324FC784BC232714BE0F561A9F9D9142DB6C2B112BE107507F23D64A39B5CCA7AC9C93D0373F7FC90245322DFD2742F268055A5914797C38BC74D0B4216996C8DBC065DF32ADB7A20FF5090B764DA5FB11D9484272C574FDB5EEF9E8EDAD2989C7517139DCD01E4D2DFAA1FF7AF718D7128D3AD1BA4B09A091E2B7A18EB3142488E3FA31104835DD7FD31D9B3061A249C745EF6E301B474A85689A22304E857B0D25C52AF795E1D899BE6D0AEBDB0782453C537E7107897CD58121FE4ADA663DA5C3ED4C6B12AD9B114EF6AC35DE8C94655671AD53C04D0EF6F5C74C538B347F0AAA61B1500D56522A9A24FF7C43B3BD961ECE454C34118C662C33389B5F08843E3115E52E5C4CB388A85AF273B4D881B0730B8036A1D75657BE2479FDD35309493780C0552705B33B13CC64D6C457A8DE17E4BED59AB9C3517202E60EB7C2648D76"],
+        @[@"736F6D56E527FE6336EAE0D2D807FEB6075833417258A79C745D1466AAD6151E4583742AAA728EE05C6EB33575B1EB7D091EBE7B766518EAC22C516C03668A48E9FF7393710174CE6F2703E5D8EE62E20C205D8385756D47A2BEB3A5253EED0E3D60A2AE61167CD13D7FB6156D18F77A3855FDBDCA6A046C29B7114EF5FF5C325FFEE1C1145D9251DD48674A605EC498B3C1557E2C59EA5510FCA306FBFF385AFE191B1277AD6454F5CB9E552963EDDD24425B509B45A5AC4148B23C48EA974604B2587B60BCCF55876DABB1D0988EF5DBE945762EEB227033D4AC7BBF43C1C3F61A3E56D60DAB5E7A560F4BEF9D40CA868540B4706324A437D11FF614E1B90AFBF760D1040C2F7F623ECA51DB0A1B618F5C1600BF3AA4F60BC3ED20A4A62A9F9E8B71A297A021F9DFEB4BBAF5661C85C23285816C297878EC6598910BC230A94DA14CE4426DDE215929DB4E8FF7D3522958D396814B0E6EB0A6FFBC682F65B6D1B19A131F783478A10FC631079A8330F256C674A2D4E2527AE10EE3107499E1", @"2533F444AC28BC4D38837E3F1D016F0F583683FA0A654C85465B6857CF0138F4", @"10C6882582DF88031FA0116FAF0E986D4FE8439FA018C965A47CA30437819BE6E9BE0F3007B5744E5BAA0314FDE0A928C3C0933304A80D9A72FB75E619EBFAA170925473754D1C0257D93F44321FDDD629BEE63C88B58674EE96323456C85C2333C378CE346270F16FDC30C1236243D62C06737E1F4A0A21CF0EC6542822F38E2E2FF34478A167B76FC8664115392E4B4FED495A0493F7DBB9BFA32DE61ADFA25306176330DB346EC7C897498E4AED5A1D2856B24D621B5DD248F58F7DDA0D7B58000A4D2CEBB1378E006C5247B6191AF00F3FACA82BF147EE9722ABD0293C8B9E9E0F08AACD62D25FFD9E41B66B19794064AC4BBA2F1C32F32A4869617EF380FD62DEF16727C58F282408B3E07012FAD1355EA6A73552706856CBFCCD6C48FF86E31407EA51436423C8F02B2242E7E7E551768EF3FEF3AADCEDD2D8EFD6ABB9C1676EAC8629BC505B159D54F1FB1520070F2441B8FEEE700762ABFE47A8356B07EDA460D7EFCEC208A043B086CF2859BE4F3040B54D2FF78E2A2A93B5EC8568B971403DB697940647E1F0C176B9FA5CCF17AE3C93DEFEAE3213E85DB9ACE274"],
+        @[@"342D39E055F52E8D78ACCC95AE3CA5067228007C8E4C01D4A7692B766A646B9F91A47FE699AD74125A40A7087C4C0EEE750E6B035A6CD702D603784067E3DFF8875FDE210C52336693DA6E0F277CFE9C8A699FE5D576E7AB795FECE043CBD8CA2AB7EB37091E9D9CF90CAC2088AABC13135BF8E8D1DF944B3E802B814B044C76BB37ADC4564A614F560D6FDFB72BF2CA86EAB257C946A207C6CE8912D2D5888D0C3551627FB2B1D6BF20B5764BA740D191F3295A39CB610099EA126BBF9AF8CCCF4A2E4EFCE024BC00D9324C80731D1166466B9F12CD9FABB7B117774B0F431A59716956518D125267449EE7B7BBF91D0264BD14315CBFE90ED66059E6A3743F14DD95666AA7B8D1EC56B9A311B2C113167E2748DAE731E8BD9142A334B6E3489378AEFD2066CF0CBC88AFCE3A70E150EE0998C9F0C9B1AD5AF3518EA934D73CAC853ACCEC09D8A8918876CBF8581BE761B4B0517D61FED8554F66FE833D3B30C375FCAF7ED5570F5DCEDA5526F53C87A9ECD8274ED6FFA32665A1A9A3DCD966", @"51D615CFAB6CDE083AB85D60AE9AE75786BF7ED4967D77BCE3196586F53FEC47", @"10ADF19065FC082075250235225EDBAD85BD2706281EB60ED3944D1B1675788CE6330F02382B5746BA5CAD59BCD28F116506D5118E54830F097DB739B64B71C8F6F12B0516EB7F865AF7B3DB553C76A71D80C540B92E4A048A80CD8D140CC797BC5BA5565E04A8E7F6DF6F379CC70F9AE1546BE107E7D7FDEA3869C1932AF693393E031E5B0029E1A1C8E0B4A861B5F0477D204FC155FFE9F1CB84D081FFAE9B55F92FF7BA8F7499B113220AF80E5E65BC14B07719AC82245B1E844FC322992B119A4D463EF1A89C120CB56C5E9EA7C666BD7C90CDE4CD12C52F77B74B2359859A7CA97B0DEB8A90D26627D123B58161557DFE20DB0BB29CD912A537A0A20BB922F7837D2893330F05CA66C09AC765D2C6E5A18595701D8E59B758B4014D3FC1B18651CB06600EBE6909D11037D5D07E75638678930B613F63B51C4235F7C0E0B14B78BCC4B172E650950F2D6049F373883B656BB7C9BAAFC1CEF5E7054C65B1A55900A062FC9173DDEACA385046658D4833AF7B318F6394D44E03D92275A29B8A12F69D36C10D15557DC1C6875C5A28C5139F67701577100E1EF1E828C4534A"]
+    ];
+}
+
+@interface AWSJKBigIntegerTests : XCTestCase
+
+@end
+
+@implementation AWSJKBigIntegerTests
+
+- (void)testDigitSize {
+#if defined(__x86_64__) || defined(__aarch64__) || defined(__arm64__)
+    XCTAssertEqual(60, AWS_DIGIT_BIT);
+#endif
+    AWSJKBigInteger *N = [[AWSJKBigInteger alloc] initWithString:AWSJKBigIntegerTestsNHex andRadix:16];
+    NSLog(@"%d bit digits, SRP modulus is %d digits", AWS_DIGIT_BIT, [N value]->used);
+}
+
+- (void)testExptmodMatchesReferenceVectors {
+    AWSJKBigInteger *N = [[AWSJKBigInteger alloc] initWithString:AWSJKBigIntegerTestsNHex andRadix:16];
+    for (NSArray<NSString *> *vector in AWSJKBigIntegerTestsExptmodVectors()) {
+        AWSJKBigInteger *base = [[AWSJKBigInteger alloc] initWithString:vector[0] andRadix:16];
+        AWSJKBigInteger *exponent = [[AWSJKBigInteger alloc] initWithString:vector[1] andRadix:16];
+        XCTAssertEqualObjects(vector[2], [[base pow:exponent andMod:N] stringValueWithRadix:16]);
+    }
+}
+
+- (void)testMulMatchesReferenceVectors {
+    for (NSArray<NSString *> *vector in AWSJKBigIntegerTestsMulVectors()) {
+        AWSJKBigInteger *a = [[AWSJKBigInteger alloc] initWithString:vector[0] andRadix:16];
+        AWSJKBigInteger *b = [[AWSJKBigInteger alloc] initWithString:vector[1] andRadix:16];
+        XCTAssertEqualObjects(vector[2], [[a multiply:b] stringValueWithRadix:16]);
+        if ([vector[0] isEqualToString:vector[1]] == NO) {
+            XCTAssertEqualObjects(vector[2], [[b multiply:a] stringValueWithRadix:16]);
+        }
+    }
+}
+
+/**
+ Measures where Karatsuba overtakes the comba kernels on this device and reports it next to
+ AWS_KARATSUBA_MUL_CUTOFF and AWS_KARATSUBA_SQR_CUTOFF, which tommath.c only sets from a
+ measurement on x86-64. The crossover is the first size from which Karatsuba stays faster.
+ */
+- (void)testKaratsubaCutoffs {
+    int cutoffs[2] = {AWS_KARATSUBA_MUL_CUTOFF, AWS_KARATSUBA_SQR_CUTOFF};
+    aws_mp_int a, b, c;
+    aws_mp_init_multi(&a, &b, &c, NULL);
+    
+    for (int square = 0; square < 2; square++) {
+        int crossover = 0;
+        int streak = 0;
+        for (int digits = 16; digits <= 256 && streak < 4; digits += 8) {
+            aws_mp_rand(&a, digits);
+            aws_mp_rand(&b, digits);
+            // the best of a few runs, so a stray scheduling delay doesn't decide the comparison
+            NSTimeInterval times[2] = {DBL_MAX, DBL_MAX};
+            for (int run = 0; run < 3; run++) {
+                for (int karatsuba = 0; karatsuba < 2; karatsuba++) {
+                    AWS_KARATSUBA_MUL_CUTOFF = AWS_KARATSUBA_SQR_CUTOFF = karatsuba ? digits : INT_MAX;
+                    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+                    for (int i = 0; i < 200; i++) {
+                        if (square) {
+                            aws_mp_sqr(&a, &c);
+                        } else {
+                            aws_mp_mul(&a, &b, &c);
+                        }
+                    }
+                    times[karatsuba] = MIN(times[karatsuba], CFAbsoluteTimeGetCurrent() - start);
+                }
+            }
+            if (times[1] < times[0] * 0.97) {
+                if (streak == 0) {
+                    crossover = digits;
+                }
+                streak++;
+            } else {
+                streak = 0;
+            }
+        }
+        AWS_KARATSUBA_MUL_CUTOFF = cutoffs[0];
+        AWS_KARATSUBA_SQR_CUTOFF = cutoffs[1];
+        NSLog(@"Karatsuba %@ with %d bit digits: measured crossover %@, compiled-in cutoff %d digits",
+              square ? @"sqr" : @"mul", AWS_DIGIT_BIT,
+              streak >= 4 ? [NSString stringWithFormat:@"%d digits", crossover] : @"above 256 digits",
+              cutoffs[square]);
+    }
+    
+    aws_mp_clear_multi(&a, &b, &c, NULL);
+}
+
+@end
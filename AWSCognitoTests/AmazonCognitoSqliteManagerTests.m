@@ -19,6 +19,106 @@
 #import <AWSCore/AWSCore.h>
 #import "AWSCognito.h"
 #import "AWSCognitoConflict_Internal.h"
+#import "AWSCognitoConstants.h"
+#import <sqlite3.h>
+
+@interface AWSCognito()
+
+@property (nonatomic, strong) AWSCognitoSQLiteManager *sqliteManager;
+@property (nonatomic, strong) AWSCognitoSync *cognitoService;
+
+@end
+
+@interface AWSCognitoSQLiteManager()
+
+@property (nonatomic, readonly) sqlite3 *sqlite;
+@property (nonatomic, strong) dispatch_queue_t dispatchQueue;
+
+@end
+
+/**
+ * Stands in for the Cognito Sync service with a fixed round trip latency.
+ * Every dataset has recordCount records, served pageSize at a time.
+ */
+@interface AWSCognitoSyncStub : NSObject <AWSCredentialsProvider>
+
+@property (nonatomic, strong) AWSServiceConfiguration *configuration;
+@property (nonatomic, strong) NSString *identityPoolId;
+@property (nonatomic, strong) NSString *identityId;
+@property (nonatomic, assign) NSTimeInterval latency;
+@property (nonatomic, assign) NSInteger recordCount;
+@property (nonatomic, assign) NSInteger pageSize;
+
+@end
+
+@implementation AWSCognitoSyncStub
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _configuration = [[AWSServiceConfiguration alloc] initWithRegion:AWSRegionUSEast1 credentialsProvider:self];
+        _identityPoolId = @"us-east-1:stub";
+        _identityId = @"us-east-1:stub-identity";
+    }
+    return self;
+}
+
+- (AWSTask<AWSCredentials *> *)credentials {
+    return [AWSTask taskWithResult:nil];
+}
+
+- (void)invalidateCachedTemporaryCredentials {
+}
+
+- (AWSTask<AWSCognitoSyncListRecordsResponse *> *)listRecords:(AWSCognitoSyncListRecordsRequest *)request {
+    NSInteger start = [request.nextToken integerValue];
+    NSInteger end = MIN(start + self.pageSize, self.recordCount);
+    
+    AWSCognitoSyncListRecordsResponse *response = [AWSCognitoSyncListRecordsResponse new];
+    response.datasetExists = @YES;
+    response.datasetSyncCount = @1;
+    response.lastModifiedBy = @"remote";
+    response.syncSessionToken = @"session";
+    response.nextToken = end < self.recordCount ? [NSString stringWithFormat:@"%ld", (long)end] : nil;
+    NSMutableArray *records = [NSMutableArray arrayWithCapacity:end - start];
+    for (NSInteger i = start; i < end; i++) {
+        AWSCognitoSyncRecord *record = [AWSCognitoSyncRecord new];
+        record.key = [NSString stringWithFormat:@"key%ld", (long)i];
+        record.value = @"on";
+        record.syncCount = @1;
+        record.lastModifiedBy = @"remote";
+        record.lastModifiedDate = [NSDate date];
+        [records addObject:record];
+    }
+    response.records = records;
+    
+    return [self respondWith:response];
+}
+
+- (AWSTask<AWSCognitoSyncUpdateRecordsResponse *> *)updateRecords:(AWSCognitoSyncUpdateRecordsRequest *)request {
+    AWSCognitoSyncUpdateRecordsResponse *response = [AWSCognitoSyncUpdateRecordsResponse new];
+    NSMutableArray *records = [NSMutableArray arrayWithCapacity:request.recordPatches.count];
+    for (AWSCognitoSyncRecordPatch *patch in request.recordPatches) {
+        AWSCognitoSyncRecord *record = [AWSCognitoSyncRecord new];
+        record.key = patch.key;
+        record.value = patch.value;
+        record.syncCount = @([patch.syncCount longLongValue] + 1);
+        record.lastModifiedBy = @"remote";
+        record.lastModifiedDate = [NSDate date];
+        [records addObject:record];
+    }
+    response.records = records;
+    return [self respondWith:response];
+}
+
+- (AWSTask *)respondWith:(id)response {
+    AWSTaskCompletionSource *completion = [AWSTaskCompletionSource taskCompletionSource];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.latency * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        completion.result = response;
+    });
+    return completion.task;
+}
+
+@end
 
 @interface AmazonCognitoSqliteManagerTests : XCTestCase
 
@@ -233,4 +333,206 @@ NSString *const DatasetName = @"testDataset";
         XCTAssertTrue(reset.syncCount == 0, @"record sync count not reset");
     }
 }
+
+- (void)testUpdateWithRemoteChangesInsertsThenCompareAndSwaps {
+    NSError * error;
+    
+    AWSCognitoRecord *local = [[AWSCognitoRecord alloc] initWithId:@"wifi" data:[[AWSCognitoRecordValue alloc] initWithString:@"on"]];
+    local.lastModifiedBy = @"me";
+    local.syncCount = 1;
+    XCTAssertTrue([self.manager updateWithRemoteChanges:DatasetName
+                                           nonConflicts:@[[[AWSCognitoRecordTuple alloc] initWithLocalRecord:nil remoteRecord:local]]
+                                      resolvedConflicts:@[]
+                                                  error:&error], @"Insert failed [%@]", error);
+    
+    AWSCognitoRecord *stored = [[self.manager getRecordsByIds:@[@"wifi", @"missing"] datasetName:DatasetName error:&error] objectForKey:@"wifi"];
+    XCTAssertEqualObjects(@"on", stored.data.string);
+    XCTAssertNil([[self.manager getRecordsByIds:@[@"missing"] datasetName:DatasetName error:&error] objectForKey:@"missing"]);
+    
+    AWSCognitoRecord *remote = [[AWSCognitoRecord alloc] initWithId:@"wifi" data:[[AWSCognitoRecordValue alloc] initWithString:@"off"]];
+    remote.lastModifiedBy = @"you";
+    remote.syncCount = 2;
+    XCTAssertTrue([self.manager updateWithRemoteChanges:DatasetName
+                                           nonConflicts:@[[[AWSCognitoRecordTuple alloc] initWithLocalRecord:stored remoteRecord:remote]]
+                                      resolvedConflicts:@[]
+                                                  error:&error], @"Update failed [%@]", error);
+    XCTAssertEqualObjects(@"off", [self.manager getRecordById:@"wifi" datasetName:DatasetName error:&error].data.string);
+    
+    // The local state the remote change was based on is stale now, so the swap has to fail and roll back.
+    AWSCognitoRecord *stale = [[AWSCognitoRecord alloc] initWithId:@"wifi" data:[[AWSCognitoRecordValue alloc] initWithString:@"stale"]];
+    stale.lastModifiedBy = @"you";
+    stale.syncCount = 3;
+    error = nil;
+    XCTAssertFalse([self.manager updateWithRemoteChanges:DatasetName
+                                            nonConflicts:@[[[AWSCognitoRecordTuple alloc] initWithLocalRecord:stored remoteRecord:stale]]
+                                       resolvedConflicts:@[]
+                                                   error:&error]);
+    XCTAssertNotNil(error);
+    XCTAssertEqualObjects(@"off", [self.manager getRecordById:@"wifi" datasetName:DatasetName error:nil].data.string);
+}
+
+- (void)testSyncThroughput {
+    for (NSNumber *recordCount in @[@1000, @10000]) {
+        NSError * error;
+        [self.manager deleteDataset:DatasetName error:nil];
+        
+        NSMutableArray *recordIds = [NSMutableArray arrayWithCapacity:[recordCount integerValue]];
+        NSMutableArray *inserts = [NSMutableArray arrayWithCapacity:[recordCount integerValue]];
+        for (NSInteger i = 0; i < [recordCount integerValue]; i++) {
+            NSString *recordId = [NSString stringWithFormat:@"key%ld", (long)i];
+            AWSCognitoRecord *record = [[AWSCognitoRecord alloc] initWithId:recordId
+                                                                       data:[[AWSCognitoRecordValue alloc] initWithString:@"on"]];
+            record.lastModifiedBy = @"remote";
+            record.lastModified = [NSDate date];
+            record.syncCount = 1;
+            [recordIds addObject:recordId];
+            [inserts addObject:[[AWSCognitoRecordTuple alloc] initWithLocalRecord:nil remoteRecord:record]];
+        }
+        
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        XCTAssertTrue([self.manager updateWithRemoteChanges:DatasetName nonConflicts:inserts resolvedConflicts:@[] error:&error], @"Insert failed [%@]", error);
+        CFAbsoluteTime insertTime = CFAbsoluteTimeGetCurrent() - start;
+        
+        // A second pull overwrites every record, reading the local state first like AWSCognitoDataset does.
+        start = CFAbsoluteTimeGetCurrent();
+        NSDictionary *localRecords = [self.manager getRecordsByIds:recordIds datasetName:DatasetName error:&error];
+        NSMutableArray *updates = [NSMutableArray arrayWithCapacity:[recordCount integerValue]];
+        for (NSString *recordId in recordIds) {
+            AWSCognitoRecord *record = [[AWSCognitoRecord alloc] initWithId:recordId
+                                                                       data:[[AWSCognitoRecordValue alloc] initWithString:@"off"]];
+            record.lastModifiedBy = @"remote";
+            record.lastModified = [NSDate date];
+            record.syncCount = 2;
+            [updates addObject:[[AWSCognitoRecordTuple alloc] initWithLocalRecord:localRecords[recordId] remoteRecord:record]];
+        }
+        XCTAssertTrue([self.manager updateWithRemoteChanges:DatasetName nonConflicts:updates resolvedConflicts:@[] error:&error], @"Update failed [%@]", error);
+        CFAbsoluteTime updateTime = CFAbsoluteTimeGetCurrent() - start;
+        
+        NSLog(@"Synced %@ records: insert %.3f s, read and update %.3f s", recordCount, insertTime, updateTime);
+        XCTAssertEqualObjects(recordCount, [self.manager numRecords:DatasetName]);
+        XCTAssertEqualObjects(@"off", [self.manager getRecordById:[recordIds lastObject] datasetName:DatasetName error:&error].data.string);
+    }
+}
+
+- (void)testSynchronizeDatasetsWallTime {
+    AWSCognitoCredentialsProvider *credentialsProvider = [[AWSCognitoCredentialsProvider alloc] initWithRegionType:AWSRegionUSEast1
+                                                                                                    identityPoolId:@"us-east-1:stub"];
+    AWSServiceConfiguration *configuration = [[AWSServiceConfiguration alloc] initWithRegion:AWSRegionUSEast1
+                                                                         credentialsProvider:credentialsProvider];
+    [AWSCognito registerCognitoWithConfiguration:configuration forKey:@"testSynchronizeDatasetsWallTime"];
+    AWSCognito *cognito = [AWSCognito CognitoForKey:@"testSynchronizeDatasetsWallTime"];
+    
+    AWSCognitoSyncStub *stub = [AWSCognitoSyncStub new];
+    stub.latency = 0.05;
+    stub.recordCount = 250;
+    stub.pageSize = 100;
+    cognito.cognitoService = (AWSCognitoSync *)stub;
+    
+    NSMutableArray *datasetNames = [NSMutableArray new];
+    for (NSInteger i = 0; i < 20; i++) {
+        [datasetNames addObject:[NSString stringWithFormat:@"dataset%ld", (long)i]];
+    }
+    
+    for (NSNumber *concurrency in @[@1, @4]) {
+        [cognito wipe];
+        cognito.maxConcurrentDatasetSynchronizations = [concurrency unsignedIntegerValue];
+        
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        AWSTask *task = [cognito synchronizeDatasets:datasetNames];
+        [task waitUntilFinished];
+        CFAbsoluteTime wallTime = CFAbsoluteTimeGetCurrent() - start;
+        
+        XCTAssertNil(task.error, @"Synchronize failed [%@]", task.error);
+        XCTAssertEqual(datasetNames.count, [task.result count]);
+        for (AWSCognitoDataset *dataset in task.result) {
+            XCTAssertEqual(stub.recordCount, [dataset getAllRecords].count);
+        }
+        NSLog(@"Synchronized %lu datasets %@ at a time in %.3f s", (unsigned long)datasetNames.count, concurrency, wallTime);
+    }
+    
+    [cognito wipe];
+    [AWSCognito removeCognitoForKey:@"testSynchronizeDatasetsWallTime"];
+}
+
+- (void)testReadsDoNotWaitForWrites {
+    NSError * error;
+    AWSCognitoRecord *record = [[AWSCognitoRecord alloc] initWithId:@"wifi" data:[[AWSCognitoRecordValue alloc] initWithString:@"on"]];
+    XCTAssertTrue([self.manager putRecord:record datasetName:DatasetName error:&error], @"Put failed [%@]", error);
+    
+    // Holds a write transaction open on the writer connection, with the dispatch queue blocked, while a read runs.
+    __block long readResult = -1;
+    __block NSString *readValue = nil;
+    dispatch_sync(self.manager.dispatchQueue, ^{
+        XCTAssertEqual(SQLITE_OK, sqlite3_exec(self.manager.sqlite, "BEGIN IMMEDIATE", NULL, NULL, NULL));
+        NSString *deleteString = [NSString stringWithFormat:@"DELETE FROM %@", AWSCognitoDefaultSqliteDataTableName];
+        XCTAssertEqual(SQLITE_OK, sqlite3_exec(self.manager.sqlite, [deleteString UTF8String], NULL, NULL, NULL));
+        
+        dispatch_semaphore_t readDone = dispatch_semaphore_create(0);
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            readValue = [self.manager getRecordById:@"wifi" datasetName:DatasetName error:nil].data.string;
+            dispatch_semaphore_signal(readDone);
+        });
+        readResult = dispatch_semaphore_wait(readDone, dispatch_time(DISPATCH_TIME_NOW, 10 * NSEC_PER_SEC));
+        
+        XCTAssertEqual(SQLITE_OK, sqlite3_exec(self.manager.sqlite, "ROLLBACK", NULL, NULL, NULL));
+    });
+    
+    // The read completed inside the transaction and did not see its uncommitted delete.
+    XCTAssertEqual(0, readResult);
+    XCTAssertEqualObjects(@"on", readValue);
+    XCTAssertEqualObjects(@1, [self.manager numRecords:DatasetName]);
+}
+
+- (void)testSynchronizeLatencyWithOneDirtyRecord {
+    AWSCognitoCredentialsProvider *credentialsProvider = [[AWSCognitoCredentialsProvider alloc] initWithRegionType:AWSRegionUSEast1
+                                                                                                    identityPoolId:@"us-east-1:stub"];
+    AWSServiceConfiguration *configuration = [[AWSServiceConfiguration alloc] initWithRegion:AWSRegionUSEast1
+                                                                         credentialsProvider:credentialsProvider];
+    [AWSCognito registerCognitoWithConfiguration:configuration forKey:@"testSynchronizeLatencyWithOneDirtyRecord"];
+    AWSCognito *cognito = [AWSCognito CognitoForKey:@"testSynchronizeLatencyWithOneDirtyRecord"];
+    [cognito wipe];
+    
+    AWSCognitoSyncStub *stub = [AWSCognitoSyncStub new];
+    cognito.cognitoService = (AWSCognitoSync *)stub;
+    
+    NSError * error;
+    AWSCognitoDataset *dataset = [cognito openOrCreateDataset:DatasetName];
+    NSMutableArray *inserts = [NSMutableArray arrayWithCapacity:10000];
+    for (NSInteger i = 0; i < 10000; i++) {
+        AWSCognitoRecord *record = [[AWSCognitoRecord alloc] initWithId:[NSString stringWithFormat:@"key%ld", (long)i]
+                                                                   data:[[AWSCognitoRecordValue alloc] initWithString:@"on"]];
+        record.lastModifiedBy = @"remote";
+        record.lastModified = [NSDate date];
+        record.syncCount = 1;
+        [inserts addObject:[[AWSCognitoRecordTuple alloc] initWithLocalRecord:nil remoteRecord:record]];
+    }
+    XCTAssertTrue([cognito.sqliteManager updateWithRemoteChanges:DatasetName nonConflicts:inserts resolvedConflicts:@[] error:&error], @"Insert failed [%@]", error);
+    [cognito.sqliteManager updateLastSyncCount:DatasetName syncCount:@1 lastModifiedBy:nil];
+    
+    [dataset setString:@"off" forKey:@"key5000"];
+    
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    NSDictionary *dirtyRecords = [cognito.sqliteManager recordsUpdatedAfterLastSync:DatasetName error:&error];
+    CFAbsoluteTime dirtyTime = CFAbsoluteTimeGetCurrent() - start;
+    XCTAssertEqual(1, dirtyRecords.count);
+    XCTAssertNotNil(dirtyRecords[@"key5000"]);
+    
+    start = CFAbsoluteTimeGetCurrent();
+    AWSTask *task = [dataset synchronize];
+    [task waitUntilFinished];
+    CFAbsoluteTime syncTime = CFAbsoluteTimeGetCurrent() - start;
+    XCTAssertNil(task.error, @"Synchronize failed [%@]", task.error);
+    XCTAssertEqual(0, [cognito.sqliteManager recordsUpdatedAfterLastSync:DatasetName error:&error].count);
+    
+    __block NSUInteger enumerated = 0;
+    [dataset enumerateRecordsUsingBlock:^(AWSCognitoRecord *record, BOOL *stop) {
+        enumerated++;
+    }];
+    XCTAssertEqual(10000, enumerated);
+    
+    NSLog(@"1 of 10000 records dirty: dirty lookup %.4f s, synchronize %.3f s", dirtyTime, syncTime);
+    
+    [cognito wipe];
+    [AWSCognito removeCognitoForKey:@"testSynchronizeLatencyWithOneDirtyRecord"];
+}
 @end
@@ -104,6 +104,55 @@ NS_ASSUME_NONNULL_BEGIN
  **/
 @property(nonatomic, assign, readonly) NSUInteger publishRetryThrottle;
 
+/**
+ The max number of publishes held while the connection is busy or down. Default value: 1024
+ **/
+@property(nonatomic, assign) NSUInteger outboundQueueCapacity;
+
+/**
+ What a publish does once outboundQueueCapacity publishes are waiting to be sent.
+ Default value: AWSIoTMQTTOutboundQueueFullPolicyDropOldest. With
+ AWSIoTMQTTOutboundQueueFullPolicyFailFast the publish methods return NO for a rejected message.
+ **/
+@property(nonatomic, assign) AWSIoTMQTTOutboundQueueFullPolicy outboundQueueFullPolicy;
+
+/**
+ The max number of QoS 1 publishes waiting for acknowledgement. Once reached, a QoS 1 publish waits
+ for an acknowledgement, or returns NO if outboundQueueFullPolicy is
+ AWSIoTMQTTOutboundQueueFullPolicyFailFast. 0 means no limit. Default value: 0
+ **/
+@property(nonatomic, assign) NSUInteger maxInFlightPublishes;
+
+/**
+ Store publishes made while disconnected on disk and replay them in order after reconnecting.
+ QoS 1 messages stay stored until acknowledged, so they also survive an app restart.
+ Default value: NO
+ **/
+@property(nonatomic, assign) BOOL offlinePublishQueueEnabled;
+
+/**
+ The max number of topic and payload bytes the offline publish queue stores. 0 means no limit.
+ Default value: 5 MB
+ **/
+@property(nonatomic, assign) NSUInteger offlinePublishQueueByteLimit;
+
+/**
+ Stored publishes older than this many seconds are discarded instead of replayed. 0 means no limit.
+ Default value: 0
+ **/
+@property(nonatomic, assign) NSTimeInterval offlinePublishQueueAgeLimit;
+
+/**
+ What a publish does once the offline publish queue has reached its byte limit.
+ Default value: AWSIoTMQTTOfflineQueueFullPolicyDropOldest
+ **/
+@property(nonatomic, assign) AWSIoTMQTTOfflineQueueFullPolicy offlinePublishQueueFullPolicy;
+
+/**
+ The max number of replayed publishes waiting to be sent or acknowledged at once. Default value: 10
+ **/
+@property(nonatomic, assign) NSUInteger offlinePublishQueueInFlightLimit;
+
 /**
  Create an AWSIoTMQTTConfiguration object and initialize its parameters.
  The AWSIoTMQTTConfiguration object is then passed to AWSIoTDataManager to initialize it.
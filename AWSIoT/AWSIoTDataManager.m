@@ -16,6 +16,7 @@
 #import "AWSSignature.h"
 #import "AWSIoTDataManager.h"
 #import "AWSIoTMQTTClient.h"
+#import "AWSIoTMQTTOfflineQueue.h"
 #import "AWSSynchronizedMutableDictionary.h"
 #import "AWSIoTModel.h"
 #import "AWSCocoaLumberjack.h"
@@ -167,6 +168,14 @@ static NSString *const AWSInfoIoTDataManager = @"IoTDataManager";
         _autoResubscribe = ars;
         _lastWillAndTestament = lwt;
         _publishRetryThrottle = 100; //Default to 100 if not specified.
+        _outboundQueueCapacity = 1024;
+        _outboundQueueFullPolicy = AWSIoTMQTTOutboundQueueFullPolicyDropOldest;
+        _maxInFlightPublishes = 0;
+        _offlinePublishQueueEnabled = NO;
+        _offlinePublishQueueByteLimit = 5 * 1024 * 1024;
+        _offlinePublishQueueAgeLimit = 0;
+        _offlinePublishQueueFullPolicy = AWSIoTMQTTOfflineQueueFullPolicyDropOldest;
+        _offlinePublishQueueInFlightLimit = 10;
         AWSDDLogInfo(@"Initializing AWSIoTMqttConfiguration with KeepAlive:%f, baseReconnectTime:%f,"
                      "minimumConnectionTime:%f, maximumReconnectTime:%f, autoResubscribe:%@, lwt topic:%@ message:%@ ",
                      _keepAliveTimeInterval, _baseReconnectTimeInterval, _minimumConnectionTimeInterval,
@@ -196,6 +205,14 @@ static NSString *const AWSInfoIoTDataManager = @"IoTDataManager";
         _autoResubscribe = ars;
         _lastWillAndTestament = lwt;
         _publishRetryThrottle = prt;
+        _outboundQueueCapacity = 1024;
+        _outboundQueueFullPolicy = AWSIoTMQTTOutboundQueueFullPolicyDropOldest;
+        _maxInFlightPublishes = 0;
+        _offlinePublishQueueEnabled = NO;
+        _offlinePublishQueueByteLimit = 5 * 1024 * 1024;
+        _offlinePublishQueueAgeLimit = 0;
+        _offlinePublishQueueFullPolicy = AWSIoTMQTTOfflineQueueFullPolicyDropOldest;
+        _offlinePublishQueueInFlightLimit = 10;
         AWSDDLogInfo(@"Initializing AWSIoTMqttConfiguration with KeepAlive:%f, baseReconnectTime:%f,"
                      "minimumConnectionTime:%f, maximumReconnectTime:%f, autoResubscribe:%@, lwt topic:%@ message:%@ ",
                      _keepAliveTimeInterval, _baseReconnectTimeInterval, _minimumConnectionTimeInterval,
@@ -407,6 +424,22 @@ static AWSSynchronizedMutableDictionary *_serviceClients = nil;
                                 port:443];
 }
 
+- (void)configureOfflineQueueForClientId:(NSString *)clientId {
+    if (!self.mqttConfiguration.offlinePublishQueueEnabled) {
+        self.mqttClient.offlineQueue = nil;
+        return;
+    }
+    AWSIoTMQTTOfflineQueue *offlineQueue = self.mqttClient.offlineQueue;
+    if (![offlineQueue.identifier isEqualToString:clientId]) {
+        offlineQueue = [[AWSIoTMQTTOfflineQueue alloc] initWithIdentifier:clientId];
+    }
+    offlineQueue.byteLimit = self.mqttConfiguration.offlinePublishQueueByteLimit;
+    offlineQueue.ageLimit = self.mqttConfiguration.offlinePublishQueueAgeLimit;
+    offlineQueue.fullPolicy = self.mqttConfiguration.offlinePublishQueueFullPolicy;
+    offlineQueue.inFlightLimit = self.mqttConfiguration.offlinePublishQueueInFlightLimit;
+    self.mqttClient.offlineQueue = offlineQueue;
+}
+
 - (BOOL)connectWithClientId:(NSString*)clientId
                cleanSession:(BOOL)cleanSession
               certificateId:(NSString *)certificateId
@@ -450,6 +483,10 @@ static AWSSynchronizedMutableDictionary *_serviceClients = nil;
     [self.mqttClient setMaximumReconnectTime:self.mqttConfiguration.maximumReconnectTimeInterval];
     [self.mqttClient setAutoResubscribe:self.mqttConfiguration.autoResubscribe];
     [self.mqttClient setPublishRetryThrottle:self.mqttConfiguration.publishRetryThrottle];
+    [self.mqttClient setOutboundQueueCapacity:self.mqttConfiguration.outboundQueueCapacity];
+    [self.mqttClient setOutboundQueueFullPolicy:self.mqttConfiguration.outboundQueueFullPolicy];
+    [self.mqttClient setMaxInFlightPublishes:self.mqttConfiguration.maxInFlightPublishes];
+    [self configureOfflineQueueForClientId:clientId];
     [self.mqttClient setAutoResubscribe:self.mqttConfiguration.autoResubscribe];
     
     return [self.mqttClient connectWithClientId:clientId
@@ -489,6 +526,10 @@ static AWSSynchronizedMutableDictionary *_serviceClients = nil;
     [self.mqttClient setMaximumReconnectTime:self.mqttConfiguration.maximumReconnectTimeInterval];
     [self.mqttClient setAutoResubscribe:self.mqttConfiguration.autoResubscribe];
     [self.mqttClient setPublishRetryThrottle:self.mqttConfiguration.publishRetryThrottle];
+    [self.mqttClient setOutboundQueueCapacity:self.mqttConfiguration.outboundQueueCapacity];
+    [self.mqttClient setOutboundQueueFullPolicy:self.mqttConfiguration.outboundQueueFullPolicy];
+    [self.mqttClient setMaxInFlightPublishes:self.mqttConfiguration.maxInFlightPublishes];
+    [self configureOfflineQueueForClientId:clientId];
     [self.mqttClient setAutoResubscribe:self.mqttConfiguration.autoResubscribe];
     
     return [self.mqttClient connectWithClientId:clientId
@@ -530,6 +571,10 @@ static AWSSynchronizedMutableDictionary *_serviceClients = nil;
     [self.mqttClient setMaximumReconnectTime:self.mqttConfiguration.maximumReconnectTimeInterval];
     [self.mqttClient setAutoResubscribe:self.mqttConfiguration.autoResubscribe];
     [self.mqttClient setPublishRetryThrottle:self.mqttConfiguration.publishRetryThrottle];
+    [self.mqttClient setOutboundQueueCapacity:self.mqttConfiguration.outboundQueueCapacity];
+    [self.mqttClient setOutboundQueueFullPolicy:self.mqttConfiguration.outboundQueueFullPolicy];
+    [self.mqttClient setMaxInFlightPublishes:self.mqttConfiguration.maxInFlightPublishes];
+    [self configureOfflineQueueForClientId:clientId];
     [self.mqttClient setAutoResubscribe:self.mqttConfiguration.autoResubscribe];
 
     return [self.mqttClient connectWithClientId:clientId
@@ -576,12 +621,10 @@ static AWSSynchronizedMutableDictionary *_serviceClients = nil;
         return NO;
     }
     
-    [self.mqttClient publishString:string
-                               qos:(UInt8)qos
-                           onTopic:topic
-                       ackCallback:ackCallback];
-    
-    return YES;
+    return [self.mqttClient publishString:string
+                                      qos:(UInt8)qos
+                                  onTopic:topic
+                              ackCallback:ackCallback];
 }
 
 - (BOOL)publishString:(NSString *)string
@@ -599,9 +642,7 @@ static AWSSynchronizedMutableDictionary *_serviceClients = nil;
         return NO;
     }
     
-    [self.mqttClient publishString:string qos:(UInt8)qos onTopic:topic];
-
-    return YES;
+    return [self.mqttClient publishString:string qos:(UInt8)qos onTopic:topic];
 }
 
 
@@ -620,11 +661,10 @@ static AWSSynchronizedMutableDictionary *_serviceClients = nil;
         return NO;
     }
     
-    [self.mqttClient publishData:data
-                             qos:(UInt8)qos
-                         onTopic:topic
-                     ackCallback:ackCallback];
-    return YES;
+    return [self.mqttClient publishData:data
+                                    qos:(UInt8)qos
+                                onTopic:topic
+                            ackCallback:ackCallback];
 }
 
 - (BOOL)publishData:(NSData *)data
@@ -641,8 +681,7 @@ static AWSSynchronizedMutableDictionary *_serviceClients = nil;
         return NO;
     }
     
-    [self.mqttClient publishData:data qos:(UInt8)qos onTopic:topic];
-    return YES;
+    return [self.mqttClient publishData:data qos:(UInt8)qos onTopic:topic];
 }
 
 - (BOOL)subscribeToTopic:(NSString *)topic
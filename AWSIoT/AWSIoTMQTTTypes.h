@@ -32,6 +32,28 @@ typedef NS_ENUM(NSInteger, AWSIoTMQTTQoS) {
     AWSIoTMQTTQoSMessageDeliveryAttemptedAtLeastOnce = 1
 };
 
+/**
+ What a publish does when the client's outbound queue is full.
+ */
+typedef NS_ENUM(NSInteger, AWSIoTMQTTOutboundQueueFullPolicy) {
+    /** The oldest queued message is discarded to make room. QoS 1 messages are still retried until acknowledged. */
+    AWSIoTMQTTOutboundQueueFullPolicyDropOldest = 0,
+    /** The publishing thread waits until the queue has room. Publishes from the client's own thread fail instead. */
+    AWSIoTMQTTOutboundQueueFullPolicyBlock = 1,
+    /** The publish is rejected and the publish call returns NO. */
+    AWSIoTMQTTOutboundQueueFullPolicyFailFast = 2
+};
+
+/**
+ What a publish does when the offline publish queue has reached its byte limit.
+ */
+typedef NS_ENUM(NSInteger, AWSIoTMQTTOfflineQueueFullPolicy) {
+    /** The oldest stored messages are discarded to make room. */
+    AWSIoTMQTTOfflineQueueFullPolicyDropOldest = 0,
+    /** The new message is rejected and the publish call returns NO. */
+    AWSIoTMQTTOfflineQueueFullPolicyDropNewest = 1
+};
+
 typedef void(^AWSIoTMQTTNewMessageBlock)(NSData *data);
 typedef void(^AWSIoTMQTTExtendedNewMessageBlock)(NSObject *mqttClient, NSString *topic, NSData *data);
 typedef void(^AWSIoTMQTTAckBlock)(void);
@@ -19,6 +19,8 @@
 #import "AWSSRWebSocket.h"
 #import "AWSIoTMQTTTypes.h"
 
+@class AWSIoTMQTTOfflineQueue;
+
 @interface AWSIoTMQTTTopicModel : NSObject
 @property (nonatomic, strong) NSString *topic;
 @property (nonatomic) UInt8 qos;
@@ -90,6 +92,25 @@
 
 @property(atomic, assign) BOOL isMetricsEnabled;
 @property(atomic, assign) NSUInteger publishRetryThrottle;
+/**
+ The max number of publishes held while the connection is busy or down, and what a publish
+ does once that many are waiting. Both take effect on the next connect. Defaults: 1024 and
+ AWSIoTMQTTOutboundQueueFullPolicyDropOldest.
+ */
+@property(atomic, assign) NSUInteger outboundQueueCapacity;
+@property(atomic, assign) AWSIoTMQTTOutboundQueueFullPolicy outboundQueueFullPolicy;
+/**
+ The max number of QoS 1 publishes waiting for acknowledgement. Once reached, a QoS 1 publish waits
+ for an acknowledgement, or is rejected if outboundQueueFullPolicy is
+ AWSIoTMQTTOutboundQueueFullPolicyFailFast. 0 means no limit. Takes effect on the next connect. Default: 0.
+ */
+@property(atomic, assign) NSUInteger maxInFlightPublishes;
+/**
+ When set, publishes made while the client is not connected are stored here and replayed in
+ order once it connects again. Publishes keep going through the queue until it has drained,
+ so nothing overtakes the stored messages. Defaults to nil.
+ */
+@property(atomic, strong) AWSIoTMQTTOfflineQueue *offlineQueue;
 @property(atomic, strong) NSString *userMetaData;
 
 /**
@@ -150,18 +171,18 @@
 - (void)disconnect;
 
 /**
- Send MQTT message to specified topic
+ Send MQTT message to specified topic. Returns NO if the outbound or offline queue rejected the message.
 
  @param str The message to be sent.
 
  @param topic The topic for publish to.
 
  */
-- (void)publishString:(NSString *)str
+- (BOOL)publishString:(NSString *)str
               onTopic:(NSString *)topic;
 
 /**
- Send MQTT message to specified topic
+ Send MQTT message to specified topic. Returns NO if the outbound or offline queue rejected the message.
 
  @param str The message to be sent.
 
@@ -170,12 +191,12 @@
  @param topic The topic for publish to.
 
  */
-- (void)publishString:(NSString *)str
+- (BOOL)publishString:(NSString *)str
                   qos:(UInt8)qos
               onTopic:(NSString *)topic;
 
 /**
- Send MQTT message to specified topic
+ Send MQTT message to specified topic. Returns NO if the outbound or offline queue rejected the message.
 
  @param str The message to be sent.
 
@@ -186,24 +207,24 @@
  @param ackCallback the callback for ack if QoS > 0.
 
  */
-- (void)publishString:(NSString *)str
+- (BOOL)publishString:(NSString *)str
                   qos:(UInt8)qos
               onTopic:(NSString *)topic
           ackCallback:(AWSIoTMQTTAckBlock)ackCallback;
 
 /**
- Send MQTT message to specified topic
+ Send MQTT message to specified topic. Returns NO if the outbound or offline queue rejected the message.
 
  @param data The data to be sent.
 
  @param topic The topic for publish to.
 
  */
-- (void)publishData:(NSData *)data
+- (BOOL)publishData:(NSData *)data
             onTopic:(NSString *)topic;
 
 /**
- Send MQTT message to specified topic
+ Send MQTT message to specified topic. Returns NO if the outbound or offline queue rejected the message.
 
  @param data The data to be sent.
 
@@ -212,12 +233,12 @@
  @param topic The topic for publish to.
 
  */
-- (void)publishData:(NSData *)data
+- (BOOL)publishData:(NSData *)data
                 qos:(UInt8)qos
             onTopic:(NSString *)topic;
 
 /**
- Send MQTT message to specified topic
+ Send MQTT message to specified topic. Returns NO if the outbound or offline queue rejected the message.
 
  @param data The data to be sent.
 
@@ -228,7 +249,7 @@
  @param ackCallback the callback for ack if QoS > 0.
 
  */
-- (void)publishData:(NSData *)data
+- (BOOL)publishData:(NSData *)data
                 qos:(UInt8)qos
             onTopic:(NSString *)topic
         ackCallback:(AWSIoTMQTTAckBlock)ackCallback;
@@ -20,6 +20,8 @@
 #import "AWSSRWebSocket.h"
 #import "AWSIoTWebSocketOutputStream.h"
 #import "AWSIoTKeychain.h"
+#import "AWSIoTMQTTTopicTrie.h"
+#import "AWSIoTMQTTOfflineQueue.h"
 
 @implementation AWSIoTMQTTTopicModel
 @end
@@ -32,6 +34,7 @@
 @property(atomic, assign, readwrite) AWSIoTMQTTStatus mqttStatus;
 @property(nonatomic, strong) AWSMQTTSession* session;
 @property(nonatomic, strong) NSMutableDictionary * topicListeners;
+@property(nonatomic, strong) AWSIoTMQTTTopicTrie * topicTrie; //The topicListeners models indexed by topic level, used to dispatch inbound messages
 
 @property(atomic, assign) BOOL userDidIssueDisconnect; //Flag to indicate if requestor has issued a disconnect
 @property(atomic, assign) BOOL userDidIssueConnect; //Flag to indicate if requestor has issued a connect
@@ -86,6 +89,8 @@
 
 @property (strong,atomic) dispatch_semaphore_t timerSemaphore;
 
+@property (nonatomic, strong) dispatch_queue_t offlineReplayQueue; //Serializes replaying the offline queue with handling its acks
+
 @end
 
 @implementation AWSIoTMQTTClient
@@ -95,6 +100,7 @@
 - (instancetype)init {
     if (self = [super init]) {
         _topicListeners = [NSMutableDictionary dictionary];
+        _topicTrie = [AWSIoTMQTTTopicTrie new];
         _clientCerts = nil;
         _session.delegate = nil;
         _session = nil;
@@ -107,12 +113,16 @@
         _autoResubscribe = YES;
         _connectionAgeInSeconds = 0;
         _isMetricsEnabled = YES;
+        _outboundQueueCapacity = 1024;
+        _outboundQueueFullPolicy = AWSIoTMQTTOutboundQueueFullPolicyDropOldest;
+        _maxInFlightPublishes = 0;
         _ackCallbackDictionary = [NSMutableDictionary new];
         _webSocket = nil;
         _userDidIssueConnect = NO;
         _userDidIssueDisconnect = NO;
         _timerSemaphore = dispatch_semaphore_create(1);
         _streamsThread = nil;
+        _offlineReplayQueue = dispatch_queue_create("com.amazonaws.iot.mqtt.offline-replay", DISPATCH_QUEUE_SERIAL);
     }
     return self;
 }
@@ -275,6 +285,7 @@
     
     if (self.cleanSession) {
         [self.topicListeners removeAllObjects];
+        [self.topicTrie removeAllObjects];
     }
     
     //Setup userName if metrics are enabled. We use the connection username as metadata for metrics calculation.
@@ -285,6 +296,7 @@
     
     //Create Session
     if (self.session == nil ) {
+        [self resetOfflineMessagesInFlight];
         self.session= [[AWSMQTTSession alloc] initWithClientId:self.clientId
                                                userName:self.userMetaData
                                                password:@""
@@ -294,7 +306,10 @@
                                                 willMsg:self.lastWillAndTestamentMessage
                                                 willQoS:self.lastWillAndTestamentQoS
                                          willRetainFlag:self.lastWillAndTestamentRetainFlag
-                                         publishRetryThrottle:self.publishRetryThrottle];
+                                         publishRetryThrottle:self.publishRetryThrottle
+                                        outboundQueueCapacity:self.outboundQueueCapacity
+                                      outboundQueueFullPolicy:self.outboundQueueFullPolicy];
+        self.session.maxInFlightPublishes = self.maxInFlightPublishes;
         self.session.delegate = self;
     }
     
@@ -532,6 +547,7 @@
     //clear session if required
     if (self.cleanSession) {
         [self.topicListeners removeAllObjects];
+        [self.topicTrie removeAllObjects];
     }
     
     //Setup userName if metrics are enabled. We use the connection username as metadata for metrics calculation.
@@ -542,6 +558,7 @@
     
     //create Session if one doesn't already exist
     if (self.session == nil ) {
+        [self resetOfflineMessagesInFlight];
         self.session = [[AWSMQTTSession alloc] initWithClientId:self.clientId
                                                        userName:self.userMetaData
                                                        password:@""
@@ -551,7 +568,10 @@
                                                         willMsg:self.lastWillAndTestamentMessage
                                                         willQoS:self.lastWillAndTestamentQoS
                                                  willRetainFlag:self.lastWillAndTestamentRetainFlag
-                                           publishRetryThrottle:self.publishRetryThrottle];
+                                           publishRetryThrottle:self.publishRetryThrottle
+                                          outboundQueueCapacity:self.outboundQueueCapacity
+                                        outboundQueueFullPolicy:self.outboundQueueFullPolicy];
+        self.session.maxInFlightPublishes = self.maxInFlightPublishes;
         self.session.delegate = self;
     }
     
@@ -775,18 +795,17 @@
 
 #pragma mark publish methods
 
-- (void)publishString:(NSString*)str
+- (BOOL)publishString:(NSString*)str
               onTopic:(NSString*)topic
           ackCallback:(AWSIoTMQTTAckBlock)ackCallBack {
-    [self publishData:[str dataUsingEncoding:NSUTF8StringEncoding] onTopic:topic];
-    
+    return [self publishData:[str dataUsingEncoding:NSUTF8StringEncoding] onTopic:topic];
 }
 
-- (void)publishString:(NSString*)str onTopic:(NSString*)topic {
-    [self publishData:[str dataUsingEncoding:NSUTF8StringEncoding] onTopic:topic];
+- (BOOL)publishString:(NSString*)str onTopic:(NSString*)topic {
+    return [self publishData:[str dataUsingEncoding:NSUTF8StringEncoding] onTopic:topic];
 }
 
-- (void)publishString:(NSString*)str
+- (BOOL)publishString:(NSString*)str
                   qos:(UInt8)qos
               onTopic:(NSString*)topic
           ackCallback:(AWSIoTMQTTAckBlock)ackCallback {
@@ -794,31 +813,34 @@
         [NSException raise:NSInvalidArgumentException
                     format:@"Cannot specify `ackCallback` block for QoS = 0."];
     }
-    [self publishData:[str dataUsingEncoding:NSUTF8StringEncoding]
-                  qos:qos
-              onTopic:topic
-          ackCallback:ackCallback];
+    return [self publishData:[str dataUsingEncoding:NSUTF8StringEncoding]
+                         qos:qos
+                     onTopic:topic
+                 ackCallback:ackCallback];
 }
 
-- (void)publishString:(NSString*)str qos:(UInt8)qos onTopic:(NSString*)topic {
-    [self publishData:[str dataUsingEncoding:NSUTF8StringEncoding] qos:qos onTopic:topic];
+- (BOOL)publishString:(NSString*)str qos:(UInt8)qos onTopic:(NSString*)topic {
+    return [self publishData:[str dataUsingEncoding:NSUTF8StringEncoding] qos:qos onTopic:topic];
 }
 
-- (void)publishData:(NSData*)data
+- (BOOL)publishData:(NSData*)data
             onTopic:(NSString*)topic {
-    [self.session publishData:data onTopic:topic];
+    if (self.offlineQueue) {
+        return [self publishData:data qos:0 onTopic:topic ackCallback:nil];
+    }
+    return [self.session publishData:data onTopic:topic];
 }
 
-- (void)publishData:(NSData *)data
+- (BOOL)publishData:(NSData *)data
                 qos:(UInt8)qos
             onTopic:(NSString *)topic {
-    [self publishData:data
-                  qos:qos
-              onTopic:topic
-          ackCallback:nil];
+    return [self publishData:data
+                         qos:qos
+                     onTopic:topic
+                 ackCallback:nil];
 }
 
-- (void)publishData:(NSData*)data
+- (BOOL)publishData:(NSData*)data
                 qos:(UInt8)qos
             onTopic:(NSString*)topic
         ackCallback:(AWSIoTMQTTAckBlock)ackCallback {
@@ -835,24 +857,88 @@
     
     if (qos > 1) {
         AWSDDLogError(@"invalid qos value: %u", qos);
-        return;
+        return NO;
     }
     if (qos == 0 && ackCallback != nil) {
         [NSException raise:NSInvalidArgumentException
                     format:@"Cannot specify `ackCallback` block for QoS = 0."];
     }
 
+    AWSIoTMQTTOfflineQueue *offlineQueue = self.offlineQueue;
+    if (offlineQueue && (self.mqttStatus != AWSIoTMQTTStatusConnected || offlineQueue.count > 0)) {
+        BOOL stored = [offlineQueue enqueueData:data onTopic:topic qos:qos ackCallback:ackCallback];
+        [self replayOfflineMessages];
+        return stored;
+    }
+
     AWSDDLogVerbose(@"isReadyToPublish: %i",[self.session isReadyToPublish]);
     if (qos == 0) {
-        [self.session publishData:data onTopic:topic];
+        return [self.session publishData:data onTopic:topic];
     }
     else {
         UInt16 messageId = [self.session publishDataAtLeastOnce:data onTopic:topic];
+        if (messageId == 0) {
+            return NO;
+        }
         if (ackCallback) {
             [self.ackCallbackDictionary setObject:ackCallback
                                            forKey:[NSNumber numberWithInt:messageId]];
         }
+        return YES;
+    }
+}
+
+// Message ids of a previous session mean nothing to a new one. Runs on the replay queue, so a replay still
+// publishing on the old session records its message ids before they are forgotten rather than after.
+- (void)resetOfflineMessagesInFlight {
+    AWSIoTMQTTOfflineQueue *offlineQueue = self.offlineQueue;
+    if (offlineQueue == nil) {
+        return;
     }
+    dispatch_async(self.offlineReplayQueue, ^{
+        [offlineQueue resetInFlight];
+    });
+}
+
+// Sends the oldest stored messages the offline queue's in-flight window has room for. Only a PUBACK
+// replays again, so a round that sent QoS 0 messages, which free their slots without one, queues the
+// next round itself; queueing rather than looping lets acks received meanwhile run in between.
+- (void)replayOfflineMessages {
+    AWSIoTMQTTOfflineQueue *offlineQueue = self.offlineQueue;
+    if (offlineQueue == nil) {
+        return;
+    }
+    dispatch_async(self.offlineReplayQueue, ^{
+        if (self.mqttStatus != AWSIoTMQTTStatusConnected) {
+            return;
+        }
+        AWSMQTTSession *session = self.session;
+        BOOL sentAtMostOnce = NO;
+        BOOL rejected = NO;
+        for (AWSIoTMQTTOfflineMessage *message in [offlineQueue nextMessagesToReplay]) {
+            if (message.qos == 0) {
+                if (![session publishData:message.data onTopic:message.topic]) {
+                    [offlineQueue rewindToMessage:message];
+                    rejected = YES;
+                    break;
+                }
+                [offlineQueue removeMessage:message];
+                sentAtMostOnce = YES;
+            } else {
+                UInt16 messageId = [session publishDataAtLeastOnce:message.data onTopic:message.topic];
+                if (messageId == 0) {
+                    [offlineQueue rewindToMessage:message];
+                    rejected = YES;
+                    break;
+                }
+                [offlineQueue message:message wasSentWithMessageId:messageId];
+            }
+        }
+        if (sentAtMostOnce && !rejected) {
+            [self replayOfflineMessages];
+        }
+        AWSDDLogVerbose(@"Offline queue: %lu stored, %lu in flight", (unsigned long)offlineQueue.count, (unsigned long)offlineQueue.inFlightCount);
+    });
 }
 
 #pragma mark subscribe methods
@@ -883,6 +969,7 @@
     topicModel.qos = qos;
     topicModel.callback = callback;
     [self.topicListeners setObject:topicModel forKey:topic];
+    [self.topicTrie setObject:topicModel forTopicFilter:topic];
     
     UInt16 messageId = [self.session subscribeToTopic:topicModel.topic atLevel:topicModel.qos];
     AWSDDLogVerbose(@"Now subscribing w/ messageId: %d", messageId);
@@ -922,6 +1009,7 @@
     topicModel.callback = nil;
     topicModel.extendedCallback = callback;
     [self.topicListeners setObject:topicModel forKey:topic];
+    [self.topicTrie setObject:topicModel forTopicFilter:topic];
     UInt16 messageId = [self.session subscribeToTopic:topicModel.topic atLevel:topicModel.qos];
     AWSDDLogVerbose(@"Now subscribing w/ messageId: %d", messageId);
     if (ackCallback) {
@@ -944,6 +1032,7 @@
     AWSDDLogInfo(@"Unsubscribing from topic %@", topic);
     UInt16 messageId = [self.session unsubscribeTopic:topic];
     [self.topicListeners removeObjectForKey:topic];
+    [self.topicTrie removeObjectForTopicFilter:topic];
     if (ackCallback) {
         [self.ackCallbackDictionary setObject:ackCallback
                                        forKey:[NSNumber numberWithInt:messageId]];
@@ -974,6 +1063,7 @@
             AWSDDLogInfo(@"MQTT session connected.");
             self.mqttStatus = AWSIoTMQTTStatusConnected;
             [self notifyConnectionStatus];
+            [self replayOfflineMessages];
           
             if (self.connectionAgeTimer != nil) {
                 [self.connectionAgeTimer invalidate];
@@ -1007,6 +1097,7 @@
             if (self.userDidIssueDisconnect ) {
                 //Clear all session state here.
                 [self.topicListeners removeAllObjects];
+                [self.topicTrie removeAllObjects];
                 self.mqttStatus = AWSIoTMQTTStatusDisconnected;
                 [self notifyConnectionStatus];
             }
@@ -1035,6 +1126,7 @@
             if (self.userDidIssueDisconnect ) {
                 //Clear all session state here.
                 [self.topicListeners removeAllObjects];
+                [self.topicTrie removeAllObjects];
                 self.mqttStatus = AWSIoTMQTTStatusDisconnected;
                 [self notifyConnectionStatus];
             }
@@ -1069,54 +1161,26 @@
 - (void)session:(AWSMQTTSession*)session newMessage:(NSData*)data onTopic:(NSString*)topic {
     AWSDDLogVerbose(@"MQTTSessionDelegate newMessage: %@ onTopic: %@",[[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding], topic);
 
-    NSArray *topicParts = [topic componentsSeparatedByString: @"/"];
-
-    for (NSString *topicKey in self.topicListeners.allKeys) {
-        NSArray *topicKeyParts = [topicKey componentsSeparatedByString: @"/"];
-
-        BOOL topicMatch = true;
-        for (int i = 0; i < topicKeyParts.count; i++) {
-            if (i >= topicParts.count) {
-                topicMatch = false;
-                break;
-            }
-
-            NSString *topicPart = topicParts[i];
-            NSString *topicKeyPart = topicKeyParts[i];
-
-            if ([topicKeyPart rangeOfString:@"#"].location == NSNotFound && [topicKeyPart rangeOfString:@"+"].location == NSNotFound) {
-                if (![topicPart isEqualToString:topicKeyPart]) {
-                    topicMatch = false;
-                    break;
-                }
-            }
+    for (AWSIoTMQTTTopicModel *topicModel in [self.topicTrie objectsMatchingTopic:topic]) {
+        AWSDDLogVerbose(@"<<%@>>Topic: %@ is matched by %@.",[NSThread currentThread], topic, topicModel.topic);
+        if (topicModel.callback != nil) {
+            AWSDDLogVerbose(@"<<%@>>topicModel.callback.", [NSThread currentThread]);
+            dispatch_async(dispatch_get_global_queue( DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(void){
+                topicModel.callback(data);
+            });
         }
-
-        if (topicMatch) {
-            AWSDDLogVerbose(@"<<%@>>Topic: %@ is matched.",[NSThread currentThread], topic);
-            AWSIoTMQTTTopicModel *topicModel = [self.topicListeners objectForKey:topicKey];
-            if (topicModel) {
-                if (topicModel.callback != nil) {
-                    AWSDDLogVerbose(@"<<%@>>topicModel.callback.", [NSThread currentThread]);
-                    dispatch_async(dispatch_get_global_queue( DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(void){
-                        topicModel.callback(data);
-                    });
-                }
-                if (topicModel.extendedCallback != nil) {
-                    AWSDDLogVerbose(@"<<%@>>topicModel.extendedcallback.", [NSThread currentThread]);
-                    dispatch_async(dispatch_get_global_queue( DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(void){
-                        topicModel.extendedCallback(self, topic, data);
-                    });
-                }
-                
-                if (self.clientDelegate != nil ) {
-                    AWSDDLogVerbose(@"<<%@>>Calling receviedMessageData on client Delegate.", [NSThread currentThread]);
-                    dispatch_async(dispatch_get_global_queue( DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(void){
-                        [self.clientDelegate receivedMessageData:data onTopic:topic];
-                    });
-                }
-                
-            }
+        if (topicModel.extendedCallback != nil) {
+            AWSDDLogVerbose(@"<<%@>>topicModel.extendedcallback.", [NSThread currentThread]);
+            dispatch_async(dispatch_get_global_queue( DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(void){
+                topicModel.extendedCallback(self, topic, data);
+            });
+        }
+        
+        if (self.clientDelegate != nil ) {
+            AWSDDLogVerbose(@"<<%@>>Calling receviedMessageData on client Delegate.", [NSThread currentThread]);
+            dispatch_async(dispatch_get_global_queue( DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(void){
+                [self.clientDelegate receivedMessageData:data onTopic:topic];
+            });
         }
     }
 }
@@ -1134,6 +1198,23 @@ newAckForMessageId:(UInt16)msgId {
         });
         [[self ackCallbackDictionary] removeObjectForKey:[NSNumber numberWithInt:msgId]];
     }
+
+    AWSIoTMQTTOfflineQueue *offlineQueue = self.offlineQueue;
+    if (offlineQueue) {
+        // On the replay queue so the ack is never handled before its message id is recorded
+        dispatch_async(self.offlineReplayQueue, ^{
+            AWSIoTMQTTOfflineMessage *message = [offlineQueue acknowledgeMessageId:msgId];
+            if (message == nil) {
+                return;
+            }
+            if (message.ackCallback) {
+                dispatch_async(dispatch_get_global_queue( DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(void){
+                    message.ackCallback();
+                });
+            }
+            [self replayOfflineMessages];
+        });
+    }
 }
 
 #pragma mark AWSSRWebSocketDelegate
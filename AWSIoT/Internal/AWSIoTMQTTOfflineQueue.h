@@ -0,0 +1,74 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import "AWSIoTMQTTTypes.h"
+
+// A publish stored in the offline queue.
+@interface AWSIoTMQTTOfflineMessage : NSObject
+
+@property (nonatomic, assign) long long rowId;
+@property (nonatomic, strong) NSString *topic;
+@property (nonatomic, strong) NSData *data;
+@property (nonatomic, assign) UInt8 qos;
+// Only kept in memory; messages loaded after an app restart have none.
+@property (nonatomic, copy) AWSIoTMQTTAckBlock ackCallback;
+
+@end
+
+/*
+ Durable store for publishes made while the MQTT connection is down, backed by an SQLite database
+ under the caches directory. Messages are replayed oldest first. A QoS 1 message stays stored
+ until its PUBACK arrives, so it is replayed again after an app restart, and at most
+ `inFlightLimit` messages are handed out for replay at a time.
+ */
+@interface AWSIoTMQTTOfflineQueue : NSObject
+
+- (instancetype)initWithIdentifier:(NSString *)identifier;
+
+@property (nonatomic, strong, readonly) NSString *identifier;
+// Upper bound on the stored topic and payload bytes. 0 means no limit.
+@property (atomic, assign) NSUInteger byteLimit;
+// Messages older than this are discarded instead of replayed. 0 means no limit.
+@property (atomic, assign) NSTimeInterval ageLimit;
+@property (atomic, assign) AWSIoTMQTTOfflineQueueFullPolicy fullPolicy;
+// The max number of replayed messages waiting to be sent or acknowledged.
+@property (atomic, assign) NSUInteger inFlightLimit;
+
+@property (atomic, assign, readonly) NSUInteger count;
+@property (atomic, assign, readonly) NSUInteger storedByteCount;
+@property (readonly) NSUInteger inFlightCount;
+
+// Returns NO if the message was rejected or could not be stored.
+- (BOOL)enqueueData:(NSData *)data
+            onTopic:(NSString *)topic
+                qos:(UInt8)qos
+        ackCallback:(AWSIoTMQTTAckBlock)ackCallback;
+
+// The oldest messages not handed out yet, as many as the in-flight window has room for.
+- (NSArray<AWSIoTMQTTOfflineMessage *> *)nextMessagesToReplay;
+// Records the message id a replayed QoS 1 message was published with.
+- (void)message:(AWSIoTMQTTOfflineMessage *)message wasSentWithMessageId:(UInt16)messageId;
+// Deletes a replayed message that needs no acknowledgement.
+- (void)removeMessage:(AWSIoTMQTTOfflineMessage *)message;
+// Hands the message and everything after it out again on the next replay, e.g. after a rejected send.
+- (void)rewindToMessage:(AWSIoTMQTTOfflineMessage *)message;
+// Deletes the message published with the id and returns it, or nil if the id is not a replayed message.
+- (AWSIoTMQTTOfflineMessage *)acknowledgeMessageId:(UInt16)messageId;
+// Forgets what is in flight so every stored message is replayed again, e.g. for a new MQTT session.
+- (void)resetInFlight;
+- (void)removeAllMessages;
+
+@end
@@ -0,0 +1,350 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import <AWSCore/AWSCore.h>
+#import "AWSIoTMQTTOfflineQueue.h"
+
+static NSString *const AWSIoTMQTTOfflineQueueDatabaseDirectory = @"com/amazonaws/AWSIoTMQTTOfflineQueue";
+// The bytes a message accounts for in `storedByteCount`: its topic and payload plus an estimate of the per-row overhead.
+static NSUInteger const AWSIoTMQTTOfflineQueueMessageOverheadBytes = 32;
+// The same size, computed by SQLite over the `message` columns.
+static NSString *AWSIoTMQTTOfflineQueueMessageSizeExpression(void) {
+    return [NSString stringWithFormat:@"(LENGTH(data) + LENGTH(CAST(topic AS BLOB)) + %lu)", (unsigned long)AWSIoTMQTTOfflineQueueMessageOverheadBytes];
+}
+
+@implementation AWSIoTMQTTOfflineMessage
+
+@end
+
+@interface AWSIoTMQTTOfflineQueue()
+
+@property (nonatomic, strong) AWSFMDatabaseQueue *databaseQueue;
+@property (atomic, assign, readwrite) NSUInteger count;
+@property (atomic, assign, readwrite) NSUInteger storedByteCount;
+// Row id of the newest message handed out for replay.
+@property (nonatomic, assign) long long replayCursor;
+// Messages handed out and not yet removed, keyed by row id.
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, AWSIoTMQTTOfflineMessage *> *inFlightMessages;
+// Row ids of replayed QoS 1 messages, keyed by the message id they were published with.
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, NSNumber *> *rowIdsByMessageId;
+// Ack callbacks of messages enqueued in this process, keyed by row id.
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, AWSIoTMQTTAckBlock> *ackCallbacks;
+
+@end
+
+@implementation AWSIoTMQTTOfflineQueue
+
+- (instancetype)initWithIdentifier:(NSString *)identifier {
+    if (self = [super init]) {
+        _identifier = identifier;
+        _byteLimit = 5 * 1024 * 1024;
+        _ageLimit = 0;
+        _fullPolicy = AWSIoTMQTTOfflineQueueFullPolicyDropOldest;
+        _inFlightLimit = 10;
+        _inFlightMessages = [NSMutableDictionary new];
+        _rowIdsByMessageId = [NSMutableDictionary new];
+        _ackCallbacks = [NSMutableDictionary new];
+
+        NSString *cachesPath = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) firstObject];
+        NSString *databaseDirectoryPath = [cachesPath stringByAppendingPathComponent:AWSIoTMQTTOfflineQueueDatabaseDirectory];
+        if (![[NSFileManager defaultManager] fileExistsAtPath:databaseDirectoryPath]) {
+            NSError *error = nil;
+            if (![[NSFileManager defaultManager] createDirectoryAtPath:databaseDirectoryPath
+                                           withIntermediateDirectories:YES
+                                                            attributes:nil
+                                                                 error:&error]) {
+                AWSDDLogError(@"Failed to create a directory for the offline queue database. [%@]", error);
+            }
+        }
+        // Client ids may contain characters that are not valid in a file name.
+        NSString *fileName = [identifier stringByAddingPercentEncodingWithAllowedCharacters:[NSCharacterSet alphanumericCharacterSet]];
+        NSString *databasePath = [databaseDirectoryPath stringByAppendingPathComponent:fileName];
+        AWSDDLogDebug(@"Offline queue database path: [%@]", databasePath);
+
+        _databaseQueue = [AWSFMDatabaseQueue serialDatabaseQueueWithPath:databasePath];
+        if (_databaseQueue == nil) {
+            AWSDDLogError(@"Unable to open the offline queue database at [%@]", databasePath);
+            return nil;
+        }
+        [_databaseQueue inDatabase:^(AWSFMDatabase *db) {
+            // WAL with normal syncing keeps a committed message across app crashes without an fsync per publish.
+            if (![db executeStatements:@"PRAGMA journal_mode = WAL; PRAGMA synchronous = NORMAL"]) {
+                AWSDDLogError(@"Failed to enable write-ahead logging. %@", db.lastError);
+            }
+            if (![db executeUpdate:
+                  @"CREATE TABLE IF NOT EXISTS message ("
+                  @"topic TEXT NOT NULL,"
+                  @"data BLOB NOT NULL,"
+                  @"qos INTEGER NOT NULL,"
+                  @"timestamp REAL NOT NULL)"]) {
+                AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+            }
+            AWSFMResultSet *rs = [db executeQuery:[NSString stringWithFormat:@"SELECT COUNT(*) AS count, COALESCE(SUM(%@), 0) AS size FROM message", AWSIoTMQTTOfflineQueueMessageSizeExpression()]];
+            if ([rs next]) {
+                self.count = (NSUInteger)[rs unsignedLongLongIntForColumn:@"count"];
+                self.storedByteCount = (NSUInteger)[rs unsignedLongLongIntForColumn:@"size"];
+            } else {
+                AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+            }
+            [rs close];
+        }];
+        if (self.count > 0) {
+            AWSDDLogInfo(@"Offline queue for [%@] holds %lu messages from a previous run", identifier, (unsigned long)self.count);
+        }
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [_databaseQueue close];
+}
+
+- (NSUInteger)inFlightCount {
+    @synchronized(self) {
+        return self.inFlightMessages.count;
+    }
+}
+
+- (BOOL)enqueueData:(NSData *)data
+            onTopic:(NSString *)topic
+                qos:(UInt8)qos
+        ackCallback:(AWSIoTMQTTAckBlock)ackCallback {
+    NSUInteger size = data.length + [topic lengthOfBytesUsingEncoding:NSUTF8StringEncoding] + AWSIoTMQTTOfflineQueueMessageOverheadBytes;
+    NSUInteger byteLimit = self.byteLimit;
+    NSTimeInterval ageLimit = self.ageLimit;
+    AWSIoTMQTTOfflineQueueFullPolicy fullPolicy = self.fullPolicy;
+    if (byteLimit > 0 && size > byteLimit) {
+        AWSDDLogWarn(@"Message of %lu bytes on [%@] exceeds the offline queue byte limit", (unsigned long)size, topic);
+        return NO;
+    }
+
+    __block BOOL stored = NO;
+    __block BOOL rolledBack = NO;
+    __block long long rowId = 0;
+    NSMutableArray<NSNumber *> *deletedRowIds = [NSMutableArray new];
+    [self.databaseQueue inTransaction:^(AWSFMDatabase *db, BOOL *rollback) {
+        if (ageLimit > 0) {
+            [self deleteMessagesWhere:@"timestamp < ?"
+                            arguments:@[@([[NSDate date] timeIntervalSince1970] - ageLimit)]
+                             database:db
+                        deletedRowIds:deletedRowIds];
+        }
+        if (byteLimit > 0 && self.storedByteCount + size > byteLimit) {
+            if (fullPolicy == AWSIoTMQTTOfflineQueueFullPolicyDropNewest) {
+                AWSDDLogWarn(@"Offline queue is full, rejecting message on [%@]", topic);
+                return;
+            }
+            if (![self evictOldestBytes:(self.storedByteCount + size - byteLimit) database:db deletedRowIds:deletedRowIds]) {
+                return;
+            }
+        }
+        if (![db executeUpdate:@"INSERT INTO message (topic, data, qos, timestamp) VALUES (?, ?, ?, ?)"
+          withArgumentsInArray:@[topic, data, @(qos), @([[NSDate date] timeIntervalSince1970])]]) {
+            AWSDDLogError(@"SQLite error. Rolling back... [%@]", db.lastError);
+            *rollback = YES;
+            rolledBack = YES;
+            return;
+        }
+        rowId = [db lastInsertRowId];
+        self.count += 1;
+        self.storedByteCount += size;
+        stored = YES;
+    }];
+
+    // Outside the database queue: nextMessagesToReplay takes the lock first and the database queue second.
+    @synchronized(self) {
+        if (!rolledBack) {
+            [self forgetMessagesWithRowIds:deletedRowIds];
+        }
+        if (stored && ackCallback != nil) {
+            self.ackCallbacks[@(rowId)] = ackCallback;
+        }
+    }
+    return stored;
+}
+
+// Deletes the oldest messages until at least `bytesToFree` bytes are released. Called inside a transaction.
+- (BOOL)evictOldestBytes:(NSUInteger)bytesToFree
+                database:(AWSFMDatabase *)db
+           deletedRowIds:(NSMutableArray<NSNumber *> *)deletedRowIds {
+    AWSFMResultSet *rs = [db executeQuery:[NSString stringWithFormat:@"SELECT rowid, %@ AS size FROM message ORDER BY rowid ASC", AWSIoTMQTTOfflineQueueMessageSizeExpression()]];
+    if (!rs) {
+        AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+        return NO;
+    }
+    NSUInteger freedBytes = 0;
+    long long lastRowId = 0;
+    while (freedBytes < bytesToFree && [rs next]) {
+        freedBytes += (NSUInteger)[rs unsignedLongLongIntForColumn:@"size"];
+        lastRowId = [rs longLongIntForColumn:@"rowid"];
+    }
+    [rs close];
+    AWSDDLogWarn(@"Offline queue is full, dropping messages up to row %lld", lastRowId);
+    return [self deleteMessagesWhere:@"rowid <= ?" arguments:@[@(lastRowId)] database:db deletedRowIds:deletedRowIds];
+}
+
+// Deletes the matching messages and keeps `count` and `storedByteCount` in step. Called inside a transaction;
+// the row ids of the deleted messages are added to `deletedRowIds` for forgetMessagesWithRowIds: once it commits.
+- (BOOL)deleteMessagesWhere:(NSString *)predicate
+                  arguments:(NSArray *)arguments
+                   database:(AWSFMDatabase *)db
+              deletedRowIds:(NSMutableArray<NSNumber *> *)deletedRowIds {
+    AWSFMResultSet *rs = [db executeQuery:[NSString stringWithFormat:@"SELECT rowid, %@ AS size FROM message WHERE %@", AWSIoTMQTTOfflineQueueMessageSizeExpression(), predicate]
+                     withArgumentsInArray:arguments];
+    if (!rs) {
+        AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+        return NO;
+    }
+    NSMutableArray<NSNumber *> *rowIds = [NSMutableArray new];
+    NSUInteger size = 0;
+    while ([rs next]) {
+        [rowIds addObject:@([rs longLongIntForColumn:@"rowid"])];
+        size += (NSUInteger)[rs unsignedLongLongIntForColumn:@"size"];
+    }
+    [rs close];
+    if (rowIds.count == 0) {
+        return YES;
+    }
+    if (![db executeUpdate:[NSString stringWithFormat:@"DELETE FROM message WHERE %@", predicate]
+      withArgumentsInArray:arguments]) {
+        AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+        return NO;
+    }
+    self.count -= MIN(rowIds.count, self.count);
+    self.storedByteCount -= MIN(size, self.storedByteCount);
+    [deletedRowIds addObjectsFromArray:rowIds];
+    return YES;
+}
+
+// Drops the in-flight entries and ack callbacks of deleted messages, so an evicted message neither holds
+// a slot of the in-flight window nor keeps its callback alive. Called with the lock held.
+- (void)forgetMessagesWithRowIds:(NSArray<NSNumber *> *)rowIds {
+    [self.inFlightMessages removeObjectsForKeys:rowIds];
+    [self.ackCallbacks removeObjectsForKeys:rowIds];
+}
+
+- (NSArray<AWSIoTMQTTOfflineMessage *> *)nextMessagesToReplay {
+    NSTimeInterval ageLimit = self.ageLimit;
+    @synchronized(self) {
+        NSUInteger inFlightLimit = MAX(self.inFlightLimit, (NSUInteger)1);
+        if (self.inFlightMessages.count >= inFlightLimit || self.count == 0) {
+            return @[];
+        }
+        NSUInteger limit = inFlightLimit - self.inFlightMessages.count;
+        long long replayCursor = self.replayCursor;
+        NSMutableArray<AWSIoTMQTTOfflineMessage *> *messages = [NSMutableArray arrayWithCapacity:limit];
+        NSMutableArray<NSNumber *> *deletedRowIds = [NSMutableArray new];
+        [self.databaseQueue inTransaction:^(AWSFMDatabase *db, BOOL *rollback) {
+            if (ageLimit > 0) {
+                [self deleteMessagesWhere:@"timestamp < ? AND rowid > ?"
+                                arguments:@[@([[NSDate date] timeIntervalSince1970] - ageLimit), @(replayCursor)]
+                                 database:db
+                            deletedRowIds:deletedRowIds];
+            }
+            AWSFMResultSet *rs = [db executeQuery:@"SELECT rowid, topic, data, qos FROM message WHERE rowid > ? ORDER BY rowid ASC LIMIT ?"
+                             withArgumentsInArray:@[@(replayCursor), @(limit)]];
+            if (!rs) {
+                AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+                return;
+            }
+            while ([rs next]) {
+                AWSIoTMQTTOfflineMessage *message = [AWSIoTMQTTOfflineMessage new];
+                message.rowId = [rs longLongIntForColumn:@"rowid"];
+                message.topic = [rs stringForColumn:@"topic"];
+                message.data = [rs dataForColumn:@"data"];
+                message.qos = (UInt8)[rs intForColumn:@"qos"];
+                [messages addObject:message];
+            }
+            [rs close];
+        }];
+        [self forgetMessagesWithRowIds:deletedRowIds];
+        for (AWSIoTMQTTOfflineMessage *message in messages) {
+            message.ackCallback = self.ackCallbacks[@(message.rowId)];
+            self.inFlightMessages[@(message.rowId)] = message;
+            self.replayCursor = message.rowId;
+        }
+        return messages;
+    }
+}
+
+- (void)message:(AWSIoTMQTTOfflineMessage *)message wasSentWithMessageId:(UInt16)messageId {
+    @synchronized(self) {
+        self.rowIdsByMessageId[@(messageId)] = @(message.rowId);
+    }
+}
+
+- (void)removeMessage:(AWSIoTMQTTOfflineMessage *)message {
+    @synchronized(self) {
+        [self.inFlightMessages removeObjectForKey:@(message.rowId)];
+        [self.ackCallbacks removeObjectForKey:@(message.rowId)];
+    }
+    [self.databaseQueue inTransaction:^(AWSFMDatabase *db, BOOL *rollback) {
+        [self deleteMessagesWhere:@"rowid = ?" arguments:@[@(message.rowId)] database:db deletedRowIds:nil];
+    }];
+}
+
+- (void)rewindToMessage:(AWSIoTMQTTOfflineMessage *)message {
+    @synchronized(self) {
+        for (NSNumber *rowId in self.inFlightMessages.allKeys) {
+            if (rowId.longLongValue >= message.rowId) {
+                [self.inFlightMessages removeObjectForKey:rowId];
+            }
+        }
+        self.replayCursor = MIN(self.replayCursor, message.rowId - 1);
+    }
+}
+
+- (AWSIoTMQTTOfflineMessage *)acknowledgeMessageId:(UInt16)messageId {
+    AWSIoTMQTTOfflineMessage *message;
+    @synchronized(self) {
+        NSNumber *rowId = self.rowIdsByMessageId[@(messageId)];
+        if (rowId == nil) {
+            return nil;
+        }
+        [self.rowIdsByMessageId removeObjectForKey:@(messageId)];
+        message = self.inFlightMessages[rowId];
+        if (message == nil) {
+            return nil;
+        }
+    }
+    [self removeMessage:message];
+    return message;
+}
+
+- (void)resetInFlight {
+    @synchronized(self) {
+        [self.inFlightMessages removeAllObjects];
+        [self.rowIdsByMessageId removeAllObjects];
+        self.replayCursor = 0;
+    }
+}
+
+- (void)removeAllMessages {
+    @synchronized(self) {
+        [self.inFlightMessages removeAllObjects];
+        [self.rowIdsByMessageId removeAllObjects];
+        [self.ackCallbacks removeAllObjects];
+        self.replayCursor = 0;
+        [self.databaseQueue inDatabase:^(AWSFMDatabase *db) {
+            if (![db executeUpdate:@"DELETE FROM message"]) {
+                AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+            }
+            self.count = 0;
+            self.storedByteCount = 0;
+        }];
+    }
+}
+
+@end
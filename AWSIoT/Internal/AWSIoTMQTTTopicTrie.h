@@ -0,0 +1,38 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/*
+ Maps MQTT topic filters to objects, one trie level per topic level, so finding the filters that
+ match a topic costs time proportional to the topic's levels rather than to the number of filters.
+ Matching follows MQTT 3.1.1 section 4.7: `+` matches exactly one level, `#` matches the parent
+ level and any number of levels below it, and topics starting with `$` are not matched by a
+ wildcard in the first level. Safe to use from multiple threads.
+ */
+@interface AWSIoTMQTTTopicTrie : NSObject
+
+@property (readonly) NSUInteger count;
+
+// Replaces any object already stored for the filter.
+- (void)setObject:(id)object forTopicFilter:(NSString *)topicFilter;
+- (id)objectForTopicFilter:(NSString *)topicFilter;
+- (void)removeObjectForTopicFilter:(NSString *)topicFilter;
+- (void)removeAllObjects;
+
+// The objects of every filter that matches the topic name, in no particular order.
+- (NSArray *)objectsMatchingTopic:(NSString *)topic;
+
+@end
@@ -0,0 +1,193 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import "AWSIoTMQTTTopicTrie.h"
+
+static NSString *const AWSIoTMQTTTopicLevelSeparator = @"/";
+static NSString *const AWSIoTMQTTSingleLevelWildcard = @"+";
+static NSString *const AWSIoTMQTTMultiLevelWildcard = @"#";
+
+@interface AWSIoTMQTTTopicTrieNode : NSObject
+
+@property (nonatomic, strong) NSMutableDictionary<NSString *, AWSIoTMQTTTopicTrieNode *> *children;
+@property (nonatomic, strong) AWSIoTMQTTTopicTrieNode *singleLevelChild; // the `+` level
+@property (nonatomic, strong) id multiLevelObject; // the object of a filter ending in `#` at this level
+@property (nonatomic, strong) id object; // the object of a filter ending at this level
+
+@end
+
+@implementation AWSIoTMQTTTopicTrieNode
+
+- (BOOL)isEmpty {
+    return self.object == nil && self.multiLevelObject == nil && self.singleLevelChild == nil && self.children.count == 0;
+}
+
+@end
+
+@interface AWSIoTMQTTTopicTrie()
+
+@property (nonatomic, strong) AWSIoTMQTTTopicTrieNode *root;
+@property (nonatomic, assign) NSUInteger objectCount;
+
+@end
+
+@implementation AWSIoTMQTTTopicTrie
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _root = [AWSIoTMQTTTopicTrieNode new];
+    }
+    return self;
+}
+
+- (NSUInteger)count {
+    @synchronized(self) {
+        return self.objectCount;
+    }
+}
+
+- (void)setObject:(id)object forTopicFilter:(NSString *)topicFilter {
+    NSArray<NSString *> *levels = [topicFilter componentsSeparatedByString:AWSIoTMQTTTopicLevelSeparator];
+    @synchronized(self) {
+        AWSIoTMQTTTopicTrieNode *node = self.root;
+        for (NSUInteger i = 0; i < levels.count; i++) {
+            NSString *level = levels[i];
+            if ([level isEqualToString:AWSIoTMQTTMultiLevelWildcard] && i == levels.count - 1) {
+                if (node.multiLevelObject == nil) {
+                    self.objectCount++;
+                }
+                node.multiLevelObject = object;
+                return;
+            }
+            AWSIoTMQTTTopicTrieNode *child;
+            if ([level isEqualToString:AWSIoTMQTTSingleLevelWildcard]) {
+                if (node.singleLevelChild == nil) {
+                    node.singleLevelChild = [AWSIoTMQTTTopicTrieNode new];
+                }
+                child = node.singleLevelChild;
+            } else {
+                if (node.children == nil) {
+                    node.children = [NSMutableDictionary dictionary];
+                }
+                child = node.children[level];
+                if (child == nil) {
+                    child = [AWSIoTMQTTTopicTrieNode new];
+                    node.children[level] = child;
+                }
+            }
+            node = child;
+        }
+        if (node.object == nil) {
+            self.objectCount++;
+        }
+        node.object = object;
+    }
+}
+
+- (id)objectForTopicFilter:(NSString *)topicFilter {
+    NSArray<NSString *> *levels = [topicFilter componentsSeparatedByString:AWSIoTMQTTTopicLevelSeparator];
+    @synchronized(self) {
+        AWSIoTMQTTTopicTrieNode *node = self.root;
+        for (NSUInteger i = 0; i < levels.count && node != nil; i++) {
+            NSString *level = levels[i];
+            if ([level isEqualToString:AWSIoTMQTTMultiLevelWildcard] && i == levels.count - 1) {
+                return node.multiLevelObject;
+            }
+            node = [level isEqualToString:AWSIoTMQTTSingleLevelWildcard] ? node.singleLevelChild : node.children[level];
+        }
+        return node.object;
+    }
+}
+
+- (void)removeObjectForTopicFilter:(NSString *)topicFilter {
+    NSArray<NSString *> *levels = [topicFilter componentsSeparatedByString:AWSIoTMQTTTopicLevelSeparator];
+    @synchronized(self) {
+        [self removeLevels:levels atIndex:0 fromNode:self.root];
+    }
+}
+
+// Returns YES when the node is left empty and can be unlinked from its parent.
+- (BOOL)removeLevels:(NSArray<NSString *> *)levels atIndex:(NSUInteger)index fromNode:(AWSIoTMQTTTopicTrieNode *)node {
+    if (index == levels.count) {
+        if (node.object != nil) {
+            node.object = nil;
+            self.objectCount--;
+        }
+        return [node isEmpty];
+    }
+    NSString *level = levels[index];
+    if ([level isEqualToString:AWSIoTMQTTMultiLevelWildcard] && index == levels.count - 1) {
+        if (node.multiLevelObject != nil) {
+            node.multiLevelObject = nil;
+            self.objectCount--;
+        }
+        return [node isEmpty];
+    }
+    if ([level isEqualToString:AWSIoTMQTTSingleLevelWildcard]) {
+        if (node.singleLevelChild != nil && [self removeLevels:levels atIndex:index + 1 fromNode:node.singleLevelChild]) {
+            node.singleLevelChild = nil;
+        }
+    } else {
+        AWSIoTMQTTTopicTrieNode *child = node.children[level];
+        if (child != nil && [self removeLevels:levels atIndex:index + 1 fromNode:child]) {
+            [node.children removeObjectForKey:level];
+        }
+    }
+    return [node isEmpty];
+}
+
+- (void)removeAllObjects {
+    @synchronized(self) {
+        self.root = [AWSIoTMQTTTopicTrieNode new];
+        self.objectCount = 0;
+    }
+}
+
+- (NSArray *)objectsMatchingTopic:(NSString *)topic {
+    NSArray<NSString *> *levels = [topic componentsSeparatedByString:AWSIoTMQTTTopicLevelSeparator];
+    NSMutableArray *matches = [NSMutableArray array];
+    @synchronized(self) {
+        // Wildcards in the first level never match topics such as $aws/things/... (MQTT 3.1.1, 4.7.2).
+        BOOL wildcardsAllowed = ![topic hasPrefix:@"$"];
+        [self collectMatchesForLevels:levels atIndex:0 node:self.root wildcardsAllowed:wildcardsAllowed into:matches];
+    }
+    return matches;
+}
+
+- (void)collectMatchesForLevels:(NSArray<NSString *> *)levels
+                        atIndex:(NSUInteger)index
+                           node:(AWSIoTMQTTTopicTrieNode *)node
+               wildcardsAllowed:(BOOL)wildcardsAllowed
+                           into:(NSMutableArray *)matches {
+    // `a/#` matches `a` itself as well as everything below it.
+    if (wildcardsAllowed && node.multiLevelObject != nil) {
+        [matches addObject:node.multiLevelObject];
+    }
+    if (index == levels.count) {
+        if (node.object != nil) {
+            [matches addObject:node.object];
+        }
+        return;
+    }
+    AWSIoTMQTTTopicTrieNode *child = node.children[levels[index]];
+    if (child != nil) {
+        [self collectMatchesForLevels:levels atIndex:index + 1 node:child wildcardsAllowed:YES into:matches];
+    }
+    if (wildcardsAllowed && node.singleLevelChild != nil) {
+        [self collectMatchesForLevels:levels atIndex:index + 1 node:node.singleLevelChild wildcardsAllowed:YES into:matches];
+    }
+}
+
+@end
@@ -23,6 +23,9 @@
 
 @property (nonatomic, strong) NSOutputStream *actualDelegate;
 @property (nonatomic, strong) AWSSRWebSocket *webSocket;
+@property (nonatomic, strong) dispatch_queue_t flushQueue; // Hands pending bytes to the web socket, in write order
+@property (nonatomic, strong) NSMutableData *pendingData; // Bytes written since the last flush
+@property (nonatomic, assign) BOOL flushScheduled;
 
 @end
 
@@ -41,18 +44,47 @@
     {
         self.actualDelegate = [NSOutputStream outputStreamToMemory];
         self.webSocket = webSocket;
+        self.flushQueue = dispatch_queue_create("com.amazonaws.iot.websocket-output", DISPATCH_QUEUE_SERIAL);
     }
     return self;
 }
 
 #pragma mark override write method
+// Consecutive writes, such as the segments of one MQTT encoder batch, are coalesced into a single
+// WebSocket frame: only the first write after a flush schedules the next one.
 - (NSInteger)write:(const uint8_t *)buffer maxLength:(NSUInteger)limit
 {
-    [self.webSocket send:[NSData dataWithBytes:(void *)buffer length:limit]];
-    AWSDDLogVerbose(@"sending %lu bytes", (unsigned long)limit);
+    BOOL scheduleFlush;
+    @synchronized(self) {
+        if (self.pendingData == nil) {
+            self.pendingData = [NSMutableData dataWithCapacity:limit];
+        }
+        [self.pendingData appendBytes:buffer length:limit];
+        scheduleFlush = !self.flushScheduled;
+        self.flushScheduled = YES;
+    }
+    if (scheduleFlush) {
+        dispatch_async(self.flushQueue, ^{
+            [self flush];
+        });
+    }
     return limit;     // writes always succeed
 }
 
+- (void)flush
+{
+    NSData *data;
+    @synchronized(self) {
+        data = self.pendingData;
+        self.pendingData = nil;
+        self.flushScheduled = NO;
+    }
+    if ([data length] > 0) {
+        AWSDDLogVerbose(@"sending %lu bytes", (unsigned long)[data length]);
+        [self.webSocket sendDataNoCopy:data];
+    }
+}
+
 #pragma mark forward all other messages to actualDelegate
 - (id)forwardingTargetForSelector:(SEL)aSelector {
     if (class_respondsToSelector([self class], aSelector)) { return self; }
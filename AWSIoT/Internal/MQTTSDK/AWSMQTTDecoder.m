@@ -13,16 +13,78 @@
 // permissions and limitations under the License.
 //
 
+#import <stdatomic.h>
 #import "AWSCocoaLumberjack.h"
 #import "AWSMQTTDecoder.h"
 
+// Bytes read from the stream per read event; larger frames grow the buffer to fit.
+static const NSUInteger AWSMQTTDecoderReadBufferSize = 64 * 1024;
+// Frames shorter than this are copied out of the block, so a small message an application holds on to doesn't pin it.
+static const NSUInteger AWSMQTTDecoderMinSliceLength = 4 * 1024;
+
+/*
+ A block of inbound bytes. Large frames decoded from it are handed out as slices that keep the block
+ alive, so the block is only compacted and reused once no slice refers to it anymore.
+ */
+@interface AWSMQTTDecoderBuffer : NSObject {
+@public
+    UInt8 *bytes;
+    NSUInteger capacity;
+    atomic_long slices;
+}
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity;
+- (NSData *)sliceAtOffset:(NSUInteger)offset length:(NSUInteger)length;
+- (BOOL)isShared;
+
+@end
+
+@implementation AWSMQTTDecoderBuffer
+
+- (instancetype)initWithCapacity:(NSUInteger)aCapacity {
+    if (self = [super init]) {
+        bytes = malloc(aCapacity);
+        if (bytes == NULL) {
+            return nil;
+        }
+        capacity = aCapacity;
+        atomic_init(&slices, 0);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    free(bytes);
+}
+
+- (NSData *)sliceAtOffset:(NSUInteger)offset length:(NSUInteger)length {
+    if (length == 0) {
+        return [NSData data];
+    }
+    if (length < AWSMQTTDecoderMinSliceLength) {
+        return [NSData dataWithBytes:bytes + offset length:length];
+    }
+    atomic_fetch_add(&slices, 1);
+    AWSMQTTDecoderBuffer *buffer = self;
+    return [[NSData alloc] initWithBytesNoCopy:bytes + offset
+                                        length:length
+                                   deallocator:^(void *sliceBytes, NSUInteger sliceLength) {
+                                       atomic_fetch_sub(&buffer->slices, 1);
+                                   }];
+}
+
+- (BOOL)isShared {
+    return atomic_load(&slices) > 0;
+}
+
+@end
+
 @interface AWSMQTTDecoder() {
         NSInputStream*  stream;
-        UInt8           header;
-        UInt32          length;
-        UInt32          lengthMultiplier;
-        NSMutableData*  dataBuffer;
-    
+        AWSMQTTDecoderBuffer* buffer;
+        NSUInteger      readOffset;
+        NSUInteger      writeOffset;
+        NSUInteger      pendingFrameLength;
 }
 
 @end
@@ -51,6 +113,9 @@ int maxLengthMultiplier = 128 * 128 * 128;
     [stream setDelegate:nil];
     [stream close];
     stream = nil;
+    buffer = nil;
+    readOffset = 0;
+    writeOffset = 0;
 }
 
 - (void)stream:(NSStream*)sender handleEvent:(NSStreamEvent)eventCode {
@@ -63,85 +128,10 @@ int maxLengthMultiplier = 128 * 128 * 128;
             _status = AWSMQTTDecoderStatusDecodingHeader;
             break;
         case NSStreamEventHasBytesAvailable:
-            if (_status == AWSMQTTDecoderStatusDecodingHeader) {
-                NSInteger n = [stream read:&header maxLength:1];
-                if (n == -1) {
-                    _status = AWSMQTTDecoderStatusConnectionError;
-                    [_delegate decoder:self handleEvent:AWSMQTTDecoderEventConnectionError];
-                }
-                else if (n == 1) {
-                    length = 0;
-                    lengthMultiplier = 1;
-                    _status = AWSMQTTDecoderStatusDecodingLength;
-                }
-            }
-            while (_status == AWSMQTTDecoderStatusDecodingLength) {
-                UInt8 digit;
-                NSInteger n = [stream read:&digit maxLength:1];
-                if (n == -1) {
-                    _status = AWSMQTTDecoderStatusConnectionError;
-                    [_delegate decoder:self handleEvent:AWSMQTTDecoderEventConnectionError];
-                    break;
-                }
-                else if (n == 0) {
-                    break;
-                }
-                length += (digit & 0x7f) * lengthMultiplier;
-                if ((digit & 0x80) == 0x00) {
-                    dataBuffer = [NSMutableData dataWithCapacity:length];
-                    _status = AWSMQTTDecoderStatusDecodingData;
-                }
-                else {
-                    lengthMultiplier *= 128;
-                    if (lengthMultiplier > maxLengthMultiplier){
-                        AWSDDLogWarn(@"Malformed Remaining Length");
-                        lengthMultiplier = 1;
-                        length = 0;
-                        break;
-                    }
-                }
-            }
-            if (_status == AWSMQTTDecoderStatusDecodingData) {
-                if (length > 0) {
-                    NSInteger n, toRead;
-                    UInt8 buffer[768];
-                    toRead = length - [dataBuffer length];
-                    if (toRead > sizeof buffer) {
-                        toRead = sizeof buffer;
-                    }
-                    n = [stream read:buffer maxLength:toRead];
-                    if (n == -1) {
-                        _status = AWSMQTTDecoderStatusConnectionError;
-                        [_delegate decoder:self handleEvent:AWSMQTTDecoderEventConnectionError];
-                    }
-                    else {
-                        [dataBuffer appendBytes:buffer length:n];
-                    }
-                }
-                if ([dataBuffer length] == length) {
-                    AWSMQTTMessage* msg;
-                    UInt8 type, qos;
-                    BOOL isDuplicate, retainFlag;
-                    type = (header >> 4) & 0x0f;
-                    isDuplicate = NO;
-                    if ((header & 0x08) == 0x08) {
-                        isDuplicate = YES;
-                    }
-                    // XXX qos > 2
-                    qos = (header >> 1) & 0x03;
-                    retainFlag = NO;
-                    if ((header & 0x01) == 0x01) {
-                        retainFlag = YES;
-                    }
-                    msg = [[AWSMQTTMessage alloc] initWithType:type
-                                                        qos:qos
-                                                 retainFlag:retainFlag
-                                                    dupFlag:isDuplicate
-                                                       data:dataBuffer];
-                    [_delegate decoder:self newMessage:msg];
-                    dataBuffer = nil;
-                    _status = AWSMQTTDecoderStatusDecodingHeader;
-                }
+            if (_status == AWSMQTTDecoderStatusDecodingHeader
+                || _status == AWSMQTTDecoderStatusDecodingLength
+                || _status == AWSMQTTDecoderStatusDecodingData) {
+                [self readAvailableBytes];
             }
             break;
         case NSStreamEventEndEncountered:
@@ -158,4 +148,115 @@ int maxLengthMultiplier = 128 * 128 * 128;
     }
 }
 
+// Makes room for at least `required` more bytes after the unparsed ones.
+- (BOOL)reserveSpace:(NSUInteger)required {
+    NSUInteger unparsed = writeOffset - readOffset;
+    if (buffer != nil && buffer->capacity - writeOffset >= required) {
+        return YES;
+    }
+
+    NSUInteger capacity = MAX(AWSMQTTDecoderReadBufferSize, unparsed + required);
+    if (buffer != nil && ![buffer isShared] && buffer->capacity >= capacity) {
+        memmove(buffer->bytes, buffer->bytes + readOffset, unparsed);
+    } else {
+        // slices of the current block are still in use, so leave it to them
+        AWSMQTTDecoderBuffer *newBuffer = [[AWSMQTTDecoderBuffer alloc] initWithCapacity:capacity];
+        if (newBuffer == nil) {
+            return NO;
+        }
+        if (unparsed > 0) {
+            memcpy(newBuffer->bytes, buffer->bytes + readOffset, unparsed);
+        }
+        buffer = newBuffer;
+    }
+    readOffset = 0;
+    writeOffset = unparsed;
+    return YES;
+}
+
+- (void)readAvailableBytes {
+    NSUInteger unparsed = writeOffset - readOffset;
+    NSUInteger required = 1;
+    if (pendingFrameLength > unparsed) {
+        required = pendingFrameLength - unparsed;
+    }
+    if (![self reserveSpace:required]) {
+        AWSDDLogError(@"Unable to allocate the MQTT read buffer.");
+        _status = AWSMQTTDecoderStatusConnectionError;
+        [_delegate decoder:self handleEvent:AWSMQTTDecoderEventConnectionError];
+        return;
+    }
+
+    NSInteger n = [stream read:buffer->bytes + writeOffset maxLength:buffer->capacity - writeOffset];
+    if (n == -1) {
+        _status = AWSMQTTDecoderStatusConnectionError;
+        [_delegate decoder:self handleEvent:AWSMQTTDecoderEventConnectionError];
+        return;
+    }
+    writeOffset += n;
+    [self decodeFrames];
+}
+
+// Hands every complete frame in the buffer to the delegate.
+- (void)decodeFrames {
+    while (stream != nil && _status != AWSMQTTDecoderStatusProtocolError) {
+        const UInt8 *bytes = buffer->bytes + readOffset;
+        NSUInteger available = writeOffset - readOffset;
+        if (available == 0) {
+            _status = AWSMQTTDecoderStatusDecodingHeader;
+            pendingFrameLength = 0;
+            return;
+        }
+
+        UInt8 header = bytes[0];
+        UInt32 length = 0;
+        UInt32 lengthMultiplier = 1;
+        NSUInteger position = 1;
+        BOOL lengthComplete = NO;
+        while (position < available) {
+            UInt8 digit = bytes[position++];
+            length += (digit & 0x7f) * lengthMultiplier;
+            if ((digit & 0x80) == 0x00) {
+                lengthComplete = YES;
+                break;
+            }
+            lengthMultiplier *= 128;
+            if (lengthMultiplier > maxLengthMultiplier) {
+                AWSDDLogWarn(@"Malformed Remaining Length");
+                _status = AWSMQTTDecoderStatusProtocolError;
+                [_delegate decoder:self handleEvent:AWSMQTTDecoderEventProtocolError];
+                return;
+            }
+        }
+        if (!lengthComplete) {
+            _status = AWSMQTTDecoderStatusDecodingLength;
+            pendingFrameLength = 0;
+            return;
+        }
+
+        NSUInteger frameLength = position + length;
+        if (available < frameLength) {
+            _status = AWSMQTTDecoderStatusDecodingData;
+            pendingFrameLength = frameLength;
+            return;
+        }
+
+        UInt8 type = (header >> 4) & 0x0f;
+        BOOL isDuplicate = (header & 0x08) == 0x08;
+        // XXX qos > 2
+        UInt8 qos = (header >> 1) & 0x03;
+        BOOL retainFlag = (header & 0x01) == 0x01;
+        NSData *data = [buffer sliceAtOffset:readOffset + position length:length];
+        readOffset += frameLength;
+        pendingFrameLength = 0;
+
+        AWSMQTTMessage *msg = [[AWSMQTTMessage alloc] initWithType:type
+                                                               qos:qos
+                                                        retainFlag:retainFlag
+                                                           dupFlag:isDuplicate
+                                                              data:data];
+        [_delegate decoder:self newMessage:msg];
+    }
+}
+
 @end
@@ -46,6 +46,8 @@ typedef enum {
 - (id)initWithStream:(NSOutputStream*)aStream;
 
 - (void)encodeMessage:(AWSMQTTMessage*)msg;
+// Encodes the messages back to back so they go out in as few stream writes as possible.
+- (void)encodeMessages:(NSArray<AWSMQTTMessage*>*)messages;
 - (void)open;
 - (void)close;
 
@@ -16,9 +16,20 @@
 #import "AWSCocoaLumberjack.h"
 #import "AWSMQTTEncoder.h"
 
+// Payloads at least this large are written from the message's own bytes instead of being
+// copied into the coalescing buffer.
+static const NSUInteger AWSMQTTEncoderCopyThreshold = 4 * 1024;
+static const NSUInteger AWSMQTTEncoderCoalescingBufferSize = 16 * 1024;
+// The largest remaining length the four byte variable length encoding can express.
+static const NSUInteger AWSMQTTEncoderMaxRemainingLength = 268435455;
+
 @interface AWSMQTTEncoder () {
     NSOutputStream* stream;
-    NSMutableData*  buffer;
+    // Data waiting for the stream, in order. Fixed headers and small messages are packed into
+    // coalescing buffers; large payloads are referenced as they are.
+    NSMutableArray<NSData*>* segments;
+    NSMutableData*  coalescingBuffer;
+    NSMutableData*  spareBuffer;
     NSInteger       byteIndex;
 }
 
@@ -33,6 +44,7 @@
     _status = AWSMQTTEncoderStatusInitializing;
     stream = aStream;
     [stream setDelegate:self];
+    segments = [NSMutableArray new];
     _encodeSemaphore = dispatch_semaphore_create(1);
     return self;
 }
@@ -70,25 +82,13 @@
                 [_delegate encoder:self handleEvent:AWSMQTTEncoderEventReady];
             }
             else if (_status == AWSMQTTEncoderStatusSending) {
-                UInt8* ptr;
-                NSInteger n, length;
-                
-                ptr = (UInt8*) [buffer bytes] + byteIndex;
-                // Number of bytes pending for transfer
-                length = [buffer length] - byteIndex;
-                n = [stream write:ptr maxLength:length];
-                if (n == -1) {
-                    _status = AWSMQTTEncoderStatusError;
+                dispatch_semaphore_wait(self.encodeSemaphore, DISPATCH_TIME_FOREVER);
+                [self writeSegments];
+                AWSMQTTEncoderStatus newStatus = _status;
+                dispatch_semaphore_signal(self.encodeSemaphore);
+                if (newStatus == AWSMQTTEncoderStatusError) {
                     [_delegate encoder:self handleEvent:AWSMQTTEncoderEventErrorOccurred];
                 }
-                else if (n < length) {
-                    byteIndex += n;
-                }
-                else {
-                    buffer = NULL;
-                    byteIndex = 0;
-                    _status = AWSMQTTEncoderStatusReady;
-                }
             }
             break;
         case NSStreamEventErrorOccurred:
@@ -105,26 +105,48 @@
 }
 
 - (void)encodeMessage:(AWSMQTTMessage*)msg {
-    //Adding a mutex to prevent buffer from being modified by multiple threads
+    [self encodeMessages:@[msg]];
+}
+
+- (void)encodeMessages:(NSArray<AWSMQTTMessage*>*)messages {
+    //Adding a mutex to prevent the pending segments from being modified by multiple threads
     AWSDDLogVerbose(@"***** waiting on encodeSemaphore *****");
     dispatch_semaphore_wait(self.encodeSemaphore, DISPATCH_TIME_FOREVER);
     AWSDDLogVerbose(@"***** passed encodeSempahore. *****");
-    UInt8 header;
-    NSInteger n, length;
-    
-    if (_status != AWSMQTTEncoderStatusReady) {
+
+    if (_status != AWSMQTTEncoderStatusReady && _status != AWSMQTTEncoderStatusSending) {
         AWSDDLogInfo(@"Encoder not ready");
         dispatch_semaphore_signal(self.encodeSemaphore);
         return;
     }
-    
-    assert (buffer == NULL);
-    assert (byteIndex == 0);
-    
-    buffer = [[NSMutableData alloc] init];
-    
-    // encode fixed header
-    header = [msg type] << 4;
+
+    for (AWSMQTTMessage *msg in messages) {
+        NSUInteger remainingLength = [[msg headerData] length] + [[msg payload] length];
+        if (remainingLength > AWSMQTTEncoderMaxRemainingLength) {
+            AWSDDLogError(@"Dropping a message of type %d with %lu bytes, more than MQTT allows", [msg type], (unsigned long)remainingLength);
+            continue;
+        }
+        [self appendMessage:msg];
+    }
+    // While a write is pending, the messages queue up behind it and go out as the stream makes room.
+    if (_status == AWSMQTTEncoderStatusReady) {
+        [self writeSegments];
+    }
+    AWSMQTTEncoderStatus newStatus = _status;
+
+    AWSDDLogVerbose(@"***** signaling encodeSemaphore *****");
+    dispatch_semaphore_signal(self.encodeSemaphore);
+    if (newStatus == AWSMQTTEncoderStatusError) {
+        [_delegate encoder:self handleEvent:AWSMQTTEncoderEventErrorOccurred];
+    }
+    AWSDDLogVerbose(@"<<%@>>: Encoder finished writing %lu messages", [NSThread currentThread], (unsigned long)[messages count]);
+}
+
+- (void)appendMessage:(AWSMQTTMessage*)msg {
+    // fixed header and remaining length, at most 5 bytes for a remaining length up to AWSMQTTEncoderMaxRemainingLength
+    UInt8 fixedHeader[5];
+    NSUInteger fixedHeaderLength = 0;
+    UInt8 header = [msg type] << 4;
     if ([msg isDuplicate]) {
         header |= 0x08;
     }
@@ -132,41 +154,81 @@
     if ([msg retainFlag]) {
         header |= 0x01;
     }
-    [buffer appendBytes:&header length:1];
-    
-    // encode remaining length
-    length = [[msg data] length];
+    fixedHeader[fixedHeaderLength++] = header;
+
+    NSData *headerData = [msg headerData];
+    NSData *payload = [msg payload];
+    NSUInteger length = [headerData length] + [payload length];
     do {
         UInt8 digit = length % 128;
         length /= 128;
         if (length > 0) {
             digit |= 0x80;
         }
-        [buffer appendBytes:&digit length:1];
+        fixedHeader[fixedHeaderLength++] = digit;
     }
     while (length > 0);
-    
-    // encode message data
-    if ([msg data] != NULL) {
-        [buffer appendData:[msg data]];
+
+    [self appendBytes:fixedHeader length:fixedHeaderLength];
+    [self appendBytes:[headerData bytes] length:[headerData length]];
+    if ([payload length] >= AWSMQTTEncoderCopyThreshold) {
+        [segments addObject:payload];
+        coalescingBuffer = nil;
+    } else {
+        [self appendBytes:[payload bytes] length:[payload length]];
     }
-    
-    n = [stream write:[buffer bytes] maxLength:[buffer length]];
-    if (n == -1) {
-        _status = AWSMQTTEncoderStatusError;
-        [_delegate encoder:self handleEvent:AWSMQTTEncoderEventErrorOccurred];
+}
+
+- (void)appendBytes:(const void *)bytes length:(NSUInteger)length {
+    if (length == 0) {
+        return;
     }
-    else if (n < [buffer length]) {
-        byteIndex += n;
-        _status = AWSMQTTEncoderStatusSending;
+    // the stream may fall behind while messages keep coming, so a full buffer is left to its
+    // segment and a new one is started rather than growing without limit
+    if (coalescingBuffer != nil && [coalescingBuffer length] + length > AWSMQTTEncoderCoalescingBufferSize) {
+        coalescingBuffer = nil;
     }
-    else {
-        buffer = NULL;
-        // XXX [delegate encoder:self handleEvent:MQTTEncoderEventReady];
+    if (coalescingBuffer == nil) {
+        if (spareBuffer != nil) {
+            coalescingBuffer = spareBuffer;
+            spareBuffer = nil;
+        } else {
+            coalescingBuffer = [NSMutableData dataWithCapacity:AWSMQTTEncoderCoalescingBufferSize];
+        }
+        [segments addObject:coalescingBuffer];
     }
-    AWSDDLogVerbose(@"***** signaling encodeSemaphore *****");
-    dispatch_semaphore_signal(self.encodeSemaphore);
-    AWSDDLogVerbose(@"<<%@>>: Encoder finished writing message", [NSThread currentThread]);
+    [coalescingBuffer appendBytes:bytes length:length];
+}
+
+// Writes pending segments until the stream takes less than offered.
+- (void)writeSegments {
+    while ([segments count] > 0) {
+        NSData *segment = [segments firstObject];
+        NSInteger length = [segment length] - byteIndex;
+        NSInteger n = [stream write:(const UInt8 *)[segment bytes] + byteIndex maxLength:length];
+        if (n == -1) {
+            _status = AWSMQTTEncoderStatusError;
+            return;
+        }
+        if (n < length) {
+            byteIndex += n;
+            _status = AWSMQTTEncoderStatusSending;
+            return;
+        }
+
+        byteIndex = 0;
+        [segments removeObjectAtIndex:0];
+        if (segment == coalescingBuffer) {
+            coalescingBuffer = nil;
+        }
+        // only coalescing buffers are mutable, payloads are immutable copies
+        if ([segment isKindOfClass:[NSMutableData class]] && [segment length] <= AWSMQTTEncoderCoalescingBufferSize) {
+            // keep one buffer around so steady traffic doesn't allocate
+            [(NSMutableData *)segment setLength:0];
+            spareBuffer = (NSMutableData *)segment;
+        }
+    }
+    _status = AWSMQTTEncoderStatusReady;
 }
 
 @end
@@ -85,18 +85,32 @@ typedef enum {
         retainFlag:(BOOL)aRetainFlag
            dupFlag:(BOOL)aDupFlag
               data:(NSData*)aData;
+- (id)initWithType:(UInt8)aType
+               qos:(UInt8)aQos
+        retainFlag:(BOOL)aRetainFlag
+           dupFlag:(BOOL)aDupFlag
+        headerData:(NSData*)aHeaderData
+           payload:(NSData*)aPayload;
 
 #pragma mark Control methods
 
 - (void)setDupFlag;
 
+// A range of the message data that shares its bytes instead of copying them.
+- (NSData*)dataInRange:(NSRange)range;
+
 #pragma mark Message Properties
 
 @property (assign) UInt8 type;
 @property (assign) UInt8 qos;
 @property (assign) BOOL retainFlag;
 @property (assign) BOOL isDuplicate;
-@property (strong) NSData * data;
+@property (nonatomic, strong) NSData * data;
+
+// data is headerData followed by payload. Publishes keep the payload apart, so it is
+// referenced rather than copied on its way to the stream.
+@property (nonatomic, readonly) NSData * headerData;
+@property (nonatomic, readonly) NSData * payload;
 
 @end
 
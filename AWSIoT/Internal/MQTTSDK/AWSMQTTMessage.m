@@ -16,6 +16,13 @@
 #import "AWSCocoaLumberjack.h"
 #import "AWSMQTTMessage.h"
 
+@interface AWSMQTTMessage () {
+    // headerData and payload joined, built on first use
+    NSData *_data;
+}
+
+@end
+
 @implementation AWSMQTTMessage
 
 + (id)connectMessageWithClientId:(NSString*)clientId
@@ -146,12 +153,12 @@
     AWSDDLogVerbose(@"Publish message on topic: %@, retain flag: %@", topic, retain ? @"true":@"false");
     NSMutableData* data = [NSMutableData data];
     [data AWSMQTT_appendMQTTString:topic];
-    [data appendData:payload];
     AWSMQTTMessage *msg = [[AWSMQTTMessage alloc] initWithType:AWSMQTTPublish
                                                      qos:0
                                               retainFlag:retain
                                                  dupFlag:false
-                                                    data:data];
+                                              headerData:data
+                                                 payload:[payload copy]];
     return msg;
 }
 
@@ -166,12 +173,12 @@
     NSMutableData* data = [NSMutableData data];
     [data AWSMQTT_appendMQTTString:topic];
     [data AWSMQTT_appendUInt16BigEndian:msgId];
-    [data appendData:payload];
     AWSMQTTMessage *msg = [[AWSMQTTMessage alloc] initWithType:AWSMQTTPublish
                                                      qos:qosLevel
                                               retainFlag:retain
                                                  dupFlag:dup
-                                                    data:data];
+                                              headerData:data
+                                                 payload:[payload copy]];
     return msg;
 }
 
@@ -237,10 +244,62 @@
     return self;
 }
 
+- (id)initWithType:(UInt8)aType
+               qos:(UInt8)aQos
+        retainFlag:(BOOL)aRetainFlag
+           dupFlag:(BOOL)aDupFlag
+        headerData:(NSData*)aHeaderData
+           payload:(NSData*)aPayload {
+    _type = aType;
+    _qos = aQos;
+    _retainFlag = aRetainFlag;
+    _isDuplicate = aDupFlag;
+    _headerData = aHeaderData;
+    _payload = aPayload;
+    return self;
+}
+
+- (NSData*)data {
+    if ([_payload length] == 0) {
+        return _headerData;
+    }
+    // callers read the data and then slices of it, so join the two once and keep the result
+    @synchronized(self) {
+        if (_data == nil) {
+            NSMutableData *data = [NSMutableData dataWithCapacity:[_headerData length] + [_payload length]];
+            [data appendData:_headerData];
+            [data appendData:_payload];
+            _data = data;
+        }
+        return _data;
+    }
+}
+
+- (void)setData:(NSData*)aData {
+    @synchronized(self) {
+        _headerData = aData;
+        _payload = nil;
+        _data = nil;
+    }
+}
+
 - (void)setDupFlag {
     _isDuplicate = true;
 }
 
+- (NSData*)dataInRange:(NSRange)range {
+    NSData *data = self.data;
+    if (range.length == 0) {
+        return [NSData data];
+    }
+    // the block keeps the message data, and with it the bytes, alive
+    return [[NSData alloc] initWithBytesNoCopy:(UInt8 *)[data bytes] + range.location
+                                        length:range.length
+                                   deallocator:^(void *bytes, NSUInteger length) {
+                                       (void)data;
+                                   }];
+}
+
 @end
 
 @implementation NSMutableData (AWSMQTT)
@@ -0,0 +1,44 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import "AWSIoTMQTTTypes.h"
+
+/*
+ Bounded ring buffer that holds outbound messages until the encoder can take them. Any number of
+ threads may enqueue concurrently; enqueue and dequeue are O(1) and lock free. Only the blocking
+ full policy ever waits, and it waits for a consumer to free a slot.
+ */
+@interface AWSMQTTOutboundQueue : NSObject
+
+// The capacity is rounded up to the next power of two.
+- (instancetype)initWithCapacity:(NSUInteger)capacity;
+
+@property (readonly) NSUInteger capacity;
+// Approximate while producers and consumers are running.
+@property (readonly) NSUInteger count;
+
+// Adds the object, applying the policy if the queue is full. Returns NO when the object was not queued.
+- (BOOL)enqueue:(id)object policy:(AWSIoTMQTTOutboundQueueFullPolicy)policy;
+// Adds the object if there is a free slot.
+- (BOOL)tryEnqueue:(id)object;
+// Returns the oldest object, or nil if the queue is empty.
+- (id)dequeue;
+// Removes and returns up to limit of the oldest objects.
+- (NSArray *)dequeueObjectsUpTo:(NSUInteger)limit;
+// Releases producers waiting under the blocking policy and makes every later blocking enqueue fail.
+- (void)invalidate;
+
+@end
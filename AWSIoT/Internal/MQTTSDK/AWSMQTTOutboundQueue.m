@@ -0,0 +1,180 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import <stdatomic.h>
+#import "AWSCocoaLumberjack.h"
+#import "AWSMQTTOutboundQueue.h"
+
+// How long a blocked producer sleeps before it checks the queue again, in case a wakeup was missed.
+static const int64_t AWSMQTTOutboundQueueBlockInterval = 100 * NSEC_PER_MSEC;
+
+/*
+ Each slot carries a sequence number that tells producers and consumers whose turn it is: a slot
+ at position p is free for the producer claiming p when its sequence is p, and holds an object for
+ the consumer claiming p once its sequence is p + 1.
+ */
+typedef struct {
+    atomic_size_t sequence;
+    void *object;
+} AWSMQTTOutboundQueueSlot;
+
+@interface AWSMQTTOutboundQueue() {
+    AWSMQTTOutboundQueueSlot *slots;
+    size_t mask;
+    atomic_size_t enqueuePosition;
+    atomic_size_t dequeuePosition;
+    atomic_int waitingProducers;
+    atomic_bool invalidated;
+    dispatch_semaphore_t spaceAvailable;
+}
+
+@end
+
+@implementation AWSMQTTOutboundQueue
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity {
+    if (self = [super init]) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        slots = calloc(size, sizeof(AWSMQTTOutboundQueueSlot));
+        if (slots == NULL) {
+            return nil;
+        }
+        for (size_t i = 0; i < size; i++) {
+            atomic_init(&slots[i].sequence, i);
+        }
+        mask = size - 1;
+        _capacity = size;
+        atomic_init(&enqueuePosition, 0);
+        atomic_init(&dequeuePosition, 0);
+        atomic_init(&waitingProducers, 0);
+        atomic_init(&invalidated, false);
+        spaceAvailable = dispatch_semaphore_create(0);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    while ([self dequeue] != nil) {
+    }
+    free(slots);
+}
+
+- (NSUInteger)count {
+    size_t tail = atomic_load(&dequeuePosition);
+    size_t head = atomic_load(&enqueuePosition);
+    return head > tail ? MIN(head - tail, _capacity) : 0;
+}
+
+- (BOOL)tryEnqueue:(id)object {
+    size_t position = atomic_load_explicit(&enqueuePosition, memory_order_relaxed);
+    AWSMQTTOutboundQueueSlot *slot;
+    for (;;) {
+        slot = &slots[position & mask];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+        if (difference == 0) {
+            if (atomic_compare_exchange_weak_explicit(&enqueuePosition, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            return NO;
+        } else {
+            position = atomic_load_explicit(&enqueuePosition, memory_order_relaxed);
+        }
+    }
+    slot->object = (void *)CFBridgingRetain(object);
+    atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+    return YES;
+}
+
+- (id)dequeue {
+    size_t position = atomic_load_explicit(&dequeuePosition, memory_order_relaxed);
+    AWSMQTTOutboundQueueSlot *slot;
+    for (;;) {
+        slot = &slots[position & mask];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+        if (difference == 0) {
+            if (atomic_compare_exchange_weak_explicit(&dequeuePosition, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            return nil;
+        } else {
+            position = atomic_load_explicit(&dequeuePosition, memory_order_relaxed);
+        }
+    }
+    id object = CFBridgingRelease(slot->object);
+    slot->object = NULL;
+    atomic_store_explicit(&slot->sequence, position + mask + 1, memory_order_release);
+    if (atomic_load(&waitingProducers) > 0) {
+        dispatch_semaphore_signal(spaceAvailable);
+    }
+    return object;
+}
+
+- (NSArray *)dequeueObjectsUpTo:(NSUInteger)limit {
+    NSMutableArray *objects = [NSMutableArray arrayWithCapacity:MIN(limit, self.count)];
+    id object;
+    while (objects.count < limit && (object = [self dequeue]) != nil) {
+        [objects addObject:object];
+    }
+    return objects;
+}
+
+- (BOOL)enqueue:(id)object policy:(AWSIoTMQTTOutboundQueueFullPolicy)policy {
+    if ([self tryEnqueue:object]) {
+        return YES;
+    }
+    switch (policy) {
+        case AWSIoTMQTTOutboundQueueFullPolicyFailFast:
+            return NO;
+        case AWSIoTMQTTOutboundQueueFullPolicyDropOldest:
+            do {
+                id dropped = [self dequeue];
+                if (dropped != nil) {
+                    AWSDDLogWarn(@"Outbound queue is full, dropping the oldest message %@", dropped);
+                }
+            } while (![self tryEnqueue:object]);
+            return YES;
+        case AWSIoTMQTTOutboundQueueFullPolicyBlock: {
+            atomic_fetch_add(&waitingProducers, 1);
+            // Check again after registering as a waiter so a slot freed in between is not missed.
+            BOOL enqueued = [self tryEnqueue:object];
+            while (!enqueued && !atomic_load(&invalidated)) {
+                dispatch_semaphore_wait(spaceAvailable, dispatch_time(DISPATCH_TIME_NOW, AWSMQTTOutboundQueueBlockInterval));
+                enqueued = [self tryEnqueue:object];
+            }
+            atomic_fetch_sub(&waitingProducers, 1);
+            return enqueued;
+        }
+    }
+    return NO;
+}
+
+- (void)invalidate {
+    atomic_store(&invalidated, true);
+    int waiting = atomic_load(&waitingProducers);
+    for (int i = 0; i < waiting; i++) {
+        dispatch_semaphore_signal(spaceAvailable);
+    }
+}
+
+@end
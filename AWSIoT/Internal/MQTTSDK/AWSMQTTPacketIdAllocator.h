@@ -0,0 +1,34 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+/*
+ Hands out the 16-bit packet identifiers of in-flight MQTT messages. Used identifiers are kept in a
+ 65535-bit bitmap and allocation continues from where the last one left off, so allocate and release
+ are O(1) amortized however many identifiers are in use. Not thread safe.
+ */
+@interface AWSMQTTPacketIdAllocator : NSObject
+
+// The number of identifiers allocated and not yet released.
+@property (readonly) NSUInteger count;
+
+// Returns the next free identifier after the last one allocated, or 0 if all 65535 are in use.
+- (UInt16)allocate;
+- (void)releaseIdentifier:(UInt16)identifier;
+- (BOOL)isAllocated:(UInt16)identifier;
+- (void)releaseAll;
+
+@end
@@ -0,0 +1,80 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import "AWSMQTTPacketIdAllocator.h"
+
+#define AWSMQTTPacketIdAllocatorWordCount (65536 / 64)
+
+@interface AWSMQTTPacketIdAllocator() {
+    // Bit n of word n / 64 is set while identifier n is in use. Identifier 0 is never handed out.
+    uint64_t words[AWSMQTTPacketIdAllocatorWordCount];
+    // Where the search for the next free identifier starts.
+    NSUInteger nextIdentifier;
+}
+
+@property (readwrite) NSUInteger count;
+
+@end
+
+@implementation AWSMQTTPacketIdAllocator
+
+- (instancetype)init {
+    if (self = [super init]) {
+        [self releaseAll];
+    }
+    return self;
+}
+
+- (UInt16)allocate {
+    if (_count == UINT16_MAX) {
+        return 0;
+    }
+    NSUInteger wordIndex = nextIdentifier / 64;
+    // Ignore the identifiers below the start position in its word until the search wraps around.
+    uint64_t word = words[wordIndex] | ((1ULL << (nextIdentifier % 64)) - 1);
+    for (NSUInteger i = 0; i <= AWSMQTTPacketIdAllocatorWordCount; i++) {
+        if (word != UINT64_MAX) {
+            NSUInteger identifier = wordIndex * 64 + (NSUInteger)__builtin_ctzll(~word);
+            words[wordIndex] |= 1ULL << (identifier % 64);
+            nextIdentifier = (identifier + 1) % 65536;
+            _count++;
+            return (UInt16)identifier;
+        }
+        wordIndex = (wordIndex + 1) % AWSMQTTPacketIdAllocatorWordCount;
+        word = words[wordIndex];
+    }
+    return 0;
+}
+
+- (void)releaseIdentifier:(UInt16)identifier {
+    if (identifier == 0 || ![self isAllocated:identifier]) {
+        return;
+    }
+    words[identifier / 64] &= ~(1ULL << (identifier % 64));
+    _count--;
+}
+
+- (BOOL)isAllocated:(UInt16)identifier {
+    return (words[identifier / 64] & (1ULL << (identifier % 64))) != 0;
+}
+
+- (void)releaseAll {
+    memset(words, 0, sizeof(words));
+    words[0] = 1;
+    nextIdentifier = 1;
+    _count = 0;
+}
+
+@end
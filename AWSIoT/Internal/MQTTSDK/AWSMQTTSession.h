@@ -15,6 +15,7 @@
 
 #import <Foundation/Foundation.h>
 #import "AWSMQTTMessage.h"
+#import "AWSIoTMQTTTypes.h"
 
 typedef enum {
     AWSMQTTSessionStatusCreated,
@@ -58,6 +59,19 @@ typedef enum {
         willRetainFlag:(BOOL)willRetainFlag
   publishRetryThrottle: (NSUInteger)publishRetryThrottle;
 
+- (id)initWithClientId:(NSString*)theClientId
+              userName:(NSString*)theUserName
+              password:(NSString*)thePassword
+             keepAlive:(UInt16)theKeepAliveInterval
+          cleanSession:(BOOL)theCleanSessionFlag
+             willTopic:(NSString*)willTopic
+               willMsg:(NSData*)willMsg
+               willQoS:(UInt8)willQoS
+        willRetainFlag:(BOOL)willRetainFlag
+  publishRetryThrottle:(NSUInteger)publishRetryThrottle
+ outboundQueueCapacity:(NSUInteger)outboundQueueCapacity
+outboundQueueFullPolicy:(AWSIoTMQTTOutboundQueueFullPolicy)outboundQueueFullPolicy;
+
 #pragma mark Delegates and Callback blocks
 @property (weak) id<AWSMQTTSessionDelegate> delegate;
 @property (strong) void (^connectionHandler)(AWSMQTTSessionEvent event);
@@ -77,18 +91,25 @@ typedef enum {
 
 #pragma mark Message Publishing
 @property NSUInteger publishRetryThrottle; //The max number of publish messages to retry per second if the pub-ack is not received within 60 seconds
-
-- (void)publishData:(NSData*)theData onTopic:(NSString*)theTopic;
+@property (readonly) NSUInteger outboundQueueCapacity; //The max number of publishes held while the encoder is busy or the connection is down
+@property AWSIoTMQTTOutboundQueueFullPolicy outboundQueueFullPolicy; //What a publish does when the outbound queue is full
+@property NSUInteger maxInFlightPublishes; //The max number of unacknowledged QoS 1 and 2 publishes. 0 means no limit beyond the 65535 message ids
+@property (readonly) NSUInteger inFlightPublishCount; //The number of QoS 1 and 2 publishes waiting for acknowledgement
+
+// Publish methods return NO, or a message id of 0, when the outbound queue rejected the message.
+// A QoS 1 or 2 publish made while maxInFlightPublishes are unacknowledged waits for an acknowledgement,
+// unless the outbound queue full policy is fail fast or it is made on the stream thread, in which case it is rejected.
+- (BOOL)publishData:(NSData*)theData onTopic:(NSString*)theTopic;
 - (UInt16)publishDataAtLeastOnce:(NSData*)theData onTopic:(NSString*)theTopic;
 - (UInt16)publishDataAtLeastOnce:(NSData*)theData onTopic:(NSString*)theTopic retain:(BOOL)retainFlag;
-- (void)publishDataAtMostOnce:(NSData*)theData onTopic:(NSString*)theTopic;
-- (void)publishDataAtMostOnce:(NSData*)theData onTopic:(NSString*)theTopic retain:(BOOL)retainFlag;
+- (BOOL)publishDataAtMostOnce:(NSData*)theData onTopic:(NSString*)theTopic;
+- (BOOL)publishDataAtMostOnce:(NSData*)theData onTopic:(NSString*)theTopic retain:(BOOL)retainFlag;
 - (UInt16)publishDataExactlyOnce:(NSData*)theData onTopic:(NSString*)theTopic;
 - (UInt16)publishDataExactlyOnce:(NSData*)theData onTopic:(NSString*)theTopic retain:(BOOL)retainFlag;
 - (void)publishJson:(id)payload onTopic:(NSString*)theTopic;
 
 - (BOOL)isReadyToPublish;
-- (void)send:(AWSMQTTMessage*)msg;
+- (BOOL)send:(AWSMQTTMessage*)msg;
 
 @end
 
@@ -18,11 +18,22 @@
 #import "AWSMQTTDecoder.h"
 #import "AWSMQTTEncoder.h"
 #import "AWSMQttTxFlow.h"
+#import "AWSMQTTOutboundQueue.h"
+#import "AWSMQTTPacketIdAllocator.h"
+#import "AWSMQTTTimerWheel.h"
+
+// Default number of publishes the session holds while the encoder is busy or the connection is down.
+static const NSUInteger AWSMQTTSessionDefaultOutboundQueueCapacity = 1024;
+// Acks and subscription requests are queued apart from publishes so publish backpressure never holds them up.
+static const NSUInteger AWSMQTTSessionControlQueueCapacity = 256;
+// Ticks (seconds) after which an unacknowledged QoS 1 or 2 flow is sent again.
+static const unsigned int AWSMQTTSessionRetryInterval = 60;
+// How long a publisher waiting for room in the in-flight window sleeps before it checks again, in case a wakeup was missed.
+static const NSTimeInterval AWSMQTTSessionFlowWaitInterval = 0.1;
 
 @interface AWSMQTTSession () <AWSMQTTDecoderDelegate,AWSMQTTEncoderDelegate>  {
     AWSMQTTSessionStatus    status;  //Current status of the session. Can be one of the values specified in the MQTTSessionStatus enum
     NSString*            clientId; //Unique Client ID passed in by the MQTTClient.
-    UInt16               txMsgId; //unique ID for the message. Counter that starts from 1
     
     UInt16               keepAliveInterval;  //client will send a PINGREQ once every keepAliveInterval to the server.
     NSInteger            idleTimer; // counter used to know when to send the PINGREQ
@@ -35,8 +46,13 @@
     
     AWSMQTTEncoder*         encoder; //Low level protocol handler that converts a message into out bound network data
     AWSMQTTDecoder*         decoder; //Low level protocol handler that converts in bound network data into a Message
+    NSThread*            streamThread; //Thread whose run loop services the encoder and decoder
     
     NSMutableDictionary* txFlows; //Required for QOS1. Outbound publishes will be stored in txFlows until a PubAck is received
+    AWSMQTTPacketIdAllocator* packetIds; //Message ids of the flows in txFlows
+    AWSMQTTTimerWheel*   retryWheel; //Retransmission schedule of the flows in txFlows, by tick
+    NSCondition*         flowCondition; //Guards txFlows, packetIds, retryWheel and ticks. Signalled when a flow completes.
+    BOOL                 flowsInvalidated; //Set by close to release publishers waiting for room in the in-flight window
     NSMutableDictionary* rxFlows; //Required for handling QOS 2. Not in use currently
     unsigned int         retryThreshold; //used to throtttle retries. Overloading the publishes beyond service limit will result in message loss.
 }
@@ -56,11 +72,11 @@
 - (void)handlePubrel:(AWSMQTTMessage*)msg;
 - (void)handlePubcomp:(AWSMQTTMessage*)msg;
 - (void)handleSuback:(AWSMQTTMessage*)msg;
-- (void)send:(AWSMQTTMessage*)msg;
+- (BOOL)send:(AWSMQTTMessage*)msg;
 - (UInt16)nextMsgId;
 
-@property (strong,atomic) NSMutableArray* queue; //Queue to temporarily hold messages if encoder is busy sending another message
-@property (strong,atomic) NSMutableArray* timerRing; // circular array of 60. Each element is a set that contains the messages that need to be retried.
+@property (strong,nonatomic) AWSMQTTOutboundQueue* queue; //Queue to temporarily hold publishes if encoder is busy sending another message
+@property (strong,nonatomic) AWSMQTTOutboundQueue* controlQueue; //Acks and subscription requests waiting for the encoder. Sent ahead of queued publishes.
 @property (strong,nonatomic) dispatch_semaphore_t drainSenderQueueSemaphore;
 
 @end
@@ -78,6 +94,33 @@
                willQoS:(UInt8)willQoS
         willRetainFlag:(BOOL)willRetainFlag
   publishRetryThrottle: (NSUInteger)publishRetryThrottle
+{
+    return [self initWithClientId:theClientId
+                         userName:theUserName
+                         password:thePassword
+                        keepAlive:theKeepAliveInterval
+                     cleanSession:theCleanSessionFlag
+                        willTopic:willTopic
+                          willMsg:willMsg
+                          willQoS:willQoS
+                   willRetainFlag:willRetainFlag
+             publishRetryThrottle:publishRetryThrottle
+            outboundQueueCapacity:AWSMQTTSessionDefaultOutboundQueueCapacity
+          outboundQueueFullPolicy:AWSIoTMQTTOutboundQueueFullPolicyDropOldest];
+}
+
+- (id)initWithClientId:(NSString*)theClientId
+              userName:(NSString*)theUserName
+              password:(NSString*)thePassword
+             keepAlive:(UInt16)theKeepAliveInterval
+          cleanSession:(BOOL)theCleanSessionFlag
+             willTopic:(NSString*)willTopic
+               willMsg:(NSData*)willMsg
+               willQoS:(UInt8)willQoS
+        willRetainFlag:(BOOL)willRetainFlag
+  publishRetryThrottle:(NSUInteger)publishRetryThrottle
+ outboundQueueCapacity:(NSUInteger)outboundQueueCapacity
+outboundQueueFullPolicy:(AWSIoTMQTTOutboundQueueFullPolicy)outboundQueueFullPolicy
 {
     AWSDDLogInfo(@"%s [Line %d], Thread:%@ ", __PRETTY_FUNCTION__, __LINE__, [NSThread currentThread]);
     
@@ -98,15 +141,16 @@
         keepAliveInterval = theKeepAliveInterval;
         connectMessage = msg;
         _publishRetryThrottle = publishRetryThrottle;
-        self.queue = [NSMutableArray array];
-        txMsgId = 1;
+        self.queue = [[AWSMQTTOutboundQueue alloc] initWithCapacity:(outboundQueueCapacity > 0 ? outboundQueueCapacity : AWSMQTTSessionDefaultOutboundQueueCapacity)];
+        self.controlQueue = [[AWSMQTTOutboundQueue alloc] initWithCapacity:AWSMQTTSessionControlQueueCapacity];
+        _outboundQueueCapacity = self.queue.capacity;
+        _outboundQueueFullPolicy = outboundQueueFullPolicy;
+        _maxInFlightPublishes = 0;
         txFlows = [[NSMutableDictionary alloc] init];
         rxFlows = [[NSMutableDictionary alloc] init];
-        self.timerRing = [[NSMutableArray alloc] initWithCapacity:60];
-        int i;
-        for (i = 0; i < 60; i++) {
-            [self.timerRing addObject:[NSMutableSet new]];
-        }
+        packetIds = [AWSMQTTPacketIdAllocator new];
+        retryWheel = [AWSMQTTTimerWheel new];
+        flowCondition = [NSCondition new];
         ticks = 0;
         status = AWSMQTTSessionStatusCreated;
     }
@@ -119,6 +163,7 @@
               outputStream:(NSOutputStream *)writeStream {
     AWSDDLogInfo(@"<<%@>> Initializing MQTTEncoder and MQTTDecoder streams", [NSThread currentThread]);
     status = AWSMQTTSessionStatusCreated;
+    streamThread = [NSThread currentThread];
     
     //Setup encoder
     encoder = [[AWSMQTTEncoder alloc] initWithStream:writeStream];
@@ -144,6 +189,13 @@
 - (void)close {
     [encoder close];
     [decoder close];
+    //Release any publisher still waiting for room in the queue.
+    [self.queue invalidate];
+    [self.controlQueue invalidate];
+    [flowCondition lock];
+    flowsInvalidated = YES;
+    [flowCondition broadcast];
+    [flowCondition unlock];
     if (timer != nil) {
         [timer invalidate];
         timer = nil;
@@ -177,21 +229,21 @@
 
 #pragma mark Publish Methods
 
-- (void)publishData:(NSData*)data onTopic:(NSString*)topic {
-    [self publishDataAtMostOnce:data onTopic:topic];
+- (BOOL)publishData:(NSData*)data onTopic:(NSString*)topic {
+    return [self publishDataAtMostOnce:data onTopic:topic];
 }
 
-- (void)publishDataAtMostOnce:(NSData*)data
+- (BOOL)publishDataAtMostOnce:(NSData*)data
                       onTopic:(NSString*)topic {
-    [self publishDataAtMostOnce:data onTopic:topic retain:false];
+    return [self publishDataAtMostOnce:data onTopic:topic retain:false];
 }
 
-- (void)publishDataAtMostOnce:(NSData*)data
+- (BOOL)publishDataAtMostOnce:(NSData*)data
                       onTopic:(NSString*)topic
                        retain:(BOOL)retainFlag {
-    [self send:[AWSMQTTMessage publishMessageWithData:data
-                                           onTopic:topic
-                                        retainFlag:retainFlag]];
+    return [self send:[AWSMQTTMessage publishMessageWithData:data
+                                                  onTopic:topic
+                                               retainFlag:retainFlag]];
 }
 
 - (UInt16)publishDataAtLeastOnce:(NSData*)data
@@ -202,19 +254,10 @@
 - (UInt16)publishDataAtLeastOnce:(NSData*)data
                        onTopic:(NSString*)topic
                         retain:(BOOL)retainFlag {
-    UInt16 msgId = [self nextMsgId];
-    AWSMQTTMessage *msg = [AWSMQTTMessage publishMessageWithData:data
-                                                   onTopic:topic
-                                                       qos:1
-                                                     msgId:msgId
-                                                retainFlag:retainFlag
-                                                   dupFlag:false];
-    AWSMQttTxFlow *flow = [AWSMQttTxFlow flowWithMsg:msg
-                                      deadline:(ticks + 60)];
-    [txFlows setObject:flow forKey:[NSNumber numberWithUnsignedInt:msgId]];
-    [[self.timerRing objectAtIndex:([flow deadline] % 60)] addObject:[NSNumber numberWithUnsignedInt:msgId]];
-    AWSDDLogDebug(@"Published message %hu for QOS 1", msgId);
-    [self send:msg];
+    UInt16 msgId = [self publishFlowWithData:data onTopic:topic qos:1 retain:retainFlag];
+    if (msgId != 0) {
+        AWSDDLogDebug(@"Published message %hu for QOS 1", msgId);
+    }
     return msgId;
 }
 
@@ -226,21 +269,90 @@
 - (UInt16)publishDataExactlyOnce:(NSData*)data
                        onTopic:(NSString*)topic
                         retain:(BOOL)retainFlag {
-    UInt16 msgId = [self nextMsgId];
+    return [self publishFlowWithData:data onTopic:topic qos:2 retain:retainFlag];
+}
+
+// Sends a QoS 1 or 2 publish and keeps it in txFlows, scheduled for retransmission, until it is acknowledged.
+- (UInt16)publishFlowWithData:(NSData*)data
+                      onTopic:(NSString*)topic
+                          qos:(UInt8)qos
+                       retain:(BOOL)retainFlag {
+    UInt16 msgId = [self reserveFlowMsgId];
+    if (msgId == 0) {
+        AWSDDLogWarn(@"<<%@>>: MQTTSession in-flight window is full, QoS %d publish on %@ was not sent", [NSThread currentThread], qos, topic);
+        return 0;
+    }
     AWSMQTTMessage *msg = [AWSMQTTMessage publishMessageWithData:data
                                                    onTopic:topic
-                                                       qos:2
+                                                       qos:qos
                                                      msgId:msgId
                                                 retainFlag:retainFlag
                                                    dupFlag:false];
     AWSMQttTxFlow *flow = [AWSMQttTxFlow flowWithMsg:msg
-                                      deadline:(ticks + 60)];
+                                      deadline:0];
+    [flowCondition lock];
     [txFlows setObject:flow forKey:[NSNumber numberWithUnsignedInt:msgId]];
-    [[self.timerRing objectAtIndex:([flow deadline] % 60)] addObject:[NSNumber numberWithUnsignedInt:msgId]];
-    [self send:msg];
+    [retryWheel scheduleFlow:flow atTick:(ticks + AWSMQTTSessionRetryInterval)];
+    [flowCondition unlock];
+    if (![self send:msg]) {
+        [self removeFlow:flow forMsgId:msgId];
+        return 0;
+    }
+    return msgId;
+}
+
+// Allocates the message id of a new flow once the in-flight window has room. Waits for an
+// acknowledgement to free a slot unless the full policy is fail fast or this is the stream thread,
+// which delivers the acknowledgements. Returns 0 if the publish must be rejected.
+- (UInt16)reserveFlowMsgId {
+    BOOL mayWait = self.outboundQueueFullPolicy != AWSIoTMQTTOutboundQueueFullPolicyFailFast
+        && [NSThread currentThread] != streamThread;
+    UInt16 msgId = 0;
+    [flowCondition lock];
+    while (!flowsInvalidated) {
+        NSUInteger window = self.maxInFlightPublishes;
+        if (window == 0 || [packetIds count] < window) {
+            msgId = [packetIds allocate];
+            if (msgId != 0) {
+                break;
+            }
+        }
+        if (!mayWait) {
+            break;
+        }
+        [flowCondition waitUntilDate:[NSDate dateWithTimeIntervalSinceNow:AWSMQTTSessionFlowWaitInterval]];
+    }
+    [flowCondition unlock];
     return msgId;
 }
 
+// Forgets a completed flow, or a publish the outbound queue rejected, so it is neither retried nor holding its message id.
+- (void)removeFlow:(AWSMQttTxFlow*)flow forMsgId:(UInt16)msgId {
+    NSNumber *key = [NSNumber numberWithUnsignedInt:msgId];
+    [flowCondition lock];
+    if ([txFlows objectForKey:key] == flow) {
+        [retryWheel cancelFlow:flow];
+        [txFlows removeObjectForKey:key];
+        [packetIds releaseIdentifier:msgId];
+        [flowCondition signal];
+    }
+    [flowCondition unlock];
+}
+
+- (NSUInteger)inFlightPublishCount {
+    [flowCondition lock];
+    NSUInteger count = [packetIds count];
+    [flowCondition unlock];
+    return count;
+}
+
+- (AWSMQttTxFlow*)flowForMsgId:(NSNumber*)msgId {
+    [flowCondition lock];
+    AWSMQttTxFlow *flow = [txFlows objectForKey:msgId];
+    [flowCondition unlock];
+    return flow;
+}
+
 - (void)publishJson:(id)payload onTopic:(NSString*)theTopic {
     NSError * error = nil;
     NSData * data = [NSJSONSerialization dataWithJSONObject:payload options:0 error:&error];
@@ -265,31 +377,26 @@
         }
     }
     
-    ticks++;
-    NSEnumerator *e = [[[self.timerRing objectAtIndex:(ticks % 60)] allObjects] objectEnumerator];
-    id msgId;
-    
     //Stay under the throttle here and move the work to the next tick if throttle is breached.
     NSUInteger count = [self.queue count];
-    [self drainSenderQueue];
-    while ((msgId = [e nextObject])) {
-        AWSMQttTxFlow *flow = [txFlows objectForKey:msgId];
-        AWSMQTTMessage *msg = [flow msg];
-        [flow setDeadline:(ticks + 60)];
-        [msg setDupFlag];
-        [self send:msg];
-        count++;
-        if ( count >= _publishRetryThrottle ) {
-            break;
+    NSMutableArray *retries = [NSMutableArray new];
+    [flowCondition lock];
+    ticks++;
+    for (AWSMQttTxFlow *flow in [retryWheel flowsDueAtTick:ticks]) {
+        if (count >= _publishRetryThrottle) {
+            [retryWheel scheduleFlow:flow atTick:(ticks + 1)];
+            continue;
         }
+        [retryWheel scheduleFlow:flow atTick:(ticks + AWSMQTTSessionRetryInterval)];
+        [[flow msg] setDupFlag];
+        [retries addObject:[flow msg]];
+        count++;
     }
-    
-    //The threshold has been breached, move the overflow to the next tick.
-    while ((msgId = [e nextObject])) {
-        AWSMQttTxFlow *flow = [txFlows objectForKey:msgId];
-        [flow setDeadline:((ticks +1) %  60)];
-        [[self.timerRing objectAtIndex:((ticks + 1) % 60)] addObject:msgId];
-        [[self.timerRing objectAtIndex:(ticks % 60)] removeObject:msgId];
+    [flowCondition unlock];
+
+    [self drainSenderQueue];
+    for (AWSMQTTMessage *msg in retries) {
+        [self send:msg];
     }
     
     if (count > 0 ) {
@@ -316,20 +423,7 @@
                     case AWSMQTTSessionStatusConnecting:
                         break;
                     case AWSMQTTSessionStatusConnected:
-                        AWSDDLogVerbose(@"%s [Line %d], Thread:%@ waiting on drainSenderQueueSemaphore", __PRETTY_FUNCTION__, __LINE__, [NSThread currentThread]);
-                        dispatch_semaphore_wait(self.drainSenderQueueSemaphore, DISPATCH_TIME_FOREVER);
-                        AWSDDLogVerbose(@"%s [Line %d], Thread:%@ passed  drainSenderQueueSemaphore", __PRETTY_FUNCTION__, __LINE__, [NSThread currentThread]);
-                        
-                        if ([self.queue count] > 0) {
-                            AWSDDLogDebug(@"Sending message from session queue" );
-                            AWSMQTTMessage *msg = [self.queue objectAtIndex:0];
-                            [self.queue removeObjectAtIndex:0];
-                            [encoder encodeMessage:msg];
-                        }
-                        
-                        AWSDDLogVerbose(@"%s [Line %d], Thread:%@ signaling on drainSenderQueueSemaphore", __PRETTY_FUNCTION__, __LINE__, [NSThread currentThread]);
-                        dispatch_semaphore_signal(self.drainSenderQueueSemaphore);
-                        AWSDDLogVerbose(@"%s [Line %d], Thread:%@ finshed draining messages", __PRETTY_FUNCTION__, __LINE__, [NSThread currentThread]);
+                        [self drainSenderQueue];
                         break;
                     case AWSMQTTSessionStatusError:
                         break;
@@ -487,27 +581,27 @@
     if ([data length] < 2 + topicLength) {
         return;
     }
-    NSData *topicData = [data subdataWithRange:NSMakeRange(2, topicLength)];
-    NSString *topic = [[NSString alloc] initWithData:topicData
-                                            encoding:NSUTF8StringEncoding];
-    NSRange range = NSMakeRange(2 + topicLength, [data length] - topicLength - 2);
-    data = [data subdataWithRange:range];
+    NSString *topic = [[NSString alloc] initWithBytes:bytes + 2
+                                               length:topicLength
+                                             encoding:NSUTF8StringEncoding];
+    NSUInteger payloadOffset = 2 + topicLength;
     if ([msg qos] == 0) {
+        data = [msg dataInRange:NSMakeRange(payloadOffset, [data length] - payloadOffset)];
         [_delegate session:self newMessage:data onTopic:topic];
         if(_messageHandler){
             _messageHandler(data, topic);
         }
     }
     else {
-        if ([data length] < 2) {
+        if ([data length] < payloadOffset + 2) {
             return;
         }
-        bytes = [data bytes];
-        UInt16 msgId = 256 * bytes[0] + bytes[1];
+        UInt16 msgId = 256 * bytes[payloadOffset] + bytes[payloadOffset + 1];
         if (msgId == 0) {
             return;
         }
-        data = [data subdataWithRange:NSMakeRange(2, [data length] - 2)];
+        payloadOffset += 2;
+        data = [msg dataInRange:NSMakeRange(payloadOffset, [data length] - payloadOffset)];
         if ([msg qos] == 1) {
             [_delegate session:self newMessage:data onTopic:topic];
             
@@ -535,7 +629,7 @@
     if ([msgId unsignedIntValue] == 0) {
         return;
     }
-    AWSMQttTxFlow *flow = [txFlows objectForKey:msgId];
+    AWSMQttTxFlow *flow = [self flowForMsgId:msgId];
     if (flow == nil) {
         return;
     }
@@ -544,8 +638,7 @@
         return;
     }
     
-    [[self.timerRing objectAtIndex:([flow deadline] % 60)] removeObject:msgId];
-    [txFlows removeObjectForKey:msgId];
+    [self removeFlow:flow forMsgId:msgId.unsignedShortValue];
     AWSDDLogDebug(@"Removing msgID %@ from internal store for QOS1 gaurantee", msgId);
     [_delegate session:self newAckForMessageId:msgId.unsignedShortValue];
 }
@@ -560,19 +653,16 @@
     if ([msgId unsignedIntValue] == 0) {
         return;
     }
+    [flowCondition lock];
     AWSMQttTxFlow *flow = [txFlows objectForKey:msgId];
-    if (flow == nil) {
-        return;
-    }
-    msg = [flow msg];
-    if ([msg type] != AWSMQTTPublish || [msg qos] != 2) {
+    if (flow == nil || [[flow msg] type] != AWSMQTTPublish || [[flow msg] qos] != 2) {
+        [flowCondition unlock];
         return;
     }
     msg = [AWSMQTTMessage pubrelMessageWithMessageId:[msgId unsignedIntValue]];
     [flow setMsg:msg];
-    [[self.timerRing objectAtIndex:([flow deadline] % 60)] removeObject:msgId];
-    [flow setDeadline:(ticks + 60)];
-    [[self.timerRing objectAtIndex:([flow deadline] % 60)] addObject:msgId];
+    [retryWheel scheduleFlow:flow atTick:(ticks + AWSMQTTSessionRetryInterval)];
+    [flowCondition unlock];
     
     [self send:msg];
 }
@@ -610,13 +700,12 @@
     if ([msgId unsignedIntValue] == 0) {
         return;
     }
-    AWSMQttTxFlow *flow = [txFlows objectForKey:msgId];
+    AWSMQttTxFlow *flow = [self flowForMsgId:msgId];
     if (flow == nil || [[flow msg] type] != AWSMQTTPubrel) {
         return;
     }
     
-    [[self.timerRing objectAtIndex:([flow deadline] % 60)] removeObject:msgId];
-    [txFlows removeObjectForKey:msgId];
+    [self removeFlow:flow forMsgId:msgId.unsignedShortValue];
 }
 
 # pragma mark error handler
@@ -645,33 +734,42 @@
 }
 
 # pragma mark Message Send methods
-- (void)send:(AWSMQTTMessage*)msg {
-    if ([encoder status] == AWSMQTTEncoderStatusReady) {
-        [self drainSenderQueue];
-        AWSDDLogVerbose(@"<<%@>>: MQTTSession.send msg to server", [NSThread currentThread]);
-        [encoder encodeMessage:msg];
+- (BOOL)send:(AWSMQTTMessage*)msg {
+    BOOL queued;
+    BOOL onStreamThread = [NSThread currentThread] == streamThread;
+    if ([msg type] == AWSMQTTPublish) {
+        AWSIoTMQTTOutboundQueueFullPolicy policy = self.outboundQueueFullPolicy;
+        if (policy == AWSIoTMQTTOutboundQueueFullPolicyBlock && onStreamThread) {
+            //Waiting here would stall the run loop that drains the queue.
+            policy = AWSIoTMQTTOutboundQueueFullPolicyFailFast;
+        }
+        queued = [self.queue enqueue:msg policy:policy];
+    }
+    else if ([msg type] == AWSMQTTDisconnect) {
+        //Goes behind the publishes queued before it, and must not be lost.
+        queued = [self.queue enqueue:msg policy:AWSIoTMQTTOutboundQueueFullPolicyDropOldest];
     }
     else {
-        AWSDDLogVerbose(@"%s [Line %d], Thread:%@ waiting on drainSenderQueueSemaphore", __PRETTY_FUNCTION__, __LINE__, [NSThread currentThread]);
-        dispatch_semaphore_wait(self.drainSenderQueueSemaphore, DISPATCH_TIME_FOREVER);
-        AWSDDLogVerbose(@"%s [Line %d], Thread:%@ passed  drainSenderQueueSemaphore", __PRETTY_FUNCTION__, __LINE__, [NSThread currentThread]);
-        
-        AWSDDLogDebug(@"<<%@>>: MQTTSession.send added msg to queue to send later", [NSThread currentThread]);
-        [self.queue addObject:msg];
-        
-        
-        AWSDDLogVerbose(@"%s [Line %d], Thread:%@ signaling drainSenderQueueSemaphore", __PRETTY_FUNCTION__, __LINE__, [NSThread currentThread]);
-        dispatch_semaphore_signal(self.drainSenderQueueSemaphore);
-        AWSDDLogVerbose(@"%s [Line %d], Thread:%@ finished draining messages", __PRETTY_FUNCTION__, __LINE__, [NSThread currentThread]);
+        //An ack that does not fit is resent by the server, so never wait for room on the stream thread.
+        queued = [self.controlQueue enqueue:msg
+                                     policy:(onStreamThread ? AWSIoTMQTTOutboundQueueFullPolicyFailFast : AWSIoTMQTTOutboundQueueFullPolicyBlock)];
     }
+    if (!queued) {
+        AWSDDLogWarn(@"<<%@>>: MQTTSession.send outbound queue is full, message type %d was not sent", [NSThread currentThread], [msg type]);
+        return NO;
+    }
+    AWSDDLogVerbose(@"<<%@>>: MQTTSession.send queued msg for the server", [NSThread currentThread]);
+    [self drainSenderQueue];
+    return YES;
 }
 
+// Message id for a subscription request. It is not held until the SUBACK, so it only skips the ids of in-flight publishes.
 - (UInt16)nextMsgId {
-    txMsgId++;
-    while (txMsgId == 0 || [txFlows objectForKey:[NSNumber numberWithUnsignedInt:txMsgId]] != nil) {
-        txMsgId++;
-    }
-    return txMsgId;
+    [flowCondition lock];
+    UInt16 msgId = [packetIds allocate];
+    [packetIds releaseIdentifier:msgId];
+    [flowCondition unlock];
+    return msgId;
 }
 
 - (BOOL)isReadyToPublish {
@@ -679,23 +777,39 @@
     return encoder && [encoder status] == AWSMQTTEncoderStatusReady;
 }
 
--(void) drainSenderQueue {
-    AWSDDLogVerbose(@"%s [Line %d], Thread:%@ waiting on drainSenderQueueSemaphore", __PRETTY_FUNCTION__, __LINE__, [NSThread currentThread]);
-    dispatch_semaphore_wait(self.drainSenderQueueSemaphore, DISPATCH_TIME_FOREVER);
-    AWSDDLogVerbose(@"%s [Line %d], Thread:%@ passed drainSenderQueueSemaphore", __PRETTY_FUNCTION__, __LINE__, [NSThread currentThread]);
-
-    int count = 0;
-    while ([self.queue count] > 0 && count < _publishRetryThrottle && [self isReadyToPublish]) {
-        AWSDDLogDebug(@"Sending message from session queue" );
-        AWSMQTTMessage *msg = [self.queue objectAtIndex:0];
-        [self.queue removeObjectAtIndex:0];
-        [encoder encodeMessage:msg];
-        count = count + 1;
+// Hands up to publishRetryThrottle queued messages to the encoder as one batch, acks and subscription requests first. Called with drainSenderQueueSemaphore held.
+- (void)encodeQueuedMessages {
+    if (![self isReadyToPublish]) {
+        return;
     }
-    
-    AWSDDLogVerbose(@"%s [Line %d], Thread:%@ signaling on drainSenderQueueSemaphore", __PRETTY_FUNCTION__, __LINE__, [NSThread currentThread]);
-    dispatch_semaphore_signal(self.drainSenderQueueSemaphore);
+    NSUInteger limit = MAX(_publishRetryThrottle, (NSUInteger)1);
+    NSArray *messages = [self.controlQueue dequeueObjectsUpTo:limit];
+    if ([messages count] < limit) {
+        NSArray *publishes = [self.queue dequeueObjectsUpTo:(limit - [messages count])];
+        messages = [messages count] == 0 ? publishes : [messages arrayByAddingObjectsFromArray:publishes];
+    }
+    if ([messages count] == 0) {
+        return;
+    }
+    AWSDDLogDebug(@"Sending %lu messages from session queue", (unsigned long)[messages count]);
+    [encoder encodeMessages:messages];
+}
+
+- (BOOL)hasQueuedMessages {
+    return [self.controlQueue count] > 0 || [self.queue count] > 0;
+}
+
+// Only one thread drains at a time. A thread that finds the queue already being drained leaves its
+// messages to the drainer, which checks the queue again after letting go of the semaphore.
+-(void) drainSenderQueue {
+    do {
+        if (dispatch_semaphore_wait(self.drainSenderQueueSemaphore, DISPATCH_TIME_NOW) != 0) {
+            AWSDDLogVerbose(@"%s [Line %d], Thread:%@ queue is being drained by another thread", __PRETTY_FUNCTION__, __LINE__, [NSThread currentThread]);
+            return;
+        }
+        [self encodeQueuedMessages];
+        dispatch_semaphore_signal(self.drainSenderQueueSemaphore);
+    } while ([self hasQueuedMessages] && [self isReadyToPublish]);
     AWSDDLogVerbose(@"%s [Line %d], Thread:%@ finished draining messages", __PRETTY_FUNCTION__, __LINE__, [NSThread currentThread]);
 }
 @end
-
@@ -0,0 +1,39 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+@class AWSMQttTxFlow;
+
+// Deadlines must be less than this many ticks ahead of the current tick.
+#define AWSMQTTTimerWheelSlotCount 64
+
+/*
+ Schedules the retransmission of in-flight flows by clock tick. Each slot holds a doubly linked
+ list threaded through the flows themselves, so scheduling, cancelling and rescheduling a flow are
+ O(1) and need no per-message timer or boxed key. Not thread safe.
+ */
+@interface AWSMQTTTimerWheel : NSObject
+
+@property (readonly) NSUInteger count;
+
+// Sets the flow's deadline and moves it to that tick's slot.
+- (void)scheduleFlow:(AWSMQttTxFlow *)flow atTick:(unsigned int)deadline;
+- (void)cancelFlow:(AWSMQttTxFlow *)flow;
+// The flows whose deadline is the tick. They stay scheduled until cancelled or rescheduled.
+- (NSArray<AWSMQttTxFlow *> *)flowsDueAtTick:(unsigned int)tick;
+- (void)cancelAllFlows;
+
+@end
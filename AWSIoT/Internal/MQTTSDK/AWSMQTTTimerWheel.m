@@ -0,0 +1,84 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import "AWSMQTTTimerWheel.h"
+#import "AWSMQttTxFlow.h"
+
+@interface AWSMQTTTimerWheel() {
+    __strong AWSMQttTxFlow *heads[AWSMQTTTimerWheelSlotCount];
+}
+
+@property (readwrite) NSUInteger count;
+
+@end
+
+@implementation AWSMQTTTimerWheel
+
+- (void)dealloc {
+    [self cancelAllFlows];
+}
+
+- (void)scheduleFlow:(AWSMQttTxFlow *)flow atTick:(unsigned int)deadline {
+    [self cancelFlow:flow];
+    flow.deadline = deadline;
+    NSUInteger slot = deadline % AWSMQTTTimerWheelSlotCount;
+    flow.nextInSlot = heads[slot];
+    flow.previousInSlot = nil;
+    heads[slot].previousInSlot = flow;
+    heads[slot] = flow;
+    flow.scheduled = YES;
+    _count++;
+}
+
+- (void)cancelFlow:(AWSMQttTxFlow *)flow {
+    if (!flow.scheduled) {
+        return;
+    }
+    AWSMQttTxFlow *next = flow.nextInSlot;
+    AWSMQttTxFlow *previous = flow.previousInSlot;
+    next.previousInSlot = previous;
+    if (previous) {
+        previous.nextInSlot = next;
+    } else {
+        heads[flow.deadline % AWSMQTTTimerWheelSlotCount] = next;
+    }
+    flow.nextInSlot = nil;
+    flow.previousInSlot = nil;
+    flow.scheduled = NO;
+    _count--;
+}
+
+- (NSArray<AWSMQttTxFlow *> *)flowsDueAtTick:(unsigned int)tick {
+    NSMutableArray<AWSMQttTxFlow *> *flows = [NSMutableArray new];
+    for (AWSMQttTxFlow *flow = heads[tick % AWSMQTTTimerWheelSlotCount]; flow != nil; flow = flow.nextInSlot) {
+        if (flow.deadline == tick) {
+            [flows addObject:flow];
+        }
+    }
+    // The newest flow is at the head; retransmit in the order the flows were scheduled.
+    return [[flows reverseObjectEnumerator] allObjects];
+}
+
+- (void)cancelAllFlows {
+    // Unlink one flow at a time so releasing a long list does not recurse through every flow.
+    for (NSUInteger slot = 0; slot < AWSMQTTTimerWheelSlotCount; slot++) {
+        AWSMQttTxFlow *flow;
+        while ((flow = heads[slot]) != nil) {
+            [self cancelFlow:flow];
+        }
+    }
+}
+
+@end
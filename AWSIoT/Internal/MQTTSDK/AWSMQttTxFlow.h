@@ -25,5 +25,10 @@
 @property (strong) AWSMQTTMessage* msg;
 @property (assign) unsigned int deadline;
 
+// Links in the AWSMQTTTimerWheel slot the flow is scheduled in. Managed by the wheel.
+@property (strong) AWSMQttTxFlow* nextInSlot;
+@property (unsafe_unretained) AWSMQttTxFlow* previousInSlot;
+@property (assign) BOOL scheduled;
+
 @end
 
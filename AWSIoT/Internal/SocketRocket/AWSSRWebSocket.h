@@ -91,6 +91,9 @@ extern NSString *const AWSSRHTTPResponseErrorKey;
 // Send a UTF8 String or Data.
 - (void)send:(id)data;
 
+// Send Data as a binary message without copying it first. The caller must not mutate it afterwards.
+- (void)sendDataNoCopy:(NSData *)data;
+
 // Send Data (can be nil) in a ping message.
 - (void)sendPing:(NSData *)data;
 
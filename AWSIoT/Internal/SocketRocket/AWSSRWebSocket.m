@@ -148,6 +148,109 @@ static NSString *newSHA1String(const char *bytes, size_t length) {
 
 @end
 
+// A contiguous byte buffer. Bytes are appended at the end and consumed from the start; the
+// unconsumed bytes are moved back to the front only when the free space at the end runs out, so
+// frames can always be parsed in place and a fully consumed buffer is reused without copying.
+typedef struct {
+    uint8_t *bytes;
+    size_t start;
+    size_t end;
+    size_t capacity;
+} AWSSRByteBuffer;
+
+static const size_t AWSSRByteBufferMinimumCapacity = 4096;
+
+static inline size_t AWSSRByteBufferLength(const AWSSRByteBuffer *buffer)
+{
+    return buffer->end - buffer->start;
+}
+
+static inline uint8_t *AWSSRByteBufferBytes(const AWSSRByteBuffer *buffer)
+{
+    return buffer->bytes + buffer->start;
+}
+
+// Returns room for at least `length` bytes after the buffered ones, or NULL if it cannot be allocated.
+// Call AWSSRByteBufferCommit with the number of bytes actually written there.
+static uint8_t *AWSSRByteBufferReserve(AWSSRByteBuffer *buffer, size_t length)
+{
+    if (buffer->capacity - buffer->end >= length) {
+        return buffer->bytes + buffer->end;
+    }
+    size_t buffered = AWSSRByteBufferLength(buffer);
+    if (buffer->capacity - buffered < length) {
+        size_t capacity = MAX(buffer->capacity * 2, AWSSRByteBufferMinimumCapacity);
+        while (capacity - buffered < length) {
+            capacity *= 2;
+        }
+        uint8_t *bytes = realloc(buffer->bytes, capacity);
+        if (bytes == NULL) {
+            return NULL;
+        }
+        buffer->bytes = bytes;
+        buffer->capacity = capacity;
+    }
+    if (buffer->start > 0) {
+        memmove(buffer->bytes, buffer->bytes + buffer->start, buffered);
+        buffer->start = 0;
+        buffer->end = buffered;
+    }
+    return buffer->bytes + buffer->end;
+}
+
+static inline void AWSSRByteBufferCommit(AWSSRByteBuffer *buffer, size_t length)
+{
+    buffer->end += length;
+}
+
+static inline void AWSSRByteBufferConsume(AWSSRByteBuffer *buffer, size_t length)
+{
+    buffer->start += length;
+    if (buffer->start == buffer->end) {
+        buffer->start = 0;
+        buffer->end = 0;
+    }
+}
+
+static inline void AWSSRByteBufferClear(AWSSRByteBuffer *buffer)
+{
+    buffer->start = 0;
+    buffer->end = 0;
+}
+
+static void AWSSRByteBufferFree(AWSSRByteBuffer *buffer)
+{
+    free(buffer->bytes);
+    buffer->bytes = NULL;
+    buffer->start = 0;
+    buffer->end = 0;
+    buffer->capacity = 0;
+}
+
+// XORs `length` bytes of `source` into `destination` (which may be `source`) with the 4-byte WebSocket
+// mask key, starting `keyOffset` bytes into the key. Works eight bytes at a time; since eight is a
+// multiple of the key length, every word sees the same rotated key.
+static void AWSSRMaskBytes(uint8_t *destination, const uint8_t *source, size_t length, const uint8_t *maskKey, size_t keyOffset)
+{
+    uint8_t rotatedKey[sizeof(uint64_t)];
+    for (size_t i = 0; i < sizeof(rotatedKey); i++) {
+        rotatedKey[i] = maskKey[(keyOffset + i) % sizeof(uint32_t)];
+    }
+    uint64_t wordKey;
+    memcpy(&wordKey, rotatedKey, sizeof(wordKey));
+
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, source + i, sizeof(word));
+        word ^= wordKey;
+        memcpy(destination + i, &word, sizeof(word));
+    }
+    for (; i < length; i++) {
+        destination[i] = source[i] ^ rotatedKey[i % sizeof(rotatedKey)];
+    }
+}
+
 NSString *const AWSSRWebSocketErrorDomain = @"AWSSRWebSocketErrorDomain";
 NSString *const SRHTTPResponseErrorKey = @"HTTPResponseStatusCode";
 
@@ -210,11 +313,8 @@ typedef void (^data_callback)(AWSSRWebSocket *webSocket,  NSData *data);
     NSInputStream *_inputStream;
     NSOutputStream *_outputStream;
    
-    NSMutableData *_readBuffer;
-    NSUInteger _readBufferOffset;
- 
-    NSMutableData *_outputBuffer;
-    NSUInteger _outputBufferOffset;
+    AWSSRByteBuffer _readBuffer;
+    AWSSRByteBuffer _outputBuffer;
 
     uint8_t _currentFrameOpcode;
     size_t _currentFrameCount;
@@ -332,9 +432,6 @@ static __strong NSData *CRLFCRLF;
     _delegateDispatchQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT,0);
     sr_dispatch_retain(_delegateDispatchQueue);
     
-    _readBuffer = [[NSMutableData alloc] init];
-    _outputBuffer = [[NSMutableData alloc] init];
-    
     _currentFrameData = [[NSMutableData alloc] init];
 
     _consumers = [[NSMutableArray alloc] init];
@@ -360,6 +457,9 @@ static __strong NSData *CRLFCRLF;
 
     [_inputStream close];
     [_outputStream close];
+
+    AWSSRByteBufferFree(&_readBuffer);
+    AWSSRByteBufferFree(&_outputBuffer);
     
     if (_workQueue) {
         sr_dispatch_release(_workQueue);
@@ -791,7 +891,13 @@ static __strong NSData *CRLFCRLF;
     if (_closeWhenFinishedWriting) {
             return;
     }
-    [_outputBuffer appendData:data];
+    uint8_t *bytes = AWSSRByteBufferReserve(&_outputBuffer, data.length);
+    if (bytes == NULL) {
+        [self _failWithError:[NSError errorWithDomain:AWSSRWebSocketErrorDomain code:2145 userInfo:[NSDictionary dictionaryWithObject:@"Unable to buffer outgoing data" forKey:NSLocalizedDescriptionKey]]];
+        return;
+    }
+    memcpy(bytes, data.bytes, data.length);
+    AWSSRByteBufferCommit(&_outputBuffer, data.length);
     [self _pumpWriting];
 }
 
@@ -813,6 +919,14 @@ static __strong NSData *CRLFCRLF;
     });
 }
 
+- (void)sendDataNoCopy:(NSData *)data;
+{
+    NSAssert(self.readyState != AWSSR_CONNECTING, @"Invalid State: Cannot call send: until connection is open");
+    dispatch_async(_workQueue, ^{
+        [self _sendFrameWithOpcode:SROpCodeBinaryFrame data:data];
+    });
+}
+
 - (void)sendPing:(NSData *)data;
 {
     NSAssert(self.readyState == AWSSR_OPEN, @"Invalid State: Cannot call send: until connection is open");
@@ -1165,24 +1279,19 @@ static const uint8_t SRPayloadLenMask   = 0x7F;
 {
     [self assertOnWorkQueue];
     
-    NSUInteger dataLength = _outputBuffer.length;
-    if (dataLength - _outputBufferOffset > 0 && _outputStream.hasSpaceAvailable) {
-        NSInteger bytesWritten = [_outputStream write:_outputBuffer.bytes + _outputBufferOffset maxLength:dataLength - _outputBufferOffset];
+    NSUInteger dataLength = AWSSRByteBufferLength(&_outputBuffer);
+    if (dataLength > 0 && _outputStream.hasSpaceAvailable) {
+        NSInteger bytesWritten = [_outputStream write:AWSSRByteBufferBytes(&_outputBuffer) maxLength:dataLength];
         if (bytesWritten == -1) {
             [self _failWithError:[NSError errorWithDomain:AWSSRWebSocketErrorDomain code:2145 userInfo:[NSDictionary dictionaryWithObject:@"Error writing to stream" forKey:NSLocalizedDescriptionKey]]];
              return;
         }
         
-        _outputBufferOffset += bytesWritten;
-        
-        if (_outputBufferOffset > 4096 && _outputBufferOffset > (_outputBuffer.length >> 1)) {
-            _outputBuffer = [[NSMutableData alloc] initWithBytes:(char *)_outputBuffer.bytes + _outputBufferOffset length:_outputBuffer.length - _outputBufferOffset];
-            _outputBufferOffset = 0;
-        }
+        AWSSRByteBufferConsume(&_outputBuffer, bytesWritten);
     }
     
     if (_closeWhenFinishedWriting && 
-        _outputBuffer.length - _outputBufferOffset == 0 && 
+        AWSSRByteBufferLength(&_outputBuffer) == 0 && 
         (_inputStream.streamStatus != NSStreamStatusNotOpen &&
          _inputStream.streamStatus != NSStreamStatusClosed) &&
         !_sentClose) {
@@ -1277,7 +1386,7 @@ static const char CRLFCRLFBytes[] = {'\r', '\n', '\r', '\n'};
         return didWork;
     }
     
-    size_t curSize = _readBuffer.length - _readBufferOffset;
+    size_t curSize = AWSSRByteBufferLength(&_readBuffer);
     if (!curSize) {
         return didWork;
     }
@@ -1288,7 +1397,7 @@ static const char CRLFCRLFBytes[] = {'\r', '\n', '\r', '\n'};
     
     size_t foundSize = 0;
     if (consumer.consumer) {
-        NSData *tempView = [NSData dataWithBytesNoCopy:(char *)_readBuffer.bytes + _readBufferOffset length:_readBuffer.length - _readBufferOffset freeWhenDone:NO];  
+        NSData *tempView = [NSData dataWithBytesNoCopy:AWSSRByteBufferBytes(&_readBuffer) length:curSize freeWhenDone:NO];
         foundSize = consumer.consumer(tempView);
     } else {
         assert(consumer.bytesNeeded);
@@ -1301,32 +1410,22 @@ static const char CRLFCRLFBytes[] = {'\r', '\n', '\r', '\n'};
     
     NSData *slice = nil;
     if (consumer.readToCurrentFrame || foundSize) {
-        NSRange sliceRange = NSMakeRange(_readBufferOffset, foundSize);
-        slice = [_readBuffer subdataWithRange:sliceRange];
-        
-        _readBufferOffset += foundSize;
-        
-        if (_readBufferOffset > 4096 && _readBufferOffset > (_readBuffer.length >> 1)) {
-            _readBuffer = [[NSMutableData alloc] initWithBytes:(char *)_readBuffer.bytes + _readBufferOffset length:_readBuffer.length - _readBufferOffset];            _readBufferOffset = 0;
+        // Unmask in place and copy the bytes out of the read buffer once.
+        uint8_t *sliceBytes = AWSSRByteBufferBytes(&_readBuffer);
+        if (consumer.unmaskBytes) {
+            AWSSRMaskBytes(sliceBytes, sliceBytes, foundSize, _currentReadMaskKey, _currentReadMaskOffset % sizeof(_currentReadMaskKey));
+            _currentReadMaskOffset += foundSize;
         }
         
-        if (consumer.unmaskBytes) {
-            NSMutableData *mutableSlice = [slice mutableCopy];
-            
-            NSUInteger len = mutableSlice.length;
-            uint8_t *bytes = mutableSlice.mutableBytes;
-            
-            for (NSUInteger i = 0; i < len; i++) {
-                bytes[i] = bytes[i] ^ _currentReadMaskKey[_currentReadMaskOffset % sizeof(_currentReadMaskKey)];
-                _currentReadMaskOffset += 1;
-            }
-            
-            slice = mutableSlice;
+        if (consumer.readToCurrentFrame) {
+            [_currentFrameData appendBytes:sliceBytes length:foundSize];
+        } else {
+            slice = [NSData dataWithBytes:sliceBytes length:foundSize];
         }
         
+        AWSSRByteBufferConsume(&_readBuffer, foundSize);
+        
         if (consumer.readToCurrentFrame) {
-            [_currentFrameData appendData:slice];
-            
             _readOpCount += 1;
             
             if (_currentFrameOpcode == SROpCodeTextFrame) {
@@ -1403,16 +1502,21 @@ static const size_t SRFrameHeaderOverhead = 32;
     NSAssert([data isKindOfClass:[NSData class]] || [data isKindOfClass:[NSString class]], @"NSString or NSData");
     
     size_t payloadLength = [data isKindOfClass:[NSString class]] ? [(NSString *)data lengthOfBytesUsingEncoding:NSUTF8StringEncoding] : [data length];
-        
-    NSMutableData *frame = [[NSMutableData alloc] initWithLength:payloadLength + SRFrameHeaderOverhead];
-    if (!frame) {
+    
+    if (_closeWhenFinishedWriting) {
+        return;
+    }
+    
+    // Build the frame in place at the end of the output buffer.
+    uint8_t *frame_buffer = AWSSRByteBufferReserve(&_outputBuffer, payloadLength + SRFrameHeaderOverhead);
+    if (!frame_buffer) {
         [self closeWithCode:AWSSRStatusCodeMessageTooBig reason:@"Message too big"];
         return;
     }
-    uint8_t *frame_buffer = (uint8_t *)[frame mutableBytes];
     
     // set fin
     frame_buffer[0] = SRFinMask | opcode;
+    frame_buffer[1] = 0;
     
     BOOL useMask = YES;
 #ifdef NOMASK
@@ -1439,19 +1543,18 @@ static const size_t SRFrameHeaderOverhead = 32;
         frame_buffer[1] |= payloadLength;
     } else if (payloadLength <= UINT16_MAX) {
         frame_buffer[1] |= 126;
-        *((uint16_t *)(frame_buffer + frame_buffer_size)) = EndianU16_BtoN((uint16_t)payloadLength);
+        uint16_t length = EndianU16_BtoN((uint16_t)payloadLength);
+        memcpy(frame_buffer + frame_buffer_size, &length, sizeof(length));
         frame_buffer_size += sizeof(uint16_t);
     } else {
         frame_buffer[1] |= 127;
-        *((uint64_t *)(frame_buffer + frame_buffer_size)) = EndianU64_BtoN((uint64_t)payloadLength);
+        uint64_t length = EndianU64_BtoN((uint64_t)payloadLength);
+        memcpy(frame_buffer + frame_buffer_size, &length, sizeof(length));
         frame_buffer_size += sizeof(uint64_t);
     }
         
     if (!useMask) {
-        for (size_t i = 0; i < payloadLength; i++) {
-            frame_buffer[frame_buffer_size] = unmasked_payload[i];
-            frame_buffer_size += 1;
-        }
+        memcpy(frame_buffer + frame_buffer_size, unmasked_payload, payloadLength);
     } else {
         uint8_t *mask_key = frame_buffer + frame_buffer_size;
         int functionExitCode = SecRandomCopyBytes(kSecRandomDefault, sizeof(uint32_t), (uint8_t *)mask_key);
@@ -1460,17 +1563,14 @@ static const size_t SRFrameHeaderOverhead = 32;
         }
         frame_buffer_size += sizeof(uint32_t);
         
-        // TODO: could probably optimize this with SIMD
-        for (size_t i = 0; i < payloadLength; i++) {
-            frame_buffer[frame_buffer_size] = unmasked_payload[i] ^ mask_key[i % sizeof(uint32_t)];
-            frame_buffer_size += 1;
-        }
+        AWSSRMaskBytes(frame_buffer + frame_buffer_size, unmasked_payload, payloadLength, mask_key, 0);
     }
+    frame_buffer_size += payloadLength;
 
-    assert(frame_buffer_size <= [frame length]);
-    frame.length = frame_buffer_size;
+    assert(frame_buffer_size <= payloadLength + SRFrameHeaderOverhead);
+    AWSSRByteBufferCommit(&_outputBuffer, frame_buffer_size);
     
-    [self _writeData:frame];
+    [self _pumpWriting];
 }
 
 - (void)stream:(NSStream *)aStream handleEvent:(NSStreamEvent)eventCode;
@@ -1520,7 +1620,6 @@ static const size_t SRFrameHeaderOverhead = 32;
                 if (self.readyState >= AWSSR_CLOSING) {
                     return;
                 }
-                assert(self->_readBuffer);
 //
 // It looks as though the original implementation requires certificate pinning when connecting
 // securely; this has been disabled here but the original test is left commented out for
@@ -1540,8 +1639,7 @@ static const size_t SRFrameHeaderOverhead = 32;
                 SRFastLog(@"NSStreamEventErrorOccurred %@ %@", aStream, [[aStream streamError] copy]);
                 /// TODO specify error better!
                 [self _failWithError:aStream.streamError];
-                self->_readBufferOffset = 0;
-                [self->_readBuffer setLength:0];
+                AWSSRByteBufferClear(&self->_readBuffer);
                 break;
                 
             }
@@ -1575,14 +1673,19 @@ static const size_t SRFrameHeaderOverhead = 32;
                 
             case NSStreamEventHasBytesAvailable: {
                 SRFastLog(@"NSStreamEventHasBytesAvailable %@", aStream);
-                const int bufferSize = 2048;
-                uint8_t buffer[bufferSize];
+                const int bufferSize = 16384;
                 
                 while (self->_inputStream.hasBytesAvailable) {
+                    // Read straight into the read buffer rather than through a copy.
+                    uint8_t *buffer = AWSSRByteBufferReserve(&self->_readBuffer, bufferSize);
+                    if (buffer == NULL) {
+                        [self _failWithError:[NSError errorWithDomain:AWSSRWebSocketErrorDomain code:2145 userInfo:[NSDictionary dictionaryWithObject:@"Unable to buffer incoming data" forKey:NSLocalizedDescriptionKey]]];
+                        break;
+                    }
                     NSInteger bytes_read = [self->_inputStream read:buffer maxLength:bufferSize];
                     
                     if (bytes_read > 0) {
-                        [self->_readBuffer appendBytes:buffer length:bytes_read];
+                        AWSSRByteBufferCommit(&self->_readBuffer, bytes_read);
                     } else if (bytes_read < 0) {
                         [self _failWithError:self->_inputStream.streamError];
                     }
@@ -0,0 +1,331 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import "AWSIoTMQTTOfflineQueue.h"
+#import "AWSIoTMQTTClient.h"
+#import "AWSMQTTSession.h"
+
+@interface AWSIoTMQTTClient (AWSIoTMQTTOfflineQueueTests)
+
+- (void)setSession:(AWSMQTTSession *)session;
+- (void)setMqttStatus:(AWSIoTMQTTStatus)mqttStatus;
+- (dispatch_queue_t)offlineReplayQueue;
+- (void)replayOfflineMessages;
+
+@end
+
+// Accepts every publish without a connection and records the QoS 0 payloads.
+@interface AWSIoTMQTTOfflineQueueTestsSession : AWSMQTTSession
+
+@property (nonatomic, strong) NSMutableArray<NSData *> *publishedPayloads;
+
+@end
+
+@implementation AWSIoTMQTTOfflineQueueTestsSession
+
+- (BOOL)publishData:(NSData *)theData onTopic:(NSString *)theTopic {
+    [self.publishedPayloads addObject:theData];
+    return YES;
+}
+
+@end
+
+@interface AWSIoTMQTTOfflineQueueTests : XCTestCase
+
+@property (nonatomic, strong) NSString *identifier;
+
+@end
+
+@implementation AWSIoTMQTTOfflineQueueTests
+
+- (void)setUp {
+    [super setUp];
+    self.identifier = [NSString stringWithFormat:@"offline-queue-test/%@", [NSUUID UUID].UUIDString];
+}
+
+- (void)tearDown {
+    [[[AWSIoTMQTTOfflineQueue alloc] initWithIdentifier:self.identifier] removeAllMessages];
+    [super tearDown];
+}
+
+- (NSData *)payload:(NSUInteger)index {
+    return [[NSString stringWithFormat:@"message %lu", (unsigned long)index] dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+- (NSArray<NSData *> *)drain:(AWSIoTMQTTOfflineQueue *)queue {
+    NSMutableArray<NSData *> *payloads = [NSMutableArray new];
+    UInt16 messageId = 0;
+    NSArray<AWSIoTMQTTOfflineMessage *> *messages;
+    while ((messages = [queue nextMessagesToReplay]).count > 0) {
+        for (AWSIoTMQTTOfflineMessage *message in messages) {
+            [payloads addObject:message.data];
+            [queue message:message wasSentWithMessageId:++messageId];
+            XCTAssertEqual(message, [queue acknowledgeMessageId:messageId]);
+        }
+    }
+    return payloads;
+}
+
+- (void)testReplaysInOrderAcrossReopen {
+    AWSIoTMQTTOfflineQueue *queue = [[AWSIoTMQTTOfflineQueue alloc] initWithIdentifier:self.identifier];
+    for (NSUInteger i = 0; i < 25; i++) {
+        XCTAssertTrue([queue enqueueData:[self payload:i] onTopic:@"sensors/1" qos:1 ackCallback:nil]);
+    }
+    XCTAssertEqual((NSUInteger)25, queue.count);
+    queue = nil;
+
+    queue = [[AWSIoTMQTTOfflineQueue alloc] initWithIdentifier:self.identifier];
+    XCTAssertEqual((NSUInteger)25, queue.count);
+    NSArray<NSData *> *payloads = [self drain:queue];
+    XCTAssertEqual((NSUInteger)25, payloads.count);
+    for (NSUInteger i = 0; i < payloads.count; i++) {
+        XCTAssertEqualObjects([self payload:i], payloads[i]);
+    }
+    XCTAssertEqual((NSUInteger)0, queue.count);
+    XCTAssertEqual((NSUInteger)0, queue.storedByteCount);
+}
+
+- (void)testUnacknowledgedMessagesAreReplayedAfterReset {
+    AWSIoTMQTTOfflineQueue *queue = [[AWSIoTMQTTOfflineQueue alloc] initWithIdentifier:self.identifier];
+    __block BOOL acked = NO;
+    [queue enqueueData:[self payload:0] onTopic:@"t" qos:1 ackCallback:^{ acked = YES; }];
+    [queue enqueueData:[self payload:1] onTopic:@"t" qos:1 ackCallback:nil];
+
+    NSArray<AWSIoTMQTTOfflineMessage *> *messages = [queue nextMessagesToReplay];
+    XCTAssertEqual((NSUInteger)2, messages.count);
+    [queue message:messages[0] wasSentWithMessageId:1];
+    [queue message:messages[1] wasSentWithMessageId:2];
+    XCTAssertEqual((NSUInteger)0, [queue nextMessagesToReplay].count);
+
+    // A new session never acknowledges the old message ids.
+    [queue resetInFlight];
+    XCTAssertNil([queue acknowledgeMessageId:1]);
+    messages = [queue nextMessagesToReplay];
+    XCTAssertEqual((NSUInteger)2, messages.count);
+    XCTAssertEqualObjects([self payload:0], messages[0].data);
+    [queue message:messages[0] wasSentWithMessageId:7];
+    AWSIoTMQTTOfflineMessage *acknowledged = [queue acknowledgeMessageId:7];
+    acknowledged.ackCallback();
+    XCTAssertTrue(acked);
+    XCTAssertEqual((NSUInteger)1, queue.count);
+}
+
+- (void)testInFlightWindow {
+    AWSIoTMQTTOfflineQueue *queue = [[AWSIoTMQTTOfflineQueue alloc] initWithIdentifier:self.identifier];
+    queue.inFlightLimit = 4;
+    for (NSUInteger i = 0; i < 10; i++) {
+        [queue enqueueData:[self payload:i] onTopic:@"t" qos:1 ackCallback:nil];
+    }
+    NSArray<AWSIoTMQTTOfflineMessage *> *messages = [queue nextMessagesToReplay];
+    XCTAssertEqual((NSUInteger)4, messages.count);
+    XCTAssertEqual((NSUInteger)4, queue.inFlightCount);
+    XCTAssertEqual((NSUInteger)0, [queue nextMessagesToReplay].count);
+
+    [queue message:messages[0] wasSentWithMessageId:1];
+    [queue acknowledgeMessageId:1];
+    messages = [queue nextMessagesToReplay];
+    XCTAssertEqual((NSUInteger)1, messages.count);
+    XCTAssertEqualObjects([self payload:4], messages[0].data);
+}
+
+- (void)testRewindAfterRejectedSend {
+    AWSIoTMQTTOfflineQueue *queue = [[AWSIoTMQTTOfflineQueue alloc] initWithIdentifier:self.identifier];
+    for (NSUInteger i = 0; i < 5; i++) {
+        [queue enqueueData:[self payload:i] onTopic:@"t" qos:0 ackCallback:nil];
+    }
+    NSArray<AWSIoTMQTTOfflineMessage *> *messages = [queue nextMessagesToReplay];
+    [queue removeMessage:messages[0]];
+    [queue rewindToMessage:messages[1]];
+    XCTAssertEqual((NSUInteger)0, queue.inFlightCount);
+
+    messages = [queue nextMessagesToReplay];
+    XCTAssertEqual((NSUInteger)4, messages.count);
+    XCTAssertEqualObjects([self payload:1], messages[0].data);
+}
+
+- (void)testByteLimitDropOldest {
+    AWSIoTMQTTOfflineQueue *queue = [[AWSIoTMQTTOfflineQueue alloc] initWithIdentifier:self.identifier];
+    NSData *data = [NSMutableData dataWithLength:100];
+    // Each message accounts for its topic, payload and 32 bytes of overhead.
+    queue.byteLimit = 3 * (1 + 100 + 32);
+    for (NSUInteger i = 0; i < 5; i++) {
+        NSMutableData *payload = [data mutableCopy];
+        ((UInt8 *)payload.mutableBytes)[0] = (UInt8)i;
+        XCTAssertTrue([queue enqueueData:payload onTopic:@"t" qos:1 ackCallback:nil]);
+    }
+    XCTAssertEqual((NSUInteger)3, queue.count);
+    XCTAssertEqual(queue.byteLimit, queue.storedByteCount);
+    NSArray<AWSIoTMQTTOfflineMessage *> *messages = [queue nextMessagesToReplay];
+    XCTAssertEqual((UInt8)2, ((const UInt8 *)messages[0].data.bytes)[0]);
+
+    XCTAssertFalse([queue enqueueData:[NSMutableData dataWithLength:1000] onTopic:@"t" qos:1 ackCallback:nil]);
+}
+
+- (void)testByteLimitDropNewest {
+    AWSIoTMQTTOfflineQueue *queue = [[AWSIoTMQTTOfflineQueue alloc] initWithIdentifier:self.identifier];
+    queue.byteLimit = 3 * (1 + 100 + 32);
+    queue.fullPolicy = AWSIoTMQTTOfflineQueueFullPolicyDropNewest;
+    for (NSUInteger i = 0; i < 3; i++) {
+        XCTAssertTrue([queue enqueueData:[NSMutableData dataWithLength:100] onTopic:@"t" qos:1 ackCallback:nil]);
+    }
+    XCTAssertFalse([queue enqueueData:[NSMutableData dataWithLength:100] onTopic:@"t" qos:1 ackCallback:nil]);
+    XCTAssertEqual((NSUInteger)3, queue.count);
+}
+
+- (void)testEvictionForgetsInFlightMessagesAndAckCallbacks {
+    AWSIoTMQTTOfflineQueue *queue = [[AWSIoTMQTTOfflineQueue alloc] initWithIdentifier:self.identifier];
+    queue.byteLimit = 3 * (1 + 100 + 32);
+    __weak NSObject *weakToken;
+    @autoreleasepool {
+        NSObject *token = [NSObject new];
+        weakToken = token;
+        XCTAssertTrue([queue enqueueData:[NSMutableData dataWithLength:100] onTopic:@"t" qos:1 ackCallback:^{
+            (void)token;
+        }]);
+        for (NSUInteger i = 1; i < 3; i++) {
+            XCTAssertTrue([queue enqueueData:[NSMutableData dataWithLength:100] onTopic:@"t" qos:1 ackCallback:nil]);
+        }
+        NSArray<AWSIoTMQTTOfflineMessage *> *messages = [queue nextMessagesToReplay];
+        XCTAssertEqual((NSUInteger)3, messages.count);
+        for (NSUInteger i = 0; i < messages.count; i++) {
+            [queue message:messages[i] wasSentWithMessageId:(UInt16)(i + 1)];
+        }
+    }
+    XCTAssertEqual((NSUInteger)3, queue.inFlightCount);
+
+    XCTAssertTrue([queue enqueueData:[NSMutableData dataWithLength:100] onTopic:@"t" qos:1 ackCallback:nil]);
+    XCTAssertEqual((NSUInteger)3, queue.count);
+    XCTAssertEqual((NSUInteger)2, queue.inFlightCount);
+    XCTAssertNil(weakToken);
+    XCTAssertNil([queue acknowledgeMessageId:1]);
+    XCTAssertEqual((NSUInteger)1, [queue nextMessagesToReplay].count);
+}
+
+- (void)testAgeLimit {
+    AWSIoTMQTTOfflineQueue *queue = [[AWSIoTMQTTOfflineQueue alloc] initWithIdentifier:self.identifier];
+    [queue enqueueData:[self payload:0] onTopic:@"t" qos:1 ackCallback:nil];
+    queue.ageLimit = 0.2;
+    [NSThread sleepForTimeInterval:0.3];
+    [queue enqueueData:[self payload:1] onTopic:@"t" qos:1 ackCallback:nil];
+    XCTAssertEqual((NSUInteger)1, queue.count);
+    NSArray<AWSIoTMQTTOfflineMessage *> *messages = [queue nextMessagesToReplay];
+    XCTAssertEqual((NSUInteger)1, messages.count);
+    XCTAssertEqualObjects([self payload:1], messages[0].data);
+}
+
+// Stands in for a connected broker: replays the queue the way AWSIoTMQTTClient does and returns each
+// PUBACK asynchronously, so at most `inFlightLimit` messages are ever outstanding.
+- (NSUInteger)replay:(AWSIoTMQTTOfflineQueue *)queue toBrokerStubOnQueue:(dispatch_queue_t)replayQueue {
+    __block NSUInteger delivered = 0;
+    __block UInt16 nextMessageId = 0;
+    __block NSUInteger maxInFlight = 0;
+    dispatch_queue_t brokerQueue = dispatch_queue_create("com.amazonaws.iot.test.broker-stub", DISPATCH_QUEUE_SERIAL);
+    dispatch_semaphore_t drained = dispatch_semaphore_create(0);
+    __block void (^replay)(void);
+    __block __weak void (^weakReplay)(void);
+    replay = ^{
+        NSArray<AWSIoTMQTTOfflineMessage *> *messages = [queue nextMessagesToReplay];
+        maxInFlight = MAX(maxInFlight, queue.inFlightCount);
+        if (messages.count == 0 && queue.inFlightCount == 0) {
+            dispatch_semaphore_signal(drained);
+        }
+        for (AWSIoTMQTTOfflineMessage *message in messages) {
+            UInt16 messageId = ++nextMessageId ?: ++nextMessageId;
+            [queue message:message wasSentWithMessageId:messageId];
+            void (^strongReplay)(void) = weakReplay;
+            dispatch_async(brokerQueue, ^{
+                dispatch_async(replayQueue, ^{
+                    if ([queue acknowledgeMessageId:messageId]) {
+                        delivered++;
+                    }
+                    strongReplay();
+                });
+            });
+        }
+    };
+    weakReplay = replay;
+    dispatch_async(replayQueue, replay);
+    dispatch_semaphore_wait(drained, DISPATCH_TIME_FOREVER);
+    XCTAssertLessThanOrEqual(maxInFlight, queue.inFlightLimit);
+    return delivered;
+}
+
+- (void)testClientReplaysAtMostOnceBacklogLargerThanInFlightLimit {
+    AWSIoTMQTTOfflineQueue *queue = [[AWSIoTMQTTOfflineQueue alloc] initWithIdentifier:self.identifier];
+    queue.inFlightLimit = 10;
+    for (NSUInteger i = 0; i < 25; i++) {
+        XCTAssertTrue([queue enqueueData:[self payload:i] onTopic:@"sensors/1" qos:0 ackCallback:nil]);
+    }
+
+    AWSIoTMQTTOfflineQueueTestsSession *session = [[AWSIoTMQTTOfflineQueueTestsSession alloc] initWithClientId:@"offline-queue-tests"
+                                                                                                        userName:@""
+                                                                                                        password:@""
+                                                                                                       keepAlive:60
+                                                                                                    cleanSession:YES
+                                                                                                       willTopic:nil
+                                                                                                         willMsg:nil
+                                                                                                         willQoS:0
+                                                                                                  willRetainFlag:NO
+                                                                                            publishRetryThrottle:100
+                                                                                           outboundQueueCapacity:1024
+                                                                                         outboundQueueFullPolicy:AWSIoTMQTTOutboundQueueFullPolicyDropOldest];
+    session.publishedPayloads = [NSMutableArray new];
+    AWSIoTMQTTClient *client = [AWSIoTMQTTClient new];
+    client.offlineQueue = queue;
+    client.session = session;
+    client.mqttStatus = AWSIoTMQTTStatusConnected;
+
+    // No PUBACK ever arrives for QoS 0, so every round after the first has to be queued by the one before it.
+    [client replayOfflineMessages];
+    for (NSUInteger round = 0; round < 25 && queue.count > 0; round++) {
+        dispatch_sync(client.offlineReplayQueue, ^{});
+    }
+
+    XCTAssertEqual((NSUInteger)0, queue.count);
+    XCTAssertEqual((NSUInteger)0, queue.inFlightCount);
+    XCTAssertEqual((NSUInteger)25, session.publishedPayloads.count);
+    for (NSUInteger i = 0; i < session.publishedPayloads.count; i++) {
+        XCTAssertEqualObjects([self payload:i], session.publishedPayloads[i]);
+    }
+}
+
+- (void)testBenchmarkEnqueueWhileDisconnectedAndDrainAfterReconnect {
+    NSUInteger messages = 5000;
+    NSData *payload = [NSMutableData dataWithLength:256];
+    AWSIoTMQTTOfflineQueue *queue = [[AWSIoTMQTTOfflineQueue alloc] initWithIdentifier:self.identifier];
+    queue.byteLimit = 0;
+    queue.inFlightLimit = 10;
+
+    NSDate *start = [NSDate date];
+    for (NSUInteger i = 0; i < messages; i++) {
+        [queue enqueueData:payload onTopic:@"devices/thing-1/telemetry" qos:1 ackCallback:nil];
+    }
+    NSTimeInterval enqueueTime = [[NSDate date] timeIntervalSinceDate:start];
+    XCTAssertEqual(messages, queue.count);
+
+    dispatch_queue_t replayQueue = dispatch_queue_create("com.amazonaws.iot.test.offline-replay", DISPATCH_QUEUE_SERIAL);
+    start = [NSDate date];
+    NSUInteger delivered = [self replay:queue toBrokerStubOnQueue:replayQueue];
+    NSTimeInterval drainTime = [[NSDate date] timeIntervalSinceDate:start];
+
+    NSLog(@"Offline queue, %lu x %lu byte QoS 1 messages: enqueue while disconnected %.0f messages/s, drain with %lu in flight %.0f messages/s",
+          (unsigned long)messages, (unsigned long)payload.length, messages / enqueueTime,
+          (unsigned long)queue.inFlightLimit, messages / drainTime);
+    XCTAssertEqual(messages, delivered);
+    XCTAssertEqual((NSUInteger)0, queue.count);
+}
+
+@end
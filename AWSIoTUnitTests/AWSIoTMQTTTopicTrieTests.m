@@ -0,0 +1,194 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import "AWSIoTMQTTTopicTrie.h"
+
+@interface AWSIoTMQTTTopicTrieTests : XCTestCase
+
+@end
+
+@implementation AWSIoTMQTTTopicTrieTests
+
+- (BOOL)filter:(NSString *)filter matchesTopic:(NSString *)topic {
+    AWSIoTMQTTTopicTrie *trie = [AWSIoTMQTTTopicTrie new];
+    [trie setObject:filter forTopicFilter:filter];
+    NSArray *matches = [trie objectsMatchingTopic:topic];
+    XCTAssertLessThanOrEqual(matches.count, (NSUInteger)1);
+    return matches.count == 1;
+}
+
+- (void)assertFilter:(NSString *)filter matches:(NSArray<NSString *> *)matching doesNotMatch:(NSArray<NSString *> *)notMatching {
+    for (NSString *topic in matching) {
+        XCTAssertTrue([self filter:filter matchesTopic:topic], @"%@ should match %@", filter, topic);
+    }
+    for (NSString *topic in notMatching) {
+        XCTAssertFalse([self filter:filter matchesTopic:topic], @"%@ should not match %@", filter, topic);
+    }
+}
+
+// Examples from MQTT 3.1.1 section 4.7.
+- (void)testMultiLevelWildcard {
+    [self assertFilter:@"sport/tennis/player1/#"
+               matches:@[@"sport/tennis/player1", @"sport/tennis/player1/ranking", @"sport/tennis/player1/score/wimbledon"]
+          doesNotMatch:@[@"sport/tennis", @"sport/tennis/player2", @"sport/tennis/player10"]];
+    [self assertFilter:@"sport/#"
+               matches:@[@"sport", @"sport/", @"sport/tennis/player1"]
+          doesNotMatch:@[@"sports", @"/sport"]];
+    [self assertFilter:@"#"
+               matches:@[@"sport", @"/", @"sport/tennis/player1", @""]
+          doesNotMatch:@[]];
+}
+
+- (void)testSingleLevelWildcard {
+    [self assertFilter:@"sport/tennis/+"
+               matches:@[@"sport/tennis/player1", @"sport/tennis/player2", @"sport/tennis/"]
+          doesNotMatch:@[@"sport/tennis/player1/ranking", @"sport/tennis"]];
+    [self assertFilter:@"sport/+"
+               matches:@[@"sport/"]
+          doesNotMatch:@[@"sport", @"sport/tennis/player1"]];
+    [self assertFilter:@"+/+" matches:@[@"/finance", @"a/b"] doesNotMatch:@[@"finance", @"a/b/c"]];
+    [self assertFilter:@"/+" matches:@[@"/finance"] doesNotMatch:@[@"finance/x", @"a/finance"]];
+    [self assertFilter:@"+" matches:@[@"finance", @""] doesNotMatch:@[@"/finance"]];
+    [self assertFilter:@"+/tennis/#" matches:@[@"sport/tennis", @"sport/tennis/player1"] doesNotMatch:@[@"sport/golf/player1"]];
+    [self assertFilter:@"a/+/b" matches:@[@"a//b", @"a/x/b"] doesNotMatch:@[@"a/b", @"a/x/y/b"]];
+}
+
+- (void)testExactFiltersMatchWholeTopicOnly {
+    [self assertFilter:@"sport/tennis"
+               matches:@[@"sport/tennis"]
+          doesNotMatch:@[@"sport", @"sport/tennis/player1", @"Sport/Tennis", @"sport/tennis/"]];
+    [self assertFilter:@"a//b" matches:@[@"a//b"] doesNotMatch:@[@"a/b", @"a/x/b"]];
+}
+
+- (void)testWildcardsDoNotMatchDollarTopicsAtFirstLevel {
+    [self assertFilter:@"#" matches:@[] doesNotMatch:@[@"$SYS/monitor/Clients", @"$aws/things/thing1/shadow/update"]];
+    [self assertFilter:@"+/monitor/Clients" matches:@[] doesNotMatch:@[@"$SYS/monitor/Clients"]];
+    [self assertFilter:@"$SYS/#" matches:@[@"$SYS", @"$SYS/monitor/Clients"] doesNotMatch:@[@"SYS/monitor"]];
+    [self assertFilter:@"$SYS/monitor/+" matches:@[@"$SYS/monitor/Clients"] doesNotMatch:@[@"$SYS/monitor"]];
+    [self assertFilter:@"$aws/things/+/shadow/#"
+               matches:@[@"$aws/things/thing1/shadow/update/accepted"]
+          doesNotMatch:@[@"aws/things/thing1/shadow/update"]];
+}
+
+- (void)testReturnsEveryMatchingFilter {
+    AWSIoTMQTTTopicTrie *trie = [AWSIoTMQTTTopicTrie new];
+    NSArray *filters = @[@"#", @"a/#", @"a/b", @"a/+", @"+/b", @"+/+", @"a/b/#", @"a/b/c", @"a/+/c", @"b/#"];
+    for (NSString *filter in filters) {
+        [trie setObject:filter forTopicFilter:filter];
+    }
+    NSSet *expected = [NSSet setWithArray:@[@"#", @"a/#", @"a/b", @"a/+", @"+/b", @"+/+", @"a/b/#"]];
+    XCTAssertEqualObjects(expected, [NSSet setWithArray:[trie objectsMatchingTopic:@"a/b"]]);
+    expected = [NSSet setWithArray:@[@"#", @"a/#", @"a/b/#", @"a/b/c", @"a/+/c"]];
+    XCTAssertEqualObjects(expected, [NSSet setWithArray:[trie objectsMatchingTopic:@"a/b/c"]]);
+}
+
+- (void)testReplaceAndRemoveFilters {
+    AWSIoTMQTTTopicTrie *trie = [AWSIoTMQTTTopicTrie new];
+    [trie setObject:@"first" forTopicFilter:@"a/+/c"];
+    [trie setObject:@"second" forTopicFilter:@"a/+/c"];
+    [trie setObject:@"hash" forTopicFilter:@"a/#"];
+    [trie setObject:@"parent" forTopicFilter:@"a"];
+    XCTAssertEqual((NSUInteger)3, trie.count);
+    XCTAssertEqualObjects(@"second", [trie objectForTopicFilter:@"a/+/c"]);
+    XCTAssertEqualObjects(@"hash", [trie objectForTopicFilter:@"a/#"]);
+    XCTAssertNil([trie objectForTopicFilter:@"a/b/c"]);
+
+    [trie removeObjectForTopicFilter:@"a/+/c"];
+    [trie removeObjectForTopicFilter:@"not/subscribed"];
+    XCTAssertEqual((NSUInteger)2, trie.count);
+    NSSet *expected = [NSSet setWithArray:@[@"hash"]];
+    XCTAssertEqualObjects(expected, [NSSet setWithArray:[trie objectsMatchingTopic:@"a/b/c"]]);
+
+    [trie removeObjectForTopicFilter:@"a/#"];
+    expected = [NSSet setWithArray:@[@"parent"]];
+    XCTAssertEqualObjects(expected, [NSSet setWithArray:[trie objectsMatchingTopic:@"a"]]);
+
+    [trie removeAllObjects];
+    XCTAssertEqual((NSUInteger)0, trie.count);
+    XCTAssertEqual((NSUInteger)0, [trie objectsMatchingTopic:@"a"].count);
+}
+
+// The per-message scan AWSIoTMQTTClient used before the trie: split every filter and compare level by level.
+- (NSUInteger)scanFilters:(NSArray<NSString *> *)filters forTopic:(NSString *)topic {
+    NSUInteger matched = 0;
+    NSArray *topicParts = [topic componentsSeparatedByString:@"/"];
+    for (NSString *topicKey in filters) {
+        NSArray *topicKeyParts = [topicKey componentsSeparatedByString:@"/"];
+        BOOL topicMatch = true;
+        for (int i = 0; i < topicKeyParts.count; i++) {
+            if (i >= topicParts.count) {
+                topicMatch = false;
+                break;
+            }
+            NSString *topicPart = topicParts[i];
+            NSString *topicKeyPart = topicKeyParts[i];
+            if ([topicKeyPart rangeOfString:@"#"].location == NSNotFound && [topicKeyPart rangeOfString:@"+"].location == NSNotFound) {
+                if (![topicPart isEqualToString:topicKeyPart]) {
+                    topicMatch = false;
+                    break;
+                }
+            }
+        }
+        if (topicMatch) {
+            matched++;
+        }
+    }
+    return matched;
+}
+
+- (void)testDispatchWithThousandSubscriptions {
+    const NSUInteger subscriptions = 1000;
+    const NSUInteger messages = 2000;
+    NSMutableArray<NSString *> *filters = [NSMutableArray array];
+    AWSIoTMQTTTopicTrie *trie = [AWSIoTMQTTTopicTrie new];
+    for (NSUInteger i = 0; i < subscriptions; i++) {
+        NSString *filter;
+        switch (i % 4) {
+            case 0: filter = [NSString stringWithFormat:@"fleet/device%lu/telemetry", (unsigned long)i]; break;
+            case 1: filter = [NSString stringWithFormat:@"fleet/device%lu/+", (unsigned long)i]; break;
+            case 2: filter = [NSString stringWithFormat:@"fleet/device%lu/alerts/#", (unsigned long)i]; break;
+            default: filter = [NSString stringWithFormat:@"$aws/things/device%lu/shadow/update/accepted", (unsigned long)i]; break;
+        }
+        [filters addObject:filter];
+        [trie setObject:filter forTopicFilter:filter];
+    }
+    NSMutableArray<NSString *> *topics = [NSMutableArray array];
+    for (NSUInteger i = 0; i < messages; i++) {
+        [topics addObject:[NSString stringWithFormat:@"fleet/device%lu/telemetry", (unsigned long)(i % subscriptions)]];
+    }
+
+    NSUInteger scanMatches = 0;
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (NSString *topic in topics) {
+        scanMatches += [self scanFilters:filters forTopic:topic];
+    }
+    CFAbsoluteTime scanTime = CFAbsoluteTimeGetCurrent() - start;
+
+    NSUInteger trieMatches = 0;
+    start = CFAbsoluteTimeGetCurrent();
+    for (NSString *topic in topics) {
+        trieMatches += [trie objectsMatchingTopic:topic].count;
+    }
+    CFAbsoluteTime trieTime = CFAbsoluteTimeGetCurrent() - start;
+
+    NSLog(@"MQTT dispatch, %lu subscriptions: filter scan %.0f messages/s, trie %.0f messages/s",
+          (unsigned long)subscriptions, messages / scanTime, messages / trieTime);
+    // Only telemetry and `+` filters of the same device match; `alerts/#` does not.
+    XCTAssertEqual(messages / 2, trieMatches);
+    XCTAssertGreaterThanOrEqual(scanMatches, trieMatches);
+}
+
+@end
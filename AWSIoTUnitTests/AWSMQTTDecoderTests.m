@@ -0,0 +1,189 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import "AWSMQTTDecoder.h"
+
+// Returns at most `chunkSize` bytes per read, like a socket delivering a frame in pieces.
+@interface AWSMQTTTestChunkedInputStream : NSInputStream
+
+@property (nonatomic, strong) NSData *data;
+@property (nonatomic, assign) NSUInteger chunkSize;
+@property (nonatomic, assign) NSUInteger offset;
+
+@end
+
+@implementation AWSMQTTTestChunkedInputStream
+
+- (instancetype)initWithData:(NSData *)data chunkSize:(NSUInteger)chunkSize {
+    if (self = [super init]) {
+        _data = data;
+        _chunkSize = chunkSize;
+    }
+    return self;
+}
+
+- (void)open {}
+- (void)close {}
+- (NSStreamStatus)streamStatus { return NSStreamStatusOpen; }
+- (id<NSStreamDelegate>)delegate { return nil; }
+- (void)setDelegate:(id<NSStreamDelegate>)delegate {}
+- (void)scheduleInRunLoop:(NSRunLoop *)aRunLoop forMode:(NSRunLoopMode)mode {}
+- (void)removeFromRunLoop:(NSRunLoop *)aRunLoop forMode:(NSRunLoopMode)mode {}
+
+- (BOOL)hasBytesAvailable {
+    return self.offset < self.data.length;
+}
+
+- (NSInteger)read:(uint8_t *)buffer maxLength:(NSUInteger)len {
+    NSUInteger n = MIN(MIN(len, self.chunkSize), self.data.length - self.offset);
+    [self.data getBytes:buffer range:NSMakeRange(self.offset, n)];
+    self.offset += n;
+    return n;
+}
+
+- (BOOL)getBuffer:(uint8_t **)buffer length:(NSUInteger *)len {
+    return NO;
+}
+
+@end
+
+@interface AWSMQTTDecoderTests : XCTestCase <AWSMQTTDecoderDelegate>
+
+@property (nonatomic, strong) NSMutableArray<AWSMQTTMessage *> *messages;
+@property (nonatomic, assign) NSUInteger messageCount;
+@property (nonatomic, assign) BOOL keepMessages;
+@property (nonatomic, assign) NSInteger lastEvent;
+
+@end
+
+@implementation AWSMQTTDecoderTests
+
+- (void)setUp {
+    [super setUp];
+    self.messages = [NSMutableArray array];
+    self.messageCount = 0;
+    self.keepMessages = YES;
+    self.lastEvent = -1;
+}
+
+- (void)decoder:(AWSMQTTDecoder *)sender newMessage:(AWSMQTTMessage *)msg {
+    self.messageCount++;
+    if (self.keepMessages) {
+        [self.messages addObject:msg];
+    }
+}
+
+- (void)decoder:(AWSMQTTDecoder *)sender handleEvent:(AWSMQTTDecoderEvent)eventCode {
+    self.lastEvent = eventCode;
+}
+
+- (NSData *)frameWithHeader:(UInt8)header body:(NSData *)body {
+    NSMutableData *frame = [NSMutableData data];
+    [frame AWSMQTT_appendByte:header];
+    NSUInteger length = body.length;
+    do {
+        UInt8 digit = length % 128;
+        length /= 128;
+        if (length > 0) {
+            digit |= 0x80;
+        }
+        [frame AWSMQTT_appendByte:digit];
+    } while (length > 0);
+    [frame appendData:body];
+    return frame;
+}
+
+- (NSData *)publishFrameWithPayloadLength:(NSUInteger)payloadLength seed:(UInt8)seed {
+    NSMutableData *body = [NSMutableData data];
+    [body AWSMQTT_appendMQTTString:@"sensors/telemetry"];
+    NSMutableData *payload = [NSMutableData dataWithLength:payloadLength];
+    UInt8 *bytes = payload.mutableBytes;
+    for (NSUInteger i = 0; i < payloadLength; i++) {
+        bytes[i] = (UInt8)(seed + i);
+    }
+    [body appendData:payload];
+    return [self frameWithHeader:(AWSMQTTPublish << 4) body:body];
+}
+
+- (void)decode:(NSInputStream *)stream {
+    AWSMQTTDecoder *decoder = [[AWSMQTTDecoder alloc] initWithStream:stream];
+    decoder.delegate = self;
+    [decoder stream:stream handleEvent:NSStreamEventOpenCompleted];
+    while ([stream hasBytesAvailable] && self.lastEvent == -1) {
+        [decoder stream:stream handleEvent:NSStreamEventHasBytesAvailable];
+    }
+}
+
+- (void)testDecodesFramesSplitAcrossReads {
+    NSMutableData *input = [NSMutableData data];
+    NSMutableArray<NSData *> *frames = [NSMutableArray array];
+    NSArray<NSNumber *> *payloadLengths = @[@0, @1, @126, @127, @128, @16383, @16384, @70000, @3];
+    for (NSUInteger i = 0; i < payloadLengths.count; i++) {
+        NSData *frame = [self publishFrameWithPayloadLength:payloadLengths[i].unsignedIntegerValue seed:(UInt8)i];
+        [frames addObject:frame];
+        [input appendData:frame];
+    }
+    [input appendData:[self frameWithHeader:(AWSMQTTPingresp << 4) body:[NSData data]]];
+
+    for (NSNumber *chunkSize in @[@1, @7, @4096, @(input.length)]) {
+        [self.messages removeAllObjects];
+        [self decode:[[AWSMQTTTestChunkedInputStream alloc] initWithData:input chunkSize:chunkSize.unsignedIntegerValue]];
+
+        XCTAssertEqual(frames.count + 1, self.messages.count);
+        for (NSUInteger i = 0; i < frames.count; i++) {
+            AWSMQTTMessage *msg = self.messages[i];
+            XCTAssertEqual(AWSMQTTPublish, msg.type);
+            // slices stay valid after the decoder has moved on to later frames
+            NSData *frame = frames[i];
+            NSUInteger headerLength = frame.length - msg.data.length;
+            XCTAssertEqualObjects([frame subdataWithRange:NSMakeRange(headerLength, msg.data.length)], msg.data);
+        }
+        XCTAssertEqual(AWSMQTTPingresp, self.messages.lastObject.type);
+        XCTAssertEqual(0, self.messages.lastObject.data.length);
+    }
+}
+
+- (void)testMalformedRemainingLengthIsProtocolError {
+    UInt8 bytes[] = {AWSMQTTPublish << 4, 0xff, 0xff, 0xff, 0xff, 0x01};
+    [self decode:[NSInputStream inputStreamWithData:[NSData dataWithBytes:bytes length:sizeof(bytes)]]];
+    XCTAssertEqual(AWSMQTTDecoderEventProtocolError, self.lastEvent);
+    XCTAssertEqual(0, self.messages.count);
+}
+
+- (void)testDecodeThroughput {
+    self.keepMessages = NO;
+    for (NSNumber *payloadLength in @[@64, @1024, @(64 * 1024)]) {
+        NSData *frame = [self publishFrameWithPayloadLength:payloadLength.unsignedIntegerValue seed:0];
+        NSUInteger count = MAX(16, (16 * 1024 * 1024) / frame.length);
+        NSMutableData *input = [NSMutableData dataWithCapacity:frame.length * count];
+        for (NSUInteger i = 0; i < count; i++) {
+            [input appendData:frame];
+        }
+
+        self.messageCount = 0;
+        NSInputStream *stream = [NSInputStream inputStreamWithData:input];
+        [stream open];
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        [self decode:stream];
+        CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+        [stream close];
+
+        XCTAssertEqual(count, self.messageCount);
+        NSLog(@"MQTT decode, %@ byte payloads: %.0f messages/s", payloadLength, count / elapsed);
+    }
+}
+
+@end
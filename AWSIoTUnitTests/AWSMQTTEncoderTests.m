@@ -0,0 +1,272 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import "AWSMQTTEncoder.h"
+
+// Records every write, accepting at most `maxWriteLength` bytes per call.
+@interface AWSMQTTTestRecordingOutputStream : NSOutputStream
+
+@property (nonatomic, strong) NSMutableData *written;
+@property (nonatomic, assign) NSUInteger writeCount;
+@property (nonatomic, assign) NSUInteger maxOfferedLength;
+@property (nonatomic, assign) NSUInteger maxWriteLength;
+@property (nonatomic, assign) BOOL recordBytes;
+
+@end
+
+@implementation AWSMQTTTestRecordingOutputStream
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _written = [NSMutableData data];
+        _maxWriteLength = NSUIntegerMax;
+        _recordBytes = YES;
+    }
+    return self;
+}
+
+- (void)open {}
+- (void)close {}
+- (NSStreamStatus)streamStatus { return NSStreamStatusOpen; }
+- (id<NSStreamDelegate>)delegate { return nil; }
+- (void)setDelegate:(id<NSStreamDelegate>)delegate {}
+- (void)scheduleInRunLoop:(NSRunLoop *)aRunLoop forMode:(NSRunLoopMode)mode {}
+- (void)removeFromRunLoop:(NSRunLoop *)aRunLoop forMode:(NSRunLoopMode)mode {}
+- (BOOL)hasSpaceAvailable { return YES; }
+
+- (NSInteger)write:(const uint8_t *)buffer maxLength:(NSUInteger)len {
+    NSUInteger n = MIN(len, self.maxWriteLength);
+    self.writeCount++;
+    self.maxOfferedLength = MAX(self.maxOfferedLength, len);
+    if (self.recordBytes) {
+        [self.written appendBytes:buffer length:n];
+    }
+    return n;
+}
+
+@end
+
+// Reports a length without holding any bytes, for messages too large to build.
+@interface AWSMQTTTestSizedData : NSData
+
+@property (nonatomic, assign) NSUInteger sizedLength;
+
+@end
+
+@implementation AWSMQTTTestSizedData
+
+- (NSUInteger)length {
+    return self.sizedLength;
+}
+
+- (const void *)bytes {
+    return NULL;
+}
+
+@end
+
+@interface AWSMQTTEncoderTests : XCTestCase <AWSMQTTEncoderDelegate>
+
+@end
+
+@implementation AWSMQTTEncoderTests
+
+- (void)encoder:(AWSMQTTEncoder *)sender handleEvent:(AWSMQTTEncoderEvent)eventCode {
+}
+
+- (AWSMQTTEncoder *)readyEncoderWithStream:(NSOutputStream *)stream {
+    AWSMQTTEncoder *encoder = [[AWSMQTTEncoder alloc] initWithStream:stream];
+    encoder.delegate = self;
+    [encoder stream:stream handleEvent:NSStreamEventHasSpaceAvailable];
+    XCTAssertEqual(AWSMQTTEncoderStatusReady, encoder.status);
+    return encoder;
+}
+
+// The frame as the encoder used to build it, from the complete message data.
+- (NSData *)expectedFrameForMessage:(AWSMQTTMessage *)msg {
+    NSMutableData *frame = [NSMutableData data];
+    UInt8 header = [msg type] << 4;
+    if ([msg isDuplicate]) {
+        header |= 0x08;
+    }
+    header |= [msg qos] << 1;
+    if ([msg retainFlag]) {
+        header |= 0x01;
+    }
+    [frame AWSMQTT_appendByte:header];
+    NSUInteger length = [[msg data] length];
+    do {
+        UInt8 digit = length % 128;
+        length /= 128;
+        if (length > 0) {
+            digit |= 0x80;
+        }
+        [frame AWSMQTT_appendByte:digit];
+    } while (length > 0);
+    [frame appendData:[msg data]];
+    return frame;
+}
+
+- (NSArray<AWSMQTTMessage *> *)publishesWithPayloadLength:(NSUInteger)payloadLength count:(NSUInteger)count {
+    NSMutableData *payload = [NSMutableData dataWithLength:payloadLength];
+    memset(payload.mutableBytes, 'x', payloadLength);
+    NSMutableArray *messages = [NSMutableArray array];
+    for (NSUInteger i = 0; i < count; i++) {
+        [messages addObject:[AWSMQTTMessage publishMessageWithData:payload
+                                                           onTopic:@"sensors/telemetry"
+                                                               qos:1
+                                                             msgId:(UInt16)(i + 1)
+                                                        retainFlag:NO
+                                                           dupFlag:NO]];
+    }
+    return messages;
+}
+
+- (void)testBatchMatchesPerMessageEncoding {
+    NSMutableArray<AWSMQTTMessage *> *messages = [NSMutableArray array];
+    [messages addObject:[AWSMQTTMessage pingreqMessage]];
+    [messages addObject:[AWSMQTTMessage publishMessageWithData:[NSData data] onTopic:@"a/b" retainFlag:YES]];
+    [messages addObjectsFromArray:[self publishesWithPayloadLength:100 count:3]];
+    [messages addObjectsFromArray:[self publishesWithPayloadLength:20000 count:2]];
+    [messages addObject:[AWSMQTTMessage pubackMessageWithMessageId:7]];
+    [messages addObjectsFromArray:[self publishesWithPayloadLength:200000 count:1]];
+
+    NSMutableData *expected = [NSMutableData data];
+    for (AWSMQTTMessage *msg in messages) {
+        [expected appendData:[self expectedFrameForMessage:msg]];
+    }
+
+    for (NSNumber *maxWriteLength in @[@(NSUIntegerMax), @1000, @1]) {
+        AWSMQTTTestRecordingOutputStream *stream = [AWSMQTTTestRecordingOutputStream new];
+        stream.maxWriteLength = maxWriteLength.unsignedIntegerValue;
+        AWSMQTTEncoder *encoder = [self readyEncoderWithStream:stream];
+        [encoder encodeMessages:messages];
+        while (encoder.status == AWSMQTTEncoderStatusSending) {
+            [encoder stream:stream handleEvent:NSStreamEventHasSpaceAvailable];
+        }
+        XCTAssertEqual(AWSMQTTEncoderStatusReady, encoder.status);
+        XCTAssertEqualObjects(expected, stream.written);
+    }
+}
+
+- (void)testMessagesEncodedWhileSendingFollowPendingOnes {
+    NSArray<AWSMQTTMessage *> *first = [self publishesWithPayloadLength:20000 count:2];
+    NSArray<AWSMQTTMessage *> *second = [self publishesWithPayloadLength:100 count:3];
+    NSMutableData *expected = [NSMutableData data];
+    for (AWSMQTTMessage *msg in [first arrayByAddingObjectsFromArray:second]) {
+        [expected appendData:[self expectedFrameForMessage:msg]];
+    }
+
+    AWSMQTTTestRecordingOutputStream *stream = [AWSMQTTTestRecordingOutputStream new];
+    stream.maxWriteLength = 1000;
+    AWSMQTTEncoder *encoder = [self readyEncoderWithStream:stream];
+    [encoder encodeMessages:first];
+    XCTAssertEqual(AWSMQTTEncoderStatusSending, encoder.status);
+    [encoder encodeMessages:second];
+    [encoder encodeMessage:[AWSMQTTMessage pingreqMessage]];
+    [expected appendData:[self expectedFrameForMessage:[AWSMQTTMessage pingreqMessage]]];
+    while (encoder.status == AWSMQTTEncoderStatusSending) {
+        [encoder stream:stream handleEvent:NSStreamEventHasSpaceAvailable];
+    }
+    XCTAssertEqual(AWSMQTTEncoderStatusReady, encoder.status);
+    XCTAssertEqualObjects(expected, stream.written);
+}
+
+- (void)testSmallMessagesQueuedWhileSendingStayInBoundedBuffers {
+    NSArray<AWSMQTTMessage *> *messages = [self publishesWithPayloadLength:100 count:1000];
+    NSMutableData *expected = [NSMutableData data];
+    for (AWSMQTTMessage *msg in messages) {
+        [expected appendData:[self expectedFrameForMessage:msg]];
+    }
+
+    AWSMQTTTestRecordingOutputStream *stream = [AWSMQTTTestRecordingOutputStream new];
+    stream.maxWriteLength = 0;
+    AWSMQTTEncoder *encoder = [self readyEncoderWithStream:stream];
+    for (AWSMQTTMessage *msg in messages) {
+        [encoder encodeMessage:msg];
+    }
+    XCTAssertEqual(AWSMQTTEncoderStatusSending, encoder.status);
+
+    stream.maxWriteLength = NSUIntegerMax;
+    while (encoder.status == AWSMQTTEncoderStatusSending) {
+        [encoder stream:stream handleEvent:NSStreamEventHasSpaceAvailable];
+    }
+    XCTAssertEqual(AWSMQTTEncoderStatusReady, encoder.status);
+    XCTAssertEqualObjects(expected, stream.written);
+    XCTAssertLessThanOrEqual(stream.maxOfferedLength, 16 * 1024);
+}
+
+- (void)testPublishDataIsJoinedOnce {
+    AWSMQTTMessage *msg = [[self publishesWithPayloadLength:100 count:1] firstObject];
+    NSData *data = [msg data];
+    XCTAssertEqual(data, [msg data]);
+    XCTAssertEqual([[msg headerData] length] + 100, [data length]);
+
+    [msg setData:[NSData dataWithBytes:"\x00\x07" length:2]];
+    XCTAssertEqualObjects([NSData dataWithBytes:"\x00\x07" length:2], [msg data]);
+}
+
+- (void)testOversizedMessageIsRejected {
+    AWSMQTTTestSizedData *payload = [AWSMQTTTestSizedData new];
+    payload.sizedLength = 268435455;
+    AWSMQTTMessage *oversized = [[AWSMQTTMessage alloc] initWithType:AWSMQTTPublish
+                                                                 qos:0
+                                                          retainFlag:NO
+                                                             dupFlag:NO
+                                                          headerData:[NSData dataWithBytes:"\x00\x01t" length:3]
+                                                             payload:payload];
+    AWSMQTTMessage *ping = [AWSMQTTMessage pingreqMessage];
+
+    AWSMQTTTestRecordingOutputStream *stream = [AWSMQTTTestRecordingOutputStream new];
+    AWSMQTTEncoder *encoder = [self readyEncoderWithStream:stream];
+    [encoder encodeMessages:@[oversized, ping]];
+    XCTAssertEqual(AWSMQTTEncoderStatusReady, encoder.status);
+    XCTAssertEqualObjects([self expectedFrameForMessage:ping], stream.written);
+}
+
+- (void)testPublishThroughput {
+    const NSUInteger count = 20000;
+    const NSUInteger batchSize = 64;
+    NSArray<AWSMQTTMessage *> *messages = [self publishesWithPayloadLength:64 count:count];
+
+    AWSMQTTTestRecordingOutputStream *stream = [AWSMQTTTestRecordingOutputStream new];
+    stream.recordBytes = NO;
+    AWSMQTTEncoder *encoder = [self readyEncoderWithStream:stream];
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (AWSMQTTMessage *msg in messages) {
+        [encoder encodeMessage:msg];
+    }
+    CFAbsoluteTime singleTime = CFAbsoluteTimeGetCurrent() - start;
+    NSUInteger singleWrites = stream.writeCount;
+
+    stream = [AWSMQTTTestRecordingOutputStream new];
+    stream.recordBytes = NO;
+    encoder = [self readyEncoderWithStream:stream];
+    start = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < count; i += batchSize) {
+        [encoder encodeMessages:[messages subarrayWithRange:NSMakeRange(i, MIN(batchSize, count - i))]];
+    }
+    CFAbsoluteTime batchTime = CFAbsoluteTimeGetCurrent() - start;
+    NSUInteger batchWrites = stream.writeCount;
+
+    NSLog(@"MQTT encode, 64 byte publishes: one at a time %.0f/s, %.3f writes/message; batches of %lu %.0f/s, %.3f writes/message",
+          count / singleTime, (double)singleWrites / count,
+          (unsigned long)batchSize, count / batchTime, (double)batchWrites / count);
+    XCTAssertEqual(count, singleWrites);
+    XCTAssertLessThan(batchWrites, singleWrites);
+}
+
+@end
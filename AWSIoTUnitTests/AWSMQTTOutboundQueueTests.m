@@ -0,0 +1,191 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import "AWSMQTTOutboundQueue.h"
+
+@interface AWSMQTTOutboundQueueTests : XCTestCase
+
+@end
+
+@implementation AWSMQTTOutboundQueueTests
+
+- (AWSMQTTOutboundQueue *)fullQueueWithCapacity:(NSUInteger)capacity {
+    AWSMQTTOutboundQueue *queue = [[AWSMQTTOutboundQueue alloc] initWithCapacity:capacity];
+    for (NSUInteger i = 0; i < queue.capacity; i++) {
+        XCTAssertTrue([queue tryEnqueue:@(i)]);
+    }
+    return queue;
+}
+
+- (void)testDequeuesInOrderAndStopsAtCapacity {
+    AWSMQTTOutboundQueue *queue = [self fullQueueWithCapacity:1000];
+    XCTAssertEqual((NSUInteger)1024, queue.capacity);
+    XCTAssertEqual((NSUInteger)1024, queue.count);
+    XCTAssertFalse([queue tryEnqueue:@(-1)]);
+
+    for (NSUInteger i = 0; i < 1024; i++) {
+        XCTAssertEqualObjects(@(i), [queue dequeue]);
+    }
+    XCTAssertNil([queue dequeue]);
+    XCTAssertEqual((NSUInteger)0, queue.count);
+
+    // Wrap around the ring a few times.
+    for (NSUInteger i = 0; i < 5000; i++) {
+        XCTAssertTrue([queue tryEnqueue:@(i)]);
+        XCTAssertEqualObjects(@(i), [queue dequeue]);
+    }
+}
+
+- (void)testDropOldestKeepsNewestMessages {
+    AWSMQTTOutboundQueue *queue = [self fullQueueWithCapacity:4];
+    XCTAssertTrue([queue enqueue:@(4) policy:AWSIoTMQTTOutboundQueueFullPolicyDropOldest]);
+    XCTAssertTrue([queue enqueue:@(5) policy:AWSIoTMQTTOutboundQueueFullPolicyDropOldest]);
+    NSArray *expected = @[@(2), @(3), @(4), @(5)];
+    XCTAssertEqualObjects(expected, [queue dequeueObjectsUpTo:10]);
+}
+
+- (void)testFailFastRejectsWhenFull {
+    AWSMQTTOutboundQueue *queue = [self fullQueueWithCapacity:4];
+    XCTAssertFalse([queue enqueue:@(4) policy:AWSIoTMQTTOutboundQueueFullPolicyFailFast]);
+    [queue dequeue];
+    XCTAssertTrue([queue enqueue:@(4) policy:AWSIoTMQTTOutboundQueueFullPolicyFailFast]);
+    NSArray *expected = @[@(1), @(2), @(3), @(4)];
+    XCTAssertEqualObjects(expected, [queue dequeueObjectsUpTo:10]);
+}
+
+- (void)testBlockWaitsForRoom {
+    AWSMQTTOutboundQueue *queue = [self fullQueueWithCapacity:4];
+    XCTestExpectation *enqueued = [self expectationWithDescription:@"blocked publish queued"];
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        XCTAssertTrue([queue enqueue:@(4) policy:AWSIoTMQTTOutboundQueueFullPolicyBlock]);
+        [enqueued fulfill];
+    });
+    [NSThread sleepForTimeInterval:0.2];
+    XCTAssertEqual((NSUInteger)4, queue.count);
+    XCTAssertEqualObjects(@(0), [queue dequeue]);
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+    NSArray *expected = @[@(1), @(2), @(3), @(4)];
+    XCTAssertEqualObjects(expected, [queue dequeueObjectsUpTo:10]);
+}
+
+- (void)testInvalidateReleasesBlockedProducers {
+    AWSMQTTOutboundQueue *queue = [self fullQueueWithCapacity:4];
+    XCTestExpectation *released = [self expectationWithDescription:@"blocked publish released"];
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        XCTAssertFalse([queue enqueue:@(4) policy:AWSIoTMQTTOutboundQueueFullPolicyBlock]);
+        [released fulfill];
+    });
+    [NSThread sleepForTimeInterval:0.2];
+    [queue invalidate];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+    XCTAssertEqual((NSUInteger)4, queue.count);
+}
+
+// Runs `producers` threads that each enqueue `perProducer` numbers while one consumer drains them,
+// returning the elapsed time. Every number must arrive exactly once and in order per producer.
+- (CFAbsoluteTime)runProducers:(NSUInteger)producers
+                   perProducer:(NSUInteger)perProducer
+                       enqueue:(void (^)(NSNumber *value))enqueue
+                       dequeue:(NSNumber * (^)(void))dequeue {
+    NSUInteger total = producers * perProducer;
+    NSMutableData *lastSeen = [NSMutableData dataWithLength:producers * sizeof(NSInteger)];
+    NSInteger *last = lastSeen.mutableBytes;
+    for (NSUInteger p = 0; p < producers; p++) {
+        last[p] = -1;
+    }
+    dispatch_group_t group = dispatch_group_create();
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger p = 0; p < producers; p++) {
+        dispatch_group_async(group, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+            for (NSUInteger i = 0; i < perProducer; i++) {
+                enqueue(@(p * perProducer + i));
+            }
+        });
+    }
+    NSUInteger received = 0;
+    BOOL ordered = YES;
+    while (received < total) {
+        NSNumber *value = dequeue();
+        if (value == nil) {
+            continue;
+        }
+        NSUInteger p = value.unsignedIntegerValue / perProducer;
+        NSInteger i = value.unsignedIntegerValue % perProducer;
+        ordered = ordered && i == last[p] + 1;
+        last[p] = i;
+        received++;
+    }
+    CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+    XCTAssertTrue(ordered);
+    XCTAssertNil(dequeue());
+    return elapsed;
+}
+
+- (void)testConcurrentProducersDeliverEveryMessageOnce {
+    AWSMQTTOutboundQueue *queue = [[AWSMQTTOutboundQueue alloc] initWithCapacity:64];
+    [self runProducers:8
+           perProducer:20000
+               enqueue:^(NSNumber *value) {
+                   [queue enqueue:value policy:AWSIoTMQTTOutboundQueueFullPolicyBlock];
+               }
+               dequeue:^NSNumber *{
+                   return [queue dequeue];
+               }];
+}
+
+- (void)testMultiProducerThroughput {
+    const NSUInteger total = 160000;
+    for (NSUInteger producers = 1; producers <= 16; producers *= 2) {
+        NSUInteger perProducer = total / producers;
+
+        // The array and semaphore the session used before.
+        NSMutableArray *array = [NSMutableArray array];
+        dispatch_semaphore_t semaphore = dispatch_semaphore_create(1);
+        CFAbsoluteTime arrayTime = [self runProducers:producers
+                                          perProducer:perProducer
+                                              enqueue:^(NSNumber *value) {
+                                                  dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+                                                  [array addObject:value];
+                                                  dispatch_semaphore_signal(semaphore);
+                                              }
+                                              dequeue:^NSNumber *{
+                                                  dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+                                                  NSNumber *value = nil;
+                                                  if (array.count > 0) {
+                                                      value = [array objectAtIndex:0];
+                                                      [array removeObjectAtIndex:0];
+                                                  }
+                                                  dispatch_semaphore_signal(semaphore);
+                                                  return value;
+                                              }];
+
+        AWSMQTTOutboundQueue *queue = [[AWSMQTTOutboundQueue alloc] initWithCapacity:1024];
+        CFAbsoluteTime ringTime = [self runProducers:producers
+                                         perProducer:perProducer
+                                             enqueue:^(NSNumber *value) {
+                                                 [queue enqueue:value policy:AWSIoTMQTTOutboundQueueFullPolicyBlock];
+                                             }
+                                             dequeue:^NSNumber *{
+                                                 return [queue dequeue];
+                                             }];
+
+        NSLog(@"MQTT outbound queue, %2lu producers: array and semaphore %.0f messages/s, ring buffer %.0f messages/s",
+              (unsigned long)producers, total / arrayTime, total / ringTime);
+    }
+}
+
+@end
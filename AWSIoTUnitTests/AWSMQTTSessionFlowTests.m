@@ -0,0 +1,253 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import "AWSMQTTSession.h"
+#import "AWSMQTTMessage.h"
+#import "AWSMQttTxFlow.h"
+#import "AWSMQTTPacketIdAllocator.h"
+#import "AWSMQTTTimerWheel.h"
+
+@interface AWSMQTTSession (AWSMQTTSessionFlowTests)
+
+- (void)handlePuback:(AWSMQTTMessage*)msg;
+
+@end
+
+@interface AWSMQTTSessionFlowTests : XCTestCase
+
+@end
+
+@implementation AWSMQTTSessionFlowTests
+
+- (AWSMQTTSession *)sessionWithPolicy:(AWSIoTMQTTOutboundQueueFullPolicy)policy {
+    return [[AWSMQTTSession alloc] initWithClientId:@"flow-tests"
+                                           userName:@""
+                                           password:@""
+                                          keepAlive:60
+                                       cleanSession:YES
+                                          willTopic:nil
+                                            willMsg:nil
+                                            willQoS:0
+                                     willRetainFlag:NO
+                               publishRetryThrottle:100
+                              outboundQueueCapacity:1024
+                            outboundQueueFullPolicy:policy];
+}
+
+- (void)testAllocatorHandsOutEveryIdentifierOnce {
+    AWSMQTTPacketIdAllocator *allocator = [AWSMQTTPacketIdAllocator new];
+    for (NSUInteger i = 1; i <= UINT16_MAX; i++) {
+        XCTAssertEqual((UInt16)i, [allocator allocate]);
+    }
+    XCTAssertEqual((NSUInteger)UINT16_MAX, allocator.count);
+    XCTAssertEqual((UInt16)0, [allocator allocate]);
+
+    [allocator releaseIdentifier:500];
+    [allocator releaseIdentifier:500];
+    XCTAssertEqual((NSUInteger)UINT16_MAX - 1, allocator.count);
+    XCTAssertFalse([allocator isAllocated:500]);
+    XCTAssertEqual((UInt16)500, [allocator allocate]);
+}
+
+- (void)testAllocatorContinuesAfterTheLastIdentifier {
+    AWSMQTTPacketIdAllocator *allocator = [AWSMQTTPacketIdAllocator new];
+    UInt16 first = [allocator allocate];
+    [allocator releaseIdentifier:first];
+    // Released identifiers are not reused until the search wraps around.
+    XCTAssertEqual((UInt16)(first + 1), [allocator allocate]);
+
+    [allocator releaseAll];
+    for (NSUInteger i = 1; i < UINT16_MAX; i++) {
+        [allocator allocate];
+    }
+    [allocator releaseIdentifier:7];
+    // Wraps past UINT16_MAX and skips 0.
+    XCTAssertEqual((UInt16)UINT16_MAX, [allocator allocate]);
+    XCTAssertEqual((UInt16)7, [allocator allocate]);
+}
+
+- (void)testTimerWheel {
+    AWSMQTTTimerWheel *wheel = [AWSMQTTTimerWheel new];
+    NSMutableArray<AWSMQttTxFlow *> *flows = [NSMutableArray new];
+    for (NSUInteger i = 0; i < 4; i++) {
+        AWSMQttTxFlow *flow = [AWSMQttTxFlow flowWithMsg:[AWSMQTTMessage pingreqMessage] deadline:0];
+        [flows addObject:flow];
+        [wheel scheduleFlow:flow atTick:10];
+    }
+    // Same slot, a full turn later.
+    AWSMQttTxFlow *later = [AWSMQttTxFlow flowWithMsg:[AWSMQTTMessage pingreqMessage] deadline:0];
+    [wheel scheduleFlow:later atTick:(10 + AWSMQTTTimerWheelSlotCount)];
+    XCTAssertEqual((NSUInteger)5, wheel.count);
+
+    [wheel cancelFlow:flows[1]];
+    [wheel cancelFlow:flows[1]];
+    NSArray *due = [wheel flowsDueAtTick:10];
+    XCTAssertEqualObjects((@[flows[0], flows[2], flows[3]]), due);
+    XCTAssertEqual((NSUInteger)0, [wheel flowsDueAtTick:11].count);
+
+    [wheel scheduleFlow:flows[0] atTick:11];
+    XCTAssertEqualObjects((@[flows[2], flows[3]]), [wheel flowsDueAtTick:10]);
+    XCTAssertEqualObjects((@[flows[0]]), [wheel flowsDueAtTick:11]);
+    XCTAssertEqualObjects((@[later]), [wheel flowsDueAtTick:(10 + AWSMQTTTimerWheelSlotCount)]);
+
+    [wheel cancelAllFlows];
+    XCTAssertEqual((NSUInteger)0, wheel.count);
+    XCTAssertFalse(later.scheduled);
+}
+
+- (void)testInFlightWindowRejectsWhenFailFast {
+    AWSMQTTSession *session = [self sessionWithPolicy:AWSIoTMQTTOutboundQueueFullPolicyFailFast];
+    session.maxInFlightPublishes = 3;
+    NSData *data = [@"payload" dataUsingEncoding:NSUTF8StringEncoding];
+    UInt16 first = [session publishDataAtLeastOnce:data onTopic:@"t"];
+    XCTAssertNotEqual((UInt16)0, first);
+    XCTAssertNotEqual((UInt16)0, [session publishDataAtLeastOnce:data onTopic:@"t"]);
+    XCTAssertNotEqual((UInt16)0, [session publishDataAtLeastOnce:data onTopic:@"t"]);
+    XCTAssertEqual((UInt16)0, [session publishDataAtLeastOnce:data onTopic:@"t"]);
+    XCTAssertEqual((NSUInteger)3, session.inFlightPublishCount);
+    // QoS 0 publishes are not part of the window.
+    XCTAssertTrue([session publishData:data onTopic:@"t"]);
+
+    [session handlePuback:[AWSMQTTMessage pubackMessageWithMessageId:first]];
+    XCTAssertEqual((NSUInteger)2, session.inFlightPublishCount);
+    XCTAssertNotEqual((UInt16)0, [session publishDataAtLeastOnce:data onTopic:@"t"]);
+    [session close];
+}
+
+- (void)testInFlightWindowBlocksUntilAcknowledged {
+    AWSMQTTSession *session = [self sessionWithPolicy:AWSIoTMQTTOutboundQueueFullPolicyBlock];
+    session.maxInFlightPublishes = 1;
+    NSData *data = [@"payload" dataUsingEncoding:NSUTF8StringEncoding];
+    UInt16 first = [session publishDataAtLeastOnce:data onTopic:@"t"];
+
+    XCTestExpectation *published = [self expectationWithDescription:@"blocked publish completes"];
+    __block UInt16 second = 0;
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        second = [session publishDataAtLeastOnce:data onTopic:@"t"];
+        [published fulfill];
+    });
+    [NSThread sleepForTimeInterval:0.3];
+    XCTAssertEqual((UInt16)0, second);
+
+    [session handlePuback:[AWSMQTTMessage pubackMessageWithMessageId:first]];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+    XCTAssertNotEqual((UInt16)0, second);
+    XCTAssertNotEqual(first, second);
+
+    // Closing the session releases a publisher still waiting for room.
+    XCTestExpectation *released = [self expectationWithDescription:@"blocked publish is released"];
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        XCTAssertEqual((UInt16)0, [session publishDataAtLeastOnce:data onTopic:@"t"]);
+        [released fulfill];
+    });
+    [NSThread sleepForTimeInterval:0.2];
+    [session close];
+    [self waitForExpectationsWithTimeout:5 handler:nil];
+}
+
+// Publish and acknowledge in random order with `outstanding` flows in flight, using the session's
+// previous bookkeeping: an incrementing id probed against txFlows and a ring of 60 sets of boxed ids.
+- (NSTimeInterval)legacyFlowTimeWithOutstanding:(NSUInteger)outstanding operations:(NSUInteger)operations {
+    NSMutableDictionary *txFlows = [NSMutableDictionary new];
+    NSMutableArray<NSMutableSet *> *timerRing = [NSMutableArray new];
+    for (NSUInteger i = 0; i < 60; i++) {
+        [timerRing addObject:[NSMutableSet new]];
+    }
+    NSMutableArray<NSNumber *> *inFlight = [NSMutableArray new];
+    AWSMQTTMessage *msg = [AWSMQTTMessage pingreqMessage];
+    __block UInt16 txMsgId = 1;
+    __block unsigned int ticks = 0;
+    srand48(1);
+
+    void (^publish)(void) = ^{
+        txMsgId++;
+        while (txMsgId == 0 || [txFlows objectForKey:[NSNumber numberWithUnsignedInt:txMsgId]] != nil) {
+            txMsgId++;
+        }
+        AWSMQttTxFlow *flow = [AWSMQttTxFlow flowWithMsg:msg deadline:(ticks + 60)];
+        [txFlows setObject:flow forKey:[NSNumber numberWithUnsignedInt:txMsgId]];
+        [[timerRing objectAtIndex:([flow deadline] % 60)] addObject:[NSNumber numberWithUnsignedInt:txMsgId]];
+        [inFlight addObject:[NSNumber numberWithUnsignedInt:txMsgId]];
+    };
+    for (NSUInteger i = 0; i < outstanding; i++) {
+        publish();
+    }
+
+    NSDate *start = [NSDate date];
+    for (NSUInteger i = 0; i < operations; i++) {
+        NSUInteger index = (NSUInteger)(drand48() * inFlight.count);
+        NSNumber *msgId = inFlight[index];
+        [inFlight replaceObjectAtIndex:index withObject:inFlight.lastObject];
+        [inFlight removeLastObject];
+        AWSMQttTxFlow *flow = [txFlows objectForKey:msgId];
+        [[timerRing objectAtIndex:([flow deadline] % 60)] removeObject:msgId];
+        [txFlows removeObjectForKey:msgId];
+        ticks = (unsigned int)(i / 1000);
+        publish();
+    }
+    return [[NSDate date] timeIntervalSinceDate:start];
+}
+
+- (NSTimeInterval)flowTimeWithOutstanding:(NSUInteger)outstanding operations:(NSUInteger)operations {
+    NSMutableDictionary *txFlows = [NSMutableDictionary new];
+    AWSMQTTPacketIdAllocator *packetIds = [AWSMQTTPacketIdAllocator new];
+    AWSMQTTTimerWheel *retryWheel = [AWSMQTTTimerWheel new];
+    NSMutableArray<NSNumber *> *inFlight = [NSMutableArray new];
+    AWSMQTTMessage *msg = [AWSMQTTMessage pingreqMessage];
+    __block unsigned int ticks = 0;
+    srand48(1);
+
+    void (^publish)(void) = ^{
+        UInt16 msgId = [packetIds allocate];
+        AWSMQttTxFlow *flow = [AWSMQttTxFlow flowWithMsg:msg deadline:0];
+        [txFlows setObject:flow forKey:[NSNumber numberWithUnsignedInt:msgId]];
+        [retryWheel scheduleFlow:flow atTick:(ticks + 60)];
+        [inFlight addObject:[NSNumber numberWithUnsignedInt:msgId]];
+    };
+    for (NSUInteger i = 0; i < outstanding; i++) {
+        publish();
+    }
+
+    NSDate *start = [NSDate date];
+    for (NSUInteger i = 0; i < operations; i++) {
+        NSUInteger index = (NSUInteger)(drand48() * inFlight.count);
+        NSNumber *msgId = inFlight[index];
+        [inFlight replaceObjectAtIndex:index withObject:inFlight.lastObject];
+        [inFlight removeLastObject];
+        AWSMQttTxFlow *flow = [txFlows objectForKey:msgId];
+        [retryWheel cancelFlow:flow];
+        [txFlows removeObjectForKey:msgId];
+        [packetIds releaseIdentifier:msgId.unsignedShortValue];
+        ticks = (unsigned int)(i / 1000);
+        publish();
+    }
+    NSTimeInterval time = [[NSDate date] timeIntervalSinceDate:start];
+    XCTAssertEqual(outstanding, packetIds.count);
+    XCTAssertEqual(outstanding, retryWheel.count);
+    return time;
+}
+
+- (void)testBenchmarkFlowBookkeeping {
+    NSUInteger operations = 200000;
+    for (NSNumber *outstanding in @[@100, @1000, @10000]) {
+        NSTimeInterval legacyTime = [self legacyFlowTimeWithOutstanding:outstanding.unsignedIntegerValue operations:operations];
+        NSTimeInterval time = [self flowTimeWithOutstanding:outstanding.unsignedIntegerValue operations:operations];
+        NSLog(@"MQTT flow bookkeeping, %@ outstanding: probed ids and set ring %.0f publish/ack pairs/s, bitmap ids and timer wheel %.0f publish/ack pairs/s",
+              outstanding, operations / legacyTime, operations / time);
+    }
+}
+
+@end
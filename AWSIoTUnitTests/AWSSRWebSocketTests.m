@@ -0,0 +1,351 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <CommonCrypto/CommonDigest.h>
+#import <arpa/inet.h>
+#import <netinet/in.h>
+#import <sys/socket.h>
+#import <unistd.h>
+#import "AWSSRWebSocket.h"
+#import "AWSIoTWebSocketOutputStream.h"
+
+static BOOL AWSSRTestReadFully(int fd, void *buffer, size_t length) {
+    uint8_t *bytes = buffer;
+    while (length > 0) {
+        ssize_t n = read(fd, bytes, length);
+        if (n <= 0) {
+            return NO;
+        }
+        bytes += n;
+        length -= (size_t)n;
+    }
+    return YES;
+}
+
+static BOOL AWSSRTestWriteFully(int fd, const void *buffer, size_t length) {
+    const uint8_t *bytes = buffer;
+    while (length > 0) {
+        ssize_t n = write(fd, bytes, length);
+        if (n <= 0) {
+            return NO;
+        }
+        bytes += n;
+        length -= (size_t)n;
+    }
+    return YES;
+}
+
+// Reads client frames, unmasks them and writes each back unmasked with the same opcode until the
+// client closes. Returns the number of data frames echoed.
+static NSUInteger AWSSRTestEchoFrames(int fd) {
+    NSUInteger frames = 0;
+    uint8_t *payload = NULL;
+    for (;;) {
+        uint8_t header[2];
+        if (!AWSSRTestReadFully(fd, header, sizeof(header))) {
+            break;
+        }
+        uint8_t opcode = header[0] & 0x0F;
+        uint64_t length = header[1] & 0x7F;
+        if (length == 126) {
+            uint8_t extended[2];
+            if (!AWSSRTestReadFully(fd, extended, sizeof(extended))) {
+                break;
+            }
+            length = ((uint64_t)extended[0] << 8) | extended[1];
+        } else if (length == 127) {
+            uint8_t extended[8];
+            if (!AWSSRTestReadFully(fd, extended, sizeof(extended))) {
+                break;
+            }
+            length = 0;
+            for (int i = 0; i < 8; i++) {
+                length = (length << 8) | extended[i];
+            }
+        }
+        uint8_t maskKey[4] = {0, 0, 0, 0};
+        if ((header[1] & 0x80) && !AWSSRTestReadFully(fd, maskKey, sizeof(maskKey))) {
+            break;
+        }
+        payload = realloc(payload, (size_t)length + 1);
+        if (!AWSSRTestReadFully(fd, payload, (size_t)length)) {
+            break;
+        }
+        for (uint64_t i = 0; i < length; i++) {
+            payload[i] ^= maskKey[i % 4];
+        }
+
+        uint8_t reply[10];
+        size_t replyHeaderLength = 2;
+        // Answer a ping with a pong and a close with a close; echo everything else.
+        reply[0] = 0x80 | (opcode == 0x9 ? 0xA : opcode);
+        if (length < 126) {
+            reply[1] = (uint8_t)length;
+        } else if (length <= UINT16_MAX) {
+            reply[1] = 126;
+            reply[2] = (uint8_t)(length >> 8);
+            reply[3] = (uint8_t)length;
+            replyHeaderLength = 4;
+        } else {
+            reply[1] = 127;
+            for (int i = 0; i < 8; i++) {
+                reply[2 + i] = (uint8_t)(length >> (56 - 8 * i));
+            }
+            replyHeaderLength = 10;
+        }
+        if (!AWSSRTestWriteFully(fd, reply, replyHeaderLength) || !AWSSRTestWriteFully(fd, payload, (size_t)length)) {
+            break;
+        }
+        if (opcode == 0x8) {
+            break;
+        }
+        if (opcode == 0x1 || opcode == 0x2) {
+            frames++;
+        }
+    }
+    free(payload);
+    return frames;
+}
+
+// Accepts one WebSocket connection on a loopback port and echoes its frames.
+@interface AWSSRWebSocketTestEchoServer : NSObject
+
+@property (nonatomic, assign, readonly) UInt16 port;
+@property (atomic, assign, readonly) NSUInteger echoedFrames;
+
+- (BOOL)waitUntilClosed;
+
+@end
+
+@interface AWSSRWebSocketTestEchoServer()
+
+@property (nonatomic, assign) int listeningSocket;
+@property (atomic, assign, readwrite) NSUInteger echoedFrames;
+@property (nonatomic, strong) dispatch_semaphore_t closed;
+
+@end
+
+@implementation AWSSRWebSocketTestEchoServer
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _listeningSocket = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_len = sizeof(address);
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t addressLength = sizeof(address);
+        if (bind(_listeningSocket, (struct sockaddr *)&address, sizeof(address)) != 0
+            || listen(_listeningSocket, 1) != 0
+            || getsockname(_listeningSocket, (struct sockaddr *)&address, &addressLength) != 0) {
+            close(_listeningSocket);
+            return nil;
+        }
+        _port = ntohs(address.sin_port);
+        _closed = dispatch_semaphore_create(0);
+
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            int connection = accept(self.listeningSocket, NULL, NULL);
+            if (connection >= 0) {
+                if ([self acceptHandshakeOnSocket:connection]) {
+                    self.echoedFrames = AWSSRTestEchoFrames(connection);
+                }
+                close(connection);
+            }
+            close(self.listeningSocket);
+            dispatch_semaphore_signal(self.closed);
+        });
+    }
+    return self;
+}
+
+- (BOOL)acceptHandshakeOnSocket:(int)connection {
+    NSMutableData *request = [NSMutableData new];
+    uint8_t byte;
+    while (request.length < 4 || memcmp((const uint8_t *)request.bytes + request.length - 4, "\r\n\r\n", 4) != 0) {
+        if (!AWSSRTestReadFully(connection, &byte, 1)) {
+            return NO;
+        }
+        [request appendBytes:&byte length:1];
+    }
+    NSString *key = nil;
+    for (NSString *line in [[[NSString alloc] initWithData:request encoding:NSUTF8StringEncoding] componentsSeparatedByString:@"\r\n"]) {
+        if ([line.lowercaseString hasPrefix:@"sec-websocket-key:"]) {
+            key = [[line substringFromIndex:@"sec-websocket-key:".length] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+        }
+    }
+    if (key == nil) {
+        return NO;
+    }
+    NSData *keyData = [[key stringByAppendingString:@"258EAFA5-E914-47DA-95CA-C5AB0DC85B11"] dataUsingEncoding:NSUTF8StringEncoding];
+    uint8_t digest[CC_SHA1_DIGEST_LENGTH];
+    CC_SHA1(keyData.bytes, (CC_LONG)keyData.length, digest);
+    NSString *accept = [[NSData dataWithBytes:digest length:sizeof(digest)] base64EncodedStringWithOptions:0];
+    NSString *response = [NSString stringWithFormat:@"HTTP/1.1 101 Switching Protocols\r\n"
+                          @"Upgrade: websocket\r\n"
+                          @"Connection: Upgrade\r\n"
+                          @"Sec-WebSocket-Accept: %@\r\n\r\n", accept];
+    NSData *responseData = [response dataUsingEncoding:NSUTF8StringEncoding];
+    return AWSSRTestWriteFully(connection, responseData.bytes, responseData.length);
+}
+
+- (BOOL)waitUntilClosed {
+    return dispatch_semaphore_wait(self.closed, dispatch_time(DISPATCH_TIME_NOW, 10 * NSEC_PER_SEC)) == 0;
+}
+
+@end
+
+@interface AWSSRWebSocketTests : XCTestCase <AWSSRWebSocketDelegate>
+
+@property (nonatomic, strong) AWSSRWebSocketTestEchoServer *server;
+@property (nonatomic, strong) AWSSRWebSocket *webSocket;
+@property (nonatomic, strong) XCTestExpectation *opened;
+// Written only on the serial delegate queue.
+@property (nonatomic, strong) NSMutableArray<NSData *> *receivedMessages;
+@property (nonatomic, assign) NSUInteger receivedLength;
+@property (nonatomic, assign) NSUInteger expectedLength;
+@property (nonatomic, strong) dispatch_semaphore_t receivedExpectedLength;
+
+@end
+
+@implementation AWSSRWebSocketTests
+
+- (void)setUp {
+    [super setUp];
+    self.server = [AWSSRWebSocketTestEchoServer new];
+    XCTAssertNotNil(self.server);
+    self.receivedMessages = [NSMutableArray new];
+    self.receivedExpectedLength = dispatch_semaphore_create(0);
+    self.expectedLength = NSUIntegerMax;
+
+    NSURL *url = [NSURL URLWithString:[NSString stringWithFormat:@"ws://127.0.0.1:%u/mqtt", self.server.port]];
+    self.webSocket = [[AWSSRWebSocket alloc] initWithURL:url];
+    self.webSocket.delegate = self;
+    [self.webSocket setDelegateDispatchQueue:dispatch_queue_create("com.amazonaws.iot.test.websocket-delegate", DISPATCH_QUEUE_SERIAL)];
+    self.opened = [self expectationWithDescription:@"web socket opened"];
+    [self.webSocket open];
+    [self waitForExpectationsWithTimeout:10 handler:nil];
+}
+
+- (void)tearDown {
+    [self.webSocket close];
+    XCTAssertTrue([self.server waitUntilClosed]);
+    [super tearDown];
+}
+
+- (void)webSocketDidOpen:(AWSSRWebSocket *)webSocket {
+    [self.opened fulfill];
+}
+
+- (void)webSocket:(AWSSRWebSocket *)webSocket didReceiveMessage:(id)message {
+    [self.receivedMessages addObject:message];
+    self.receivedLength += [message length];
+    if (self.receivedLength == self.expectedLength) {
+        dispatch_semaphore_signal(self.receivedExpectedLength);
+    }
+}
+
+- (void)webSocket:(AWSSRWebSocket *)webSocket didFailWithError:(NSError *)error {
+    XCTFail(@"web socket failed: %@", error);
+    dispatch_semaphore_signal(self.receivedExpectedLength);
+}
+
+// Sets how many bytes to wait for. Call before sending them.
+- (void)expectLength:(NSUInteger)length {
+    self.receivedLength = 0;
+    [self.receivedMessages removeAllObjects];
+    self.expectedLength = length;
+}
+
+- (BOOL)waitForExpectedLength {
+    return dispatch_semaphore_wait(self.receivedExpectedLength, dispatch_time(DISPATCH_TIME_NOW, 30 * NSEC_PER_SEC)) == 0;
+}
+
+- (NSData *)receivedBytes {
+    NSMutableData *bytes = [NSMutableData new];
+    for (NSData *message in self.receivedMessages) {
+        [bytes appendData:message];
+    }
+    return bytes;
+}
+
+- (NSData *)randomDataOfLength:(NSUInteger)length {
+    NSMutableData *data = [NSMutableData dataWithLength:length];
+    arc4random_buf(data.mutableBytes, length);
+    return data;
+}
+
+// Covers the 7-bit, 16-bit and 64-bit length encodings and lengths around the word-wide masking loop.
+- (void)testEchoesMessagesOfEveryLengthClass {
+    NSArray<NSNumber *> *lengths = @[@1, @7, @8, @9, @125, @126, @127, @65535, @65536, @200003];
+    NSMutableArray<NSData *> *sent = [NSMutableArray new];
+    NSUInteger total = 0;
+    for (NSNumber *length in lengths) {
+        [sent addObject:[self randomDataOfLength:length.unsignedIntegerValue]];
+        total += length.unsignedIntegerValue;
+    }
+    [self expectLength:total];
+    for (NSData *data in sent) {
+        [self.webSocket send:data];
+    }
+    XCTAssertTrue([self waitForExpectedLength]);
+    XCTAssertEqualObjects(sent, self.receivedMessages);
+}
+
+- (void)testOutputStreamCoalescesWrites {
+    AWSIoTWebSocketOutputStream *stream = [AWSIoTWebSocketOutputStreamFactory createAWSIoTWebSocketOutputStreamWithWebSocket:self.webSocket];
+    NSData *data = [self randomDataOfLength:5000];
+    [self expectLength:data.length];
+    for (NSUInteger offset = 0; offset < data.length; offset += 50) {
+        XCTAssertEqual((NSInteger)50, [stream write:(const uint8_t *)data.bytes + offset maxLength:50]);
+    }
+    XCTAssertTrue([self waitForExpectedLength]);
+    XCTAssertEqualObjects(data, [self receivedBytes]);
+    XCTAssertLessThanOrEqual(self.receivedMessages.count, (NSUInteger)100);
+    NSLog(@"100 writes to the web socket output stream arrived in %lu frames", (unsigned long)self.receivedMessages.count);
+}
+
+- (void)testBenchmarkEchoThroughput {
+    AWSIoTWebSocketOutputStream *stream = [AWSIoTWebSocketOutputStreamFactory createAWSIoTWebSocketOutputStreamWithWebSocket:self.webSocket];
+    NSUInteger total = 8 * 1024 * 1024;
+    for (NSNumber *writeLength in @[@64, @1024, @16384]) {
+        NSData *chunk = [self randomDataOfLength:writeLength.unsignedIntegerValue];
+        NSUInteger writes = total / chunk.length;
+
+        [self expectLength:writes * chunk.length];
+        NSDate *start = [NSDate date];
+        for (NSUInteger i = 0; i < writes; i++) {
+            [self.webSocket send:chunk];
+        }
+        XCTAssertTrue([self waitForExpectedLength]);
+        NSTimeInterval frameTime = [[NSDate date] timeIntervalSinceDate:start];
+
+        [self expectLength:writes * chunk.length];
+        start = [NSDate date];
+        for (NSUInteger i = 0; i < writes; i++) {
+            [stream write:chunk.bytes maxLength:chunk.length];
+        }
+        XCTAssertTrue([self waitForExpectedLength]);
+        NSTimeInterval streamTime = [[NSDate date] timeIntervalSinceDate:start];
+        NSUInteger frames = self.receivedMessages.count;
+
+        NSLog(@"WebSocket loopback echo, %lu x %@ byte writes: frame per write %.1f MB/s, coalescing output stream %.1f MB/s in %lu frames",
+              (unsigned long)writes, writeLength, total / frameTime / 1e6, total / streamTime / 1e6, (unsigned long)frames);
+    }
+}
+
+@end
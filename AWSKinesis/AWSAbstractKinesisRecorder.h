@@ -22,7 +22,7 @@
 @interface AWSAbstractKinesisRecorder : AWSService
 
 /**
- The number of bytes currently used to store AWSKinesisPutRecordInput objects on disk.
+ The number of bytes currently used to store AWSKinesisPutRecordInput objects on disk. This is a running count of the stored record payloads plus a small per-record overhead, maintained as records are saved and deleted.
  */
 @property (nonatomic, assign, readonly) NSUInteger diskBytesUsed;
 
@@ -47,6 +47,22 @@
  */
 @property (nonatomic, assign) NSUInteger batchRecordsByteLimit;
 
+/**
+ The maximum number of PutRecords or PutRecordBatch requests `submitAllRecords` keeps in flight for each stream. Different streams are always submitted in parallel. The default value is 1, which sends the records of a stream in the order they were saved.
+ */
+@property (nonatomic, assign) NSUInteger submissionConcurrencyLimit;
+
+/**
+ The number of saved records buffered in memory before they are written to disk in a single transaction. The default is 0 meaning every record is written to disk before the task returned by `saveRecord:streamName:` completes.
+ @discussion When set to a value greater than 0, the task returned by `saveRecord:streamName:` completes as soon as the record is buffered, and the age and size limits are enforced once per write instead of once per record. Buffered records are lost if the app terminates before they are written; `writeBehindFlushInterval` bounds how long a record can stay in the buffer.
+ */
+@property (nonatomic, assign) NSUInteger writeBehindRecordCount;
+
+/**
+ The maximum time in seconds a buffered record waits before it is written to disk when `writeBehindRecordCount` is greater than 0. The default is 0.5 seconds.
+ */
+@property (nonatomic, assign) NSTimeInterval writeBehindFlushInterval;
+
 /**
  Saves a record to local storage to be sent later. The record will be submitted to the streamName provided with a randomly generated partition key to ensure equal distribution across shards.
 
@@ -72,6 +88,13 @@
              streamName:(NSString *)streamName
            partitionKey:(NSString *)partitionKey;
 
+/**
+ Writes all records buffered by `writeBehindRecordCount` to disk. `submitAllRecords` calls this before submitting, so you only need to call it directly to shorten the loss window, e.g. when the app enters the background.
+
+ @return AWSTask - task.result is always nil.
+ */
+- (AWSTask *)flushRecords;
+
 /**
  Submits all locally saved requests to Amazon Kinesis. Requests that are successfully sent will be deleted from the device. Requests that fail due to the device being offline will stop the submission process and be kept. Requests that fail due to other reasons (such as the request being invalid) will be deleted.
 
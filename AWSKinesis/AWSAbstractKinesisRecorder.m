@@ -22,6 +22,18 @@ NSTimeInterval const AWSKinesisAbstractClientAgeLimitDefault = 0.0; // Keeps the
 NSString *const AWSKinesisAbstractClientUserAgent = @"recorder";
 NSUInteger const AWSKinesisAbstractClientBatchRecordByteLimitDefault = 512 * 1024 * 1024;
 NSString *const AWSKinesisAbstractClientRecorderDatabasePathPrefix = @"com/amazonaws/AWSKinesisRecorder";
+NSTimeInterval const AWSKinesisAbstractClientWriteBehindFlushIntervalDefault = 0.5;
+NSUInteger const AWSKinesisAbstractClientSubmissionConcurrencyLimitDefault = 1;
+NSUInteger const AWSKinesisAbstractClientBatchRecordCountLimitDefault = 128;
+NSUInteger const AWSKinesisAbstractClientStatementRowIdLimit = 500; // Stays below SQLITE_MAX_VARIABLE_NUMBER.
+double const AWSKinesisAbstractClientEvictionLowWaterMark = 0.9; // Evicts down to 90% of `diskByteLimit`.
+
+// The bytes a record accounts for in `diskBytesUsed`: its payload plus an estimate of the per-row overhead.
+NSUInteger const AWSKinesisAbstractClientRecordOverheadBytes = 32;
+// `sizeOfRecord:` as an SQL expression over the `record` columns.
+static NSString *AWSKinesisAbstractClientRecordSizeExpression(void) {
+    return [NSString stringWithFormat:@"(LENGTH(data) + LENGTH(CAST(partition_key AS BLOB)) + LENGTH(CAST(stream_name AS BLOB)) + %lu)", (unsigned long)AWSKinesisAbstractClientRecordOverheadBytes];
+}
 
 @protocol AWSKinesisRecorderHelper <NSObject>
 
@@ -42,11 +54,58 @@ NSString *const AWSKinesisAbstractClientRecorderDatabasePathPrefix = @"com/amazo
 
 @end
 
+@class AWSKinesisRecorderSubmissionBatch;
+
+// Tracks the progress of `submitAllRecords` through the records of one stream.
+@interface AWSKinesisRecorderStreamSubmission : NSObject
+
+@property (nonatomic, strong) NSString *streamName;
+@property (nonatomic, assign) long long lastRowId;
+@property (nonatomic, assign) NSUInteger inFlightCount;
+@property (nonatomic, assign) BOOL retryPending;
+@property (nonatomic, strong) AWSKinesisRecorderSubmissionBatch *nextBatch;
+
+@end
+
+@implementation AWSKinesisRecorderStreamSubmission
+
+@end
+
+// A batch of records read from the database and the result of sending it.
+@interface AWSKinesisRecorderSubmissionBatch : NSObject
+
+@property (nonatomic, weak) AWSKinesisRecorderStreamSubmission *stream;
+@property (nonatomic, strong) NSArray *records;
+@property (nonatomic, strong) NSArray *rowIds;
+@property (nonatomic, strong) NSMutableArray *putRowIds;
+@property (nonatomic, strong) NSMutableArray *retryRowIds;
+@property (nonatomic, strong) AWSTask *task;
+
+@end
+
+@implementation AWSKinesisRecorderSubmissionBatch
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _putRowIds = [NSMutableArray new];
+        _retryRowIds = [NSMutableArray new];
+    }
+    return self;
+}
+
+@end
+
 @interface AWSAbstractKinesisRecorder()
 
 @property (nonatomic, strong) id<AWSKinesisRecorderHelper> recorderHelper;
 @property (nonatomic, strong) AWSFMDatabaseQueue *databaseQueue;
 @property (nonatomic, strong) NSString *databasePath;
+@property (nonatomic, strong) NSMutableArray *pendingRecords;
+@property (nonatomic, assign) BOOL pendingRecordsFlushScheduled;
+@property (nonatomic, assign) NSUInteger pendingRecordsFlushGeneration;
+@property (nonatomic, assign) NSUInteger writeTransactionCount;
+@property (nonatomic, assign) NSUInteger batchRecordCountLimit;
+@property (atomic, assign) NSUInteger storedByteCount;
 
 @end
 
@@ -70,6 +129,11 @@ NSString *const AWSKinesisAbstractClientRecorderDatabasePathPrefix = @"com/amazo
         _diskByteLimit = AWSKinesisAbstractClientByteLimitDefault;
         _diskAgeLimit = AWSKinesisAbstractClientAgeLimitDefault;
         _batchRecordsByteLimit = AWSKinesisAbstractClientBatchRecordByteLimitDefault;
+        _writeBehindRecordCount = 0;
+        _writeBehindFlushInterval = AWSKinesisAbstractClientWriteBehindFlushIntervalDefault;
+        _pendingRecords = [NSMutableArray new];
+        _submissionConcurrencyLimit = AWSKinesisAbstractClientSubmissionConcurrencyLimitDefault;
+        _batchRecordCountLimit = AWSKinesisAbstractClientBatchRecordCountLimitDefault;
 
         // Creates a directory for storing databases if it doesn't exist.
         BOOL fileExistsAtPath = [[NSFileManager defaultManager] fileExistsAtPath:databaseDirectoryPath];
@@ -88,8 +152,9 @@ NSString *const AWSKinesisAbstractClientRecorderDatabasePathPrefix = @"com/amazo
         AWSDDLogDebug(@"Database path: [%@]", _databasePath);
         _databaseQueue = [AWSFMDatabaseQueue serialDatabaseQueueWithPath:_databasePath];
         [_databaseQueue inDatabase:^(AWSFMDatabase *db) {
-            if (![db executeStatements:@"PRAGMA auto_vacuum = FULL"]) {
-                AWSDDLogError(@"Failed to enable 'auto_vacuum' to 'FULL'. %@", db.lastError);
+            // Free pages are reclaimed with `PRAGMA incremental_vacuum` after bulk deletes instead of on every commit.
+            if (![db executeStatements:@"PRAGMA auto_vacuum = INCREMENTAL"]) {
+                AWSDDLogError(@"Failed to enable 'auto_vacuum' to 'INCREMENTAL'. %@", db.lastError);
             }
 
             if (![db executeUpdate:
@@ -102,9 +167,23 @@ NSString *const AWSKinesisAbstractClientRecorderDatabasePathPrefix = @"com/amazo
                 AWSDDLogError(@"SQLite error. [%@]", db.lastError);
             }
 
+            if (![db executeUpdate:@"CREATE INDEX IF NOT EXISTS record_timestamp ON record (timestamp)"]
+                || ![db executeUpdate:@"CREATE INDEX IF NOT EXISTS record_stream_name ON record (stream_name)"]) {
+                AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+            }
+
             if (![db executeUpdate:@"VACUUM"]) {
                 AWSDDLogError(@"SQLite error. [%@]", db.lastError);
             }
+
+            // Seeds the running byte counter that `diskBytesUsed` and the eviction use from then on.
+            AWSFMResultSet *rs = [db executeQuery:[NSString stringWithFormat:@"SELECT COALESCE(SUM(%@), 0) AS size FROM record", AWSKinesisAbstractClientRecordSizeExpression()]];
+            if ([rs next]) {
+                self.storedByteCount = (NSUInteger)[rs unsignedLongLongIntForColumn:@"size"];
+            } else {
+                AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+            }
+            [rs close];
         }];
     }
     return self;
@@ -121,6 +200,19 @@ NSString *const AWSKinesisAbstractClientRecorderDatabasePathPrefix = @"com/amazo
     return queue;
 }
 
+// Runs `submitAllRecords`, which blocks until its requests complete, so that saving records on
+// `sharedQueue` doesn't wait for the network.
++ (dispatch_queue_t)submissionQueue {
+    static dispatch_queue_t queue;
+    static dispatch_once_t predicate;
+
+    dispatch_once(&predicate, ^{
+        queue = dispatch_queue_create("com.amazonaws.AWSKinesisRecorder.submission", DISPATCH_QUEUE_SERIAL);
+    });
+
+    return queue;
+}
+
 - (AWSTask *)saveRecord:(NSData *)data
              streamName:(NSString *)streamName {
     return [self saveRecord:data streamName:streamName partitionKey:[[NSUUID UUID] UUIDString]];
@@ -134,211 +226,476 @@ NSString *const AWSKinesisAbstractClientRecorderDatabasePathPrefix = @"com/amazo
         return [AWSTask taskWithError:[self.recorderHelper dataTooLargeError]];
     }
 
+    NSDictionary *record = @{
+                             @"partition_key" : partitionKey,
+                             @"stream_name" : streamName,
+                             @"data" : data,
+                             @"timestamp" : @([[NSDate date] timeIntervalSince1970]),
+                             @"retry_count" : @0
+                             };
+    NSUInteger writeBehindRecordCount = self.writeBehindRecordCount;
+    NSTimeInterval writeBehindFlushInterval = self.writeBehindFlushInterval;
+
+    return [[AWSTask taskWithResult:nil] continueWithExecutor:[AWSExecutor executorWithDispatchQueue:[AWSKinesisRecorder sharedQueue]] withSuccessBlock:^id _Nullable(AWSTask * _Nonnull task) {
+        if (writeBehindRecordCount == 0) {
+            NSError *error = [self writeRecords:@[record] inserted:NULL];
+            if (error) {
+                return [AWSTask taskWithError:error];
+            }
+            return nil;
+        }
+
+        // Buffers the record and writes the buffer in one transaction once it is full or old enough.
+        [self.pendingRecords addObject:record];
+        if ([self.pendingRecords count] >= writeBehindRecordCount) {
+            NSError *error = [self writePendingRecords];
+            if (error) {
+                return [AWSTask taskWithError:error];
+            }
+        } else if (!self.pendingRecordsFlushScheduled) {
+            self.pendingRecordsFlushScheduled = YES;
+            // A timer is superseded when the buffer is written before it fires, so that it doesn't flush the
+            // records buffered after that write early.
+            NSUInteger generation = self.pendingRecordsFlushGeneration;
+            __weak AWSAbstractKinesisRecorder *weakSelf = self;
+            dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(writeBehindFlushInterval * NSEC_PER_SEC)),
+                           [AWSKinesisRecorder sharedQueue], ^{
+                               AWSAbstractKinesisRecorder *strongSelf = weakSelf;
+                               if (!strongSelf || strongSelf.pendingRecordsFlushGeneration != generation) {
+                                   return;
+                               }
+                               NSError *error = [strongSelf writePendingRecords];
+                               if (error) {
+                                   AWSDDLogError(@"Failed to write the buffered records. They will be written with the next record or flush. [%@]", error);
+                               }
+                           });
+        }
+
+        return nil;
+    }];
+}
+
+- (AWSTask *)flushRecords {
+    return [[AWSTask taskWithResult:nil] continueWithExecutor:[AWSExecutor executorWithDispatchQueue:[AWSKinesisRecorder sharedQueue]] withSuccessBlock:^id _Nullable(AWSTask * _Nonnull task) {
+        NSError *error = [self writePendingRecords];
+        if (error) {
+            return [AWSTask taskWithError:error];
+        }
+        return nil;
+    }];
+}
+
+// Must be called on `[AWSKinesisRecorder sharedQueue]`.
+- (NSError *)writePendingRecords {
+    self.pendingRecordsFlushScheduled = NO;
+    self.pendingRecordsFlushGeneration += 1;
+    if ([self.pendingRecords count] == 0) {
+        return nil;
+    }
+
+    // The records stay buffered unless the transaction that inserts them commits, so a failed write is retried
+    // with the next record or flush instead of losing the buffered window.
+    BOOL inserted = NO;
+    NSError *error = [self writeRecords:self.pendingRecords inserted:&inserted];
+    if (inserted) {
+        [self.pendingRecords removeAllObjects];
+    }
+    return error;
+}
+
+// Inserts the records and enforces the age and size limits in a single transaction for the whole group.
+// `inserted` is set to YES only when that transaction committed. If any of its statements fails it is rolled back
+// as a whole and `storedByteCount` is restored, so a failed write leaves neither rows nor bytes behind.
+// Must be called on `[AWSKinesisRecorder sharedQueue]`.
+- (NSError *)writeRecords:(NSArray *)records inserted:(BOOL *)inserted {
     AWSFMDatabaseQueue *databaseQueue = self.databaseQueue;
     NSTimeInterval diskAgeLimit = self.diskAgeLimit;
-    NSString *databasePath = self.databasePath;
     NSUInteger notificationByteThreshold = self.notificationByteThreshold;
     NSUInteger diskByteLimit = self.diskByteLimit;
     __weak id notificationSender = self;
 
-    return [[AWSTask taskWithResult:nil] continueWithExecutor:[AWSExecutor executorWithDispatchQueue:[AWSKinesisRecorder sharedQueue]] withSuccessBlock:^id _Nullable(AWSTask * _Nonnull task) {
-        // Inserts a new record to the database.
-        __block NSError *error = nil;
-        [databaseQueue inDatabase:^(AWSFMDatabase *db) {
-            BOOL result = [db executeUpdate:
-                           @"INSERT INTO record ("
-                           @"partition_key, stream_name, data, timestamp, retry_count"
-                           @") VALUES ("
-                           @":partition_key, :stream_name, :data, :timestamp, :retry_count"
-                           @")"
-                    withParameterDictionary:@{
-                                              @"partition_key" : partitionKey,
-                                              @"stream_name" : streamName,
-                                              @"data" : data,
-                                              @"timestamp" : @([[NSDate date] timeIntervalSince1970]),
-                                              @"retry_count" : @0
-                                              }
-                           ];
-
-
-            if (!result) {
-                AWSDDLogError(@"SQLite error. [%@]", db.lastError);
-                error = db.lastError;
-            }
-        }];
+    __block NSError *error = nil;
+    __block BOOL evicted = NO;
+    __block BOOL committed = NO;
+    // Runs the transaction by hand rather than with `inTransaction:`, which ignores the result of COMMIT.
+    [databaseQueue inDatabase:^(AWSFMDatabase *db) {
+        NSUInteger storedByteCount = self.storedByteCount;
+        if (![db beginTransaction]) {
+            AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+            error = db.lastError;
+            return;
+        }
+        if (![self applyRecords:records diskAgeLimit:diskAgeLimit diskByteLimit:diskByteLimit evicted:&evicted database:db]
+            || ![db commit]) {
+            AWSDDLogError(@"SQLite error. Rolling back... [%@]", db.lastError);
+            error = db.lastError;
+            [db rollback];
+            self.storedByteCount = storedByteCount;
+            evicted = NO;
+            return;
+        }
+        committed = YES;
+    }];
+    self.writeTransactionCount += 1;
+    if (inserted) {
+        *inserted = committed;
+    }
 
-        if (!error && diskAgeLimit > 0) {
-            [databaseQueue inDatabase:^(AWSFMDatabase *db) {
-                // Deletes old records exceeding the threshold.
-                BOOL result = [db executeUpdate:
-                               @"DELETE FROM record "
-                               @"WHERE timestamp < :timestamp"
-                        withParameterDictionary:@{
-                                                  @"timestamp" : @([[NSDate date] timeIntervalSince1970] - diskAgeLimit)
-                                                  }
-                               ];
-                if (!result) {
-                    AWSDDLogError(@"SQLite error. [%@]", db.lastError);
-                    error = db.lastError;
-                }
-            }];
+    if (error) {
+        return error;
+    }
+
+    [self.recorderHelper checkByteThresholdForNotification:notificationByteThreshold
+                                        notificationSender:notificationSender
+                                                  fileSize:self.storedByteCount];
+
+    if (evicted) {
+        [self reclaimFreePages];
+    }
+
+    return error;
+}
+
+// The statements of `writeRecords:inserted:`. Returns NO as soon as one of them fails. Called inside a transaction.
+- (BOOL)applyRecords:(NSArray *)records
+        diskAgeLimit:(NSTimeInterval)diskAgeLimit
+       diskByteLimit:(NSUInteger)diskByteLimit
+             evicted:(BOOL *)evicted
+            database:(AWSFMDatabase *)db {
+    for (NSDictionary *record in records) {
+        if (![db executeUpdate:
+              @"INSERT INTO record ("
+              @"partition_key, stream_name, data, timestamp, retry_count"
+              @") VALUES ("
+              @":partition_key, :stream_name, :data, :timestamp, :retry_count"
+              @")"
+       withParameterDictionary:record]) {
+            return NO;
         }
+        self.storedByteCount += [self sizeOfRecord:record];
+    }
 
-        if (error) {
-            return [AWSTask taskWithError:error];
+    if (diskAgeLimit > 0) {
+        // Deletes old records exceeding the threshold.
+        if (![self deleteRecordsWhere:@"timestamp < ?"
+                            arguments:@[@([[NSDate date] timeIntervalSince1970] - diskAgeLimit)]
+                             database:db]) {
+            return NO;
         }
+    }
 
-        NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:databasePath
-                                                                                    error:&error];
-        if (attributes) {
-            NSUInteger fileSize = (NSUInteger)[attributes fileSize];
-            [self.recorderHelper checkByteThresholdForNotification:notificationByteThreshold
-                                                notificationSender:notificationSender
-                                                          fileSize:fileSize];
-            if (fileSize > diskByteLimit) {
-                // Deletes the oldest record if it exceeds the disk size threshold.
-                [databaseQueue inDatabase:^(AWSFMDatabase *db) {
-                    BOOL result = [db executeUpdate:
-                                   @"DELETE FROM record "
-                                   @"WHERE rowid IN ( "
-                                   @"SELECT rowid "
-                                   @"FROM record "
-                                   @"ORDER BY timestamp ASC "
-                                   @"LIMIT 1 "
-                                   @")"
-                                   ];
-                    if (!result) {
-                        AWSDDLogError(@"SQLite error. [%@]", db.lastError);
-                        error = db.lastError;
-                        return;
-                    }
-                }];
+    if (diskByteLimit > 0 && self.storedByteCount > diskByteLimit) {
+        // Deletes the oldest records until the stored bytes are back under the low-water mark, so that
+        // eviction runs once per many writes instead of on every write once the limit is reached.
+        NSUInteger bytesToFree = self.storedByteCount - (NSUInteger)(diskByteLimit * AWSKinesisAbstractClientEvictionLowWaterMark);
+        NSUInteger freedBytes = 0;
+        NSUInteger recordCount = 0;
+        AWSFMResultSet *rs = [db executeQuery:[NSString stringWithFormat:
+                                               @"SELECT %@ AS size "
+                                               @"FROM record "
+                                               @"ORDER BY timestamp ASC", AWSKinesisAbstractClientRecordSizeExpression()]];
+        if (!rs) {
+            return NO;
+        }
+        while (freedBytes < bytesToFree && [rs next]) {
+            freedBytes += (NSUInteger)[rs unsignedLongLongIntForColumn:@"size"];
+            recordCount += 1;
+        }
+        [rs close];
 
-            }
-        } else if (error) {
-            return [AWSTask taskWithError:error];
+        AWSDDLogWarn(@"Deleting %lu oldest records from disk, diskByteLimit has been reached.", (unsigned long)recordCount);
+        if (![self deleteRecordsWhere:@"rowid IN (SELECT rowid FROM record ORDER BY timestamp ASC LIMIT ?)"
+                            arguments:@[@(recordCount)]
+                             database:db]) {
+            return NO;
         }
+        *evicted = YES;
+    }
 
-        return nil;
+    return YES;
+}
+
+- (NSUInteger)sizeOfRecord:(NSDictionary *)record {
+    return [record[@"data"] length]
+    + [record[@"partition_key"] lengthOfBytesUsingEncoding:NSUTF8StringEncoding]
+    + [record[@"stream_name"] lengthOfBytesUsingEncoding:NSUTF8StringEncoding]
+    + AWSKinesisAbstractClientRecordOverheadBytes;
+}
+
+// Deletes the records matching `predicate` and subtracts their size from the running byte counter.
+// Must be called inside a transaction so that the sum and the delete see the same rows.
+- (BOOL)deleteRecordsWhere:(NSString *)predicate
+                 arguments:(NSArray *)arguments
+                  database:(AWSFMDatabase *)db {
+    AWSFMResultSet *rs = [db executeQuery:[NSString stringWithFormat:@"SELECT COALESCE(SUM(%@), 0) AS size FROM record WHERE %@", AWSKinesisAbstractClientRecordSizeExpression(), predicate]
+                     withArgumentsInArray:arguments];
+    if (!rs) {
+        AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+        return NO;
+    }
+    NSUInteger size = [rs next] ? (NSUInteger)[rs unsignedLongLongIntForColumn:@"size"] : 0;
+    [rs close];
+
+    if (![db executeUpdate:[NSString stringWithFormat:@"DELETE FROM record WHERE %@", predicate]
+      withArgumentsInArray:arguments]) {
+        AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+        return NO;
+    }
+    self.storedByteCount -= MIN(size, self.storedByteCount);
+
+    return YES;
+}
+
+- (void)reclaimFreePages {
+    [self.databaseQueue inDatabase:^(AWSFMDatabase *db) {
+        if (![db executeStatements:@"PRAGMA incremental_vacuum"]) {
+            AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+        }
     }];
 }
 
 - (AWSTask *)submitAllRecords {
     AWSFMDatabaseQueue *databaseQueue = self.databaseQueue;
+    NSUInteger submissionConcurrencyLimit = MAX(self.submissionConcurrencyLimit, 1);
 
-    return [[AWSTask taskWithResult:nil] continueWithExecutor:[AWSExecutor executorWithDispatchQueue:[AWSKinesisRecorder sharedQueue]] withSuccessBlock:^id _Nullable(AWSTask * _Nonnull task) {
+    // Only the database work of a drain runs on `sharedQueue`, in short steps between the saves; waiting for the
+    // requests happens on `submissionQueue`.
+    return [[AWSTask taskWithResult:nil] continueWithExecutor:[AWSExecutor executorWithDispatchQueue:[AWSKinesisRecorder submissionQueue]] withSuccessBlock:^id _Nullable(AWSTask * _Nonnull task) {
         __block NSError *error = nil;
-        __block NSUInteger batchSize = 0;
-        __block BOOL stop = NO;
-
-        do {
-            [databaseQueue inTransaction:^(AWSFMDatabase *db, BOOL *rollback) {
-                NSMutableArray *rowIds = nil;
-
-                AWSFMResultSet *rs = [db executeQuery:
-                                      @"SELECT rowid, partition_key, data, retry_count, stream_name "
-                                      @"FROM record "
-                                      @"WHERE stream_name = (SELECT stream_name FROM record ORDER BY timestamp ASC LIMIT 1) "
-                                      @"ORDER BY timestamp ASC "
-                                      @"LIMIT 128"];
+        NSMutableArray *streams = [NSMutableArray new];
+        dispatch_sync([AWSKinesisRecorder sharedQueue], ^{
+            error = [self writePendingRecords];
+            if (error) {
+                return;
+            }
+            [databaseQueue inDatabase:^(AWSFMDatabase *db) {
+                AWSFMResultSet *rs = [db executeQuery:@"SELECT DISTINCT stream_name FROM record"];
                 if (!rs) {
-                    AWSDDLogError(@"SQLite error. Rolling back... [%@]", db.lastError);
+                    AWSDDLogError(@"SQLite error. [%@]", db.lastError);
                     error = db.lastError;
-                    *rollback = YES;
                     return;
                 }
-
-                NSUInteger batchDataSize = 0;
-                NSMutableArray *temporaryRecords = [NSMutableArray new];
-                rowIds = [NSMutableArray new];
                 while ([rs next]) {
-                    [temporaryRecords addObject:@{
-                                                  @"partition_key": [rs stringForColumn:@"partition_key"],
-                                                  @"data": [rs dataForColumn:@"data"],
-                                                  @"stream_name": [rs stringForColumn:@"stream_name"],
-                                                  }];
-
-                    [rowIds addObject:[rs stringForColumn:@"rowid"]];
-                    batchDataSize += [[rs dataForColumn:@"data"] length];
+                    AWSKinesisRecorderStreamSubmission *stream = [AWSKinesisRecorderStreamSubmission new];
+                    stream.streamName = [rs stringForColumn:@"stream_name"];
+                    [streams addObject:stream];
+                }
+            }];
+        });
+        if (error) {
+            return [AWSTask taskWithError:error];
+        }
 
-                    if (batchDataSize > self.batchRecordsByteLimit) { // if the batch size exceeds `batchRecordsByteLimit`, stop there.
+        BOOL stop = NO;
+        NSMutableArray *inFlightBatches = [NSMutableArray new];
+
+        while (YES) {
+            // Keeps up to `submissionConcurrencyLimit` batches in flight for every stream, and reads the next batch of a
+            // stream while the previous one is still being sent.
+            for (AWSKinesisRecorderStreamSubmission *stream in streams) {
+                while (!stop && !error && stream.inFlightCount < submissionConcurrencyLimit) {
+                    if (stream.retryPending) {
+                        // Resends the records marked for retry before any newer record of the stream. The prefetched
+                        // batch is discarded and the stream is read again from the start once its in-flight batches
+                        // have finished, so the retried records go out ahead of the records that follow them.
+                        if (stream.inFlightCount > 0) {
+                            break;
+                        }
+                        stream.nextBatch = nil;
+                        stream.lastRowId = 0;
+                        stream.retryPending = NO;
+                    }
+                    if (!stream.nextBatch) {
+                        stream.nextBatch = [self readBatchForStream:stream error:&error];
+                    }
+                    AWSKinesisRecorderSubmissionBatch *batch = stream.nextBatch;
+                    if (!batch) {
                         break;
                     }
+
+                    batch.task = [self.recorderHelper submitRecordsForStream:stream.streamName
+                                                                     records:batch.records
+                                                                      rowIds:batch.rowIds
+                                                                   putRowIds:batch.putRowIds
+                                                                 retryRowIds:batch.retryRowIds
+                                                                        stop:&stop];
+                    stream.inFlightCount += 1;
+                    [inFlightBatches addObject:batch];
+                    stream.nextBatch = [self readBatchForStream:stream error:&error];
                 }
-                rs = nil;
-                batchSize = [temporaryRecords count];
+            }
 
-                if (batchSize > 0) {
-                    __block NSMutableArray *putRowIds = [NSMutableArray new];
-                    __block NSMutableArray *retryRowIds = [NSMutableArray new];
+            if ([inFlightBatches count] == 0) {
+                break;
+            }
 
-                    NSString *streamName = temporaryRecords[0][@"stream_name"];
+            // Waits for the first batch to finish, whether it succeeded or not.
+            NSMutableArray *completionTasks = [NSMutableArray new];
+            for (AWSKinesisRecorderSubmissionBatch *batch in inFlightBatches) {
+                [completionTasks addObject:[batch.task continueWithBlock:^id _Nullable(AWSTask * _Nonnull task) {
+                    return nil;
+                }]];
+            }
+            [[AWSTask taskForCompletionOfAnyTask:completionTasks] waitUntilFinished];
+
+            NSMutableArray *completedBatches = [NSMutableArray new];
+            for (AWSKinesisRecorderSubmissionBatch *batch in inFlightBatches) {
+                if (batch.task.completed) {
+                    [completedBatches addObject:batch];
+                    batch.stream.inFlightCount -= 1;
+                    if ([batch.retryRowIds count] > 0) {
+                        batch.stream.retryPending = YES;
+                    }
+                    if (batch.task.error && !error) {
+                        error = batch.task.error;
+                    }
+                }
+            }
+            [inFlightBatches removeObjectsInArray:completedBatches];
 
-                    AWSTask *submitTask = \
-                        [self.recorderHelper submitRecordsForStream:streamName
-                                                            records:temporaryRecords
-                                                             rowIds:rowIds
-                                                          putRowIds:putRowIds
-                                                        retryRowIds:retryRowIds
-                                                               stop:&stop];
+            NSError *databaseError = [self finishSubmittedBatches:completedBatches];
+            if (databaseError && !error) {
+                error = databaseError;
+            }
+        }
 
-                    [submitTask waitUntilFinished];
+        dispatch_sync([AWSKinesisRecorder sharedQueue], ^{
+            [self reclaimFreePages];
+        });
 
-                    if (submitTask.error) {
-                        error = submitTask.error;
-                    }
+        if (error) {
+            return [AWSTask taskWithError:error];
+        }
 
-                    for (NSString *rowId in putRowIds) {
-                        BOOL result = [db executeUpdate:@"DELETE FROM record WHERE rowid = :rowid"
-                                withParameterDictionary:@{
-                                                          @"rowid" : rowId
-                                                          }];
-                        if (!result) {
-                            AWSDDLogError(@"SQLite error. [%@]", db.lastError);
-                            error = db.lastError;
-                        }
-                    }
+        return nil;
+    }];
+}
 
-                    for (NSString *rowId in retryRowIds) {
-                        BOOL result = [db executeUpdate:@"UPDATE record SET retry_count = retry_count + 1 WHERE rowid = :rowid"
-                                withParameterDictionary:@{
-                                                          @"rowid" : rowId
-                                                          }];
-                        if (!result) {
-                            AWSDDLogError(@"SQLite error. [%@]", db.lastError);
-                            error = db.lastError;
-                        }
-                    }
+// Reads the next batch of records after `stream.lastRowId`, or returns nil when there are no more records in the stream.
+// Must be called on `[AWSKinesisRecorder submissionQueue]`.
+- (AWSKinesisRecorderSubmissionBatch *)readBatchForStream:(AWSKinesisRecorderStreamSubmission *)stream
+                                                    error:(NSError **)error {
+    __block AWSKinesisRecorderSubmissionBatch *batch = nil;
+    __block NSError *readError = nil;
+    dispatch_sync([AWSKinesisRecorder sharedQueue], ^{
+        [self.databaseQueue inDatabase:^(AWSFMDatabase *db) {
+            AWSFMResultSet *rs = [db executeQuery:
+                                  @"SELECT rowid, partition_key, data, stream_name "
+                                  @"FROM record "
+                                  @"WHERE stream_name = :stream_name AND rowid > :rowid "
+                                  @"ORDER BY rowid ASC "
+                                  @"LIMIT :limit"
+                          withParameterDictionary:@{
+                                                    @"stream_name" : stream.streamName,
+                                                    @"rowid" : @(stream.lastRowId),
+                                                    @"limit" : @(self.batchRecordCountLimit)
+                                                    }];
+            if (!rs) {
+                AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+                readError = db.lastError;
+                return;
+            }
+
+            NSUInteger batchDataSize = 0;
+            NSMutableArray *temporaryRecords = [NSMutableArray new];
+            NSMutableArray *rowIds = [NSMutableArray new];
+            while ([rs next]) {
+                NSData *data = [rs dataForColumn:@"data"];
+                [temporaryRecords addObject:@{
+                                              @"partition_key": [rs stringForColumn:@"partition_key"],
+                                              @"data": data,
+                                              @"stream_name": [rs stringForColumn:@"stream_name"],
+                                              }];
+
+                stream.lastRowId = [rs longLongIntForColumn:@"rowid"];
+                [rowIds addObject:@(stream.lastRowId)];
+                batchDataSize += [data length];
+
+                if (batchDataSize > self.batchRecordsByteLimit) { // if the batch size exceeds `batchRecordsByteLimit`, stop there.
+                    break;
+                }
+            }
+            [rs close];
+
+            if ([temporaryRecords count] > 0) {
+                batch = [AWSKinesisRecorderSubmissionBatch new];
+                batch.stream = stream;
+                batch.records = temporaryRecords;
+                batch.rowIds = rowIds;
+            }
+        }];
+    });
+    if (readError && error) {
+        *error = readError;
+    }
+
+    return batch;
+}
+
+// Deletes the acknowledged records and updates the retry counts of all completed batches in a single transaction.
+// Must be called on `[AWSKinesisRecorder submissionQueue]`.
+- (NSError *)finishSubmittedBatches:(NSArray *)batches {
+    NSMutableArray *putRowIds = [NSMutableArray new];
+    NSMutableArray *retryRowIds = [NSMutableArray new];
+    for (AWSKinesisRecorderSubmissionBatch *batch in batches) {
+        [putRowIds addObjectsFromArray:batch.putRowIds];
+        [retryRowIds addObjectsFromArray:batch.retryRowIds];
+    }
+
+    __block NSError *error = nil;
+    dispatch_sync([AWSKinesisRecorder sharedQueue], ^{
+        [self.databaseQueue inTransaction:^(AWSFMDatabase *db, BOOL *rollback) {
+            for (NSUInteger location = 0; location < [putRowIds count]; location += AWSKinesisAbstractClientStatementRowIdLimit) {
+                NSArray *rowIds = [putRowIds subarrayWithRange:NSMakeRange(location, MIN(AWSKinesisAbstractClientStatementRowIdLimit, [putRowIds count] - location))];
+                NSString *predicate = [NSString stringWithFormat:@"rowid IN (%@)", [self placeholdersForCount:[rowIds count]]];
+                if (![self deleteRecordsWhere:predicate arguments:rowIds database:db]) {
+                    error = db.lastError;
                 }
+            }
 
-                // If a record failed three times, give up and delete the record.
-                BOOL result = [db executeUpdate:@"DELETE FROM record WHERE retry_count > 3"];
-                if (!result) {
+            for (NSUInteger location = 0; location < [retryRowIds count]; location += AWSKinesisAbstractClientStatementRowIdLimit) {
+                NSArray *rowIds = [retryRowIds subarrayWithRange:NSMakeRange(location, MIN(AWSKinesisAbstractClientStatementRowIdLimit, [retryRowIds count] - location))];
+                NSString *statement = [NSString stringWithFormat:@"UPDATE record SET retry_count = retry_count + 1 WHERE rowid IN (%@)", [self placeholdersForCount:[rowIds count]]];
+                if (![db executeUpdate:statement withArgumentsInArray:rowIds]) {
                     AWSDDLogError(@"SQLite error. [%@]", db.lastError);
                     error = db.lastError;
                 }
-            }];
-        } while (!stop && !error && batchSize > 0);
+            }
 
-        if (error) {
-            return [AWSTask taskWithError:error];
-        }
+            // If a record failed three times, give up and delete the record.
+            if (![self deleteRecordsWhere:@"retry_count > 3" arguments:@[] database:db]) {
+                error = db.lastError;
+            }
+        }];
+    });
 
-        return nil;
-    }];
+    return error;
+}
+
+- (NSString *)placeholdersForCount:(NSUInteger)count {
+    NSMutableArray *placeholders = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [placeholders addObject:@"?"];
+    }
+    return [placeholders componentsJoinedByString:@", "];
 }
 
 - (AWSTask *)removeAllRecords {
     AWSFMDatabaseQueue *databaseQueue = self.databaseQueue;
 
     return [[AWSTask taskWithResult:nil] continueWithExecutor:[AWSExecutor executorWithDispatchQueue:[AWSKinesisRecorder sharedQueue]] withSuccessBlock:^id _Nullable(AWSTask * _Nonnull task) {
+        [self.pendingRecords removeAllObjects];
+
         __block NSError *error = nil;
         [databaseQueue inDatabase:^(AWSFMDatabase *db) {
             if (![db executeUpdate:@"DELETE FROM record"]) {
                 AWSDDLogError(@"SQLite error. [%@]", db.lastError);
                 error = db.lastError;
+                return;
             }
+            self.storedByteCount = 0;
         }];
+        [self reclaimFreePages];
 
         if (error) {
             return [AWSTask taskWithError:error];
@@ -349,15 +706,7 @@ NSString *const AWSKinesisAbstractClientRecorderDatabasePathPrefix = @"com/amazo
 }
 
 - (NSUInteger)diskBytesUsed {
-    NSError *error = nil;
-    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:self.databasePath
-                                                                                error:&error];
-    if (attributes) {
-        return (NSUInteger)[attributes fileSize];
-    } else {
-        AWSDDLogError(@"Error [%@]", error);
-        return 0;
-    }
+    return self.storedByteCount;
 }
 
 - (void)setBatchRecordsByteLimit:(NSUInteger)batchRecordsByteLimit {
@@ -43,6 +43,17 @@ FOUNDATION_EXPORT NSString *const AWSFirehoseRecorderByteThresholdReachedNotific
  */
 @interface AWSFirehoseRecorder : AWSAbstractKinesisRecorder
 
+/**
+ The target size in bytes of the Firehose records sent by `submitAllRecords`. When greater than 0, consecutive saved records for the same delivery stream are concatenated, each followed by `recordCoalescingSeparator`, into Firehose records of up to this size. The default is 0 meaning every saved record is sent as its own Firehose record. The maximum is 1,000KB.
+ @discussion Firehose bills and throttles in 5KB increments per record, so coalescing small records reduces both the number of records and the number of `PutRecordBatch` requests. If a coalesced record fails, all the saved records in it are retried together.
+ */
+@property (nonatomic, assign) NSUInteger recordCoalescingByteLimit;
+
+/**
+ The bytes appended to every saved record when `recordCoalescingByteLimit` is greater than 0. The default is a newline.
+ */
+@property (nonatomic, copy) NSData *recordCoalescingSeparator;
+
 /**
  Returns a shared instance of this service client using `[AWSServiceManager defaultServiceManager].defaultServiceConfiguration`. When `defaultServiceConfiguration` is not set, this method returns nil.
 
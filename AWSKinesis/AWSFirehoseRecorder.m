@@ -23,6 +23,15 @@ NSString *const AWSFirehoseRecorderByteThresholdReachedNotificationDiskBytesUsed
 
 static NSString *const AWSInfoFirehoseRecorder = @"FirehoseRecorder";
 
+// PutRecordBatch limits.
+static NSUInteger const AWSFirehoseRecorderPutRecordBatchRecordLimit = 500;
+static NSUInteger const AWSFirehoseRecorderPutRecordBatchByteLimit = 4 * 1024 * 1024;
+static NSUInteger const AWSFirehoseRecorderRecordByteLimit = 1000 * 1024;
+
+// The number of rows read per batch when coalescing is enabled. The batches still respect `batchRecordsByteLimit`.
+static NSUInteger const AWSFirehoseRecorderCoalescingBatchRecordCountLimit = 4096;
+static NSUInteger const AWSFirehoseRecorderBatchRecordCountLimitDefault = 128;
+
 // Legacy constants
 NSString *const AWSFirehoseRecorderCacheName = @"com.amazonaws.AWSFirehoseRecorderCacheName.Cache";
 
@@ -35,12 +44,15 @@ NSString *const AWSFirehoseRecorderCacheName = @"com.amazonaws.AWSFirehoseRecord
 @interface AWSFirehoseRecorderHelper : NSObject <AWSFirehoseRecorderHelper>
 
 @property (nonatomic, strong) AWSFirehose *firehose;
+@property (atomic, assign) NSUInteger recordCoalescingByteLimit;
+@property (atomic, copy) NSData *recordCoalescingSeparator;
 
 @end
 
 @interface AWSAbstractKinesisRecorder()
 
 @property (nonatomic, strong) id<AWSFirehoseRecorderHelper> recorderHelper;
+@property (nonatomic, assign) NSUInteger batchRecordCountLimit;
 
 - (instancetype)initWithConfiguration:(AWSServiceConfiguration *)configuration
                            identifier:(NSString *)identifier
@@ -131,10 +143,22 @@ static AWSSynchronizedMutableDictionary *_serviceClients = nil;
                                 identifier:identifier
                                  cacheName:cacheName]) {
         self.recorderHelper = [[AWSFirehoseRecorderHelper alloc] initWithConfiguration:configuration];
+        self.recordCoalescingSeparator = [@"\n" dataUsingEncoding:NSUTF8StringEncoding];
     }
     return self;
 }
 
+- (void)setRecordCoalescingByteLimit:(NSUInteger)recordCoalescingByteLimit {
+    _recordCoalescingByteLimit = MIN(recordCoalescingByteLimit, AWSFirehoseRecorderRecordByteLimit);
+    ((AWSFirehoseRecorderHelper *)self.recorderHelper).recordCoalescingByteLimit = _recordCoalescingByteLimit;
+    self.batchRecordCountLimit = _recordCoalescingByteLimit > 0 ? AWSFirehoseRecorderCoalescingBatchRecordCountLimit : AWSFirehoseRecorderBatchRecordCountLimitDefault;
+}
+
+- (void)setRecordCoalescingSeparator:(NSData *)recordCoalescingSeparator {
+    _recordCoalescingSeparator = [recordCoalescingSeparator copy];
+    ((AWSFirehoseRecorderHelper *)self.recorderHelper).recordCoalescingSeparator = _recordCoalescingSeparator;
+}
+
 @end
 
 @interface AWSFirehose()
@@ -159,6 +183,15 @@ static AWSSynchronizedMutableDictionary *_serviceClients = nil;
                           putRowIds:(NSMutableArray *)putRowIds
                         retryRowIds:(NSMutableArray *)retryRowIds
                                stop:(BOOL *)stop {
+    if (self.recordCoalescingByteLimit > 0) {
+        return [self submitCoalescedRecordsForStream:streamName
+                                             records:temporaryRecords
+                                              rowIds:rowIds
+                                           putRowIds:putRowIds
+                                         retryRowIds:retryRowIds
+                                                stop:stop];
+    }
+
     NSMutableArray *records = [NSMutableArray new];
 
     for (NSDictionary *recordDictionary in temporaryRecords) {
@@ -205,6 +238,107 @@ static AWSSynchronizedMutableDictionary *_serviceClients = nil;
     }];
 }
 
+- (AWSTask *)submitCoalescedRecordsForStream:(NSString *)streamName
+                                     records:(NSArray *)temporaryRecords
+                                      rowIds:(NSArray *)rowIds
+                                   putRowIds:(NSMutableArray *)putRowIds
+                                 retryRowIds:(NSMutableArray *)retryRowIds
+                                        stop:(BOOL *)stop {
+    NSUInteger recordCoalescingByteLimit = self.recordCoalescingByteLimit;
+    NSData *separator = self.recordCoalescingSeparator ?: [NSData data];
+
+    // Concatenates consecutive records into Firehose records of up to `recordCoalescingByteLimit` bytes,
+    // remembering which rows went into each of them.
+    NSMutableArray *coalescedData = [NSMutableArray new];
+    NSMutableArray *coalescedRowIds = [NSMutableArray new];
+    NSMutableData *currentData = nil;
+    NSMutableArray *currentRowIds = nil;
+    for (NSUInteger i = 0; i < [temporaryRecords count]; i++) {
+        NSData *data = temporaryRecords[i][@"data"];
+        NSUInteger length = [data length] + [separator length];
+        if (!currentData || [currentData length] + length > recordCoalescingByteLimit) {
+            currentData = [NSMutableData dataWithCapacity:MAX(recordCoalescingByteLimit, length)];
+            currentRowIds = [NSMutableArray new];
+            [coalescedData addObject:currentData];
+            [coalescedRowIds addObject:currentRowIds];
+        }
+        [currentData appendData:data];
+        [currentData appendData:separator];
+        [currentRowIds addObject:rowIds[i]];
+    }
+
+    // Splits the coalesced records into as few PutRecordBatch requests as the service limits allow.
+    NSMutableArray *requestRanges = [NSMutableArray new];
+    NSUInteger location = 0;
+    NSUInteger byteCount = 0;
+    for (NSUInteger i = 0; i < [coalescedData count]; i++) {
+        NSUInteger length = [coalescedData[i] length];
+        if (i - location == AWSFirehoseRecorderPutRecordBatchRecordLimit
+            || (i > location && byteCount + length > AWSFirehoseRecorderPutRecordBatchByteLimit)) {
+            [requestRanges addObject:[NSValue valueWithRange:NSMakeRange(location, i - location)]];
+            location = i;
+            byteCount = 0;
+        }
+        byteCount += length;
+    }
+    if (location < [coalescedData count]) {
+        [requestRanges addObject:[NSValue valueWithRange:NSMakeRange(location, [coalescedData count] - location)]];
+    }
+
+    NSMutableArray *tasks = [NSMutableArray new];
+    for (NSValue *requestRange in requestRanges) {
+        NSMutableArray *records = [NSMutableArray new];
+        for (NSData *data in [coalescedData subarrayWithRange:[requestRange rangeValue]]) {
+            AWSFirehoseRecord *record = [AWSFirehoseRecord new];
+            record.data = data;
+            [records addObject:record];
+        }
+
+        AWSFirehosePutRecordBatchInput *putRecordBatchInput = [AWSFirehosePutRecordBatchInput new];
+        putRecordBatchInput.deliveryStreamName = streamName;
+        putRecordBatchInput.records = records;
+        AWSDDLogVerbose(@"putRecordBatchInput: [%@]", putRecordBatchInput);
+        [tasks addObject:[self.firehose putRecordBatch:putRecordBatchInput]];
+    }
+
+    return [[AWSTask taskForCompletionOfAllTasks:tasks] continueWithBlock:^id(AWSTask *task) {
+        NSError *error = nil;
+        for (NSUInteger i = 0; i < [tasks count]; i++) {
+            AWSTask *putRecordBatchTask = tasks[i];
+            if (putRecordBatchTask.error) {
+                AWSDDLogError(@"Error: [%@]", putRecordBatchTask.error);
+                const NSArray *stopErrorDomains = @[NSURLErrorDomain, AWSCognitoIdentityErrorDomain];
+                if ([stopErrorDomains containsObject:putRecordBatchTask.error.domain]) {
+                    *stop = YES;
+                }
+                error = putRecordBatchTask.error;
+                continue;
+            }
+
+            AWSFirehosePutRecordBatchOutput *putRecordBatchOutput = putRecordBatchTask.result;
+            NSRange requestRange = [requestRanges[i] rangeValue];
+            for (NSUInteger j = 0; j < [putRecordBatchOutput.requestResponses count] && j < requestRange.length; j++) {
+                AWSFirehosePutRecordBatchResponseEntry *resultEntry = putRecordBatchOutput.requestResponses[j];
+                if (resultEntry.errorCode) {
+                    AWSDDLogInfo(@"Error Code: [%@] Error Message: [%@]", resultEntry.errorCode, resultEntry.errorMessage);
+                }
+                // All rows in a coalesced record share its result.
+                if (![resultEntry.errorCode isEqualToString:@"Throttling"]
+                    && ![resultEntry.errorCode isEqualToString:@"ServiceUnavailable"]) {
+                    [putRowIds addObjectsFromArray:coalescedRowIds[requestRange.location + j]];
+                } else {
+                    [retryRowIds addObjectsFromArray:coalescedRowIds[requestRange.location + j]];
+                }
+            }
+        }
+
+        if (error) {
+            return [AWSTask taskWithError:error];
+        }
+        return nil;
+    }];
+}
+
 - (NSError *)dataTooLargeError {
     return [NSError errorWithDomain:AWSFirehoseRecorderErrorDomain
                                code:AWSFirehoseRecorderErrorDataTooLarge
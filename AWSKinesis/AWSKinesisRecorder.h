@@ -43,6 +43,12 @@ FOUNDATION_EXPORT NSString *const AWSKinesisRecorderByteThresholdReachedNotifica
  */
 @interface AWSKinesisRecorder : AWSAbstractKinesisRecorder
 
+/**
+ Whether `submitAllRecords` packs saved records into aggregated Kinesis records using the Kinesis Producer Library (KPL) aggregated record format. The default is NO.
+ @discussion Aggregation sends many small records in a single Kinesis record of up to 1MB, so a stream can accept far more than 1,000 records per second per shard. Consumers must de-aggregate the records with the Kinesis Client Library or the Kinesis aggregation libraries. Records are only aggregated with records whose partition keys map to the same shard, using the stream's shards as listed by `ListShards` every few minutes. If the credentials don't allow `kinesis:ListShards`, records with any partition key are aggregated together, routed to the shard of the first record's partition key and given its explicit hash key. All records in an aggregated record are retried or discarded together.
+ */
+@property (nonatomic, assign) BOOL aggregationEnabled;
+
 /**
  Returns a shared instance of this service client using `[AWSServiceManager defaultServiceManager].defaultServiceConfiguration`. When `defaultServiceConfiguration` is not set, this method returns nil.
 
@@ -15,6 +15,7 @@
 
 #import "AWSKinesisRecorder.h"
 #import "AWSKinesis.h"
+#import "AWSKinesisRecordAggregator.h"
 
 // Constants
 NSString *const AWSKinesisRecorderErrorDomain = @"com.amazonaws.AWSKinesisRecorderErrorDomain";
@@ -23,6 +24,17 @@ NSString *const AWSKinesisRecorderByteThresholdReachedNotificationDiskBytesUsedK
 
 static NSString *const AWSInfoKinesisRecorder = @"KinesisRecorder";
 
+// PutRecords limits.
+static NSUInteger const AWSKinesisRecorderPutRecordsRecordLimit = 500;
+static NSUInteger const AWSKinesisRecorderPutRecordsByteLimit = 5 * 1024 * 1024;
+
+// The number of rows read per batch when aggregation is enabled. The aggregated records still respect `batchRecordsByteLimit`.
+static NSUInteger const AWSKinesisRecorderAggregationBatchRecordCountLimit = 4096;
+static NSUInteger const AWSKinesisRecorderBatchRecordCountLimitDefault = 128;
+
+// How long the shard map of a stream is used to group aggregated records before it is listed again.
+static NSTimeInterval const AWSKinesisRecorderShardMapRefreshInterval = 5 * 60;
+
 // Legacy constants
 NSString *const AWSKinesisRecorderCacheName = @"com.amazonaws.AWSKinesisRecorderCacheName.Cache";
 
@@ -32,15 +44,30 @@ NSString *const AWSKinesisRecorderCacheName = @"com.amazonaws.AWSKinesisRecorder
 
 @end
 
+// The starting hash keys of a stream's open shards, or nil when they could not be listed.
+@interface AWSKinesisRecorderShardMap : NSObject
+
+@property (nonatomic, strong) NSArray<NSString *> *startingHashKeys;
+@property (nonatomic, strong) NSDate *listDate;
+
+@end
+
+@implementation AWSKinesisRecorderShardMap
+
+@end
+
 @interface AWSKinesisRecorderHelper : NSObject <AWSKinesisRecorderHelper>
 
 @property (nonatomic, strong) AWSKinesis *kinesis;
+@property (atomic, assign) BOOL aggregationEnabled;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, AWSKinesisRecorderShardMap *> *shardMaps;
 
 @end
 
 @interface AWSAbstractKinesisRecorder()
 
 @property (nonatomic, strong) id<AWSKinesisRecorderHelper> recorderHelper;
+@property (nonatomic, assign) NSUInteger batchRecordCountLimit;
 
 - (instancetype)initWithConfiguration:(AWSServiceConfiguration *)configuration
                            identifier:(NSString *)identifier
@@ -141,6 +168,12 @@ static AWSSynchronizedMutableDictionary *_serviceClients = nil;
     return self;
 }
 
+- (void)setAggregationEnabled:(BOOL)aggregationEnabled {
+    _aggregationEnabled = aggregationEnabled;
+    ((AWSKinesisRecorderHelper *)self.recorderHelper).aggregationEnabled = aggregationEnabled;
+    self.batchRecordCountLimit = aggregationEnabled ? AWSKinesisRecorderAggregationBatchRecordCountLimit : AWSKinesisRecorderBatchRecordCountLimitDefault;
+}
+
 @end
 
 @implementation AWSKinesisRecorderHelper
@@ -148,6 +181,7 @@ static AWSSynchronizedMutableDictionary *_serviceClients = nil;
 - (instancetype)initWithConfiguration:(AWSServiceConfiguration *)configuration {
     if (self = [super init]) {
         _kinesis = [[AWSKinesis alloc] initWithConfiguration:configuration];
+        _shardMaps = [NSMutableDictionary new];
     }
 
     return self;
@@ -159,6 +193,15 @@ static AWSSynchronizedMutableDictionary *_serviceClients = nil;
                           putRowIds:(NSMutableArray *)putRowIds
                         retryRowIds:(NSMutableArray *)retryRowIds
                                stop:(BOOL *)stop {
+    if (self.aggregationEnabled) {
+        return [self submitAggregatedRecordsForStream:streamName
+                                              records:temporaryRecords
+                                               rowIds:rowIds
+                                            putRowIds:putRowIds
+                                          retryRowIds:retryRowIds
+                                                 stop:stop];
+    }
+
     NSMutableArray *records = [NSMutableArray new];
 
     for (NSDictionary *recordDictionary in temporaryRecords) {
@@ -205,6 +248,162 @@ static AWSSynchronizedMutableDictionary *_serviceClients = nil;
     }];
 }
 
+- (AWSTask *)submitAggregatedRecordsForStream:(NSString *)streamName
+                                      records:(NSArray *)temporaryRecords
+                                       rowIds:(NSArray *)rowIds
+                                    putRowIds:(NSMutableArray *)putRowIds
+                                  retryRowIds:(NSMutableArray *)retryRowIds
+                                         stop:(BOOL *)stop {
+    return [[self shardStartingHashKeysForStream:streamName] continueWithBlock:^id(AWSTask *task) {
+        NSArray *aggregatedRecords = [AWSKinesisRecordAggregator aggregateRecords:temporaryRecords
+                                                                          rowIds:rowIds
+                                                           shardStartingHashKeys:task.result
+                                                                       byteLimit:AWSKinesisAggregatedRecordByteLimit];
+        return [self putAggregatedRecords:aggregatedRecords
+                                forStream:streamName
+                                putRowIds:putRowIds
+                              retryRowIds:retryRowIds
+                                     stop:stop];
+    }];
+}
+
+// Returns the starting hash keys of the stream's open shards, listing them at most once per `AWSKinesisRecorderShardMapRefreshInterval`.
+// The task's result is nil when the shards cannot be listed, e.g. because the credentials don't allow `kinesis:ListShards`.
+- (AWSTask<NSArray<NSString *> *> *)shardStartingHashKeysForStream:(NSString *)streamName {
+    @synchronized(self.shardMaps) {
+        AWSKinesisRecorderShardMap *shardMap = self.shardMaps[streamName];
+        if (shardMap && -[shardMap.listDate timeIntervalSinceNow] < AWSKinesisRecorderShardMapRefreshInterval) {
+            return [AWSTask taskWithResult:shardMap.startingHashKeys];
+        }
+    }
+
+    return [[self listShardsForStream:streamName
+                            nextToken:nil
+                     startingHashKeys:[NSMutableArray new]] continueWithBlock:^id(AWSTask *task) {
+        if (task.error) {
+            AWSDDLogWarn(@"Failed to list the shards of %@. Aggregated records carry an explicit hash key for every user record instead. [%@]", streamName, task.error);
+            // A connection failure is not remembered, so the shards are listed again with the next batch.
+            if ([task.error.domain isEqualToString:NSURLErrorDomain]) {
+                return nil;
+            }
+        }
+
+        AWSKinesisRecorderShardMap *shardMap = [AWSKinesisRecorderShardMap new];
+        shardMap.listDate = [NSDate date];
+        shardMap.startingHashKeys = task.result;
+        @synchronized(self.shardMaps) {
+            self.shardMaps[streamName] = shardMap;
+        }
+        return shardMap.startingHashKeys;
+    }];
+}
+
+- (AWSTask<NSArray<NSString *> *> *)listShardsForStream:(NSString *)streamName
+                                              nextToken:(NSString *)nextToken
+                                       startingHashKeys:(NSMutableArray<NSString *> *)startingHashKeys {
+    AWSKinesisListShardsInput *listShardsInput = [AWSKinesisListShardsInput new];
+    // `StreamName` must not be set together with `NextToken`.
+    if (nextToken) {
+        listShardsInput.nextToken = nextToken;
+    } else {
+        listShardsInput.streamName = streamName;
+    }
+
+    return [[self.kinesis listShards:listShardsInput] continueWithSuccessBlock:^id(AWSTask<AWSKinesisListShardsOutput *> *task) {
+        for (AWSKinesisShard *shard in task.result.shards) {
+            // Closed shards no longer accept records.
+            if (!shard.sequenceNumberRange.endingSequenceNumber && shard.hashKeyRange.startingHashKey) {
+                [startingHashKeys addObject:shard.hashKeyRange.startingHashKey];
+            }
+        }
+        if (task.result.nextToken) {
+            return [self listShardsForStream:streamName
+                                   nextToken:task.result.nextToken
+                            startingHashKeys:startingHashKeys];
+        }
+        return [AWSTask taskWithResult:startingHashKeys];
+    }];
+}
+
+- (AWSTask *)putAggregatedRecords:(NSArray<AWSKinesisAggregatedRecord *> *)aggregatedRecords
+                        forStream:(NSString *)streamName
+                        putRowIds:(NSMutableArray *)putRowIds
+                      retryRowIds:(NSMutableArray *)retryRowIds
+                             stop:(BOOL *)stop {
+    // Splits the aggregated records into as few PutRecords requests as the service limits allow.
+    NSMutableArray *requestRecords = [NSMutableArray new];
+    NSMutableArray *currentRecords = [NSMutableArray new];
+    NSUInteger currentByteCount = 0;
+    for (AWSKinesisAggregatedRecord *aggregatedRecord in aggregatedRecords) {
+        NSUInteger byteCount = [aggregatedRecord.data length] + [aggregatedRecord.partitionKey lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+        if ([currentRecords count] == AWSKinesisRecorderPutRecordsRecordLimit
+            || ([currentRecords count] > 0 && currentByteCount + byteCount > AWSKinesisRecorderPutRecordsByteLimit)) {
+            [requestRecords addObject:currentRecords];
+            currentRecords = [NSMutableArray new];
+            currentByteCount = 0;
+        }
+        [currentRecords addObject:aggregatedRecord];
+        currentByteCount += byteCount;
+    }
+    if ([currentRecords count] > 0) {
+        [requestRecords addObject:currentRecords];
+    }
+
+    NSMutableArray *tasks = [NSMutableArray new];
+    for (NSArray *records in requestRecords) {
+        NSMutableArray *requestEntries = [NSMutableArray new];
+        for (AWSKinesisAggregatedRecord *aggregatedRecord in records) {
+            AWSKinesisPutRecordsRequestEntry *requestEntry = [AWSKinesisPutRecordsRequestEntry new];
+            requestEntry.partitionKey = aggregatedRecord.partitionKey;
+            requestEntry.data = aggregatedRecord.data;
+            [requestEntries addObject:requestEntry];
+        }
+
+        AWSKinesisPutRecordsInput *putRecordsInput = [AWSKinesisPutRecordsInput new];
+        putRecordsInput.streamName = streamName;
+        putRecordsInput.records = requestEntries;
+        AWSDDLogVerbose(@"putRecordsInput: [%@]", putRecordsInput);
+        [tasks addObject:[self.kinesis putRecords:putRecordsInput]];
+    }
+
+    return [[AWSTask taskForCompletionOfAllTasks:tasks] continueWithBlock:^id(AWSTask *task) {
+        NSError *error = nil;
+        for (NSUInteger i = 0; i < [tasks count]; i++) {
+            AWSTask *putRecordsTask = tasks[i];
+            if (putRecordsTask.error) {
+                AWSDDLogError(@"Error: [%@]", putRecordsTask.error);
+                if ([putRecordsTask.error.domain isEqualToString:NSURLErrorDomain]) {
+                    *stop = YES;
+                }
+                error = putRecordsTask.error;
+                continue;
+            }
+
+            AWSKinesisPutRecordsOutput *putRecordsOutput = putRecordsTask.result;
+            NSArray *records = requestRecords[i];
+            for (NSUInteger j = 0; j < [putRecordsOutput.records count] && j < [records count]; j++) {
+                AWSKinesisPutRecordsResultEntry *resultEntry = putRecordsOutput.records[j];
+                AWSKinesisAggregatedRecord *aggregatedRecord = records[j];
+                if (resultEntry.errorCode) {
+                    AWSDDLogInfo(@"Error Code: [%@] Error Message: [%@]", resultEntry.errorCode, resultEntry.errorMessage);
+                }
+                // All user records in an aggregated record share its result.
+                if (![resultEntry.errorCode isEqualToString:@"ProvisionedThroughputExceededException"]
+                    && ![resultEntry.errorCode isEqualToString:@"InternalFailure"]) {
+                    [putRowIds addObjectsFromArray:aggregatedRecord.rowIds];
+                } else {
+                    [retryRowIds addObjectsFromArray:aggregatedRecord.rowIds];
+                }
+            }
+        }
+
+        if (error) {
+            return [AWSTask taskWithError:error];
+        }
+        return nil;
+    }];
+}
+
 - (NSError *)dataTooLargeError {
     return [NSError errorWithDomain:AWSKinesisRecorderErrorDomain
                                code:AWSKinesisRecorderErrorDataTooLarge
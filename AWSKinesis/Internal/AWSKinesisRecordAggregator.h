@@ -0,0 +1,71 @@
+//
+// Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The magic number prefixed to every aggregated record by the Kinesis Producer Library.
+ */
+FOUNDATION_EXPORT const uint8_t AWSKinesisAggregatedRecordMagic[4];
+
+/**
+ The maximum size of a Kinesis record's data and partition key combined.
+ */
+FOUNDATION_EXPORT NSUInteger const AWSKinesisAggregatedRecordByteLimit;
+
+/**
+ A Kinesis record that carries one or more user records, and the database rows they were read from. `explicitHashKey` is the hash key of `partitionKey`, which decides the shard the record is written to.
+ */
+@interface AWSKinesisAggregatedRecord : NSObject
+
+@property (nonatomic, strong, readonly) NSData *data;
+@property (nonatomic, strong, readonly) NSString *partitionKey;
+@property (nonatomic, strong, readonly) NSString *explicitHashKey;
+@property (nonatomic, strong, readonly) NSArray *rowIds;
+
+@end
+
+/**
+ Packs user records into Kinesis records using the Kinesis Producer Library aggregated record format: the magic number, an `AggregatedRecord` protobuf message and the MD5 digest of that message. Consumers using the KCL or the Kinesis de-aggregation libraries see the individual user records.
+ */
+@interface AWSKinesisRecordAggregator : NSObject
+
+/**
+ Aggregates the records, keeping their order within each shard. A Kinesis record is started whenever the next user record would make the current one larger than `byteLimit`. A Kinesis record with a single user record is sent as is, without the aggregation envelope.
+
+ When the starting hash keys of the stream's open shards are known, user records are only aggregated with records whose partition keys map to the same shard, so every user record is read from the shard its own partition key selects. Otherwise, user records with any partition key are aggregated together and each one carries the explicit hash key of the Kinesis record, so that de-aggregating consumers attribute it to the shard it was actually written to.
+
+ @param records               Dictionaries with `data` and `partition_key` entries, as read by `AWSAbstractKinesisRecorder`.
+ @param rowIds                The database row of each record.
+ @param shardStartingHashKeys The starting hash keys of the stream's open shards in decimal notation, or nil if they are not known.
+ @param byteLimit             The maximum size of each Kinesis record's data and partition key.
+
+ @return An array of `AWSKinesisAggregatedRecord`.
+ */
++ (NSArray<AWSKinesisAggregatedRecord *> *)aggregateRecords:(NSArray<NSDictionary *> *)records
+                                                     rowIds:(NSArray *)rowIds
+                                      shardStartingHashKeys:(nullable NSArray<NSString *> *)shardStartingHashKeys
+                                                  byteLimit:(NSUInteger)byteLimit;
+
+/**
+ Returns the explicit hash key Kinesis derives from a partition key: the MD5 digest of the key as a 128-bit unsigned decimal integer.
+ */
++ (NSString *)explicitHashKeyForPartitionKey:(NSString *)partitionKey;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,326 @@
+//
+// Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import "AWSKinesisRecordAggregator.h"
+#import <CommonCrypto/CommonDigest.h>
+
+const uint8_t AWSKinesisAggregatedRecordMagic[4] = {0xF3, 0x89, 0x9A, 0xC2};
+NSUInteger const AWSKinesisAggregatedRecordByteLimit = 1024 * 1024;
+
+// Field numbers of the KPL protobuf messages.
+//
+// message AggregatedRecord {
+//     repeated string partition_key_table = 1;
+//     repeated string explicit_hash_key_table = 2;
+//     repeated Record records = 3;
+// }
+//
+// message Record {
+//     required uint64 partition_key_index = 1;
+//     optional uint64 explicit_hash_key_index = 2;
+//     required bytes data = 3;
+// }
+static const uint8_t AWSKinesisAggregatedRecordPartitionKeyTableTag = (1 << 3) | 2;
+static const uint8_t AWSKinesisAggregatedRecordExplicitHashKeyTableTag = (2 << 3) | 2;
+static const uint8_t AWSKinesisAggregatedRecordRecordsTag = (3 << 3) | 2;
+static const uint8_t AWSKinesisRecordPartitionKeyIndexTag = (1 << 3) | 0;
+static const uint8_t AWSKinesisRecordExplicitHashKeyIndexTag = (2 << 3) | 0;
+static const uint8_t AWSKinesisRecordDataTag = (3 << 3) | 2;
+
+// Parses a hash key in the decimal notation Kinesis uses into a 128-bit big-endian integer.
+static BOOL AWSKinesisHashKeyFromDecimal(NSString *decimal, uint8_t hashKey[CC_MD5_DIGEST_LENGTH]) {
+    memset(hashKey, 0, CC_MD5_DIGEST_LENGTH);
+    const char *characters = [decimal UTF8String];
+    if (!characters || characters[0] == '\0') {
+        return NO;
+    }
+    for (const char *character = characters; *character != '\0'; character++) {
+        if (*character < '0' || *character > '9') {
+            return NO;
+        }
+        unsigned int carry = (unsigned int)(*character - '0');
+        for (NSInteger i = CC_MD5_DIGEST_LENGTH - 1; i >= 0; i--) {
+            unsigned int value = hashKey[i] * 10 + carry;
+            hashKey[i] = (uint8_t)value;
+            carry = value >> 8;
+        }
+        if (carry != 0) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+static NSUInteger AWSKinesisVarintLength(uint64_t value) {
+    NSUInteger length = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        length++;
+    }
+    return length;
+}
+
+static void AWSKinesisAppendVarint(NSMutableData *data, uint64_t value) {
+    uint8_t buffer[10];
+    NSUInteger length = 0;
+    while (value >= 0x80) {
+        buffer[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    buffer[length++] = (uint8_t)value;
+    [data appendBytes:buffer length:length];
+}
+
+static void AWSKinesisAppendLengthDelimited(NSMutableData *data, uint8_t tag, const void *bytes, NSUInteger length) {
+    [data appendBytes:&tag length:1];
+    AWSKinesisAppendVarint(data, length);
+    [data appendBytes:bytes length:length];
+}
+
+@interface AWSKinesisAggregatedRecord()
+
+@property (nonatomic, strong) NSData *data;
+@property (nonatomic, strong) NSString *partitionKey;
+@property (nonatomic, strong) NSString *explicitHashKey;
+@property (nonatomic, strong) NSArray *rowIds;
+
+@end
+
+@implementation AWSKinesisAggregatedRecord
+
+@end
+
+// Accumulates the user records of one aggregated record.
+@interface AWSKinesisRecordAggregatorBuffer : NSObject
+
+@property (nonatomic, strong) NSMutableArray<NSString *> *partitionKeys;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *partitionKeyIndexes;
+@property (nonatomic, strong) NSMutableArray<NSDictionary *> *records;
+@property (nonatomic, strong) NSMutableArray *rowIds;
+@property (nonatomic, assign) NSUInteger messageLength;
+@property (nonatomic, assign) BOOL writesExplicitHashKeys;
+
+@end
+
+@implementation AWSKinesisRecordAggregatorBuffer
+
+- (instancetype)initWithExplicitHashKeys:(BOOL)writesExplicitHashKeys {
+    if (self = [super init]) {
+        _writesExplicitHashKeys = writesExplicitHashKeys;
+        _partitionKeys = [NSMutableArray new];
+        _partitionKeyIndexes = [NSMutableDictionary new];
+        _records = [NSMutableArray new];
+        _rowIds = [NSMutableArray new];
+    }
+    return self;
+}
+
+// The number of bytes the protobuf message grows by when the record is added.
+- (NSUInteger)messageLengthForData:(NSData *)data partitionKey:(NSString *)partitionKey {
+    NSUInteger length = 0;
+    NSNumber *partitionKeyIndex = self.partitionKeyIndexes[partitionKey];
+    if (!partitionKeyIndex) {
+        NSUInteger partitionKeyLength = [partitionKey lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+        length += 1 + AWSKinesisVarintLength(partitionKeyLength) + partitionKeyLength;
+    }
+
+    NSUInteger recordLength = 1 + AWSKinesisVarintLength(partitionKeyIndex ? [partitionKeyIndex unsignedLongLongValue] : [self.partitionKeys count])
+    + 1 + AWSKinesisVarintLength([data length]) + [data length];
+    if (self.writesExplicitHashKeys) {
+        // Every record points at the single entry of the explicit hash key table, which the first record adds.
+        recordLength += 2;
+        if ([self.records count] == 0) {
+            NSUInteger explicitHashKeyLength = [[AWSKinesisRecordAggregator explicitHashKeyForPartitionKey:partitionKey] length];
+            length += 1 + AWSKinesisVarintLength(explicitHashKeyLength) + explicitHashKeyLength;
+        }
+    }
+    length += 1 + AWSKinesisVarintLength(recordLength) + recordLength;
+
+    return length;
+}
+
+- (void)addData:(NSData *)data partitionKey:(NSString *)partitionKey rowId:(id)rowId {
+    self.messageLength += [self messageLengthForData:data partitionKey:partitionKey];
+    if (!self.partitionKeyIndexes[partitionKey]) {
+        self.partitionKeyIndexes[partitionKey] = @([self.partitionKeys count]);
+        [self.partitionKeys addObject:partitionKey];
+    }
+    [self.records addObject:@{@"data" : data, @"partition_key" : partitionKey}];
+    [self.rowIds addObject:rowId];
+}
+
+- (AWSKinesisAggregatedRecord *)aggregatedRecord {
+    AWSKinesisAggregatedRecord *aggregatedRecord = [AWSKinesisAggregatedRecord new];
+    aggregatedRecord.partitionKey = self.records[0][@"partition_key"];
+    aggregatedRecord.explicitHashKey = [AWSKinesisRecordAggregator explicitHashKeyForPartitionKey:aggregatedRecord.partitionKey];
+    aggregatedRecord.rowIds = [self.rowIds copy];
+
+    if ([self.records count] == 1) {
+        aggregatedRecord.data = self.records[0][@"data"];
+        return aggregatedRecord;
+    }
+
+    NSMutableData *data = [NSMutableData dataWithCapacity:sizeof(AWSKinesisAggregatedRecordMagic) + self.messageLength + CC_MD5_DIGEST_LENGTH];
+    [data appendBytes:AWSKinesisAggregatedRecordMagic length:sizeof(AWSKinesisAggregatedRecordMagic)];
+
+    for (NSString *partitionKey in self.partitionKeys) {
+        NSData *partitionKeyData = [partitionKey dataUsingEncoding:NSUTF8StringEncoding];
+        AWSKinesisAppendLengthDelimited(data, AWSKinesisAggregatedRecordPartitionKeyTableTag, [partitionKeyData bytes], [partitionKeyData length]);
+    }
+
+    if (self.writesExplicitHashKeys) {
+        NSData *explicitHashKeyData = [aggregatedRecord.explicitHashKey dataUsingEncoding:NSUTF8StringEncoding];
+        AWSKinesisAppendLengthDelimited(data, AWSKinesisAggregatedRecordExplicitHashKeyTableTag, [explicitHashKeyData bytes], [explicitHashKeyData length]);
+    }
+
+    NSMutableData *recordMessage = [NSMutableData new];
+    for (NSDictionary *record in self.records) {
+        NSData *recordData = record[@"data"];
+        [recordMessage setLength:0];
+        [recordMessage appendBytes:&AWSKinesisRecordPartitionKeyIndexTag length:1];
+        AWSKinesisAppendVarint(recordMessage, [self.partitionKeyIndexes[record[@"partition_key"]] unsignedLongLongValue]);
+        if (self.writesExplicitHashKeys) {
+            [recordMessage appendBytes:&AWSKinesisRecordExplicitHashKeyIndexTag length:1];
+            AWSKinesisAppendVarint(recordMessage, 0);
+        }
+        AWSKinesisAppendLengthDelimited(recordMessage, AWSKinesisRecordDataTag, [recordData bytes], [recordData length]);
+        AWSKinesisAppendLengthDelimited(data, AWSKinesisAggregatedRecordRecordsTag, [recordMessage bytes], [recordMessage length]);
+    }
+
+    unsigned char digest[CC_MD5_DIGEST_LENGTH];
+    CC_MD5((const uint8_t *)[data bytes] + sizeof(AWSKinesisAggregatedRecordMagic),
+           (CC_LONG)([data length] - sizeof(AWSKinesisAggregatedRecordMagic)),
+           digest);
+    [data appendBytes:digest length:CC_MD5_DIGEST_LENGTH];
+
+    aggregatedRecord.data = data;
+    return aggregatedRecord;
+}
+
+@end
+
+@implementation AWSKinesisRecordAggregator
+
++ (NSArray<AWSKinesisAggregatedRecord *> *)aggregateRecords:(NSArray<NSDictionary *> *)records
+                                                     rowIds:(NSArray *)rowIds
+                                      shardStartingHashKeys:(NSArray<NSString *> *)shardStartingHashKeys
+                                                  byteLimit:(NSUInteger)byteLimit {
+    // Sorts the starting hash keys of the shards so that the shard of a hash key is the last one starting at or before it.
+    NSMutableArray<NSData *> *shardHashKeys = [NSMutableArray new];
+    for (NSString *startingHashKey in shardStartingHashKeys) {
+        uint8_t hashKey[CC_MD5_DIGEST_LENGTH];
+        if (AWSKinesisHashKeyFromDecimal(startingHashKey, hashKey)) {
+            [shardHashKeys addObject:[NSData dataWithBytes:hashKey length:CC_MD5_DIGEST_LENGTH]];
+        }
+    }
+    [shardHashKeys sortUsingComparator:^NSComparisonResult(NSData *hashKey1, NSData *hashKey2) {
+        int result = memcmp([hashKey1 bytes], [hashKey2 bytes], CC_MD5_DIGEST_LENGTH);
+        return result < 0 ? NSOrderedAscending : (result > 0 ? NSOrderedDescending : NSOrderedSame);
+    }];
+    BOOL groupsByShard = [shardHashKeys count] > 0;
+
+    NSMutableArray *aggregatedRecords = [NSMutableArray new];
+    NSMutableDictionary<NSNumber *, AWSKinesisRecordAggregatorBuffer *> *buffers = [NSMutableDictionary new];
+    NSMutableArray<NSNumber *> *shardIndexes = [NSMutableArray new];
+    NSMutableDictionary<NSString *, NSNumber *> *shardIndexesForPartitionKeys = [NSMutableDictionary new];
+
+    for (NSUInteger i = 0; i < [records count]; i++) {
+        NSData *data = records[i][@"data"];
+        NSString *partitionKey = records[i][@"partition_key"];
+
+        NSNumber *shardIndex = @0;
+        if (groupsByShard) {
+            shardIndex = shardIndexesForPartitionKeys[partitionKey];
+            if (!shardIndex) {
+                shardIndex = @([self shardIndexForPartitionKey:partitionKey shardHashKeys:shardHashKeys]);
+                shardIndexesForPartitionKeys[partitionKey] = shardIndex;
+            }
+        }
+
+        AWSKinesisRecordAggregatorBuffer *buffer = buffers[shardIndex];
+        if (!buffer) {
+            buffer = [[AWSKinesisRecordAggregatorBuffer alloc] initWithExplicitHashKeys:!groupsByShard];
+            buffers[shardIndex] = buffer;
+            [shardIndexes addObject:shardIndex];
+        } else {
+            // The partition key of the first user record becomes the partition key of the Kinesis record.
+            NSUInteger length = sizeof(AWSKinesisAggregatedRecordMagic)
+            + buffer.messageLength
+            + [buffer messageLengthForData:data partitionKey:partitionKey]
+            + CC_MD5_DIGEST_LENGTH
+            + [buffer.records[0][@"partition_key"] lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+            if (length > byteLimit) {
+                [aggregatedRecords addObject:[buffer aggregatedRecord]];
+                buffer = [[AWSKinesisRecordAggregatorBuffer alloc] initWithExplicitHashKeys:!groupsByShard];
+                buffers[shardIndex] = buffer;
+            }
+        }
+
+        [buffer addData:data partitionKey:partitionKey rowId:rowIds[i]];
+    }
+
+    for (NSNumber *shardIndex in shardIndexes) {
+        [aggregatedRecords addObject:[buffers[shardIndex] aggregatedRecord]];
+    }
+
+    return aggregatedRecords;
+}
+
++ (NSUInteger)shardIndexForPartitionKey:(NSString *)partitionKey shardHashKeys:(NSArray<NSData *> *)shardHashKeys {
+    NSData *partitionKeyData = [partitionKey dataUsingEncoding:NSUTF8StringEncoding];
+    unsigned char digest[CC_MD5_DIGEST_LENGTH];
+    CC_MD5([partitionKeyData bytes], (CC_LONG)[partitionKeyData length], digest);
+
+    NSUInteger low = 0;
+    NSUInteger high = [shardHashKeys count];
+    while (high - low > 1) {
+        NSUInteger middle = low + (high - low) / 2;
+        if (memcmp([shardHashKeys[middle] bytes], digest, CC_MD5_DIGEST_LENGTH) <= 0) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
++ (NSString *)explicitHashKeyForPartitionKey:(NSString *)partitionKey {
+    NSData *partitionKeyData = [partitionKey dataUsingEncoding:NSUTF8StringEncoding];
+    unsigned char digest[CC_MD5_DIGEST_LENGTH];
+    CC_MD5([partitionKeyData bytes], (CC_LONG)[partitionKeyData length], digest);
+
+    // Converts the big-endian 128-bit digest to decimal by repeated division by 10.
+    char decimal[40];
+    NSUInteger position = sizeof(decimal);
+    decimal[--position] = '\0';
+    BOOL isZero = NO;
+    while (!isZero) {
+        unsigned int remainder = 0;
+        isZero = YES;
+        for (NSUInteger i = 0; i < CC_MD5_DIGEST_LENGTH; i++) {
+            unsigned int value = (remainder << 8) | digest[i];
+            digest[i] = (unsigned char)(value / 10);
+            remainder = value % 10;
+            if (digest[i] != 0) {
+                isZero = NO;
+            }
+        }
+        decimal[--position] = (char)('0' + remainder);
+    }
+
+    return [NSString stringWithUTF8String:decimal + position];
+}
+
+@end
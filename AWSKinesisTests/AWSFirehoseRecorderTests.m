@@ -22,6 +22,42 @@
 
 NSString *const AWSFirehoseRecorderTestStream = @"test-permanent-firehose";
 
+@interface AWSFirehose()
+
+- (instancetype)initWithConfiguration:(AWSServiceConfiguration *)configuration;
+
+@end
+
+// Acknowledges every PutRecordBatch request without going to the network.
+@interface AWSFirehoseRecorderTestsStubFirehose : AWSFirehose
+
+@property (nonatomic, assign) NSUInteger requestCount;
+@property (nonatomic, strong) NSMutableArray<NSData *> *records;
+
+@end
+
+@implementation AWSFirehoseRecorderTestsStubFirehose
+
+- (AWSTask<AWSFirehosePutRecordBatchOutput *> *)putRecordBatch:(AWSFirehosePutRecordBatchInput *)request {
+    NSMutableArray *requestResponses = [NSMutableArray new];
+    @synchronized(self) {
+        self.requestCount += 1;
+        if (!self.records) {
+            self.records = [NSMutableArray new];
+        }
+        for (AWSFirehoseRecord *record in request.records) {
+            [self.records addObject:record.data];
+            [requestResponses addObject:[AWSFirehosePutRecordBatchResponseEntry new]];
+        }
+    }
+
+    AWSFirehosePutRecordBatchOutput *putRecordBatchOutput = [AWSFirehosePutRecordBatchOutput new];
+    putRecordBatchOutput.requestResponses = requestResponses;
+    return [AWSTask taskWithResult:putRecordBatchOutput];
+}
+
+@end
+
 @interface AWSFirehoseRecorderTests : XCTestCase
 
 @end
@@ -222,6 +258,56 @@ NSString *const AWSFirehoseRecorderTestStream = @"test-permanent-firehose";
     }];
 }
 
+- (void)testRecordCoalescing {
+    AWSServiceConfiguration *configuration = [[AWSServiceConfiguration alloc] initWithRegion:AWSRegionUSWest2
+                                                                         credentialsProvider:nil];
+    [AWSFirehoseRecorder registerFirehoseRecorderWithConfiguration:configuration
+                                                            forKey:@"AWSFirehoseRecorderTests.testRecordCoalescing"];
+    AWSFirehoseRecorder *firehoseRecorder = [AWSFirehoseRecorder FirehoseRecorderForKey:@"AWSFirehoseRecorderTests.testRecordCoalescing"];
+    firehoseRecorder.writeBehindRecordCount = 500;
+
+    for (NSNumber *recordCoalescingByteLimit in @[@0, @(5 * 1024), @(100 * 1024), @(1000 * 1024)]) {
+        AWSFirehoseRecorderTestsStubFirehose *stubFirehose = [[AWSFirehoseRecorderTestsStubFirehose alloc] initWithConfiguration:configuration];
+        [[firehoseRecorder valueForKey:@"recorderHelper"] setValue:stubFirehose forKey:@"firehose"];
+        firehoseRecorder.recordCoalescingByteLimit = [recordCoalescingByteLimit unsignedIntegerValue];
+
+        [[firehoseRecorder removeAllRecords] waitUntilFinished];
+        NSMutableString *expectedString = [NSMutableString new];
+        for (int32_t i = 0; i < 2000; i++) {
+            NSString *string = [NSString stringWithFormat:@"{\"event\":\"TestString-%04d\",\"padding\":\"0123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890123456789\"}", i];
+            [expectedString appendFormat:@"%@\n", string];
+            [firehoseRecorder saveRecord:[string dataUsingEncoding:NSUTF8StringEncoding]
+                              streamName:@"testRecordCoalescing"];
+        }
+
+        AWSTask *task = [firehoseRecorder submitAllRecords];
+        [task waitUntilFinished];
+        XCTAssertNil(task.error);
+
+        NSUInteger byteCount = 0;
+        for (NSData *data in stubFirehose.records) {
+            XCTAssertLessThanOrEqual([data length], MAX([recordCoalescingByteLimit unsignedIntegerValue], 200));
+            byteCount += [data length];
+        }
+        NSLog(@"recordCoalescingByteLimit: %@, Firehose records: %lu, requests: %lu, bytes: %lu",
+              recordCoalescingByteLimit, (unsigned long)[stubFirehose.records count], (unsigned long)stubFirehose.requestCount, (unsigned long)byteCount);
+
+        if ([recordCoalescingByteLimit unsignedIntegerValue] == 0) {
+            XCTAssertEqual([stubFirehose.records count], 2000);
+        } else {
+            // The coalesced records contain every saved record in order, each followed by the separator.
+            NSMutableData *data = [NSMutableData new];
+            for (NSData *record in stubFirehose.records) {
+                [data appendData:record];
+            }
+            XCTAssertEqualObjects([[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding], expectedString);
+            XCTAssertLessThan([stubFirehose.records count], 2000 / 20);
+        }
+    }
+
+    [AWSFirehoseRecorder removeFirehoseRecorderForKey:@"AWSFirehoseRecorderTests.testRecordCoalescing"];
+}
+
 - (void)testAll {
     AWSFirehoseRecorder *firehoseRecorder = [AWSFirehoseRecorder defaultFirehoseRecorder];
     
@@ -22,6 +22,90 @@
 
 NSString *const AWSKinesisRecorderTestStream = @"AWSSDKForiOSv2Test";
 
+@interface AWSAbstractKinesisRecorder()
+
+@property (nonatomic, assign) NSUInteger writeTransactionCount;
+@property (nonatomic, assign) NSUInteger batchRecordCountLimit;
+
+@end
+
+@interface AWSKinesis()
+
+- (instancetype)initWithConfiguration:(AWSServiceConfiguration *)configuration;
+
+@end
+
+// Acknowledges every PutRecords request after a fixed latency without going to the network.
+@interface AWSKinesisRecorderTestsStubKinesis : AWSKinesis
+
+@property (nonatomic, assign) int latencyInMilliseconds;
+@property (nonatomic, assign) NSUInteger throttledRecordCount;
+@property (nonatomic, strong) NSMutableArray *sentData;
+@property (nonatomic, assign) NSUInteger requestCount;
+@property (nonatomic, assign) NSUInteger recordCount;
+@property (nonatomic, assign) NSUInteger inFlightCount;
+@property (nonatomic, assign) NSUInteger maxInFlightCount;
+
+@end
+
+@implementation AWSKinesisRecorderTestsStubKinesis
+
+- (instancetype)initWithConfiguration:(AWSServiceConfiguration *)configuration {
+    if (self = [super initWithConfiguration:configuration]) {
+        _sentData = [NSMutableArray new];
+    }
+    return self;
+}
+
+- (AWSTask<AWSKinesisPutRecordsOutput *> *)putRecords:(AWSKinesisPutRecordsInput *)request {
+    @synchronized(self) {
+        self.requestCount += 1;
+        self.recordCount += [request.records count];
+        self.inFlightCount += 1;
+        self.maxInFlightCount = MAX(self.maxInFlightCount, self.inFlightCount);
+    }
+
+    return [[AWSTask taskWithDelay:self.latencyInMilliseconds] continueWithBlock:^id _Nullable(AWSTask * _Nonnull task) {
+        @synchronized(self) {
+            self.inFlightCount -= 1;
+        }
+
+        NSMutableArray *records = [NSMutableArray new];
+        for (AWSKinesisPutRecordsRequestEntry *requestEntry in request.records) {
+            AWSKinesisPutRecordsResultEntry *resultEntry = [AWSKinesisPutRecordsResultEntry new];
+            @synchronized(self) {
+                [self.sentData addObject:requestEntry.data];
+                // Throttles the first `throttledRecordCount` records so that the recorder retries them.
+                if (self.throttledRecordCount > 0) {
+                    self.throttledRecordCount -= 1;
+                    resultEntry.errorCode = @"ProvisionedThroughputExceededException";
+                }
+            }
+            [records addObject:resultEntry];
+        }
+        AWSKinesisPutRecordsOutput *putRecordsOutput = [AWSKinesisPutRecordsOutput new];
+        putRecordsOutput.records = records;
+        return putRecordsOutput;
+    }];
+}
+
+// Lists a single shard covering the whole hash key range.
+- (AWSTask<AWSKinesisListShardsOutput *> *)listShards:(AWSKinesisListShardsInput *)request {
+    AWSKinesisShard *shard = [AWSKinesisShard new];
+    shard.shardId = @"shardId-000000000000";
+    shard.hashKeyRange = [AWSKinesisHashKeyRange new];
+    shard.hashKeyRange.startingHashKey = @"0";
+    shard.hashKeyRange.endingHashKey = @"340282366920938463463374607431768211455";
+    shard.sequenceNumberRange = [AWSKinesisSequenceNumberRange new];
+    shard.sequenceNumberRange.startingSequenceNumber = @"0";
+
+    AWSKinesisListShardsOutput *listShardsOutput = [AWSKinesisListShardsOutput new];
+    listShardsOutput.shards = @[shard];
+    return [AWSTask taskWithResult:listShardsOutput];
+}
+
+@end
+
 @interface AWSKinesisRecorderTests : XCTestCase
 
 @end
@@ -273,6 +357,298 @@ static NSString *testStreamName = nil;
     kinesisRecorder.diskAgeLimit = 0.0;
 }
 
+- (void)testFailedAgeLimitDeleteRollsBackWrite {
+    AWSKinesisRecorder *kinesisRecorder = [AWSKinesisRecorder defaultKinesisRecorder];
+    [[kinesisRecorder removeAllRecords] waitUntilFinished];
+    AWSTask *task = [kinesisRecorder saveRecord:[NSMutableData dataWithLength:100]
+                                     streamName:@"testFailedAgeLimitDeleteRollsBackWrite"];
+    [task waitUntilFinished];
+    XCTAssertNil(task.error);
+    NSUInteger diskBytesUsed = kinesisRecorder.diskBytesUsed;
+
+    // Makes deleting the expired record fail.
+    AWSFMDatabaseQueue *databaseQueue = [kinesisRecorder valueForKey:@"databaseQueue"];
+    [databaseQueue inDatabase:^(AWSFMDatabase *db) {
+        XCTAssertTrue([db executeUpdate:@"CREATE TEMP TRIGGER fail_delete BEFORE DELETE ON record BEGIN SELECT RAISE(ABORT, 'delete failed'); END"]);
+    }];
+    kinesisRecorder.diskAgeLimit = 1;
+    sleep(2);
+
+    task = [kinesisRecorder saveRecord:[NSMutableData dataWithLength:100]
+                            streamName:@"testFailedAgeLimitDeleteRollsBackWrite"];
+    [task waitUntilFinished];
+    XCTAssertNotNil(task.error);
+    XCTAssertEqual(kinesisRecorder.diskBytesUsed, diskBytesUsed);
+    [databaseQueue inDatabase:^(AWSFMDatabase *db) {
+        XCTAssertEqual([db intForQuery:@"SELECT COUNT(*) FROM record"], 1);
+        XCTAssertTrue([db executeUpdate:@"DROP TRIGGER fail_delete"]);
+    }];
+
+    kinesisRecorder.diskAgeLimit = 0.0;
+    [[kinesisRecorder removeAllRecords] waitUntilFinished];
+}
+
+- (void)testDiskByteLimitSteadyState {
+    AWSServiceConfiguration *configuration = [[AWSServiceConfiguration alloc] initWithRegion:AWSRegionUSWest2
+                                                                         credentialsProvider:nil];
+    [AWSKinesisRecorder registerKinesisRecorderWithConfiguration:configuration
+                                                          forKey:@"AWSKinesisRecorderTests.testDiskByteLimitSteadyState"];
+    AWSKinesisRecorder *kinesisRecorder = [AWSKinesisRecorder KinesisRecorderForKey:@"AWSKinesisRecorderTests.testDiskByteLimitSteadyState"];
+    [[kinesisRecorder removeAllRecords] waitUntilFinished];
+    kinesisRecorder.diskByteLimit = 256 * 1024; // 256KB
+
+    NSMutableString *mutableString = [NSMutableString new];
+    for (int i = 0; i < 100; i++) {
+        [mutableString appendString:@"0123456789"];
+    }
+    NSData *data = [mutableString dataUsingEncoding:NSUTF8StringEncoding];
+
+    // Fills the store past the limit so that every following save runs against a full store.
+    AWSTask *task = [AWSTask taskWithResult:nil];
+    for (int i = 0; i < 500; i++) {
+        task = [task continueWithBlock:^id(AWSTask *task) {
+            return [kinesisRecorder saveRecord:data
+                                    streamName:@"testDiskByteLimitSteadyState"];
+        }];
+    }
+    [task waitUntilFinished];
+    XCTAssertNil(task.error);
+    XCTAssertLessThanOrEqual(kinesisRecorder.diskBytesUsed, kinesisRecorder.diskByteLimit);
+
+    NSUInteger steadyStateCount = 2000;
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    task = [AWSTask taskWithResult:nil];
+    for (int i = 0; i < steadyStateCount; i++) {
+        task = [task continueWithBlock:^id(AWSTask *task) {
+            return [kinesisRecorder saveRecord:data
+                                    streamName:@"testDiskByteLimitSteadyState"];
+        }];
+    }
+    [task waitUntilFinished];
+    CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+    NSLog(@"Saved %lu records into a full store in %.3f seconds (%.3f ms per record).",
+          (unsigned long)steadyStateCount, elapsed, elapsed * 1000 / steadyStateCount);
+
+    XCTAssertNil(task.error);
+    XCTAssertGreaterThan(kinesisRecorder.diskBytesUsed, 0.8 * kinesisRecorder.diskByteLimit);
+    XCTAssertLessThanOrEqual(kinesisRecorder.diskBytesUsed, kinesisRecorder.diskByteLimit);
+
+    [[kinesisRecorder removeAllRecords] waitUntilFinished];
+    XCTAssertEqual(kinesisRecorder.diskBytesUsed, 0);
+}
+
+- (void)testWriteBehind {
+    AWSServiceConfiguration *configuration = [[AWSServiceConfiguration alloc] initWithRegion:AWSRegionUSWest2
+                                                                         credentialsProvider:nil];
+    [AWSKinesisRecorder registerKinesisRecorderWithConfiguration:configuration
+                                                          forKey:@"AWSKinesisRecorderTests.testWriteBehind"];
+    AWSKinesisRecorder *kinesisRecorder = [AWSKinesisRecorder KinesisRecorderForKey:@"AWSKinesisRecorderTests.testWriteBehind"];
+    kinesisRecorder.writeBehindRecordCount = 100;
+    kinesisRecorder.writeBehindFlushInterval = 60;
+    [[kinesisRecorder removeAllRecords] waitUntilFinished];
+
+    NSData *data = [@"TestString" dataUsingEncoding:NSUTF8StringEncoding];
+    NSUInteger writeTransactionCount = kinesisRecorder.writeTransactionCount;
+    for (int32_t i = 0; i < 150; i++) {
+        AWSTask *task = [kinesisRecorder saveRecord:data
+                                         streamName:@"testWriteBehind"];
+        [task waitUntilFinished];
+        XCTAssertNil(task.error);
+    }
+    // The first 100 records are written in one transaction and the rest stay in the buffer.
+    XCTAssertEqual(kinesisRecorder.writeTransactionCount, writeTransactionCount + 1);
+
+    [[kinesisRecorder flushRecords] waitUntilFinished];
+    XCTAssertEqual(kinesisRecorder.writeTransactionCount, writeTransactionCount + 2);
+
+    [[kinesisRecorder flushRecords] waitUntilFinished];
+    XCTAssertEqual(kinesisRecorder.writeTransactionCount, writeTransactionCount + 2);
+
+    // Buffered records are written once the flush interval has passed.
+    kinesisRecorder.writeBehindFlushInterval = 0.1;
+    [[kinesisRecorder saveRecord:data
+                      streamName:@"testWriteBehind"] waitUntilFinished];
+    XCTAssertEqual(kinesisRecorder.writeTransactionCount, writeTransactionCount + 2);
+    [NSThread sleepForTimeInterval:0.5];
+    XCTAssertEqual(kinesisRecorder.writeTransactionCount, writeTransactionCount + 3);
+
+    [[kinesisRecorder removeAllRecords] waitUntilFinished];
+    [AWSKinesisRecorder removeKinesisRecorderForKey:@"AWSKinesisRecorderTests.testWriteBehind"];
+}
+
+- (void)testWriteBehindThroughput {
+    AWSServiceConfiguration *configuration = [[AWSServiceConfiguration alloc] initWithRegion:AWSRegionUSWest2
+                                                                         credentialsProvider:nil];
+    [AWSKinesisRecorder registerKinesisRecorderWithConfiguration:configuration
+                                                          forKey:@"AWSKinesisRecorderTests.testWriteBehindThroughput"];
+    AWSKinesisRecorder *kinesisRecorder = [AWSKinesisRecorder KinesisRecorderForKey:@"AWSKinesisRecorderTests.testWriteBehindThroughput"];
+    kinesisRecorder.diskByteLimit = 50 * 1024 * 1024;
+
+    NSMutableData *data = [NSMutableData dataWithLength:200];
+    for (NSNumber *writeBehindRecordCount in @[@0, @10, @100, @500]) {
+        [[kinesisRecorder removeAllRecords] waitUntilFinished];
+        kinesisRecorder.writeBehindRecordCount = [writeBehindRecordCount unsignedIntegerValue];
+
+        NSUInteger writeTransactionCount = kinesisRecorder.writeTransactionCount;
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        NSMutableArray *tasks = [NSMutableArray new];
+        for (int32_t i = 0; i < 2000; i++) {
+            [tasks addObject:[kinesisRecorder saveRecord:data
+                                              streamName:@"testWriteBehindThroughput"]];
+        }
+        [[AWSTask taskForCompletionOfAllTasks:tasks] waitUntilFinished];
+        [[kinesisRecorder flushRecords] waitUntilFinished];
+        CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+
+        NSUInteger transactions = kinesisRecorder.writeTransactionCount - writeTransactionCount;
+        NSLog(@"writeBehindRecordCount: %@, records/sec: %.0f, fsyncs/sec: %.0f (%lu transactions)",
+              writeBehindRecordCount, 2000 / elapsed, transactions / elapsed, (unsigned long)transactions);
+        XCTAssertGreaterThan(kinesisRecorder.diskBytesUsed, 2000 * 200);
+    }
+
+    [[kinesisRecorder removeAllRecords] waitUntilFinished];
+    [AWSKinesisRecorder removeKinesisRecorderForKey:@"AWSKinesisRecorderTests.testWriteBehindThroughput"];
+}
+
+- (void)testPipelinedSubmissionThroughput {
+    AWSServiceConfiguration *configuration = [[AWSServiceConfiguration alloc] initWithRegion:AWSRegionUSWest2
+                                                                         credentialsProvider:nil];
+    [AWSKinesisRecorder registerKinesisRecorderWithConfiguration:configuration
+                                                          forKey:@"AWSKinesisRecorderTests.testPipelinedSubmissionThroughput"];
+    AWSKinesisRecorder *kinesisRecorder = [AWSKinesisRecorder KinesisRecorderForKey:@"AWSKinesisRecorderTests.testPipelinedSubmissionThroughput"];
+    kinesisRecorder.diskByteLimit = 50 * 1024 * 1024;
+    kinesisRecorder.writeBehindRecordCount = 500;
+
+    NSMutableData *data = [NSMutableData dataWithLength:200];
+    for (NSNumber *submissionConcurrencyLimit in @[@1, @2, @4, @8]) {
+        AWSKinesisRecorderTestsStubKinesis *stubKinesis = [[AWSKinesisRecorderTestsStubKinesis alloc] initWithConfiguration:configuration];
+        stubKinesis.latencyInMilliseconds = 50;
+        [[kinesisRecorder valueForKey:@"recorderHelper"] setValue:stubKinesis forKey:@"kinesis"];
+        kinesisRecorder.submissionConcurrencyLimit = [submissionConcurrencyLimit unsignedIntegerValue];
+
+        [[kinesisRecorder removeAllRecords] waitUntilFinished];
+        for (int32_t i = 0; i < 2048; i++) {
+            [kinesisRecorder saveRecord:data
+                             streamName:[NSString stringWithFormat:@"testPipelinedSubmissionThroughput-%d", i % 2]];
+        }
+        [[kinesisRecorder flushRecords] waitUntilFinished];
+
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        AWSTask *task = [kinesisRecorder submitAllRecords];
+        [task waitUntilFinished];
+        CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+
+        XCTAssertNil(task.error);
+        XCTAssertEqual(stubKinesis.recordCount, 2048);
+        XCTAssertLessThanOrEqual(stubKinesis.maxInFlightCount, 2 * [submissionConcurrencyLimit unsignedIntegerValue]);
+        NSLog(@"submissionConcurrencyLimit: %@, records/sec: %.0f, requests: %lu, max in flight: %lu",
+              submissionConcurrencyLimit, 2048 / elapsed, (unsigned long)stubKinesis.requestCount, (unsigned long)stubKinesis.maxInFlightCount);
+
+        // All acknowledged records have been deleted.
+        [[kinesisRecorder submitAllRecords] waitUntilFinished];
+        XCTAssertEqual(stubKinesis.recordCount, 2048);
+    }
+
+    [AWSKinesisRecorder removeKinesisRecorderForKey:@"AWSKinesisRecorderTests.testPipelinedSubmissionThroughput"];
+}
+
+- (void)testRetriedRecordsKeepStreamOrder {
+    AWSServiceConfiguration *configuration = [[AWSServiceConfiguration alloc] initWithRegion:AWSRegionUSWest2
+                                                                         credentialsProvider:nil];
+    [AWSKinesisRecorder registerKinesisRecorderWithConfiguration:configuration
+                                                          forKey:@"AWSKinesisRecorderTests.testRetriedRecordsKeepStreamOrder"];
+    AWSKinesisRecorder *kinesisRecorder = [AWSKinesisRecorder KinesisRecorderForKey:@"AWSKinesisRecorderTests.testRetriedRecordsKeepStreamOrder"];
+    AWSKinesisRecorderTestsStubKinesis *stubKinesis = [[AWSKinesisRecorderTestsStubKinesis alloc] initWithConfiguration:configuration];
+    stubKinesis.latencyInMilliseconds = 10;
+    stubKinesis.throttledRecordCount = 1;
+    [[kinesisRecorder valueForKey:@"recorderHelper"] setValue:stubKinesis forKey:@"kinesis"];
+    kinesisRecorder.batchRecordCountLimit = 4;
+
+    [[kinesisRecorder removeAllRecords] waitUntilFinished];
+    for (uint8_t i = 0; i < 12; i++) {
+        [kinesisRecorder saveRecord:[NSData dataWithBytes:&i length:1]
+                         streamName:@"testRetriedRecordsKeepStreamOrder"];
+    }
+
+    AWSTask *task = [kinesisRecorder submitAllRecords];
+    [task waitUntilFinished];
+    XCTAssertNil(task.error);
+
+    // The throttled first record is resent before any record saved after its batch.
+    NSMutableArray *sentIndexes = [NSMutableArray new];
+    for (NSData *data in stubKinesis.sentData) {
+        [sentIndexes addObject:@(((const uint8_t *)data.bytes)[0])];
+    }
+    NSArray *expectedIndexes = @[@0, @1, @2, @3, @0, @4, @5, @6, @7, @8, @9, @10, @11];
+    XCTAssertEqualObjects(sentIndexes, expectedIndexes);
+
+    [AWSKinesisRecorder removeKinesisRecorderForKey:@"AWSKinesisRecorderTests.testRetriedRecordsKeepStreamOrder"];
+}
+
+- (void)testSaveRecordDuringSubmission {
+    AWSServiceConfiguration *configuration = [[AWSServiceConfiguration alloc] initWithRegion:AWSRegionUSWest2
+                                                                         credentialsProvider:nil];
+    [AWSKinesisRecorder registerKinesisRecorderWithConfiguration:configuration
+                                                          forKey:@"AWSKinesisRecorderTests.testSaveRecordDuringSubmission"];
+    AWSKinesisRecorder *kinesisRecorder = [AWSKinesisRecorder KinesisRecorderForKey:@"AWSKinesisRecorderTests.testSaveRecordDuringSubmission"];
+    AWSKinesisRecorderTestsStubKinesis *stubKinesis = [[AWSKinesisRecorderTestsStubKinesis alloc] initWithConfiguration:configuration];
+    stubKinesis.latencyInMilliseconds = 2000;
+    [[kinesisRecorder valueForKey:@"recorderHelper"] setValue:stubKinesis forKey:@"kinesis"];
+
+    [[kinesisRecorder removeAllRecords] waitUntilFinished];
+    [[kinesisRecorder saveRecord:[NSMutableData dataWithLength:16]
+                      streamName:@"testSaveRecordDuringSubmission"] waitUntilFinished];
+
+    AWSTask *submitTask = [kinesisRecorder submitAllRecords];
+    while (stubKinesis.requestCount == 0) {
+        [NSThread sleepForTimeInterval:0.01];
+    }
+
+    // Saving doesn't wait for the request the drain is blocked on.
+    AWSTask *saveTask = [kinesisRecorder saveRecord:[NSMutableData dataWithLength:16]
+                                         streamName:@"testSaveRecordDuringSubmission"];
+    [saveTask waitUntilFinished];
+    XCTAssertNil(saveTask.error);
+    XCTAssertFalse(submitTask.completed);
+
+    [submitTask waitUntilFinished];
+    XCTAssertNil(submitTask.error);
+
+    [AWSKinesisRecorder removeKinesisRecorderForKey:@"AWSKinesisRecorderTests.testSaveRecordDuringSubmission"];
+}
+
+- (void)testAggregation {
+    AWSServiceConfiguration *configuration = [[AWSServiceConfiguration alloc] initWithRegion:AWSRegionUSWest2
+                                                                         credentialsProvider:nil];
+    [AWSKinesisRecorder registerKinesisRecorderWithConfiguration:configuration
+                                                          forKey:@"AWSKinesisRecorderTests.testAggregation"];
+    AWSKinesisRecorder *kinesisRecorder = [AWSKinesisRecorder KinesisRecorderForKey:@"AWSKinesisRecorderTests.testAggregation"];
+    AWSKinesisRecorderTestsStubKinesis *stubKinesis = [[AWSKinesisRecorderTestsStubKinesis alloc] initWithConfiguration:configuration];
+    [[kinesisRecorder valueForKey:@"recorderHelper"] setValue:stubKinesis forKey:@"kinesis"];
+    kinesisRecorder.aggregationEnabled = YES;
+    kinesisRecorder.writeBehindRecordCount = 500;
+
+    [[kinesisRecorder removeAllRecords] waitUntilFinished];
+    NSMutableData *data = [NSMutableData dataWithLength:200];
+    for (int32_t i = 0; i < 2000; i++) {
+        [kinesisRecorder saveRecord:data
+                         streamName:@"testAggregation"];
+    }
+
+    AWSTask *task = [kinesisRecorder submitAllRecords];
+    [task waitUntilFinished];
+    XCTAssertNil(task.error);
+
+    // 2,000 records of 200 bytes fit in a single aggregated Kinesis record.
+    XCTAssertEqual(stubKinesis.requestCount, 1);
+    XCTAssertEqual(stubKinesis.recordCount, 1);
+
+    [[kinesisRecorder submitAllRecords] waitUntilFinished];
+    XCTAssertEqual(stubKinesis.requestCount, 1);
+
+    [AWSKinesisRecorder removeKinesisRecorderForKey:@"AWSKinesisRecorderTests.testAggregation"];
+}
+
 - (void)testAll {
     XCTestExpectation *expectation = [self expectationWithDescription:@"Test finished running."];
     
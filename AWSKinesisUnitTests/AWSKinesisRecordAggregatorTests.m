@@ -0,0 +1,223 @@
+//
+// Copyright 2010-2019 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import <CommonCrypto/CommonDigest.h>
+#import "AWSKinesisRecordAggregator.h"
+
+@interface AWSKinesisRecordAggregatorTests : XCTestCase
+
+@end
+
+@implementation AWSKinesisRecordAggregatorTests
+
+// A minimal de-aggregator following the KPL aggregated record format, returning dictionaries with `data` and `partition_key`.
+- (NSArray *)deaggregateData:(NSData *)data {
+    return [self deaggregateData:data explicitHashKeys:nil];
+}
+
+// Also collects the explicit hash key of every user record, or NSNull for records without one.
+- (NSArray *)deaggregateData:(NSData *)data explicitHashKeys:(NSMutableArray *)userRecordExplicitHashKeys {
+    const uint8_t *bytes = [data bytes];
+    NSUInteger length = [data length];
+    XCTAssertGreaterThan(length, sizeof(AWSKinesisAggregatedRecordMagic) + CC_MD5_DIGEST_LENGTH);
+    XCTAssertEqual(memcmp(bytes, AWSKinesisAggregatedRecordMagic, sizeof(AWSKinesisAggregatedRecordMagic)), 0);
+
+    const uint8_t *message = bytes + sizeof(AWSKinesisAggregatedRecordMagic);
+    NSUInteger messageLength = length - sizeof(AWSKinesisAggregatedRecordMagic) - CC_MD5_DIGEST_LENGTH;
+    unsigned char digest[CC_MD5_DIGEST_LENGTH];
+    CC_MD5(message, (CC_LONG)messageLength, digest);
+    XCTAssertEqual(memcmp(digest, message + messageLength, CC_MD5_DIGEST_LENGTH), 0);
+
+    NSMutableArray *partitionKeys = [NSMutableArray new];
+    NSMutableArray *explicitHashKeys = [NSMutableArray new];
+    NSMutableArray *records = [NSMutableArray new];
+    NSUInteger position = 0;
+    while (position < messageLength) {
+        uint64_t tag = [self readVarint:message length:messageLength position:&position];
+        uint64_t fieldLength = [self readVarint:message length:messageLength position:&position];
+        NSData *field = [NSData dataWithBytes:message + position length:(NSUInteger)fieldLength];
+        position += fieldLength;
+
+        if (tag == ((1 << 3) | 2)) {
+            [partitionKeys addObject:[[NSString alloc] initWithData:field encoding:NSUTF8StringEncoding]];
+        } else if (tag == ((2 << 3) | 2)) {
+            [explicitHashKeys addObject:[[NSString alloc] initWithData:field encoding:NSUTF8StringEncoding]];
+        } else if (tag == ((3 << 3) | 2)) {
+            const uint8_t *recordBytes = [field bytes];
+            NSUInteger recordPosition = 0;
+            uint64_t partitionKeyIndex = 0;
+            NSNumber *explicitHashKeyIndex = nil;
+            NSData *recordData = nil;
+            while (recordPosition < [field length]) {
+                uint64_t recordTag = [self readVarint:recordBytes length:[field length] position:&recordPosition];
+                if (recordTag == ((1 << 3) | 0)) {
+                    partitionKeyIndex = [self readVarint:recordBytes length:[field length] position:&recordPosition];
+                } else if (recordTag == ((2 << 3) | 0)) {
+                    explicitHashKeyIndex = @([self readVarint:recordBytes length:[field length] position:&recordPosition]);
+                } else if (recordTag == ((3 << 3) | 2)) {
+                    uint64_t dataLength = [self readVarint:recordBytes length:[field length] position:&recordPosition];
+                    recordData = [NSData dataWithBytes:recordBytes + recordPosition length:(NSUInteger)dataLength];
+                    recordPosition += dataLength;
+                } else {
+                    XCTFail(@"Unexpected field %llu", recordTag);
+                    return nil;
+                }
+            }
+            [records addObject:@{@"data" : recordData,
+                                 @"partition_key" : @(partitionKeyIndex),
+                                 @"explicit_hash_key" : explicitHashKeyIndex ?: [NSNull null]}];
+        } else {
+            XCTFail(@"Unexpected field %llu", tag);
+            return nil;
+        }
+    }
+
+    NSMutableArray *userRecords = [NSMutableArray new];
+    for (NSDictionary *record in records) {
+        [userRecords addObject:@{@"data" : record[@"data"],
+                                 @"partition_key" : partitionKeys[[record[@"partition_key"] unsignedIntegerValue]]}];
+        id explicitHashKeyIndex = record[@"explicit_hash_key"];
+        [userRecordExplicitHashKeys addObject:explicitHashKeyIndex == [NSNull null] ? explicitHashKeyIndex : explicitHashKeys[[explicitHashKeyIndex unsignedIntegerValue]]];
+    }
+    return userRecords;
+}
+
+- (uint64_t)readVarint:(const uint8_t *)bytes length:(NSUInteger)length position:(NSUInteger *)position {
+    uint64_t value = 0;
+    int shift = 0;
+    while (*position < length) {
+        uint8_t byte = bytes[(*position)++];
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            break;
+        }
+        shift += 7;
+    }
+    return value;
+}
+
+- (NSArray *)recordsWithCount:(NSUInteger)count dataLength:(NSUInteger)dataLength partitionKeyCount:(NSUInteger)partitionKeyCount {
+    NSMutableArray *records = [NSMutableArray new];
+    for (NSUInteger i = 0; i < count; i++) {
+        NSMutableData *data = [NSMutableData dataWithLength:dataLength];
+        memset([data mutableBytes], (int)(i % 256), dataLength);
+        [records addObject:@{@"data" : data,
+                             @"partition_key" : [NSString stringWithFormat:@"partitionKey-%lu", (unsigned long)(i % partitionKeyCount)]}];
+    }
+    return records;
+}
+
+- (NSArray *)rowIdsWithCount:(NSUInteger)count {
+    NSMutableArray *rowIds = [NSMutableArray new];
+    for (NSUInteger i = 0; i < count; i++) {
+        [rowIds addObject:@(i + 1)];
+    }
+    return rowIds;
+}
+
+- (void)testAggregateRoundTrip {
+    NSArray *records = [self recordsWithCount:1000 dataLength:200 partitionKeyCount:7];
+    NSArray *aggregatedRecords = [AWSKinesisRecordAggregator aggregateRecords:records
+                                                                      rowIds:[self rowIdsWithCount:1000]
+                                                       shardStartingHashKeys:nil
+                                                                   byteLimit:AWSKinesisAggregatedRecordByteLimit];
+    XCTAssertEqual([aggregatedRecords count], 1);
+
+    AWSKinesisAggregatedRecord *aggregatedRecord = aggregatedRecords[0];
+    XCTAssertEqualObjects(aggregatedRecord.partitionKey, @"partitionKey-0");
+    XCTAssertEqualObjects(aggregatedRecord.explicitHashKey, [AWSKinesisRecordAggregator explicitHashKeyForPartitionKey:@"partitionKey-0"]);
+    XCTAssertEqualObjects(aggregatedRecord.rowIds, [self rowIdsWithCount:1000]);
+
+    // Without the shard map, every user record is attributed to the shard the aggregated record is written to.
+    NSMutableArray *explicitHashKeys = [NSMutableArray new];
+    XCTAssertEqualObjects([self deaggregateData:aggregatedRecord.data explicitHashKeys:explicitHashKeys], records);
+    XCTAssertEqual([explicitHashKeys count], 1000);
+    for (id explicitHashKey in explicitHashKeys) {
+        XCTAssertEqualObjects(explicitHashKey, aggregatedRecord.explicitHashKey);
+    }
+}
+
+- (void)testAggregateGroupsRecordsByShard {
+    NSArray *records = [self recordsWithCount:1000 dataLength:200 partitionKeyCount:7];
+    // Two shards splitting the hash key range at 2^127.
+    NSArray *aggregatedRecords = [AWSKinesisRecordAggregator aggregateRecords:records
+                                                                      rowIds:[self rowIdsWithCount:1000]
+                                                       shardStartingHashKeys:@[@"170141183460469231731687303715884105728", @"0"]
+                                                                   byteLimit:AWSKinesisAggregatedRecordByteLimit];
+    XCTAssertEqual([aggregatedRecords count], 2);
+
+    NSMutableArray *userRecords = [NSMutableArray new];
+    for (AWSKinesisAggregatedRecord *aggregatedRecord in aggregatedRecords) {
+        BOOL upperShard = [self mostSignificantHashKeyByteForPartitionKey:aggregatedRecord.partitionKey] >= 0x80;
+        NSMutableArray *explicitHashKeys = [NSMutableArray new];
+        NSArray *shardRecords = [self deaggregateData:aggregatedRecord.data explicitHashKeys:explicitHashKeys];
+        XCTAssertEqual([shardRecords count], [aggregatedRecord.rowIds count]);
+        for (NSUInteger i = 0; i < [shardRecords count]; i++) {
+            XCTAssertEqual([self mostSignificantHashKeyByteForPartitionKey:shardRecords[i][@"partition_key"]] >= 0x80, upperShard);
+            XCTAssertEqualObjects(explicitHashKeys[i], [NSNull null]);
+            XCTAssertEqualObjects(shardRecords[i], records[[aggregatedRecord.rowIds[i] unsignedIntegerValue] - 1]);
+        }
+        [userRecords addObjectsFromArray:shardRecords];
+    }
+    XCTAssertEqual([userRecords count], [records count]);
+}
+
+// The most significant byte of the partition key's hash key.
+- (uint8_t)mostSignificantHashKeyByteForPartitionKey:(NSString *)partitionKey {
+    NSData *partitionKeyData = [partitionKey dataUsingEncoding:NSUTF8StringEncoding];
+    unsigned char digest[CC_MD5_DIGEST_LENGTH];
+    CC_MD5([partitionKeyData bytes], (CC_LONG)[partitionKeyData length], digest);
+    return digest[0];
+}
+
+- (void)testAggregateRespectsByteLimit {
+    NSArray *records = [self recordsWithCount:100 dataLength:1000 partitionKeyCount:100];
+    NSArray *aggregatedRecords = [AWSKinesisRecordAggregator aggregateRecords:records
+                                                                      rowIds:[self rowIdsWithCount:100]
+                                                       shardStartingHashKeys:nil
+                                                                   byteLimit:10 * 1024];
+    XCTAssertGreaterThan([aggregatedRecords count], 1);
+
+    NSMutableArray *userRecords = [NSMutableArray new];
+    NSMutableArray *rowIds = [NSMutableArray new];
+    for (AWSKinesisAggregatedRecord *aggregatedRecord in aggregatedRecords) {
+        XCTAssertLessThanOrEqual([aggregatedRecord.data length] + [aggregatedRecord.partitionKey length], 10 * 1024);
+        [userRecords addObjectsFromArray:[self deaggregateData:aggregatedRecord.data]];
+        [rowIds addObjectsFromArray:aggregatedRecord.rowIds];
+    }
+    XCTAssertEqualObjects(userRecords, records);
+    XCTAssertEqualObjects(rowIds, [self rowIdsWithCount:100]);
+}
+
+- (void)testSingleRecordIsNotAggregated {
+    NSArray *records = [self recordsWithCount:1 dataLength:100 partitionKeyCount:1];
+    NSArray *aggregatedRecords = [AWSKinesisRecordAggregator aggregateRecords:records
+                                                                      rowIds:@[@1]
+                                                       shardStartingHashKeys:nil
+                                                                   byteLimit:AWSKinesisAggregatedRecordByteLimit];
+    XCTAssertEqual([aggregatedRecords count], 1);
+    XCTAssertEqualObjects([aggregatedRecords[0] data], records[0][@"data"]);
+    XCTAssertEqualObjects([aggregatedRecords[0] partitionKey], records[0][@"partition_key"]);
+}
+
+- (void)testExplicitHashKeyForPartitionKey {
+    // MD5("") = d41d8cd98f00b204e9800998ecf8427e
+    XCTAssertEqualObjects([AWSKinesisRecordAggregator explicitHashKeyForPartitionKey:@""], @"281949768489412648962353822266799178366");
+    // MD5("a") = 0cc175b9c0f1b6a831c399e269772661
+    XCTAssertEqualObjects([AWSKinesisRecordAggregator explicitHashKeyForPartitionKey:@"a"], @"16955237001963240173058271559858726497");
+}
+
+@end
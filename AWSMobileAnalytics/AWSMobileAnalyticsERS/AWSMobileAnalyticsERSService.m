@@ -24,6 +24,7 @@
 #import <AWSCore/AWSURLRequestRetryHandler.h>
 #import <AWSCore/AWSSynchronizedMutableDictionary.h>
 #import "AWSMobileAnalyticsERSResources.h"
+#import "AWSMobileAnalyticsERSEncodedRequest.h"
 
 static NSString *const AWSInfoMobileAnalyticsERS = @"MobileAnalyticsERS";
 NSString *const AWSMobileAnalyticsERSSDKVersion = @"2.10.0";
@@ -135,6 +136,48 @@ static NSDictionary *errorCodeDictionary = nil;
 
 @end
 
+@interface AWSMobileAnalyticsERSEncodedRequestSerializer : AWSJSONRequestSerializer
+
+@property (nonatomic, strong) NSData *body;
+@property (nonatomic, strong) NSString *contentEncoding;
+
+- (instancetype)initWithJSONDefinition:(NSDictionary *)JSONDefinition
+                            actionName:(NSString *)actionName
+                                  body:(NSData *)body
+                       contentEncoding:(NSString *)contentEncoding;
+
+@end
+
+@implementation AWSMobileAnalyticsERSEncodedRequestSerializer
+
+- (instancetype)initWithJSONDefinition:(NSDictionary *)JSONDefinition
+                            actionName:(NSString *)actionName
+                                  body:(NSData *)body
+                       contentEncoding:(NSString *)contentEncoding {
+    if (self = [super initWithJSONDefinition:JSONDefinition actionName:actionName]) {
+        _body = body;
+        _contentEncoding = contentEncoding;
+    }
+    return self;
+}
+
+- (AWSTask *)serializeRequest:(NSMutableURLRequest *)request
+                      headers:(NSDictionary *)headers
+                   parameters:(NSDictionary *)parameters {
+    // Let the JSON serializer build the URI and headers, then swap in the pre-encoded body.
+    return [[super serializeRequest:request
+                            headers:headers
+                         parameters:parameters] continueWithSuccessBlock:^id(AWSTask *task) {
+        request.HTTPBody = self.body;
+        if (self.contentEncoding) {
+            [request setValue:self.contentEncoding forHTTPHeaderField:@"Content-Encoding"];
+        }
+        return nil;
+    }];
+}
+
+@end
+
 @interface AWSMobileAnalyticsERSRequestRetryHandler : AWSURLRequestRetryHandler
 
 @end
@@ -340,3 +383,29 @@ static AWSSynchronizedMutableDictionary *_serviceClients = nil;
 #pragma mark -
 
 @end
+
+@implementation AWSMobileAnalyticsERS (EncodedRequest)
+
+- (AWSTask *)putEventsWithEncodedBody:(NSData *)body
+                      contentEncoding:(NSString *)contentEncoding
+                        clientContext:(NSString *)clientContext {
+    @autoreleasepool {
+        NSString *operationName = @"PutEvents";
+
+        AWSNetworkingRequest *networkingRequest = [AWSNetworkingRequest new];
+        networkingRequest.parameters = clientContext ? @{@"clientContext" : clientContext} : @{};
+        networkingRequest.headers = @{@"X-Amz-Target" : [NSString stringWithFormat:@"AmazonMobileAnalytics.%@", operationName]};
+        networkingRequest.HTTPMethod = AWSHTTPMethodPOST;
+        networkingRequest.requestSerializer = [[AWSMobileAnalyticsERSEncodedRequestSerializer alloc] initWithJSONDefinition:[[AWSMobileAnalyticsERSResources sharedInstance] JSONObject]
+                                                                                                                  actionName:operationName
+                                                                                                                        body:body
+                                                                                                             contentEncoding:contentEncoding];
+        networkingRequest.responseSerializer = [[AWSMobileAnalyticsERSResponseSerializer alloc] initWithJSONDefinition:[[AWSMobileAnalyticsERSResources sharedInstance] JSONObject]
+                                                                                                            actionName:operationName
+                                                                                                           outputClass:nil];
+
+        return [self.networking sendRequest:networkingRequest];
+    }
+}
+
+@end
@@ -33,7 +33,10 @@ FOUNDATION_EXPORT NSString *const AWSKeyIsAnalyticsEnabled;
 
 FOUNDATION_EXPORT NSString *const AWSKeyMaxSubmissionsAllowed;
 FOUNDATION_EXPORT NSString *const AWSKeyMaxSubmissionSize;
+FOUNDATION_EXPORT NSString *const AWSKeyMaxSubmissionUncompressedSize;
+FOUNDATION_EXPORT NSString *const AWSKeyCompressSubmissions;
 FOUNDATION_EXPORT NSString *const AWSKeyMaxStorageSize;
+FOUNDATION_EXPORT NSString *const AWSKeyEventsSegmentSize;
 FOUNDATION_EXPORT NSString *const AWSKeyForceSubmissionWaitTime;
 FOUNDATION_EXPORT NSString *const AWSKeyBackgroundSubmissionWaitTime;
 FOUNDATION_EXPORT NSString *const AWSKeyMaxPutOperations;
@@ -58,7 +61,10 @@ FOUNDATION_EXPORT BOOL      const AWSValueIsAnalyticsEnabled;
 
 FOUNDATION_EXPORT int const AWSValueMaxSubmissionsAllowed;
 FOUNDATION_EXPORT int const AWSValueMaxSubmissionSize;
+FOUNDATION_EXPORT int const AWSValueMaxSubmissionUncompressedSize;
+FOUNDATION_EXPORT BOOL      const AWSValueCompressSubmissions;
 FOUNDATION_EXPORT int const AWSValueMaxStorageSize;
+FOUNDATION_EXPORT int const AWSValueEventsSegmentSize;
 FOUNDATION_EXPORT double    const AWSValueForceSubmissionWaitTime;
 FOUNDATION_EXPORT double    const AWSValueBackgroundSubmissionWaitTime;
 FOUNDATION_EXPORT int const AWSValueMaxPutOperations;
@@ -31,8 +31,11 @@ NSString *const AWSKeyLogLevel                    = @"logLevel";
 NSString *const AWSKeyIsAnalyticsEnabled          = @"isAnalyticsEnabled";
 
 NSString *const AWSKeyMaxSubmissionSize           = @"maxSubmissionSize";
+NSString *const AWSKeyMaxSubmissionUncompressedSize = @"maxSubmissionUncompressedSize";
+NSString *const AWSKeyCompressSubmissions         = @"compressSubmissions";
 NSString *const AWSKeyMaxSubmissionsAllowed       = @"maxSubmissionAllowed";
 NSString *const AWSKeyMaxStorageSize              = @"maxStorageSize";
+NSString *const AWSKeyEventsSegmentSize           = @"eventsSegmentSize";
 NSString *const AWSKeyForceSubmissionWaitTime     = @"forceSubmissionWaitTime";
 NSString *const AWSKeyBackgroundSubmissionWaitTime = @"backgroundSubmissionWaitTime";
 NSString *const AWSKeyMaxPutOperations            = @"maxPutOperations";
@@ -58,9 +61,12 @@ BOOL      const AWSValueAllowWANEventDelivery       = YES;
 NSString *const AWSValueLogLevel                  = @"ERROR";
 BOOL      const AWSValueIsAnalyticsEnabled          = YES;
 
-int const AWSValueMaxSubmissionSize           = 1024 * 100; // 100 KB
+int const AWSValueMaxSubmissionSize           = 1024 * 100; // 100 KB, measured on the wire
+int const AWSValueMaxSubmissionUncompressedSize = 1024 * 1024; // 1 MB
+BOOL      const AWSValueCompressSubmissions         = YES;
 int const AWSValueMaxSubmissionsAllowed       = 3;
 int const AWSValueMaxStorageSize              = 1024 * 1024 * 5; // 5 MB
+int const AWSValueEventsSegmentSize           = 1024 * 256; // 256 KB
 double    const AWSValueForceSubmissionWaitTime     = 60; //default 60 sec
 double    const AWSValueBackgroundSubmissionWaitTime = 0;
 int const AWSValueMaxPutOperations            = 1000;
@@ -25,8 +25,14 @@
 #import "AWSMobileAnalyticsDefaultSessionClient.h"
 #import <UIKit/UIKit.h>
 #import "AWSMobileAnalyticsClientContext.h"
+#import "AWSMobileAnalyticsERSEncodedRequest.h"
+#import <AWSCore/AWSGZIP.h>
 
 NSUInteger const AWSMobileAnalyticsDefaultDeliveryClientMaxOperations = 1000;
+// Padding applied to the last observed compression ratio when sizing the next batch.
+static double const AWSMobileAnalyticsDefaultDeliveryClientCompressionHeadroom = 1.1;
+static NSString *const AWSMobileAnalyticsDefaultDeliveryClientBodyPrefix = @"{\"events\":[";
+static NSString *const AWSMobileAnalyticsDefaultDeliveryClientBodySuffix = @"]}";
 
 @interface AWSMobileAnalyticsDefaultDeliveryClient()
 
@@ -38,6 +44,7 @@ NSUInteger const AWSMobileAnalyticsDefaultDeliveryClientMaxOperations = 1000;
 @property (nonatomic, strong) id backgroundObserverHandle;
 @property (nonatomic, strong) AWSMobileAnalyticsClientContext *clientContext;
 @property (nonatomic, strong) AWSMobileAnalyticsERS *ers;
+@property (nonatomic, assign) double compressionRatio;
 
 @end
 
@@ -90,6 +97,7 @@ NSUInteger const AWSMobileAnalyticsDefaultDeliveryClientMaxOperations = 1000;
         _serializer = serializer;
         _clientContext = clientContext;
         _ers = ers;
+        _compressionRatio = 1.0;
     }
     return self;
 }
@@ -185,38 +193,73 @@ NSUInteger const AWSMobileAnalyticsDefaultDeliveryClientMaxOperations = 1000;
         }
 
         BOOL successful = YES;
+        BOOL compress = [self.configuration boolForKey:AWSKeyCompressSubmissions withOptValue:AWSValueCompressSubmissions];
         long maxRequestSize = [self.configuration longForKey:AWSKeyMaxSubmissionSize withOptValue:AWSValueMaxSubmissionSize];
+        long maxUncompressedSize = maxRequestSize;
+        if (compress) {
+            maxUncompressedSize = MAX(maxRequestSize, [self.configuration longForKey:AWSKeyMaxSubmissionUncompressedSize withOptValue:AWSValueMaxSubmissionUncompressedSize]);
+        }
 
-        // get the batched items (they are stored in the event store as json strings
-        NSMutableArray* eventArray = [NSMutableArray array];
+        // get the batched items (they are stored in the event store as json strings) and encode them into the request shape as they are read
+        NSMutableArray* encodedEvents = [NSMutableArray array];
         id<AWSMobileAnalyticsEventIterator> iterator = [self.eventStore iterator];
 
-        long currentRequestLength = 0L;
+        long currentRequestLength = (long)([AWSMobileAnalyticsDefaultDeliveryClientBodyPrefix length] + [AWSMobileAnalyticsDefaultDeliveryClientBodySuffix length]);
+        long emptyRequestLength = currentRequestLength;
+        NSUInteger maxBatchCount = NSUIntegerMax;
         int submissions = 0;
         int maxAllowedSubmissions = [self.configuration intForKey:AWSKeyMaxSubmissionsAllowed withOptValue:AWSValueMaxSubmissionsAllowed];
 
-        while([iterator hasNext] && submissions < maxAllowedSubmissions) {
-            long eventLength = [[iterator peek] length];
-            if(currentRequestLength + eventLength <= maxRequestSize) {
-                currentRequestLength += eventLength;
-                [eventArray addObject:[iterator next]];
-            } else {
-                successful = [self submitEvents:eventArray andUpdatePolicies:policies];
-                if (successful) {
-                    submissions++;
-                    [iterator removeReadEvents];
-                    eventArray = [NSMutableArray array];
-                    currentRequestLength = 0;
-                } else {
+        while(successful && submissions < maxAllowedSubmissions) {
+            while([iterator hasNext] && [encodedEvents count] < maxBatchCount) {
+                NSData *encodedEvent = [self encodedEventForEvent:[iterator peek]];
+                if (!encodedEvent) {
+                    AWSDDLogError(@"Dropping an event that could not be read from the local filestore.");
+                    [iterator next];
+                    continue;
+                }
+
+                // the separator between events counts towards the request too
+                long requestLength = currentRequestLength + (long)[encodedEvent length] + ([encodedEvents count] > 0 ? 1 : 0);
+                long estimatedLength = compress ? (long)(requestLength * self.compressionRatio) : requestLength;
+                if([encodedEvents count] > 0 && (requestLength > maxUncompressedSize || estimatedLength > maxRequestSize)) {
                     break;
                 }
+                currentRequestLength = requestLength;
+                [encodedEvents addObject:encodedEvent];
+                [iterator next];
+            }
+            if ([encodedEvents count] == 0) {
+                // only dropped events, if any, are left unremoved
+                [iterator removeReadEvents];
+                break;
+            }
+
+            NSString *contentEncoding = nil;
+            NSData *body = [self requestBodyForEncodedEvents:encodedEvents
+                                                    compress:compress
+                                             contentEncoding:&contentEncoding];
+
+            // The batch was sized on an estimate of its compressed size. If the events turned out less compressible
+            // than the estimate, read the first half of them again from the store so that only what is delivered is removed.
+            if ([body length] > maxRequestSize && [encodedEvents count] > 1) {
+                maxBatchCount = [encodedEvents count] / 2;
+                iterator = [self.eventStore iterator];
+                encodedEvents = [NSMutableArray array];
+                currentRequestLength = emptyRequestLength;
+                continue;
             }
-        }
 
-        //Send the remainder batch to the server if everything has been successful in the previous batches
-        if(successful && [eventArray count] > 0) {
-            if ([self submitEvents:eventArray andUpdatePolicies:policies]) {
+            successful = [self submitRequestBody:body
+                                 contentEncoding:contentEncoding
+                                      eventCount:[encodedEvents count]
+                               andUpdatePolicies:policies];
+            if (successful) {
+                submissions++;
                 [iterator removeReadEvents];
+                encodedEvents = [NSMutableArray array];
+                currentRequestLength = emptyRequestLength;
+                maxBatchCount = NSUIntegerMax;
             }
         }
 
@@ -234,16 +277,40 @@ NSUInteger const AWSMobileAnalyticsDefaultDeliveryClientMaxOperations = 1000;
     return events;
 }
 
-- (BOOL)submitEvents:(NSArray*)events
-   andUpdatePolicies:(NSArray*)policies {
+- (NSData *)requestBodyForEncodedEvents:(NSArray *)encodedEvents
+                               compress:(BOOL)compress
+                        contentEncoding:(NSString **)contentEncoding {
+    NSData *body = [self requestBodyForEncodedEvents:encodedEvents];
+    *contentEncoding = nil;
+
+    if (compress) {
+        NSData *compressedBody = [body awsgzip_gzippedData];
+        if ([compressedBody length] > 0) {
+            self.compressionRatio = MIN(1.0, ((double)[compressedBody length] / [body length]) * AWSMobileAnalyticsDefaultDeliveryClientCompressionHeadroom);
+            body = compressedBody;
+            *contentEncoding = @"gzip";
+        } else {
+            AWSDDLogWarn(@"Unable to compress the submission of %lu events, sending it uncompressed.", (unsigned long)[encodedEvents count]);
+        }
+    }
+
+    return body;
+}
+
+- (BOOL)submitRequestBody:(NSData *)body
+          contentEncoding:(NSString *)contentEncoding
+               eventCount:(NSUInteger)eventCount
+        andUpdatePolicies:(NSArray*)policies {
     __block BOOL submitted = NO;
     
-    [[[self.ers putEvents:[self putEventsInputForEvents:events]] continueWithBlock:^id(AWSTask *task) {
+    [[[self.ers putEventsWithEncodedBody:body
+                         contentEncoding:contentEncoding
+                           clientContext:[self.clientContext JSONString]] continueWithBlock:^id(AWSTask *task) {
         if (task.error) {
             if ([task.error.domain isEqualToString:AWSMobileAnalyticsERSErrorDomain]
                 && task.error.code == AWSMobileAnalyticsERSErrorBadRequest) {
                 NSInteger responseCode = [task.error.userInfo[@"responseStatusCode"] integerValue];
-                AWSDDLogError(@"Server rejected submission of %lu events. (Pending events will be removed from queue.) Response code:%ld, Error Message:%@", (unsigned long)[events count], (long)responseCode, task.error);
+                AWSDDLogError(@"Server rejected submission of %lu events. (Pending events will be removed from queue.) Response code:%ld, Error Message:%@", (unsigned long)eventCount, (long)responseCode, task.error);
                 submitted = YES;
             } else {
                 AWSDDLogError(@"Unable to successfully deliver events to server. Error Message:%@", task.error);
@@ -254,7 +321,7 @@ NSUInteger const AWSMobileAnalyticsDefaultDeliveryClientMaxOperations = 1000;
         if (task.result) {
             NSInteger responseCode = [task.result[@"responseStatusCode"] integerValue];
             AWSDDLogVerbose(@"The http response code is %ld", (long)responseCode);
-            AWSDDLogInfo(@"Successful submission of %lu events. Response code:%ld", (unsigned long)[events count], (long)responseCode);
+            AWSDDLogInfo(@"Successful submission of %lu events (%lu bytes). Response code:%ld", (unsigned long)eventCount, (unsigned long)[body length], (long)responseCode);
             submitted = YES;
         }
 
@@ -269,53 +336,65 @@ NSUInteger const AWSMobileAnalyticsDefaultDeliveryClientMaxOperations = 1000;
     return submitted;
 }
 
-- (AWSMobileAnalyticsERSPutEventsInput*) putEventsInputForEvents:(NSArray*) events {
-    AWSMobileAnalyticsERSPutEventsInput *putEventInput = [AWSMobileAnalyticsERSPutEventsInput new];
-    
-    putEventInput.clientContext = [self.clientContext JSONString];
-    
-    NSMutableArray *parsedEventsArray = [NSMutableArray new];
-    for (NSString *event in events) {
-        NSDictionary *sourceEventDict = [NSJSONSerialization JSONObjectWithData:[event dataUsingEncoding:NSUTF8StringEncoding] options:kNilOptions error:NULL];
-
-        AWSMobileAnalyticsERSEvent *serviceEvent = [AWSMobileAnalyticsERSEvent new];
-        AWSMobileAnalyticsERSSession *serviceSession = [AWSMobileAnalyticsERSSession new];
-        
-        //process the attributes
-        NSMutableDictionary *mutableAttributesDic = [sourceEventDict[@"attributes"] mutableCopy];
-        [mutableAttributesDic removeObjectForKey:@""]; //Clean out invalid empty keys that may have been previously set
-        NSMutableDictionary *mutableMetricsDic = [sourceEventDict[@"metrics"] mutableCopy];
-        [mutableMetricsDic removeObjectForKey:@""]; //Clean out invalid empty keys that may have been previously set
-        serviceEvent.version = mutableAttributesDic[@"ver"];
-        [mutableAttributesDic removeObjectForKey:@"ver"];
-        
-        serviceSession.identifier = mutableAttributesDic[AWSSessionIDAttributeKey];
-        [mutableAttributesDic removeObjectForKey:AWSSessionIDAttributeKey];
-        
-        serviceSession.startTimestamp = mutableAttributesDic[AWSSessionStartTimeAttributeKey];
-        [mutableAttributesDic removeObjectForKey:AWSSessionStartTimeAttributeKey];
-        
-        //move sessionStop time attribute session section
-        serviceSession.stopTimestamp = mutableAttributesDic[AWSSessionEndTimeAttributeKey];
-        [mutableAttributesDic removeObjectForKey:AWSSessionEndTimeAttributeKey];
-        
-        //move session duration Time metrics to session section
-        serviceSession.duration = mutableMetricsDic[AWSSessionDurationMetricKey];
-        [mutableMetricsDic removeObjectForKey:AWSSessionDurationMetricKey];
-        
-        serviceEvent.session = serviceSession;
-        serviceEvent.attributes = mutableAttributesDic;
-        serviceEvent.metrics = mutableMetricsDic;
-        
-        //process others
-        serviceEvent.eventType = sourceEventDict[@"event_type"];
-        serviceEvent.timestamp = sourceEventDict[@"timestamp"];
-        
-        [parsedEventsArray addObject:serviceEvent];
+- (NSData *)requestBodyForEncodedEvents:(NSArray *)encodedEvents {
+    NSUInteger length = [AWSMobileAnalyticsDefaultDeliveryClientBodyPrefix length] + [AWSMobileAnalyticsDefaultDeliveryClientBodySuffix length];
+    for (NSData *encodedEvent in encodedEvents) {
+        length += [encodedEvent length] + 1;
     }
-    putEventInput.events = parsedEventsArray;
-    
-    return putEventInput;
+
+    NSMutableData *body = [NSMutableData dataWithCapacity:length];
+    [body appendData:[AWSMobileAnalyticsDefaultDeliveryClientBodyPrefix dataUsingEncoding:NSUTF8StringEncoding]];
+    [encodedEvents enumerateObjectsUsingBlock:^(NSData *encodedEvent, NSUInteger idx, BOOL *stop) {
+        if (idx > 0) {
+            [body appendBytes:"," length:1];
+        }
+        [body appendData:encodedEvent];
+    }];
+    [body appendData:[AWSMobileAnalyticsDefaultDeliveryClientBodySuffix dataUsingEncoding:NSUTF8StringEncoding]];
+
+    return body;
+}
+
+- (NSData *)encodedEventForEvent:(NSString *)event {
+    NSDictionary *sourceEventDict = [NSJSONSerialization JSONObjectWithData:[event dataUsingEncoding:NSUTF8StringEncoding] options:kNilOptions error:NULL];
+    if (![sourceEventDict isKindOfClass:[NSDictionary class]]) {
+        return nil;
+    }
+
+    NSMutableDictionary *serviceEvent = [NSMutableDictionary dictionary];
+    NSMutableDictionary *serviceSession = [NSMutableDictionary dictionary];
+
+    //process the attributes
+    NSMutableDictionary *mutableAttributesDic = [sourceEventDict[@"attributes"] mutableCopy];
+    [mutableAttributesDic removeObjectForKey:@""]; //Clean out invalid empty keys that may have been previously set
+    NSMutableDictionary *mutableMetricsDic = [sourceEventDict[@"metrics"] mutableCopy];
+    [mutableMetricsDic removeObjectForKey:@""]; //Clean out invalid empty keys that may have been previously set
+    serviceEvent[@"version"] = mutableAttributesDic[@"ver"];
+    [mutableAttributesDic removeObjectForKey:@"ver"];
+
+    serviceSession[@"id"] = mutableAttributesDic[AWSSessionIDAttributeKey];
+    [mutableAttributesDic removeObjectForKey:AWSSessionIDAttributeKey];
+
+    serviceSession[@"startTimestamp"] = mutableAttributesDic[AWSSessionStartTimeAttributeKey];
+    [mutableAttributesDic removeObjectForKey:AWSSessionStartTimeAttributeKey];
+
+    //move sessionStop time attribute session section
+    serviceSession[@"stopTimestamp"] = mutableAttributesDic[AWSSessionEndTimeAttributeKey];
+    [mutableAttributesDic removeObjectForKey:AWSSessionEndTimeAttributeKey];
+
+    //move session duration Time metrics to session section
+    serviceSession[@"duration"] = mutableMetricsDic[AWSSessionDurationMetricKey];
+    [mutableMetricsDic removeObjectForKey:AWSSessionDurationMetricKey];
+
+    serviceEvent[@"session"] = serviceSession;
+    serviceEvent[@"attributes"] = mutableAttributesDic;
+    serviceEvent[@"metrics"] = mutableMetricsDic;
+
+    //process others
+    serviceEvent[@"eventType"] = sourceEventDict[@"event_type"];
+    serviceEvent[@"timestamp"] = sourceEventDict[@"timestamp"];
+
+    return [NSJSONSerialization dataWithJSONObject:serviceEvent options:kNilOptions error:NULL];
 }
 
 
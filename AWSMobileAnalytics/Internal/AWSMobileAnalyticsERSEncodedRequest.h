@@ -0,0 +1,38 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import "AWSMobileAnalyticsERSService.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface AWSMobileAnalyticsERS (EncodedRequest)
+
+/**
+ Records a batch of events whose `PutEventsInput` JSON body has already been encoded by the caller. The body is sent as is, and `contentEncoding`, when set, is sent as the `Content-Encoding` header so that a gzipped body can be passed straight through.
+
+ @param body The encoded request body.
+ @param contentEncoding The encoding applied to `body`, e.g. `gzip`, or `nil` for an identity encoded body.
+ @param clientContext The client context JSON string sent in the `x-amz-Client-Context` header.
+
+ @return An instance of `AWSTask`. On successful execution, `task.result` will be `nil`. On failed execution, `task.error` may contain an `NSError` with `AWSMobileAnalyticsERSErrorDomain` domain and the following error code: `AWSMobileAnalyticsERSErrorBadRequest`.
+ */
+- (AWSTask *)putEventsWithEncodedBody:(NSData *)body
+                      contentEncoding:(nullable NSString *)contentEncoding
+                        clientContext:(nullable NSString *)clientContext;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -23,7 +23,14 @@
 
 FOUNDATION_EXPORT NSString * const AWSEventsDirectoryName;
 FOUNDATION_EXPORT NSString * const AWSEventsFilename;
-
+FOUNDATION_EXPORT NSString * const AWSEventsCursorFilename;
+
+/**
+ * Stores events as an append-only log split into segment files. Events are appended to the active segment,
+ * `eventsFile`, through a long-lived writer; once it reaches `eventsSegmentSize` it is sealed by renaming it to
+ * `eventsFile.<segment>`. The read cursor, a segment and a line within it, is persisted in `eventsFile.cursor`,
+ * and removing read events advances it and deletes the segments it has moved past.
+ */
 @interface AWSMobileAnalyticsFileEventStore : NSObject<AWSMobileAnalyticsEventStore>
  
 +(AWSMobileAnalyticsFileEventStore *) fileStoreWithContext:(id<AWSMobileAnalyticsContext>) theContext;
@@ -36,10 +43,23 @@ FOUNDATION_EXPORT NSString * const AWSEventsFilename;
 
 @property (nonatomic, readwrite) id<AWSMobileAnalyticsContext> context;
 
+/**
+ * The active segment.
+ */
 @property (nonatomic, readwrite) AWSMobileAnalyticsFile *eventsFile;
 
 @property (nonatomic, readwrite) NSRecursiveLock *lock;
 
+/**
+ * The number of bytes held by all segments, including events that were read but not yet removed.
+ */
+@property (nonatomic, readonly) unsigned long long storedBytes;
+
+/**
+ * The number of bytes read from and written to the segment and cursor files since the store was created.
+ */
+@property (nonatomic, readonly) unsigned long long bytesRead;
+@property (nonatomic, readonly) unsigned long long bytesWritten;
 
 @end
 
@@ -57,7 +77,19 @@ FOUNDATION_EXPORT NSString * const AWSEventsFilename;
 
 @property (nonatomic, readwrite) AWSMobileAnalyticsFileEventStore *eventStore;
 
-@property (nonatomic, readwrite) int linesRead;
+/**
+ * The position of the reader: the segment it reads and the number of lines read from it.
+ */
+@property (nonatomic, readwrite) uint64_t segment;
+
+@property (nonatomic, readwrite) NSUInteger linesRead;
+
+/**
+ * The position just past the last event returned by `next`, which `removeReadEvents` removes up to.
+ */
+@property (nonatomic, readwrite) uint64_t consumedSegment;
+
+@property (nonatomic, readwrite) NSUInteger consumedLines;
 
 @property (nonatomic, readwrite) NSString* nextBuffer;
 
@@ -18,6 +18,26 @@
 
 NSString * const AWSEventsDirectoryName = @"events";
 NSString * const AWSEventsFilename = @"eventsFile";
+NSString * const AWSEventsCursorFilename = @"eventsFile.cursor";
+NSString * const AWSEventsCursorSegmentKey = @"segment";
+NSString * const AWSEventsCursorLinesKey = @"lines";
+
+@interface AWSMobileAnalyticsFileEventStore()
+
+@property (nonatomic, readwrite) AWSMobileAnalyticsWriter *writer;
+@property (nonatomic, readwrite) AWSMobileAnalyticsFile *cursorFile;
+// The sealed segments in ascending order.
+@property (nonatomic, readwrite) NSMutableArray<NSNumber *> *sealedSegments;
+@property (nonatomic, readwrite) uint64_t activeSegment;
+@property (nonatomic, readwrite) NSUInteger activeLineCount;
+@property (nonatomic, readwrite) unsigned long long activeBytes;
+@property (nonatomic, readwrite) uint64_t cursorSegment;
+@property (nonatomic, readwrite) NSUInteger cursorLines;
+@property (nonatomic, readwrite) unsigned long long storedBytes;
+@property (nonatomic, readwrite) unsigned long long bytesRead;
+@property (nonatomic, readwrite) unsigned long long bytesWritten;
+
+@end
 
 @implementation AWSMobileAnalyticsFileEventStore
 
@@ -71,7 +91,14 @@ NSString * const AWSEventsFilename = @"eventsFile";
             return nil;
         }
         
-       
+        self.cursorFile = [fileManager createFileWithPath:[AWSEventsDirectoryName stringByAppendingPathComponent:AWSEventsCursorFilename] error:&error];
+        if(error != nil || self.cursorFile == nil)
+        {
+            AWSDDLogError( @"Unable to open events cursor file - An error occurred while attempting to create/open the events cursor file. Error: %@", [error localizedDescription]);
+            return nil;
+        }
+        
+        [self recoverSegments];
     }
     return self;
 }
@@ -81,25 +108,262 @@ NSString * const AWSEventsFilename = @"eventsFile";
     return [AWSEventsDirectoryName stringByAppendingPathComponent:AWSEventsFilename];
 }
 
+-(NSString *) filenameForSegment:(uint64_t) theSegment
+{
+    return [NSString stringWithFormat:@"%@.%llu", AWSEventsFilename, theSegment];
+}
+
+// Rebuilds the segment state from the events directory, undoing whatever an interrupted write or removal left behind:
+// a torn line at the end of the active segment is truncated, and segments the cursor has moved past are deleted.
+-(void) recoverSegments
+{
+    id<AWSMobileAnalyticsFileManager> fileManager = self.context.system.fileManager;
+    NSString *sealedPrefix = [AWSEventsFilename stringByAppendingString:@"."];
+    NSMutableArray<NSNumber *> *sealedSegments = [NSMutableArray array];
+    for(AWSMobileAnalyticsFile *file in [fileManager listFilesInDirectoryWithPath:AWSEventsDirectoryName error:nil])
+    {
+        if(![file.fileName hasPrefix:sealedPrefix])
+        {
+            continue;
+        }
+        NSScanner *scanner = [NSScanner scannerWithString:[file.fileName substringFromIndex:[sealedPrefix length]]];
+        unsigned long long segment = 0;
+        if([scanner scanUnsignedLongLong:&segment] && [scanner isAtEnd])
+        {
+            [sealedSegments addObject:@(segment)];
+        }
+    }
+    [sealedSegments sortUsingSelector:@selector(compare:)];
+    self.sealedSegments = sealedSegments;
+    self.activeSegment = [sealedSegments count] > 0 ? [[sealedSegments lastObject] unsignedLongLongValue] + 1 : 0;
+    
+    uint64_t cursorSegment = 0;
+    NSUInteger cursorLines = 0;
+    if([self readCursorSegment:&cursorSegment lines:&cursorLines])
+    {
+        self.activeSegment = MAX(self.activeSegment, cursorSegment);
+        if(cursorSegment != self.activeSegment && ![sealedSegments containsObject:@(cursorSegment)])
+        {
+            cursorSegment = [self segmentAfter:cursorSegment];
+            cursorLines = 0;
+        }
+    }
+    else
+    {
+        cursorSegment = [sealedSegments count] > 0 ? [[sealedSegments firstObject] unsignedLongLongValue] : self.activeSegment;
+        cursorLines = 0;
+    }
+    
+    [self repairActiveSegment];
+    if(cursorSegment == self.activeSegment && cursorLines > self.activeLineCount)
+    {
+        cursorLines = self.activeLineCount;
+    }
+    self.cursorSegment = cursorSegment;
+    self.cursorLines = cursorLines;
+    
+    self.storedBytes = self.activeBytes;
+    for(NSNumber *segment in [sealedSegments copy])
+    {
+        AWSMobileAnalyticsFile *segmentFile = [self fileForSegment:[segment unsignedLongLongValue]];
+        if([segment unsignedLongLongValue] < cursorSegment)
+        {
+            [self deleteSegmentFile:segmentFile];
+            [self.sealedSegments removeObject:segment];
+        }
+        else if(segmentFile != nil)
+        {
+            self.storedBytes += [segmentFile length];
+        }
+    }
+}
+
+// Truncates the active segment after its last complete line and counts the lines the buffered reader will see in it.
+-(void) repairActiveSegment
+{
+    NSError *error = nil;
+    NSData *data = [NSData dataWithContentsOfFile:self.eventsFile.absolutePath options:NSDataReadingMappedIfSafe error:&error];
+    if(data == nil)
+    {
+        AWSDDLogError( @"Unable to read the events file. Error: %@", [error localizedDescription]);
+        self.activeLineCount = 0;
+        self.activeBytes = 0;
+        return;
+    }
+    
+    const char *bytes = [data bytes];
+    NSUInteger length = [data length];
+    while(length > 0 && bytes[length - 1] != '\n')
+    {
+        length--;
+    }
+    if(length < [data length])
+    {
+        AWSDDLogWarn( @"Truncating %lu bytes of an incomplete event at the end of the events file.", (unsigned long)([data length] - length));
+        @try
+        {
+            NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingAtPath:self.eventsFile.absolutePath];
+            [fileHandle truncateFileAtOffset:length];
+            [fileHandle closeFile];
+        }
+        @catch(NSException *exception)
+        {
+            AWSDDLogError( @"Unable to truncate the events file. Exception: %@", exception);
+        }
+    }
+    
+    NSString *contents = [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+    self.activeLineCount = contents != nil ? [self lineCountOfString:contents] : 0;
+    self.activeBytes = length;
+    self.bytesRead += [data length];
+}
+
+// The number of lines the buffered reader splits `theString` into, which ends every line at any newline character.
+-(NSUInteger) lineCountOfString:(NSString *) theString
+{
+    NSCharacterSet *newlineCharacterSet = [NSCharacterSet newlineCharacterSet];
+    NSUInteger lineCount = 0;
+    NSRange searchRange = NSMakeRange(0, [theString length]);
+    NSRange newlineRange = [theString rangeOfCharacterFromSet:newlineCharacterSet options:0 range:searchRange];
+    while(newlineRange.location != NSNotFound)
+    {
+        lineCount++;
+        searchRange = NSMakeRange(NSMaxRange(newlineRange), [theString length] - NSMaxRange(newlineRange));
+        newlineRange = [theString rangeOfCharacterFromSet:newlineCharacterSet options:0 range:searchRange];
+    }
+    return lineCount;
+}
+
+-(BOOL) readCursorSegment:(uint64_t *) theSegment lines:(NSUInteger *) theLines
+{
+    NSData *data = [NSData dataWithContentsOfFile:self.cursorFile.absolutePath];
+    if([data length] == 0)
+    {
+        return NO;
+    }
+    self.bytesRead += [data length];
+    NSDictionary *cursor = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+    if(![cursor isKindOfClass:[NSDictionary class]]
+       || ![cursor[AWSEventsCursorSegmentKey] isKindOfClass:[NSNumber class]]
+       || ![cursor[AWSEventsCursorLinesKey] isKindOfClass:[NSNumber class]])
+    {
+        AWSDDLogError( @"The events cursor file is corrupted. Reading events from the oldest segment.");
+        return NO;
+    }
+    *theSegment = [cursor[AWSEventsCursorSegmentKey] unsignedLongLongValue];
+    *theLines = [cursor[AWSEventsCursorLinesKey] unsignedIntegerValue];
+    return YES;
+}
+
+-(BOOL) writeCursor
+{
+    NSDictionary *cursor = @{AWSEventsCursorSegmentKey : @(self.cursorSegment),
+                             AWSEventsCursorLinesKey : @(self.cursorLines)};
+    NSData *data = [NSJSONSerialization dataWithJSONObject:cursor options:0 error:nil];
+    // Written atomically so that a crash leaves either the old or the new cursor behind.
+    if(![data writeToFile:self.cursorFile.absolutePath atomically:YES])
+    {
+        AWSDDLogError( @"Failed to write the events cursor file.");
+        return NO;
+    }
+    self.bytesWritten += [data length];
+    return YES;
+}
+
+// The segment file, or nil if it does not exist.
+-(AWSMobileAnalyticsFile *) fileForSegment:(uint64_t) theSegment
+{
+    if(theSegment == self.activeSegment)
+    {
+        return self.eventsFile;
+    }
+    if(![self.sealedSegments containsObject:@(theSegment)])
+    {
+        return nil;
+    }
+    NSError *error = nil;
+    return [self.context.system.fileManager createFileWithPath:[AWSEventsDirectoryName stringByAppendingPathComponent:[self filenameForSegment:theSegment]]
+                                                         error:&error];
+}
+
+// The first segment after `theSegment`, which is the active segment if no sealed segment follows it.
+-(uint64_t) segmentAfter:(uint64_t) theSegment
+{
+    for(NSNumber *segment in self.sealedSegments)
+    {
+        if([segment unsignedLongLongValue] > theSegment)
+        {
+            return [segment unsignedLongLongValue];
+        }
+    }
+    return self.activeSegment;
+}
+
+-(void) deleteSegmentFile:(AWSMobileAnalyticsFile *) theSegmentFile
+{
+    if(theSegmentFile == nil)
+    {
+        return;
+    }
+    unsigned long long length = [theSegmentFile length];
+    if([theSegmentFile deleteFile])
+    {
+        self.storedBytes -= MIN(self.storedBytes, length);
+    }
+    else
+    {
+        AWSDDLogError( @"Failed to delete the consumed events segment %@", theSegmentFile.fileName);
+    }
+}
+
 -(BOOL) put:(NSString *) theEvent withError:(NSError **) theError
 {
     
     NSError *error = nil;
-    AWSMobileAnalyticsWriter *writer = nil;
     [self.lock lock];
     @try
     {
-        [self tryInitializeWriter:&writer error:&error];
-        if(error != nil || writer == nil)
+        if(self.writer == nil)
         {
-            AWSDDLogError( @"Unable to write event to file - There was an error while attempting to create the writer. Error: %@", [error localizedDescription]);
-            [AWSMobileAnalyticsErrorUtils safeSetError:theError withError:error];
-            return NO;
+            AWSMobileAnalyticsWriter *writer = nil;
+            [self tryInitializeWriter:&writer error:&error];
+            if(error != nil || writer == nil)
+            {
+                AWSDDLogError( @"Unable to write event to file - There was an error while attempting to create the writer. Error: %@", [error localizedDescription]);
+                [AWSMobileAnalyticsErrorUtils safeSetError:theError withError:error];
+                return NO;
+            }
+            self.writer = writer;
         }
         int maxStorageSize = [self.context.configuration intForKey:AWSKeyMaxStorageSize withOptValue:AWSValueMaxStorageSize];
-        if([theEvent length] + [self.eventsFile length] <= maxStorageSize)
+        if([theEvent length] == 0)
         {
-            [writer writeLine:theEvent error:&error];
+            AWSDDLogWarn( @"Skipping an empty event.");
+        }
+        else if([theEvent length] + self.storedBytes <= maxStorageSize)
+        {
+            // Every line ends with '\n', so that a torn write is always detectable at the end of the segment.
+            NSString *line = [theEvent hasSuffix:@"\n"] ? theEvent : [theEvent stringByAppendingString:@"\n"];
+            if([self.writer write:line error:&error])
+            {
+                unsigned long long lineBytes = [line lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+                self.activeBytes += lineBytes;
+                self.storedBytes += lineBytes;
+                self.bytesWritten += lineBytes;
+                self.activeLineCount += [self lineCountOfString:line];
+                
+                int segmentSize = [self.context.configuration intForKey:AWSKeyEventsSegmentSize withOptValue:AWSValueEventsSegmentSize];
+                if(self.activeBytes >= segmentSize)
+                {
+                    [self sealActiveSegment];
+                }
+            }
+            else
+            {
+                // Reopens the writer for the next event.
+                [self.writer close];
+                self.writer = nil;
+            }
         }
         else
         {
@@ -110,7 +374,6 @@ NSString * const AWSEventsFilename = @"eventsFile";
         {
             AWSDDLogError( @"Unable to write event to file - There was an error while attempting to write to the writer. Error: %@", [error localizedDescription]);
         }
-        [writer close];
     }
     @finally
     {
@@ -127,6 +390,10 @@ NSString * const AWSEventsFilename = @"eventsFile";
     NSError *error = nil;
     *theWriter = nil;
     NSOutputStream *stream = [self.context.system.fileManager newOutputStream:self.eventsFile appendMode:YES error:&error];
+    if(error == nil && [stream streamStatus] == NSStreamStatusError)
+    {
+        error = [stream streamError];
+    }
     AWSMobileAnalyticsWriter *writer = [AWSMobileAnalyticsWriter writerWithOutputStream:stream];
     if(error != nil)
     {
@@ -139,88 +406,95 @@ NSString * const AWSEventsFilename = @"eventsFile";
     }
 }
 
+// Renames the active segment to its sealed name and starts a new, empty active segment.
+-(BOOL) sealActiveSegment
+{
+    [self.writer close];
+    self.writer = nil;
+    
+    if(![self.eventsFile renameTo:[self filenameForSegment:self.activeSegment]])
+    {
+        AWSDDLogError( @"Failed to seal the events file.");
+        return NO;
+    }
+    [self.sealedSegments addObject:@(self.activeSegment)];
+    self.activeSegment += 1;
+    self.activeLineCount = 0;
+    self.activeBytes = 0;
+    
+    NSError *error = nil;
+    AWSMobileAnalyticsFile *eventsFile = [self.context.system.fileManager createFileWithPath:self.eventsFileName error:&error];
+    if(error != nil || eventsFile == nil)
+    {
+        AWSDDLogError( @"Unable to create a new events file. Error: %@", [error localizedDescription]);
+    }
+    else
+    {
+        self.eventsFile = eventsFile;
+    }
+    return YES;
+}
+
 -(id<AWSMobileAnalyticsEventIterator>) iterator
 {
     return [[AWSFileEventIterator alloc] initFileStore:self];
 }
 
--(AWSMobileAnalyticsFile *) deleteReadEvents:(int) theLineNumber
+// Moves the persisted cursor forward to `theLines` lines into `theSegment` and deletes the segments before it. A fully
+// read active segment is sealed first, so that it can be deleted without rewriting anything.
+-(void) removeEventsBeforeSegment:(uint64_t) theSegment lines:(NSUInteger) theLines
 {
-    //Write all events after line number to a temporary file
-    id<AWSMobileAnalyticsFileManager> fileManager = self.context.system.fileManager;
-    AWSMobileAnalyticsFile *origEventsFile = self.eventsFile;
-
-    NSError *error = nil;
-    AWSMobileAnalyticsFile *tempEventsFile = [fileManager createFileWithPath:[self.eventsFileName stringByAppendingString:@".tmp"] error:&error];
-    if(error != nil || tempEventsFile == nil || ![tempEventsFile exists])
-    {
-        AWSDDLogError( @"There was an error while attempting to create temporary events file. Error: %@", [error localizedDescription]);
-        return self.eventsFile;
-    }
-    
-    if([origEventsFile exists])
+    [self.lock lock];
+    @try
     {
-        NSInputStream *inStream = [fileManager newInputStream:origEventsFile error:&error];
-        AWSMobileAnalyticsBufferedReader *reader = [AWSMobileAnalyticsBufferedReader readerWithInputStream:inStream];
-        
-        NSOutputStream *outStream = [fileManager newOutputStream:tempEventsFile appendMode:YES error:&error];
-        AWSMobileAnalyticsWriter *writer = [AWSMobileAnalyticsWriter writerWithOutputStream:outStream];
-
-        if(error == nil)
+        if(theSegment < self.cursorSegment || (theSegment == self.cursorSegment && theLines <= self.cursorLines))
         {
-            NSString *line = nil;
-            int currentLineNumber = 0;
-            while ([reader readLine:&line withError:&error] && line != nil && error == nil)
+            return;
+        }
+        if(theSegment == self.activeSegment && theLines >= self.activeLineCount && self.activeLineCount > 0)
+        {
+            if([self sealActiveSegment])
             {
-                currentLineNumber++;
-                if (currentLineNumber > theLineNumber)
-                {
-                    [writer writeLine:line error:&error];
-                    if(error != nil)
-                    {
-                        break;
-                    }
-                }
+                theSegment = self.activeSegment;
+                theLines = 0;
             }
-            [writer close];
-            [reader close];
         }
         
-        if(error == nil)
+        self.cursorSegment = theSegment;
+        self.cursorLines = theLines;
+        if(![self writeCursor])
         {
-            if([origEventsFile deleteFile])
-            {
-                if([tempEventsFile renameTo:AWSEventsFilename])
-                {
-                    self.eventsFile = [fileManager createFileWithPath:self.eventsFileName error:&error];
-                }
-                else
-                {
-                    AWSDDLogError( @"Failed to rename temp file to events file");
-                }
-            }
-            else
-            {
-                AWSDDLogError( @"Failed to delete previous events file");
-            }
+            return;
         }
-        else
+        
+        for(NSNumber *segment in [self.sealedSegments copy])
         {
-            if([tempEventsFile exists] && [tempEventsFile length] == 0)
+            if([segment unsignedLongLongValue] >= theSegment)
             {
-                if(![tempEventsFile deleteFile])
-                {
-                    AWSDDLogError( @"Failed to delete the empty temp events file");
-                }
+                break;
             }
+            [self deleteSegmentFile:[self fileForSegment:[segment unsignedLongLongValue]]];
+            [self.sealedSegments removeObject:segment];
         }
     }
-
-    return self.eventsFile;
+    @finally
+    {
+        [self.lock unlock];
+    }
 }
 
 @end
 
+@interface AWSFileEventIterator()
+
+// Whether the segment was already sealed when the reader was opened, so that its end is the end of the segment.
+@property (nonatomic, readwrite) BOOL isReadingSealedSegment;
+// The position just past the buffered event.
+@property (nonatomic, readwrite) uint64_t nextBufferSegment;
+@property (nonatomic, readwrite) NSUInteger nextBufferLines;
+
+@end
+
 @implementation AWSFileEventIterator
 
 -(id) initFileStore:(AWSMobileAnalyticsFileEventStore *) theEventStore
@@ -228,7 +502,18 @@ NSString * const AWSEventsFilename = @"eventsFile";
     if(self = [super init])
     {
         self.eventStore = theEventStore;
-        self.linesRead = 0;
+        [self.eventStore.lock lock];
+        @try
+        {
+            self.segment = self.eventStore.cursorSegment;
+            self.linesRead = self.eventStore.cursorLines;
+        }
+        @finally
+        {
+            [self.eventStore.lock unlock];
+        }
+        self.consumedSegment = self.segment;
+        self.consumedLines = self.linesRead;
         self.nextBuffer = nil;
         self.reader = nil;
         self.isEndOfFile = NO;
@@ -243,11 +528,19 @@ NSString * const AWSEventsFilename = @"eventsFile";
         return YES;
     }
     
-    if(!self.isEndOfFile)
+    while(!self.isEndOfFile)
     {
+        AWSMobileAnalyticsFile *segmentFile = [self.eventStore fileForSegment:self.segment];
+        if(segmentFile == nil)
+        {
+            // The segment was removed through another iterator.
+            [self moveToSegment:[self.eventStore segmentAfter:self.segment]];
+            continue;
+        }
+        
         NSError *error;
         id<AWSMobileAnalyticsFileManager> fileManager = self.eventStore.context.system.fileManager;
-        NSInputStream *inputStream = [fileManager newInputStream:self.eventStore.eventsFile error:&error];
+        NSInputStream *inputStream = [fileManager newInputStream:segmentFile error:&error];
         
         if(error != nil || inputStream == nil)
         {
@@ -256,6 +549,15 @@ NSString * const AWSEventsFilename = @"eventsFile";
         }
         
         AWSMobileAnalyticsBufferedReader *bufferedReader = [AWSMobileAnalyticsBufferedReader readerWithInputStream:inputStream];
+        self.isReadingSealedSegment = self.segment != self.eventStore.activeSegment;
+        
+        // Skips the lines of the segment that were already read.
+        for(NSUInteger line = 0; line < self.linesRead; line++)
+        {
+            NSString *skippedLine = nil;
+            [bufferedReader readLine:&skippedLine withError:nil];
+            self.eventStore.bytesRead += [skippedLine lengthOfBytesUsingEncoding:NSUTF8StringEncoding] + 1;
+        }
         
         self.reader = bufferedReader;
         
@@ -264,6 +566,17 @@ NSString * const AWSEventsFilename = @"eventsFile";
     return NO;
 }
 
+-(void) moveToSegment:(uint64_t) theSegment
+{
+    if(theSegment == self.segment)
+    {
+        self.isEndOfFile = YES;
+        return;
+    }
+    self.segment = theSegment;
+    self.linesRead = 0;
+}
+
 -(void) tryCloseReader
 {
     if(self.reader != nil) {
@@ -285,7 +598,7 @@ NSString * const AWSEventsFilename = @"eventsFile";
     [self.eventStore.lock lock];
     @try
     {
-        [self.eventStore deleteReadEvents:self.linesRead];
+        [self.eventStore removeEventsBeforeSegment:self.consumedSegment lines:self.consumedLines];
         [self resetReader];
     }
     @finally
@@ -302,61 +615,13 @@ NSString * const AWSEventsFilename = @"eventsFile";
 
 -(BOOL) hasNext
 {
-    BOOL hasNext = NO;
-    
-    //If there is something already buffered then there is a next
-    if(self.nextBuffer != nil) {
-        hasNext = YES;
-    } else {
-        [self.eventStore.lock lock];
-        @try
-        {
-            if(![self tryOpenReader])
-            {
-                return hasNext;
-            }
-            //Nothing was previously buffered so try to read one more line
-            BOOL found = NO;
-            while(!found)
-            {
-                NSString *line = nil;
-                NSError *error = nil;
-                BOOL success = [self.reader readLine:&line withError:&error];
-                
-                if(success)
-                {
-                    self.nextBuffer = line;
-                    found = YES;
-                }
-                else if(error)
-                {
-                    self.linesRead++;
-                    found = NO;
-                }
-                else
-                {
-                    self.nextBuffer = nil;
-                    found = YES;
-                }
-            }
-            if(self.nextBuffer != nil)
-            {
-                //There was at least one more line so there is a next
-                hasNext = YES;
-            }
-            else
-            {
-                //The next line was nil so it should be the end of the file. Try to close the reader
-                self.isEndOfFile = YES;
-                [self tryCloseReader];
-            }
-        }
-        @finally
-        {
-            [self.eventStore.lock unlock];
-        }
+    if(self.nextBuffer == nil)
+    {
+        self.nextBuffer = [self readLine];
+        self.nextBufferSegment = self.segment;
+        self.nextBufferLines = self.linesRead;
     }
-    return hasNext;
+    return self.nextBuffer != nil;
 }
 
 -(NSString *) next
@@ -366,63 +631,76 @@ NSString * const AWSEventsFilename = @"eventsFile";
     if(self.nextBuffer != nil)
     {
         next = self.nextBuffer;
-        self.linesRead++;
+        self.consumedSegment = self.nextBufferSegment;
+        self.consumedLines = self.nextBufferLines;
         self.nextBuffer = nil;
     }
     else
     {
-        [self.eventStore.lock lock];
-        @try
+        next = [self readLine];
+        if(next != nil)
         {
-            if(![self tryOpenReader]) {
-                return next;
-            }
-            BOOL found = NO;
-            while(!found) {
-                NSString *line = nil;
-                NSError *error = nil;
-                BOOL success = [self.reader readLine:&line withError:&error];
-                
-                if(success)
-                {
-                    next = line;
-                    found = YES;
-                }
-                else if(error)
-                {
-                    self.linesRead++;
-                    found = NO;
-                }
-                else
-                {
-                    next = nil;
-                    found = YES;
-                }
-            }
+            self.consumedSegment = self.segment;
+            self.consumedLines = self.linesRead;
+        }
+    }
+    
+    return next;
+}
+
+// Reads the next line, moving on to the following segment at the end of a sealed one. Lines that cannot be read are
+// skipped.
+-(NSString *) readLine
+{
+    NSString *next = nil;
+    [self.eventStore.lock lock];
+    @try
+    {
+        while(next == nil && [self tryOpenReader])
+        {
+            NSString *line = nil;
+            NSError *error = nil;
+            BOOL success = [self.reader readLine:&line withError:&error];
             
-            if(next != nil)
+            if(success && line != nil)
+            {
+                self.linesRead++;
+                self.eventStore.bytesRead += [line lengthOfBytesUsingEncoding:NSUTF8StringEncoding] + 1;
+                next = line;
+            }
+            else if(error)
             {
                 self.linesRead++;
             }
             else
             {
-                self.isEndOfFile = true;
+                //The end of the segment. Move on if the segment is sealed, reading it again if it was sealed while read.
                 [self tryCloseReader];
+                if(self.segment == self.eventStore.activeSegment)
+                {
+                    self.isEndOfFile = YES;
+                }
+                else if(self.isReadingSealedSegment)
+                {
+                    [self moveToSegment:[self.eventStore segmentAfter:self.segment]];
+                }
             }
         }
-        @finally
-        {
-            [self.eventStore.lock unlock];
-        }
     }
-    
+    @finally
+    {
+        [self.eventStore.lock unlock];
+    }
     return next;
 }
 
 -(void) resetReader
 {
     [self tryCloseReader];
-    self.linesRead = 0;
+    self.segment = self.eventStore.cursorSegment;
+    self.linesRead = self.eventStore.cursorLines;
+    self.consumedSegment = self.segment;
+    self.consumedLines = self.linesRead;
     self.nextBuffer = nil;
 }
 
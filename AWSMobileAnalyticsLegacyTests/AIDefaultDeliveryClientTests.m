@@ -0,0 +1,246 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import "AIDefaultDeliveryClientTests.h"
+#import "AWSMobileAnalyticsERSEncodedRequest.h"
+#import <AWSCore/AWSGZIP.h>
+
+static NSString *const APP_KEY = @"app_key";
+static NSString *const PRIVATE_KEY = @"private_key";
+static NSString *const UNIQUE_ID = @"BEEFBEEF-BEEF-BEEF-BEEF-BEEFBEEFBEEF";
+static NSString *const SDK_NAME = @"MobileAnalyticsSDK-IOS";
+static NSString *const SDK_VERSION = @"2.0.dev-build";
+
+@interface AWSMobileAnalyticsIOSSystem(Testing)
+
++ (NSString *) rootFileDirectoryWithFileManager:(NSFileManager *) theFileManager;
+
+@end
+
+@interface AWSMobileAnalyticsDefaultDeliveryClient()
+
+@property (nonatomic, strong) id<AWSMobileAnalyticsEventStore> eventStore;
+
+- (void)attemptDeliveryUsingPolicies:(NSArray*)policies;
+- (void)waitForDeliveryOperations;
+- (NSData *)encodedEventForEvent:(NSString *)event;
+- (NSData *)requestBodyForEncodedEvents:(NSArray *)encodedEvents;
+
+@end
+
+@interface AIDefaultDeliveryClientTestsERSStub : NSObject
+
+@property (nonatomic, strong) NSMutableArray *bodies;
+@property (nonatomic, strong) NSMutableArray *contentEncodings;
+
+@end
+
+@implementation AIDefaultDeliveryClientTestsERSStub
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _bodies = [NSMutableArray array];
+        _contentEncodings = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (AWSTask *)putEventsWithEncodedBody:(NSData *)body
+                      contentEncoding:(NSString *)contentEncoding
+                        clientContext:(NSString *)clientContext {
+    [self.bodies addObject:body];
+    [self.contentEncodings addObject:contentEncoding ?: [NSNull null]];
+    return [AWSTask taskWithResult:@{@"responseStatusCode" : @202}];
+}
+
+@end
+
+@implementation AIDefaultDeliveryClientTests
+
+-(void) setUp
+{
+    [self tearDown];
+    self.system = [[AWSMobileAnalyticsIOSSystem alloc] initWithIdentifier:APP_KEY];
+}
+
+-(void) tearDown
+{
+    NSFileManager *internalFileManager = [NSFileManager defaultManager];
+    NSString *rootPath = [AWSMobileAnalyticsIOSSystem rootFileDirectoryWithFileManager:internalFileManager];
+    NSString *absolutePath = [rootPath stringByAppendingPathComponent:AWSMobileAnalyticsRoot];
+    
+    NSError *error;
+    [internalFileManager removeItemAtPath:absolutePath error:&error];
+}
+
+-(void) test_encodedEvent_movesSessionFieldsIntoSession
+{
+    AWSMobileAnalyticsDefaultDeliveryClient *deliveryClient = [self deliveryClientWithConfiguration:@{} ers:nil];
+    NSData *encodedEvent = [deliveryClient encodedEventForEvent:[self serializedEventWithIndex:7]];
+    NSDictionary *body = [NSJSONSerialization JSONObjectWithData:[deliveryClient requestBodyForEncodedEvents:@[encodedEvent, encodedEvent]]
+                                                         options:kNilOptions
+                                                           error:NULL];
+    
+    assertThatUnsignedInteger([body[@"events"] count], is(equalToUnsignedInteger(2)));
+    NSDictionary *event = [body[@"events"] firstObject];
+    assertThat(event[@"eventType"], is(equalTo(@"_custom.event7")));
+    assertThat(event[@"timestamp"], is(equalTo(@"2017-01-01T00:00:07.000Z")));
+    assertThat(event[@"version"], is(equalTo(@"v2.0")));
+    assertThat(event[@"session"][@"id"], is(equalTo(@"session-id")));
+    assertThat(event[@"session"][@"startTimestamp"], is(equalTo(@"2017-01-01T00:00:00.000Z")));
+    assertThat(event[@"session"][@"duration"], is(equalTo(@7)));
+    assertThat(event[@"attributes"], is(equalTo(@{@"screen" : @"screen-7"})));
+    assertThat(event[@"metrics"], is(equalTo(@{@"score" : @7})));
+    
+    assertThat([deliveryClient encodedEventForEvent:@"not json"], is(nilValue()));
+}
+
+-(void) test_attemptDelivery_sendsGzippedBatchesCappedByCompressedSize
+{
+    int maxSubmissionSize = 4 * 1024;
+    AIDefaultDeliveryClientTestsERSStub *ers = [AIDefaultDeliveryClientTestsERSStub new];
+    AWSMobileAnalyticsDefaultDeliveryClient *deliveryClient = [self deliveryClientWithConfiguration:@{@"maxSubmissionSize" : @(maxSubmissionSize),
+                                                                                                       @"maxSubmissionAllowed" : @100}
+                                                                                                 ers:ers];
+    int eventCount = 1000;
+    NSError *error = nil;
+    for(int i = 0; i < eventCount; i++) {
+        [deliveryClient.eventStore put:[self serializedEventWithIndex:i] withError:&error];
+    }
+    assertThat(error, is(nilValue()));
+    
+    [deliveryClient attemptDeliveryUsingPolicies:@[]];
+    [deliveryClient waitForDeliveryOperations];
+    
+    NSUInteger deliveredCount = 0;
+    NSUInteger uncompressedLength = 0;
+    for(NSUInteger i = 0; i < [ers.bodies count]; i++) {
+        NSData *body = ers.bodies[i];
+        assertThat(ers.contentEncodings[i], is(equalTo(@"gzip")));
+        assertThatUnsignedInteger([body length], is(lessThanOrEqualTo(@(maxSubmissionSize))));
+        
+        NSData *uncompressedBody = [body awsgzip_gunzippedData];
+        uncompressedLength += [uncompressedBody length];
+        NSDictionary *request = [NSJSONSerialization JSONObjectWithData:uncompressedBody options:kNilOptions error:NULL];
+        deliveredCount += [request[@"events"] count];
+    }
+    
+    assertThatUnsignedInteger(deliveredCount, is(equalToUnsignedInteger(eventCount)));
+    // Capping on the compressed size packs far more than maxSubmissionSize of events into each request.
+    assertThatUnsignedInteger(uncompressedLength / [ers.bodies count], is(greaterThan(@(maxSubmissionSize))));
+    assertThatBool([deliveryClient.eventStore.iterator hasNext], is(equalToBool(NO)));
+}
+
+-(void) test_attemptDelivery_compressionCanBeDisabled
+{
+    int maxSubmissionSize = 4 * 1024;
+    AIDefaultDeliveryClientTestsERSStub *ers = [AIDefaultDeliveryClientTestsERSStub new];
+    AWSMobileAnalyticsDefaultDeliveryClient *deliveryClient = [self deliveryClientWithConfiguration:@{@"maxSubmissionSize" : @(maxSubmissionSize),
+                                                                                                       @"maxSubmissionAllowed" : @100,
+                                                                                                       @"compressSubmissions" : @NO}
+                                                                                                 ers:ers];
+    NSError *error = nil;
+    for(int i = 0; i < 100; i++) {
+        [deliveryClient.eventStore put:[self serializedEventWithIndex:i] withError:&error];
+    }
+    
+    [deliveryClient attemptDeliveryUsingPolicies:@[]];
+    [deliveryClient waitForDeliveryOperations];
+    
+    NSUInteger deliveredCount = 0;
+    for(NSUInteger i = 0; i < [ers.bodies count]; i++) {
+        assertThat(ers.contentEncodings[i], is(equalTo([NSNull null])));
+        assertThatUnsignedInteger([ers.bodies[i] length], is(lessThanOrEqualTo(@(maxSubmissionSize))));
+        NSDictionary *request = [NSJSONSerialization JSONObjectWithData:ers.bodies[i] options:kNilOptions error:NULL];
+        deliveredCount += [request[@"events"] count];
+    }
+    assertThatUnsignedInteger(deliveredCount, is(equalToUnsignedInteger(100)));
+}
+
+-(void) test_attemptDelivery_benchmarkBytesOnTheWireAndCPUPer1000Events
+{
+    for(NSNumber *compress in @[@NO, @YES]) {
+        [self tearDown];
+        self.system = [[AWSMobileAnalyticsIOSSystem alloc] initWithIdentifier:APP_KEY];
+        AIDefaultDeliveryClientTestsERSStub *ers = [AIDefaultDeliveryClientTestsERSStub new];
+        AWSMobileAnalyticsDefaultDeliveryClient *deliveryClient = [self deliveryClientWithConfiguration:@{@"maxSubmissionAllowed" : @1000,
+                                                                                                           @"compressSubmissions" : compress}
+                                                                                                     ers:ers];
+        int eventCount = 10000;
+        NSError *error = nil;
+        for(int i = 0; i < eventCount; i++) {
+            [deliveryClient.eventStore put:[self serializedEventWithIndex:i] withError:&error];
+        }
+        
+        clock_t start = clock();
+        [deliveryClient attemptDeliveryUsingPolicies:@[]];
+        [deliveryClient waitForDeliveryOperations];
+        double cpuSeconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+        
+        NSUInteger wireBytes = 0;
+        for(NSData *body in ers.bodies) {
+            wireBytes += [body length];
+        }
+        NSLog(@"%@: %lu requests, %.0f bytes on the wire and %.3f ms of CPU per 1000 events.",
+              [compress boolValue] ? @"gzip" : @"identity",
+              (unsigned long)[ers.bodies count],
+              wireBytes * 1000.0 / eventCount,
+              cpuSeconds * 1000 * 1000 / eventCount);
+        assertThatBool([deliveryClient.eventStore.iterator hasNext], is(equalToBool(NO)));
+    }
+}
+
+-(AWSMobileAnalyticsDefaultDeliveryClient *) deliveryClientWithConfiguration:(NSDictionary *) theConfiguration
+                                                                          ers:(AIDefaultDeliveryClientTestsERSStub *) theERS
+{
+    NSMutableDictionary *configuration = [theConfiguration mutableCopy];
+    configuration[@"maxStorageSize"] = @(50 * 1024 * 1024);
+    
+    AIInsightsContextBuilder *builder = [[AIInsightsContextBuilder alloc] init];
+    [builder withAppKey:APP_KEY];
+    [builder withPrivateKey:PRIVATE_KEY];
+    [builder withUniqueId:UNIQUE_ID];
+    [builder withSdkName:SDK_NAME andSDKVersion:SDK_VERSION];
+    [builder withFileManager:self.system.fileManager];
+    [builder withConfiguration:[AITestConfiguration configurationWithDictionary:configuration]];
+    id<AWSMobileAnalyticsContext> context = [builder build];
+    
+    NSOperationQueue *queue = [NSOperationQueue new];
+    queue.maxConcurrentOperationCount = 1;
+    return [[AWSMobileAnalyticsDefaultDeliveryClient alloc] initWithConfiguration:context.configuration
+                                                             withLifeCycleManager:nil
+                                                                withPolicyFactory:nil
+                                                               withOperationQueue:queue
+                                                                   withEventStore:[AWSMobileAnalyticsFileEventStore fileStoreWithContext:context]
+                                                                   withSerializer:nil
+                                                                withClientContext:nil
+                                                                   withERSService:(AWSMobileAnalyticsERS *)theERS];
+}
+
+-(NSString *) serializedEventWithIndex:(int) theIndex
+{
+    NSDictionary *event = @{@"event_type" : [NSString stringWithFormat:@"_custom.event%d", theIndex % 10],
+                            @"timestamp" : [NSString stringWithFormat:@"2017-01-01T00:00:%02d.000Z", theIndex % 60],
+                            @"attributes" : @{@"ver" : @"v2.0",
+                                              @"_session.id" : @"session-id",
+                                              @"_session.startTime" : @"2017-01-01T00:00:00.000Z",
+                                              @"screen" : [NSString stringWithFormat:@"screen-%d", theIndex % 10]},
+                            @"metrics" : @{@"_session.duration" : @(theIndex),
+                                           @"score" : @(theIndex)}};
+    NSData *data = [NSJSONSerialization dataWithJSONObject:event options:kNilOptions error:NULL];
+    return [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+}
+
+@end
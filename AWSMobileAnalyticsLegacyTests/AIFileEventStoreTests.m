@@ -143,8 +143,7 @@ static NSString *const SDK_VERSION = @"2.0.dev-build";
         //If we read 5 events remove the 5 last read events
         if(counter % 5 == 0) {
             [iter removeReadEvents];
-            int lineNumber = [self getNumberOfLinesInFile:context.system.fileManager withFileName:[eventStore eventsFile]];
-            assertThatInt(lineNumber, is(equalToInt(10-counter)));
+            assertThatInt([self getNumberOfEventsInStore:eventStore], is(equalToInt(10-counter)));
         }
     }
     
@@ -310,6 +309,217 @@ static NSString *const SDK_VERSION = @"2.0.dev-build";
     }
 }
 
+-(id<AWSMobileAnalyticsContext>) contextWithConfiguration:(NSDictionary *) theConfiguration
+{
+    AIInsightsContextBuilder *builder = [[AIInsightsContextBuilder alloc] init];
+    [builder withAppKey:APP_KEY];
+    [builder withPrivateKey:PRIVATE_KEY];
+    [builder withUniqueId:UNIQUE_ID];
+    [builder withSdkName:SDK_NAME andSDKVersion:SDK_VERSION];
+    [builder withFileManager:self.system.fileManager];
+    [builder withConfiguration:[AITestConfiguration configurationWithDictionary:theConfiguration]];
+    return [builder build];
+}
+
+-(void) test_FileEventStore_eventsSpanSegmentsAndConsumedSegmentsAreDeleted
+{
+    // Three 11-byte events per segment.
+    id<AWSMobileAnalyticsContext> context = [self contextWithConfiguration:@{@"eventsSegmentSize" : @30}];
+    AWSMobileAnalyticsFileEventStore *eventStore = [AWSMobileAnalyticsFileEventStore fileStoreWithContext:context];
+    
+    NSError *error = nil;
+    for(int i = 0; i < 10; i++) {
+        [eventStore put:[NSString stringWithFormat:@"event-%04d", i] withError:&error];
+        assertThat(error, is(nilValue()));
+    }
+    NSString *eventsDirectory = [eventStore.eventsFile.absolutePath stringByDeletingLastPathComponent];
+    assertThatInt([self getNumberOfSegmentsInDirectory:eventsDirectory], is(equalToInt(4)));
+    assertThatUnsignedLongLong(eventStore.storedBytes, is(equalToUnsignedLongLong(110)));
+    
+    id<AWSMobileAnalyticsEventIterator> iter = eventStore.iterator;
+    for(int i = 0; i < 7; i++) {
+        assertThat([iter next], is(equalTo([NSString stringWithFormat:@"event-%04d", i])));
+    }
+    [iter removeReadEvents];
+    
+    // The two fully read segments are gone; the partially read one stays.
+    assertThatInt([self getNumberOfSegmentsInDirectory:eventsDirectory], is(equalToInt(2)));
+    assertThatUnsignedLongLong(eventStore.storedBytes, is(equalToUnsignedLongLong(44)));
+    for(int i = 7; i < 10; i++) {
+        assertThat([iter next], is(equalTo([NSString stringWithFormat:@"event-%04d", i])));
+    }
+    assertThat([iter next], is(nilValue()));
+    [iter removeReadEvents];
+    assertThatInt([self getNumberOfSegmentsInDirectory:eventsDirectory], is(equalToInt(1)));
+    assertThatUnsignedLongLong(eventStore.storedBytes, is(equalToUnsignedLongLong(0)));
+    assertThatBool([eventStore.iterator hasNext], is(equalToBool(NO)));
+}
+
+-(void) test_FileEventStore_readCursorSurvivesRestart
+{
+    id<AWSMobileAnalyticsContext> context = [self contextWithConfiguration:@{@"eventsSegmentSize" : @30}];
+    AWSMobileAnalyticsFileEventStore *eventStore = [AWSMobileAnalyticsFileEventStore fileStoreWithContext:context];
+    
+    NSError *error = nil;
+    for(int i = 0; i < 10; i++) {
+        [eventStore put:[NSString stringWithFormat:@"event-%04d", i] withError:&error];
+    }
+    id<AWSMobileAnalyticsEventIterator> iter = eventStore.iterator;
+    for(int i = 0; i < 4; i++) {
+        [iter next];
+    }
+    // A peeked event is not removed.
+    assertThat([iter peek], is(equalTo(@"event-0004")));
+    [iter removeReadEvents];
+    
+    AWSMobileAnalyticsFileEventStore *restartedEventStore = [AWSMobileAnalyticsFileEventStore fileStoreWithContext:context];
+    iter = restartedEventStore.iterator;
+    for(int i = 4; i < 10; i++) {
+        assertThat([iter next], is(equalTo([NSString stringWithFormat:@"event-%04d", i])));
+    }
+    assertThat([iter next], is(nilValue()));
+    assertThatUnsignedLongLong(restartedEventStore.storedBytes, is(equalToUnsignedLongLong(eventStore.storedBytes)));
+}
+
+-(void) test_FileEventStore_tornWriteIsTruncatedOnRestart
+{
+    id<AWSMobileAnalyticsContext> context = [self contextWithConfiguration:[NSDictionary dictionary]];
+    AWSMobileAnalyticsFileEventStore *eventStore = [AWSMobileAnalyticsFileEventStore fileStoreWithContext:context];
+    
+    NSError *error = nil;
+    [eventStore put:@"1" withError:&error];
+    [eventStore put:@"2" withError:&error];
+    
+    // Simulates a crash in the middle of writing the third event.
+    NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingAtPath:eventStore.eventsFile.absolutePath];
+    [fileHandle seekToEndOfFile];
+    [fileHandle writeData:[@"{\"torn" dataUsingEncoding:NSUTF8StringEncoding]];
+    [fileHandle closeFile];
+    
+    AWSMobileAnalyticsFileEventStore *restartedEventStore = [AWSMobileAnalyticsFileEventStore fileStoreWithContext:context];
+    assertThatUnsignedLongLong([restartedEventStore.eventsFile length], is(equalToUnsignedLongLong(4)));
+    [restartedEventStore put:@"3" withError:&error];
+    
+    id<AWSMobileAnalyticsEventIterator> iter = restartedEventStore.iterator;
+    assertThat([iter next], is(equalTo(@"1")));
+    assertThat([iter next], is(equalTo(@"2")));
+    assertThat([iter next], is(equalTo(@"3")));
+    assertThat([iter next], is(nilValue()));
+}
+
+-(void) test_FileEventStore_interruptedRemovalIsCompletedOnRestart
+{
+    id<AWSMobileAnalyticsContext> context = [self contextWithConfiguration:@{@"eventsSegmentSize" : @30}];
+    AWSMobileAnalyticsFileEventStore *eventStore = [AWSMobileAnalyticsFileEventStore fileStoreWithContext:context];
+    
+    NSError *error = nil;
+    for(int i = 0; i < 7; i++) {
+        [eventStore put:[NSString stringWithFormat:@"event-%04d", i] withError:&error];
+    }
+    NSString *eventsDirectory = [eventStore.eventsFile.absolutePath stringByDeletingLastPathComponent];
+    NSString *firstSegmentPath = [eventsDirectory stringByAppendingPathComponent:@"eventsFile.0"];
+    NSData *firstSegment = [NSData dataWithContentsOfFile:firstSegmentPath];
+    assertThat(firstSegment, is(notNilValue()));
+    
+    id<AWSMobileAnalyticsEventIterator> iter = eventStore.iterator;
+    for(int i = 0; i < 4; i++) {
+        [iter next];
+    }
+    [iter removeReadEvents];
+    assertThatBool([[NSFileManager defaultManager] fileExistsAtPath:firstSegmentPath], is(equalToBool(NO)));
+    
+    // Simulates a crash after the cursor moved past the first segment but before it was deleted.
+    [firstSegment writeToFile:firstSegmentPath atomically:YES];
+    
+    AWSMobileAnalyticsFileEventStore *restartedEventStore = [AWSMobileAnalyticsFileEventStore fileStoreWithContext:context];
+    assertThatBool([[NSFileManager defaultManager] fileExistsAtPath:firstSegmentPath], is(equalToBool(NO)));
+    assertThatUnsignedLongLong(restartedEventStore.storedBytes, is(equalToUnsignedLongLong(44)));
+    iter = restartedEventStore.iterator;
+    for(int i = 4; i < 7; i++) {
+        assertThat([iter next], is(equalTo([NSString stringWithFormat:@"event-%04d", i])));
+    }
+    assertThat([iter next], is(nilValue()));
+}
+
+-(void) test_FileEventStore_legacyEventsFileIsRead
+{
+    id<AWSMobileAnalyticsContext> context = [self contextWithConfiguration:[NSDictionary dictionary]];
+    AWSMobileAnalyticsFileEventStore *eventStore = [AWSMobileAnalyticsFileEventStore fileStoreWithContext:context];
+    NSString *eventsDirectory = [eventStore.eventsFile.absolutePath stringByDeletingLastPathComponent];
+    
+    // An events file left by a version without segments or a cursor.
+    [[@"1\n2\n3\n" dataUsingEncoding:NSUTF8StringEncoding] writeToFile:eventStore.eventsFile.absolutePath atomically:YES];
+    [[NSFileManager defaultManager] removeItemAtPath:[eventsDirectory stringByAppendingPathComponent:AWSEventsCursorFilename] error:nil];
+    
+    AWSMobileAnalyticsFileEventStore *upgradedEventStore = [AWSMobileAnalyticsFileEventStore fileStoreWithContext:context];
+    assertThatInt([self getNumberOfEventsInStore:upgradedEventStore], is(equalToInt(3)));
+}
+
+-(void) test_FileEventStore_benchmark
+{
+    NSString *event = [@"" stringByPaddingToLength:1023 withString:@"x" startingAtIndex:0];
+    int maxSubmissionSize = 1024 * 100;
+    
+    for(NSNumber *backlogSize in @[@(1024 * 1024), @(5 * 1024 * 1024), @(20 * 1024 * 1024)]) {
+        [self tearDown];
+        self.system = [[AWSMobileAnalyticsIOSSystem alloc] initWithIdentifier:APP_KEY];
+        id<AWSMobileAnalyticsContext> context = [self contextWithConfiguration:@{@"maxStorageSize" : @(50 * 1024 * 1024)}];
+        AWSMobileAnalyticsFileEventStore *eventStore = [AWSMobileAnalyticsFileEventStore fileStoreWithContext:context];
+        
+        int eventCount = [backlogSize intValue] / 1024;
+        NSError *error = nil;
+        NSDate *start = [NSDate date];
+        for(int i = 0; i < eventCount; i++) {
+            [eventStore put:event withError:&error];
+        }
+        NSTimeInterval putDuration = [[NSDate date] timeIntervalSinceDate:start];
+        assertThat(error, is(nilValue()));
+        
+        // One delivery cycle: reads a submission's worth of events and removes them.
+        unsigned long long bytesRead = eventStore.bytesRead;
+        unsigned long long bytesWritten = eventStore.bytesWritten;
+        start = [NSDate date];
+        id<AWSMobileAnalyticsEventIterator> iter = eventStore.iterator;
+        long submissionSize = 0;
+        while([iter hasNext] && submissionSize + [[iter peek] length] <= maxSubmissionSize) {
+            submissionSize += [[iter next] length];
+        }
+        [iter removeReadEvents];
+        NSTimeInterval deliveryDuration = [[NSDate date] timeIntervalSinceDate:start];
+        
+        NSLog(@"Backlog of %d MB: %.0f puts/s; a delivery cycle took %.3f ms and %llu bytes of I/O.",
+              [backlogSize intValue] / (1024 * 1024),
+              eventCount / putDuration,
+              deliveryDuration * 1000,
+              (eventStore.bytesRead - bytesRead) + (eventStore.bytesWritten - bytesWritten));
+        assertThatInt([self getNumberOfEventsInStore:eventStore], is(equalToInt(eventCount - maxSubmissionSize / 1024)));
+    }
+}
+
+-(int) getNumberOfEventsInStore:(AWSMobileAnalyticsFileEventStore *) theEventStore
+{
+    int counter = 0;
+    id<AWSMobileAnalyticsEventIterator> iter = theEventStore.iterator;
+    while([iter next] != nil)
+    {
+        counter++;
+    }
+    return counter;
+}
+
+-(int) getNumberOfSegmentsInDirectory:(NSString *) theDirectory
+{
+    int counter = 0;
+    for(NSString *fileName in [[NSFileManager defaultManager] contentsOfDirectoryAtPath:theDirectory error:nil])
+    {
+        if([fileName hasPrefix:AWSEventsFilename] && ![fileName isEqualToString:AWSEventsCursorFilename])
+        {
+            counter++;
+        }
+    }
+    return counter;
+}
+
 -(int) getNumberOfLinesInFile:(id<AWSMobileAnalyticsFileManager>) theFileManager withFileName:(AWSMobileAnalyticsFile *) theFile
 {
     AWSMobileAnalyticsBufferedReader *reader = [self getEventsFileReader:theFileManager withFileName:theFile];
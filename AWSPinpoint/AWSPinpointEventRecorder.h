@@ -48,7 +48,7 @@ FOUNDATION_EXPORT NSString *const AWSPinpointEventByteThresholdReachedNotificati
 @interface AWSPinpointEventRecorder : AWSService
 
 /**
- The number of bytes currently used to store AWSPinpointEvent objects on disk.
+ The number of bytes currently used to store AWSPinpointEvent objects on disk. This is a running count of the stored event columns plus a small per-event overhead, maintained as events are saved and deleted.
  */
 @property (nonatomic, assign, readonly) uint64_t diskBytesUsed;
 
@@ -78,6 +78,11 @@ FOUNDATION_EXPORT NSString *const AWSPinpointEventByteThresholdReachedNotificati
  */
 @property (nonatomic, assign) NSUInteger batchRecordsByteLimit;
 
+/**
+ The maximum number of PutEvents requests `submitAllEvents` keeps in flight at once. The default value is 4. Setting it to 1 submits one batch at a time.
+ */
+@property (nonatomic, assign) NSUInteger submissionConcurrencyLimit;
+
 /**
  Saves an event to local storage to be sent later.
  
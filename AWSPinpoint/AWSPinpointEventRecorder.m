@@ -23,6 +23,8 @@
 #import "AWSPinpointDateUtils.h"
 #import "AWSPinpointConfiguration.h"
 #import "AWSPinpoint.h"
+#import "AWSPinpointEventCodec.h"
+#import "AWSPinpointTargetingResources.h"
 
 //Analytics error domain
 NSString *const AWSPinpointAnalyticsErrorDomain = @"com.amazonaws.AWSPinpointAnalyticsErrorDomain";
@@ -31,9 +33,23 @@ NSString *const AWSPinpointAnalyticsErrorDomain = @"com.amazonaws.AWSPinpointAna
 NSUInteger const AWSPinpointClientByteLimitDefault = 5 * 1024 * 1024; // 5MB
 NSTimeInterval const AWSPinpointClientAgeLimitDefault = 0.0; // Keeps the data indefinitely unless it hits the size limit.
 NSUInteger const AWSPinpointClientBatchRecordByteLimitDefault = 512 * 1024;
+NSUInteger const AWSPinpointClientSubmissionConcurrencyLimitDefault = 4;
+NSUInteger const AWSPinpointClientStatementIdLimit = 500; // Keeps `id IN (...)` under SQLite's bound parameter limit.
 NSString *const AWSPinpointClientRecorderDatabasePathPrefix = @"com/amazonaws/AWSPinpointRecorder";
 NSUInteger const AWSPinpointClientValidEvent = 0;
 NSUInteger const AWSPinpointClientInvalidEvent = 1;
+// 0: attributes and metrics as NSKeyedArchiver blobs and timestamps as ISO-8601 strings.
+// 1: attributes and metrics encoded by AWSPinpointEventCodec and timestamps as milliseconds since 1970.
+uint32_t const AWSPinpointClientDatabaseSchemaVersion = 1;
+double const AWSPinpointClientEvictionLowWaterMark = 0.9; // Evicts down to 90% of `diskByteLimit`.
+
+// The bytes an event accounts for in `diskBytesUsed`: its stored columns plus an estimate of the per-row overhead.
+// The three millisecond timestamps are counted as 8 bytes each.
+NSUInteger const AWSPinpointClientEventOverheadBytes = 32 + 3 * 8;
+// Computes `sizeOfEventRow:` in SQL.
+static NSString *AWSPinpointClientEventSizeExpression(void) {
+    return [NSString stringWithFormat:@"(LENGTH(CAST(id AS BLOB)) + LENGTH(attributes) + LENGTH(CAST(eventType AS BLOB)) + LENGTH(metrics) + LENGTH(CAST(sessionId AS BLOB)) + %lu)", (unsigned long)AWSPinpointClientEventOverheadBytes];
+}
 
 // Constants
 NSString *const AWSPinpointEventByteThresholdReachedNotification = @"com.amazonaws.AWSPinpointEventByteThresholdReachedNotification";
@@ -47,6 +63,8 @@ NSString *const FAILURE_REASON = @"NSLocalizedFailureReason";
 @property (nonatomic, strong) AWSPinpointContext *context;
 @property (nonatomic, strong) AWSPinpointEndpointProfile *profile;
 @property (nonatomic, strong) NSObject *lock;
+@property (atomic, assign) uint64_t storedByteCount;
+@property (nonatomic, strong) AWSPinpointEventCodec *codec;
 
 @end
 
@@ -71,6 +89,17 @@ NSString *const FAILURE_REASON = @"NSLocalizedFailureReason";
 @property (nonnull, strong) NSUserDefaults *userDefaults;
 @end
 
+// A batch of events sent in one PutEvents request.
+@interface AWSPinpointEventRecorderBatch : NSObject
+
+@property (nonatomic, strong) NSDictionary *eventsWithEventId;
+@property (nonatomic, strong) AWSTask<AWSPinpointTargetingPutEventsResponse *> *task;
+
+@end
+
+@implementation AWSPinpointEventRecorderBatch
+@end
+
 @implementation AWSPinpointEventRecorder
 
 - (instancetype)init {
@@ -91,6 +120,8 @@ NSString *const FAILURE_REASON = @"NSLocalizedFailureReason";
         _diskByteLimit = AWSPinpointClientByteLimitDefault;
         _diskAgeLimit = AWSPinpointClientAgeLimitDefault;
         _batchRecordsByteLimit = AWSPinpointClientBatchRecordByteLimitDefault;
+        _submissionConcurrencyLimit = AWSPinpointClientSubmissionConcurrencyLimitDefault;
+        _codec = [AWSPinpointEventCodec new];
         
         // Creates a directory for storing databases if it doesn't exist.
         BOOL fileExistsAtPath = [[NSFileManager defaultManager] fileExistsAtPath:databaseDirectoryPath];
@@ -110,8 +141,27 @@ NSString *const FAILURE_REASON = @"NSLocalizedFailureReason";
         _databaseQueue = [AWSFMDatabaseQueue serialDatabaseQueueWithPath:_databasePath];
         [_databaseQueue inDatabase:^(AWSFMDatabase *db) {
             db.shouldCacheStatements = YES;
-            if (![db executeStatements:@"PRAGMA auto_vacuum = FULL"]) {
-                AWSDDLogError(@"Failed to enable 'auto_vacuum' to 'FULL'. %@", db.lastError);
+            // Free pages are reclaimed with `PRAGMA incremental_vacuum` after bulk deletes instead of on every commit.
+            if (![db executeStatements:@"PRAGMA auto_vacuum = INCREMENTAL"]) {
+                AWSDDLogError(@"Failed to enable 'auto_vacuum' to 'INCREMENTAL'. %@", db.lastError);
+            }
+            
+            if (![db beginTransaction]) {
+                AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+            }
+            
+            // Databases written before the schema was versioned hold version 0 events, which are moved aside and re-encoded below.
+            BOOL migrating = [db userVersion] < AWSPinpointClientDatabaseSchemaVersion && [db tableExists:@"Event"];
+            if (migrating) {
+                AWSDDLogInfo(@"Migrating the event database to version %u.", AWSPinpointClientDatabaseSchemaVersion);
+                if (![db executeStatements:
+                      @"DROP INDEX IF EXISTS Event_id;"
+                      @"DROP INDEX IF EXISTS Event_dirty_timestamp;"
+                      @"DROP INDEX IF EXISTS Event_timestamp;"
+                      @"ALTER TABLE Event RENAME TO Event_v0;"]
+                    || ([db tableExists:@"DirtyEvent"] && ![db executeUpdate:@"ALTER TABLE DirtyEvent RENAME TO DirtyEvent_v0"])) {
+                    AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+                }
             }
             
             //Event Table
@@ -121,10 +171,10 @@ NSString *const FAILURE_REASON = @"NSLocalizedFailureReason";
                   @"attributes BLOB NOT NULL,"
                   @"eventType TEXT NOT NULL,"
                   @"metrics BLOB NOT NULL,"
-                  @"eventTimestamp TEXT NOT NULL,"
+                  @"eventTimestamp INTEGER NOT NULL,"
                   @"sessionId TEXT NOT NULL,"
-                  @"sessionStartTime TEXT NOT NULL,"
-                  @"sessionStopTime TEXT NOT NULL,"
+                  @"sessionStartTime INTEGER NOT NULL,"
+                  @"sessionStopTime INTEGER NOT NULL,"
                   @"timestamp REAL NOT NULL,"
                   @"dirty INTEGER NOT NULL,"
                   @"retryCount INTEGER NOT NULL)"]) {
@@ -138,15 +188,64 @@ NSString *const FAILURE_REASON = @"NSLocalizedFailureReason";
                   @"attributes BLOB NOT NULL,"
                   @"eventType TEXT NOT NULL,"
                   @"metrics BLOB NOT NULL,"
-                  @"eventTimestamp TEXT NOT NULL,"
+                  @"eventTimestamp INTEGER NOT NULL,"
                   @"sessionId TEXT NOT NULL,"
-                  @"sessionStartTime TEXT NOT NULL,"
-                  @"sessionStopTime TEXT NOT NULL,"
+                  @"sessionStartTime INTEGER NOT NULL,"
+                  @"sessionStopTime INTEGER NOT NULL,"
                   @"timestamp REAL NOT NULL,"
                   @"dirty INTEGER NOT NULL,"
                   @"retryCount INTEGER NOT NULL)"]) {
                 AWSDDLogError(@"SQLite error. [%@]", db.lastError);
             }
+            
+            //Attribute and metric names referenced by the encoded events
+            if (![AWSPinpointEventCodec createKeyTableInDatabase:db]) {
+                AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+            }
+
+            if (![db executeUpdate:@"CREATE INDEX IF NOT EXISTS Event_id ON Event (id)"]
+                || ![db executeUpdate:@"CREATE INDEX IF NOT EXISTS Event_dirty_timestamp ON Event (dirty, timestamp)"]
+                || ![db executeUpdate:@"CREATE INDEX IF NOT EXISTS Event_timestamp ON Event (timestamp)"]) {
+                AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+            }
+            
+            if (migrating) {
+                if (![self migrateEventsFromTable:@"Event_v0" toTable:@"Event" database:db]
+                    || ([db tableExists:@"DirtyEvent_v0"] && ![self migrateEventsFromTable:@"DirtyEvent_v0" toTable:@"DirtyEvent" database:db])) {
+                    AWSDDLogError(@"Failed to migrate the stored events, the remaining ones are dropped. [%@]", db.lastError);
+                }
+                if (![db executeStatements:@"DROP TABLE IF EXISTS Event_v0; DROP TABLE IF EXISTS DirtyEvent_v0;"]) {
+                    AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+                }
+            }
+            [db setUserVersion:AWSPinpointClientDatabaseSchemaVersion];
+            
+            if (![db commit]) {
+                AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+                [db rollback];
+                [self.codec resetKeys];
+            }
+
+            // Switching an existing database to incremental auto_vacuum only takes effect after a VACUUM.
+            if (![db executeUpdate:@"VACUUM"]) {
+                AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+            }
+
+            // Seeds the running byte counter that `diskBytesUsed` and the eviction use from then on.
+            AWSFMResultSet *rs = [db executeQuery:[NSString stringWithFormat:
+                                                   @"SELECT (SELECT COALESCE(SUM(%@), 0) FROM Event) + (SELECT COALESCE(SUM(%@), 0) FROM DirtyEvent) AS size",
+                                                   AWSPinpointClientEventSizeExpression(), AWSPinpointClientEventSizeExpression()]];
+            if ([rs next]) {
+                self.storedByteCount = [rs unsignedLongLongIntForColumn:@"size"];
+            } else {
+                AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+            }
+            [rs close];
+
+            // Loads the key table so that its size is part of `diskBytesUsed` from the start.
+            if (![self.codec loadKeysFromDatabase:db]) {
+                AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+            }
         }];
     }
     return self;
@@ -163,6 +262,18 @@ NSString *const FAILURE_REASON = @"NSLocalizedFailureReason";
     return queue;
 }
 
+// Event submission blocks while it waits for PutEvents responses, so it runs off `sharedQueue` to keep saves flowing.
++ (dispatch_queue_t)submissionQueue {
+    static dispatch_queue_t queue;
+    static dispatch_once_t predicate;
+    
+    dispatch_once(&predicate, ^{
+        queue = dispatch_queue_create("com.amazonaws.AWSPinpointEventRecorder.submission", DISPATCH_QUEUE_SERIAL);
+    });
+    
+    return queue;
+}
+
 - (AWSPinpointSession *)validateOrRetrieveSession:(AWSPinpointSession *) session {
     if (session && session.sessionId && session.sessionId.length >=1) {
         return session;
@@ -199,7 +310,6 @@ NSString *const FAILURE_REASON = @"NSLocalizedFailureReason";
     
     AWSFMDatabaseQueue *databaseQueue = self.databaseQueue;
     NSTimeInterval diskAgeLimit = self.diskAgeLimit;
-    NSString *databasePath = self.databasePath;
     NSUInteger notificationByteThreshold = self.notificationByteThreshold;
     NSUInteger diskByteLimit = self.diskByteLimit;
     __weak id notificationSender = self;
@@ -210,109 +320,256 @@ NSString *const FAILURE_REASON = @"NSLocalizedFailureReason";
     return [[AWSTask taskWithResult:nil] continueWithExecutor:[AWSExecutor executorWithDispatchQueue:[AWSPinpointEventRecorder sharedQueue]] withSuccessBlock:^id _Nullable(AWSTask * _Nonnull task) {
         // Inserts a new record to the database.
         __block NSError *error = nil;
-        [databaseQueue inDatabase:^(AWSFMDatabase *db) {
+        __block BOOL evicted = NO;
+        [databaseQueue inTransaction:^(AWSFMDatabase *db, BOOL *rollback) {
             
-            NSString *sessionId = event.session.sessionId;
-            NSString *stopTime = [event.session.stopTime aws_stringValue:AWSDateISO8601DateFormat3];
-            NSString *startTime = [event.session.startTime aws_stringValue:AWSDateISO8601DateFormat3];
+            NSDictionary *row = [self rowForEvent:event
+                                          eventId:[[NSUUID UUID] UUIDString]
+                                        timestamp:[[NSDate date] timeIntervalSince1970]
+                                            dirty:AWSPinpointClientValidEvent
+                                       retryCount:0
+                                         database:db];
             
-            BOOL result = [db executeUpdate:
-                           @"INSERT INTO Event ("
-                           @"id, attributes, eventType, metrics, eventTimestamp, sessionId, sessionStartTime, sessionStopTime, timestamp, dirty, retryCount"
-                           @") VALUES ("
-                           @":id, :attributes, :eventType, :metrics, :eventTimestamp, :sessionId, :sessionStartTime, :sessionStopTime, :timestamp, :dirty, :retryCount"
-                           @")"
-                    withParameterDictionary:@{
-                                              @"id" : [[NSUUID UUID] UUIDString],
-                                              @"attributes" : [NSKeyedArchiver archivedDataWithRootObject:event.allAttributes],
-                                              @"eventType" : event.eventType,
-                                              @"metrics" : [NSKeyedArchiver archivedDataWithRootObject:event.allMetrics],
-                                              @"eventTimestamp" : [AWSPinpointDateUtils isoDateTimeWithTimestamp:event.eventTimestamp],
-                                              @"sessionId": sessionId,
-                                              @"sessionStartTime": startTime? startTime : @"",
-                                              @"sessionStopTime": stopTime? stopTime : @"",
-                                              @"timestamp": @([[NSDate date] timeIntervalSince1970]),
-                                              @"dirty" : [NSNumber numberWithInteger:AWSPinpointClientValidEvent],
-                                              @"retryCount" : @0
-                                              }
-                           ];
+            BOOL result = row && [self insertRow:row intoTable:@"Event" database:db];
             
             if (!result) {
-                AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+                AWSDDLogError(@"SQLite error. Rolling back... [%@]", db.lastError);
                 error = db.lastError;
+                *rollback = YES;
+                [self.codec resetKeys];
+                return;
             }
-        }];
-        
-        if (!error && diskAgeLimit > 0) {
-            [databaseQueue inDatabase:^(AWSFMDatabase *db) {
+            self.storedByteCount += [self sizeOfEventRow:row];
+            
+            if (diskAgeLimit > 0) {
                 // Deletes old events exceeding the threshold.
-                BOOL result = [db executeUpdate:
-                               @"DELETE FROM Event "
-                               @"WHERE timestamp < :timestamp"
-                        withParameterDictionary:@{
-                                                  @"timestamp" : @([[NSDate date] timeIntervalSince1970] - diskAgeLimit)
-                                                  }
-                               ];
-                if (!result) {
-                    AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+                if (![self deleteFromTable:@"Event"
+                                     where:@"timestamp < :timestamp"
+                                parameters:@{
+                                             @"timestamp" : @([[NSDate date] timeIntervalSince1970] - diskAgeLimit)
+                                             }
+                                  database:db]) {
                     error = db.lastError;
+                    return;
                 }
-            }];
-        }
-        
-        if (error) {
-            return [AWSTask taskWithError:error];
-        }
-        
-        NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:databasePath
-                                                                                    error:&error];
-        if (attributes) {
-            NSUInteger fileSize = (NSUInteger)[attributes fileSize];
-            [self checkByteThresholdForNotification:notificationByteThreshold
-                                 notificationSender:notificationSender
-                                           fileSize:fileSize];
-            if (fileSize > diskByteLimit) {
+            }
+            
+            if (diskByteLimit > 0 && self.diskBytesUsed > diskByteLimit) {
                 //First Flush the dirty events
-                [databaseQueue inDatabase:^(AWSFMDatabase *db) {
-                    if (![db executeUpdate:@"DELETE FROM DirtyEvent"]) {
-                        AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+                if (![self deleteFromTable:@"DirtyEvent" where:@"1" parameters:@{} database:db]) {
+                    error = db.lastError;
+                    return;
+                }
+                evicted = YES;
+                
+                if (self.diskBytesUsed > diskByteLimit) {
+                    // Deletes the oldest events until the stored bytes are back under the low-water mark, so that
+                    // eviction runs once per many saves instead of on every save once the limit is reached.
+                    uint64_t bytesToFree = self.diskBytesUsed - (uint64_t)(diskByteLimit * AWSPinpointClientEvictionLowWaterMark);
+                    uint64_t freedBytes = 0;
+                    NSUInteger eventCount = 0;
+                    AWSFMResultSet *rs = [db executeQuery:[NSString stringWithFormat:
+                                                           @"SELECT %@ AS size "
+                                                           @"FROM Event "
+                                                           @"ORDER BY timestamp ASC", AWSPinpointClientEventSizeExpression()]];
+                    while (freedBytes < bytesToFree && [rs next]) {
+                        freedBytes += [rs unsignedLongLongIntForColumn:@"size"];
+                        eventCount += 1;
+                    }
+                    [rs close];
+                    
+                    AWSDDLogWarn(@"Deleting %lu oldest events from disk, diskByteLimit has been reached.", (unsigned long)eventCount);
+                    if (![self deleteFromTable:@"Event"
+                                         where:@"rowid IN (SELECT rowid FROM Event ORDER BY timestamp ASC LIMIT :limit)"
+                                    parameters:@{@"limit" : @(eventCount)}
+                                      database:db]) {
                         error = db.lastError;
+                        return;
                     }
-                }];
-                
-                if (error) {
-                    return [AWSTask taskWithError:error];
                 }
                 
-                if ([self diskBytesUsed] > diskByteLimit) {
-                    // Deletes the oldest event if it still exceeds the disk size threshold after clearing the dirty events.
-                    [databaseQueue inDatabase:^(AWSFMDatabase *db) {
-                        AWSDDLogWarn(@"Deleting oldest event from disk, diskByteLimit has been reached.");
-                        BOOL result = [db executeUpdate:
-                                       @"DELETE FROM Event "
-                                       @"WHERE id IN ( "
-                                       @"SELECT id "
-                                       @"FROM Event "
-                                       @"ORDER BY timestamp ASC "
-                                       @"LIMIT 1 "
-                                       @")"
-                                       ];
-                        if (!result) {
-                            AWSDDLogError(@"SQLite error. [%@]", db.lastError);
-                            error = db.lastError;
-                            return;
-                        }
-                    }];
+                // The keys only the evicted events used go with them, once enough new keys make the scan worthwhile.
+                if (self.codec.shouldRemoveUnreferencedKeys
+                    && ![self.codec removeKeysUnreferencedByTables:@[@"Event", @"DirtyEvent"] database:db]) {
+                    error = db.lastError;
+                    return;
                 }
             }
-        } else if (error) {
+        }];
+        
+        if (error) {
             return [AWSTask taskWithError:error];
         }
         
+        [self checkByteThresholdForNotification:notificationByteThreshold
+                             notificationSender:notificationSender
+                                       fileSize:(NSUInteger)self.diskBytesUsed];
+        
+        if (evicted) {
+            [self reclaimFreePages];
+        }
+        
         return [AWSTask taskWithResult:event];
     }];
 }
 
+- (NSDictionary *)rowForEvent:(AWSPinpointEvent *)event
+                      eventId:(NSString *)eventId
+                    timestamp:(NSTimeInterval)timestamp
+                        dirty:(NSUInteger)dirty
+                   retryCount:(NSUInteger)retryCount
+                     database:(AWSFMDatabase *)db {
+    NSData *attributes = [self.codec dataWithAttributes:event.allAttributes database:db];
+    NSData *metrics = [self.codec dataWithMetrics:event.allMetrics database:db];
+    if (!attributes || !metrics) {
+        return nil;
+    }
+    
+    return @{
+             @"id" : eventId,
+             @"attributes" : attributes,
+             @"eventType" : event.eventType,
+             @"metrics" : metrics,
+             @"eventTimestamp" : @(event.eventTimestamp),
+             @"sessionId" : event.session.sessionId,
+             @"sessionStartTime" : @(event.session.startTime ? [AWSPinpointDateUtils utcTimeMillisFromDate:event.session.startTime] : 0),
+             @"sessionStopTime" : @(event.session.stopTime ? [AWSPinpointDateUtils utcTimeMillisFromDate:event.session.stopTime] : 0),
+             @"timestamp" : @(timestamp),
+             @"dirty" : @(dirty),
+             @"retryCount" : @(retryCount)
+             };
+}
+
+- (BOOL)insertRow:(NSDictionary *)row
+        intoTable:(NSString *)table
+         database:(AWSFMDatabase *)db {
+    return [db executeUpdate:[NSString stringWithFormat:
+                              @"INSERT INTO %@ ("
+                              @"id, attributes, eventType, metrics, eventTimestamp, sessionId, sessionStartTime, sessionStopTime, timestamp, dirty, retryCount"
+                              @") VALUES ("
+                              @":id, :attributes, :eventType, :metrics, :eventTimestamp, :sessionId, :sessionStartTime, :sessionStopTime, :timestamp, :dirty, :retryCount"
+                              @")", table]
+     withParameterDictionary:row];
+}
+
+- (AWSPinpointEvent *)eventFromResultSet:(AWSFMResultSet *)rs
+                                database:(AWSFMDatabase *)db {
+    NSMutableDictionary *attributes = [self.codec attributesWithData:[rs dataForColumn:@"attributes"] database:db];
+    NSMutableDictionary *metrics = [self.codec metricsWithData:[rs dataForColumn:@"metrics"] database:db];
+    if (!attributes || !metrics) {
+        AWSDDLogError(@"Failed to decode the event [%@].", [rs stringForColumn:@"id"]);
+        return nil;
+    }
+    
+    UTCTimeMillis startTime = [rs unsignedLongLongIntForColumn:@"sessionStartTime"];
+    UTCTimeMillis stopTime = [rs unsignedLongLongIntForColumn:@"sessionStopTime"];
+    AWSPinpointSession *session = [[AWSPinpointSession alloc] initWithSessionId:[rs stringForColumn:@"sessionId"]
+                                                                  withStartTime:startTime ? [AWSPinpointDateUtils dateFromutcTimeMillis:startTime] : nil
+                                                                   withStopTime:stopTime ? [AWSPinpointDateUtils dateFromutcTimeMillis:stopTime] : nil];
+    return [[AWSPinpointEvent alloc] initWithEventType:[rs stringForColumn:@"eventType"]
+                                        eventTimestamp:[rs unsignedLongLongIntForColumn:@"eventTimestamp"]
+                                               session:session
+                                            attributes:attributes
+                                               metrics:metrics];
+}
+
+// Re-encodes the version 0 events of `sourceTable` into `destinationTable`. Events that cannot be decoded are dropped.
+- (BOOL)migrateEventsFromTable:(NSString *)sourceTable
+                       toTable:(NSString *)destinationTable
+                      database:(AWSFMDatabase *)db {
+    AWSFMResultSet *rs = [db executeQuery:[NSString stringWithFormat:@"SELECT * FROM %@", sourceTable]];
+    if (!rs) {
+        return NO;
+    }
+    
+    NSUInteger migratedCount = 0;
+    NSUInteger droppedCount = 0;
+    while ([rs next]) {
+        @autoreleasepool {
+            NSMutableDictionary *attributes = nil;
+            NSMutableDictionary *metrics = nil;
+            @try {
+                attributes = [NSKeyedUnarchiver unarchiveObjectWithData:[rs dataForColumn:@"attributes"]];
+                metrics = [NSKeyedUnarchiver unarchiveObjectWithData:[rs dataForColumn:@"metrics"]];
+            } @catch (NSException *exception) {
+                AWSDDLogError(@"Failed to unarchive the event [%@]. [%@]", [rs stringForColumn:@"id"], exception);
+            }
+            NSString *eventType = [rs stringForColumn:@"eventType"];
+            NSString *sessionId = [rs stringForColumn:@"sessionId"];
+            if (![attributes isKindOfClass:[NSDictionary class]] || ![metrics isKindOfClass:[NSDictionary class]] || !eventType || !sessionId) {
+                droppedCount += 1;
+                continue;
+            }
+            
+            AWSPinpointSession *session = [[AWSPinpointSession alloc] initWithSessionId:sessionId
+                                                                          withStartTime:[NSDate aws_dateFromString:[rs stringForColumn:@"sessionStartTime"] format:AWSDateISO8601DateFormat3]
+                                                                           withStopTime:[NSDate aws_dateFromString:[rs stringForColumn:@"sessionStopTime"] format:AWSDateISO8601DateFormat3]];
+            AWSPinpointEvent *event = [[AWSPinpointEvent alloc] initWithEventType:eventType
+                                                                   eventTimestamp:[AWSPinpointDateUtils utcTimeMillisFromISO8061String:[rs stringForColumn:@"eventTimestamp"]]
+                                                                          session:session
+                                                                       attributes:[attributes mutableCopy]
+                                                                          metrics:[metrics mutableCopy]];
+            NSDictionary *row = [self rowForEvent:event
+                                          eventId:[rs stringForColumn:@"id"]
+                                        timestamp:[rs doubleForColumn:@"timestamp"]
+                                            dirty:[rs longForColumn:@"dirty"]
+                                       retryCount:[rs longForColumn:@"retryCount"]
+                                         database:db];
+            if (!row || ![self insertRow:row intoTable:destinationTable database:db]) {
+                [rs close];
+                return NO;
+            }
+            migratedCount += 1;
+        }
+    }
+    [rs close];
+    
+    AWSDDLogInfo(@"Migrated %lu events from %@, dropped %lu.", (unsigned long)migratedCount, sourceTable, (unsigned long)droppedCount);
+    return YES;
+}
+
+- (uint64_t)sizeOfEventRow:(NSDictionary *)row {
+    uint64_t size = AWSPinpointClientEventOverheadBytes;
+    for (NSString *column in @[@"id", @"eventType", @"sessionId"]) {
+        size += [row[column] lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    }
+    size += [row[@"attributes"] length] + [row[@"metrics"] length];
+    return size;
+}
+
+// Deletes the rows of `table` matching `predicate` and subtracts their size from the running byte counter.
+// Must be called inside a transaction so that the sum and the delete see the same rows.
+- (BOOL)deleteFromTable:(NSString *)table
+                  where:(NSString *)predicate
+             parameters:(NSDictionary *)parameters
+               database:(AWSFMDatabase *)db {
+    AWSFMResultSet *rs = [db executeQuery:[NSString stringWithFormat:@"SELECT COALESCE(SUM(%@), 0) AS size FROM %@ WHERE %@", AWSPinpointClientEventSizeExpression(), table, predicate]
+                  withParameterDictionary:parameters];
+    if (!rs) {
+        AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+        return NO;
+    }
+    uint64_t size = [rs next] ? [rs unsignedLongLongIntForColumn:@"size"] : 0;
+    [rs close];
+    
+    if (![db executeUpdate:[NSString stringWithFormat:@"DELETE FROM %@ WHERE %@", table, predicate]
+   withParameterDictionary:parameters]) {
+        AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+        return NO;
+    }
+    self.storedByteCount -= MIN(size, self.storedByteCount);
+    
+    return YES;
+}
+
+- (void)reclaimFreePages {
+    [self.databaseQueue inDatabase:^(AWSFMDatabase *db) {
+        if (![db executeStatements:@"PRAGMA incremental_vacuum"]) {
+            AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+        }
+    }];
+}
+
 - (AWSTask*) updateSessionStartWithCampaignAttributes:(NSDictionary*) attributes {
     AWSFMDatabaseQueue *databaseQueue = self.databaseQueue;
     NSString *sessionId = [self validateOrRetrieveSessionId:self.context.sessionClient.session.sessionId];
@@ -321,13 +578,22 @@ NSString *const FAILURE_REASON = @"NSLocalizedFailureReason";
         __block NSError *error = nil;
         
         [databaseQueue inTransaction:^(AWSFMDatabase *db, BOOL *rollback) {
+            NSData *encodedAttributes = [self.codec dataWithAttributes:attributes database:db];
+            if (!encodedAttributes) {
+                AWSDDLogError(@"SQLite error. Rolling back... [%@]", db.lastError);
+                error = db.lastError;
+                *rollback = YES;
+                [self.codec resetKeys];
+                return;
+            }
+            
             BOOL result = [db executeUpdate:
                            @"UPDATE Event "
                            @"SET attributes = :attributes "
                            @"WHERE sessionId = :sessionId "
                            @"AND eventType = :eventType"
                     withParameterDictionary:@{
-                                              @"attributes" : [NSKeyedArchiver archivedDataWithRootObject:attributes],
+                                              @"attributes" : encodedAttributes,
                                               @"eventType" : @"_session.start",
                                               @"sessionId" : sessionId
                                               }
@@ -372,17 +638,9 @@ NSString *const FAILURE_REASON = @"NSLocalizedFailureReason";
             }
             
             if ([rs next]) {
-                NSMutableDictionary *attributes = [NSKeyedUnarchiver unarchiveObjectWithData:[rs dataForColumn:@"attributes"]];
-                NSMutableDictionary *metrics = [NSKeyedUnarchiver unarchiveObjectWithData:[rs dataForColumn:@"metrics"]];
-                AWSPinpointSession *session = [[AWSPinpointSession alloc] initWithSessionId:[rs stringForColumn:@"sessionId"]
-                                                                              withStartTime:[NSDate aws_dateFromString:[rs stringForColumn:@"sessionStartTime"] format:AWSDateISO8601DateFormat3]
-                                                                               withStopTime:[NSDate aws_dateFromString:[rs stringForColumn:@"sessionStopTime"] format:AWSDateISO8601DateFormat3]];
-                event = [[AWSPinpointEvent alloc] initWithEventType:[rs stringForColumn:@"eventType"]
-                                                     eventTimestamp:[AWSPinpointDateUtils utcTimeMillisFromISO8061String:[rs stringForColumn:@"eventTimestamp"]]
-                                                            session:session
-                                                         attributes:attributes
-                                                            metrics:metrics];
+                event = [self eventFromResultSet:rs database:db];
             }
+            [rs close];
         }];
         
         if (error) {
@@ -418,17 +676,10 @@ NSString *const FAILURE_REASON = @"NSLocalizedFailureReason";
             }
             
             while ([rs next]) {
-                NSMutableDictionary *attributes = [NSKeyedUnarchiver unarchiveObjectWithData:[rs dataForColumn:@"attributes"]];
-                NSMutableDictionary *metrics = [NSKeyedUnarchiver unarchiveObjectWithData:[rs dataForColumn:@"metrics"]];
-                AWSPinpointSession *session = [[AWSPinpointSession alloc] initWithSessionId:[rs stringForColumn:@"sessionId"]
-                                                                              withStartTime:[NSDate aws_dateFromString:[rs stringForColumn:@"sessionStartTime"] format:AWSDateISO8601DateFormat3]
-                                                                               withStopTime:[NSDate aws_dateFromString:[rs stringForColumn:@"sessionStopTime"] format:AWSDateISO8601DateFormat3]];
-                AWSPinpointEvent *event = [[AWSPinpointEvent alloc] initWithEventType:[rs stringForColumn:@"eventType"]
-                                                                       eventTimestamp:[AWSPinpointDateUtils utcTimeMillisFromISO8061String:[rs stringForColumn:@"eventTimestamp"]]
-                                                                              session:session
-                                                                           attributes:attributes
-                                                                              metrics:metrics];
-                [events addObject:event];
+                AWSPinpointEvent *event = [self eventFromResultSet:rs database:db];
+                if (event) {
+                    [events addObject:event];
+                }
             }
         }];
         
@@ -465,17 +716,10 @@ NSString *const FAILURE_REASON = @"NSLocalizedFailureReason";
             }
             
             while ([rs next]) {
-                NSMutableDictionary *attributes = [NSKeyedUnarchiver unarchiveObjectWithData:[rs dataForColumn:@"attributes"]];
-                NSMutableDictionary *metrics = [NSKeyedUnarchiver unarchiveObjectWithData:[rs dataForColumn:@"metrics"]];
-                AWSPinpointSession *session = [[AWSPinpointSession alloc] initWithSessionId:[rs stringForColumn:@"sessionId"]
-                                                                              withStartTime:[NSDate aws_dateFromString:[rs stringForColumn:@"sessionStartTime"] format:AWSDateISO8601DateFormat3]
-                                                                               withStopTime:[NSDate aws_dateFromString:[rs stringForColumn:@"sessionStopTime"] format:AWSDateISO8601DateFormat3]];
-                AWSPinpointEvent *event = [[AWSPinpointEvent alloc] initWithEventType:[rs stringForColumn:@"eventType"]
-                                                                       eventTimestamp:[AWSPinpointDateUtils utcTimeMillisFromISO8061String:[rs stringForColumn:@"eventTimestamp"]]
-                                                                              session:session
-                                                                           attributes:attributes
-                                                                              metrics:metrics];
-                [events addObject:event];
+                AWSPinpointEvent *event = [self eventFromResultSet:rs database:db];
+                if (event) {
+                    [events addObject:event];
+                }
             }
         }];
         
@@ -490,99 +734,163 @@ NSString *const FAILURE_REASON = @"NSLocalizedFailureReason";
 
 - (AWSTask<NSArray<AWSPinpointEvent *> *> *)submitAllEvents {
     @synchronized(self.lock) {
-        __block NSMutableArray *result = [NSMutableArray new];
-        __block AWSTask *returnTask;
-        
-        if (!self.submissionInProgress) {
-            self.submissionInProgress = YES;
-            dispatch_group_t serviceGroup = dispatch_group_create();
-            dispatch_group_enter(serviceGroup);
-            
-            self.profile = [self.context.targetingClient currentEndpointProfile];
-            [self getBatchRecords:^(NSDictionary *eventsWithEventId, NSError *error) {
-                __block NSError *_error = [error copy];
-                __block NSDictionary *_eventsWithEventId = [eventsWithEventId copy];
-                returnTask = [[self submitEvents:&result eventsWithEventId:_eventsWithEventId error:_error]
-                              continueWithBlock:^id _Nullable(AWSTask<NSArray<AWSPinpointEvent *> *> * _Nonnull t) {
-                                  dispatch_group_leave(serviceGroup);
-                                  return t;
-                              }];
-            }];
-            
-            dispatch_group_notify(serviceGroup,dispatch_get_main_queue(),^{
-                self.submissionInProgress = NO;
-            });
-        } else {
-            returnTask = [AWSTask taskWithError:[NSError errorWithDomain:AWSPinpointAnalyticsErrorDomain
-                                                                    code:AWSPinpointTargetingErrorTooManyRequests
-                                                                userInfo:@{NSLocalizedDescriptionKey: @"Event submission is in progress."}]];
+        if (self.submissionInProgress) {
+            return [AWSTask taskWithError:[NSError errorWithDomain:AWSPinpointAnalyticsErrorDomain
+                                                              code:AWSPinpointTargetingErrorTooManyRequests
+                                                          userInfo:@{NSLocalizedDescriptionKey: @"Event submission is in progress."}]];
         }
-        return returnTask;
+        self.submissionInProgress = YES;
     }
+    
+    self.profile = [self.context.targetingClient currentEndpointProfile];
+    return [[AWSTask taskWithResult:nil] continueWithExecutor:[AWSExecutor executorWithDispatchQueue:[AWSPinpointEventRecorder submissionQueue]] withBlock:^id _Nullable(AWSTask * _Nonnull task) {
+        AWSTask *submitTask = [self submitEvents];
+        @synchronized(self.lock) {
+            self.submissionInProgress = NO;
+        }
+        return submitTask;
+    }];
 }
 
-- (AWSTask<NSArray<AWSPinpointEvent *> *> *)submitEvents:(NSMutableArray**) resultEvents
-                                       eventsWithEventId:(NSDictionary *)eventsWithEventId
-                                                   error:(NSError *)error {
-    __block AWSTask *returnTask;
-    __block NSMutableArray *result = *resultEvents;
-    __block NSDictionary *_eventsWithEventId = [eventsWithEventId copy];
-    __block NSError *_error = [error copy];
-    
-    AWSDDLogVerbose(@"Submitting Batch with %lu events ", (unsigned long)[eventsWithEventId count]);
+// Drains the Event table, keeping up to `submissionConcurrencyLimit` PutEvents requests in flight. Events are read
+// in rowid order behind a cursor so that batches in flight are never read again; retryable events, which stay behind
+// the cursor, are picked up by another pass once the table has been read to the end. Blocks until the drain is over.
+- (AWSTask<NSArray<AWSPinpointEvent *> *> *)submitEvents {
+    NSMutableArray<AWSPinpointEvent *> *submittedEvents = [NSMutableArray new];
+    NSMutableArray<AWSPinpointEventRecorderBatch *> *inFlightBatches = [NSMutableArray new];
+    NSUInteger concurrencyLimit = MAX(self.submissionConcurrencyLimit, 1);
+    AWSPinpointEndpointProfile *profile = self.profile;
+    // Every batch carries the same endpoint, so its payload is built once per drain.
+    AWSPinpointTargetingPublicEndpoint *endpoint = [self buildEndpointRequestPayload:profile];
+    NSUInteger eventsByteLimit = [self eventsByteLimitForEndpointProfile:profile
+                                                         endpointPayload:endpoint];
+    int64_t lastRowId = 0;
+    BOOL endOfTable = NO;
+    BOOL retryPending = NO;
+    NSUInteger batchCount = 0;
+    NSError *error = nil;
     
-    if (_error) {
-        returnTask = [AWSTask taskWithError:_error];
-    } else if ([_eventsWithEventId count] < 1) {
-        AWSDDLogWarn(@"No events to submit.");
-        _error = [NSError errorWithDomain:AWSPinpointAnalyticsErrorDomain
-                                     code:AWSPinpointAnalyticsErrorUnknown
-                                 userInfo:@{NSLocalizedDescriptionKey: @"No events to submit."}];
-        returnTask = [AWSTask taskWithError:_error];
-    } else {
-        returnTask = [[self submitBatchEvents:_eventsWithEventId] continueWithBlock:^id _Nullable(AWSTask<NSDictionary <NSString *, NSDictionary *> *> * _Nonnull t) {
-            __block AWSTask *nextTask;
-            
-            if (t.error) {
-                nextTask = [AWSTask taskWithError:t.error];
+    while (YES) {
+        while (!error && !endOfTable && [inFlightBatches count] < concurrencyLimit) {
+            __block NSDictionary *batchEvents = nil;
+            __block int64_t batchLastRowId = 0;
+            __block NSError *readError = nil;
+            [self getBatchRecordsAfterRowId:lastRowId
+                            eventsByteLimit:eventsByteLimit
+                                     result:^(NSDictionary *eventsWithEventId, int64_t rowId, NSError *error) {
+                                         batchEvents = eventsWithEventId;
+                                         batchLastRowId = rowId;
+                                         readError = error;
+                                     }];
+            if (readError) {
+                error = readError;
+            } else if ([batchEvents count] == 0) {
+                // A read that only found undecodable events moves the cursor past them without producing a batch.
+                endOfTable = batchLastRowId == lastRowId;
+                lastRowId = batchLastRowId;
             } else {
-                for (NSDictionary* object in [t.result allValues]) {
-                    if ([[object objectForKey:@"statusCode"] intValue] == 202) {
-                        //Aggregate results
-                        [result addObject:[object objectForKey:@"event"]];
-                    }
-                }
-
-                [self getBatchRecords:^(NSDictionary *eventsWithEventId, NSError *error) {
-                    __block NSError *__error = error;
-                    __block NSDictionary *__eventsWithEventId = eventsWithEventId;
-                    if (__error) {
-                        nextTask = [AWSTask taskWithError:t.error];
-                    } else if ([eventsWithEventId count] > 0) {
-                        nextTask = [self submitEvents:&result eventsWithEventId:__eventsWithEventId error:__error];
-                    } else {
-                        nextTask = [AWSTask taskWithResult:result];
-                    }
-                }];
+                AWSDDLogVerbose(@"Submitting Batch with %lu events ", (unsigned long)[batchEvents count]);
+                AWSPinpointEventRecorderBatch *batch = [AWSPinpointEventRecorderBatch new];
+                batch.eventsWithEventId = batchEvents;
+                batch.task = [self sendEvents:batchEvents
+                              endpointProfile:profile
+                              endpointPayload:endpoint];
+                [inFlightBatches addObject:batch];
+                lastRowId = batchLastRowId;
+                batchCount += 1;
+            }
+        }
+        
+        if ([inFlightBatches count] == 0) {
+            if (!error && endOfTable && retryPending) {
+                retryPending = NO;
+                endOfTable = NO;
+                lastRowId = 0;
+                continue;
+            }
+            break;
+        }
+        
+        // Waits for any batch to complete, successfully or not.
+        NSMutableArray *completionTasks = [NSMutableArray new];
+        for (AWSPinpointEventRecorderBatch *batch in inFlightBatches) {
+            [completionTasks addObject:[batch.task continueWithBlock:^id _Nullable(AWSTask * _Nonnull task) {
+                return nil;
+            }]];
+        }
+        [[AWSTask taskForCompletionOfAnyTask:completionTasks] waitUntilFinished];
+        
+        for (AWSPinpointEventRecorderBatch *batch in [inFlightBatches copy]) {
+            if (!batch.task.completed) {
+                continue;
+            }
+            [inFlightBatches removeObject:batch];
+            
+            NSError *batchError = nil;
+            BOOL batchRetryPending = NO;
+            NSArray *acceptedEvents = [self finishBatch:batch
+                                           retryPending:&batchRetryPending
+                                                  error:&batchError];
+            [submittedEvents addObjectsFromArray:acceptedEvents];
+            retryPending = retryPending || batchRetryPending;
+            if (batchError && !error) {
+                error = batchError;
+            }
+        }
+    }
+    
+    if (batchCount > 0) {
+        // Drops the keys that only the submitted events used, once enough new keys make the scan worthwhile.
+        [self.databaseQueue inTransaction:^(AWSFMDatabase *db, BOOL *rollback) {
+            if (self.codec.shouldRemoveUnreferencedKeys
+                && ![self.codec removeKeysUnreferencedByTables:@[@"Event", @"DirtyEvent"] database:db]) {
+                *rollback = YES;
+                [self.codec resetKeys];
             }
-            return nextTask;
         }];
     }
     
-    return returnTask;
+    if (error) {
+        return [AWSTask taskWithError:error];
+    }
+    if (batchCount == 0) {
+        AWSDDLogWarn(@"No events to submit.");
+        return [AWSTask taskWithError:[NSError errorWithDomain:AWSPinpointAnalyticsErrorDomain
+                                                          code:AWSPinpointAnalyticsErrorUnknown
+                                                      userInfo:@{NSLocalizedDescriptionKey: @"No events to submit."}]];
+    }
+    return [AWSTask taskWithResult:submittedEvents];
 }
 
 - (void) getBatchRecords:(void (^)(NSDictionary *eventsWithEventId, NSError *error))result {
+    AWSPinpointEndpointProfile *profile = [self.context.targetingClient currentEndpointProfile];
+    NSUInteger eventsByteLimit = [self eventsByteLimitForEndpointProfile:profile
+                                                         endpointPayload:[self buildEndpointRequestPayload:profile]];
+    [self getBatchRecordsAfterRowId:0
+                    eventsByteLimit:eventsByteLimit
+                             result:^(NSDictionary *eventsWithEventId, int64_t lastRowId, NSError *error) {
+                                 result(eventsWithEventId, error);
+                             }];
+}
+
+// Reads the next batch of events after `rowId` whose encoded entries fit in `eventsByteLimit`, the room
+// `eventsByteLimitForEndpointProfile:endpointPayload:` leaves for them in the request.
+- (void) getBatchRecordsAfterRowId:(int64_t)rowId
+                   eventsByteLimit:(NSUInteger)eventsByteLimit
+                            result:(void (^)(NSDictionary *eventsWithEventId, int64_t lastRowId, NSError *error))result {
     AWSFMDatabaseQueue *databaseQueue = self.databaseQueue;
     __block NSError *error = nil;
     
     [databaseQueue inTransaction:^(AWSFMDatabase *db, BOOL *rollback) {
-        AWSFMResultSet *rs = [db executeQuery:[NSString stringWithFormat:
-                                               @"SELECT id, attributes, eventType, metrics, eventTimestamp, sessionId, sessionStartTime, sessionStopTime, timestamp, retryCount "
-                                               @"FROM Event "
-                                               @"WHERE dirty = %@ "
-                                               @"ORDER BY timestamp ASC "
-                                               @"LIMIT 1000", [NSNumber numberWithInteger:AWSPinpointClientValidEvent]]];
+        AWSFMResultSet *rs = [db executeQuery:@"SELECT rowid, id, attributes, eventType, metrics, eventTimestamp, sessionId, sessionStartTime, sessionStopTime, timestamp, retryCount "
+                                              @"FROM Event "
+                                              @"WHERE dirty = :dirty AND rowid > :rowid "
+                                              @"ORDER BY rowid ASC "
+                                              @"LIMIT 1000"
+                      withParameterDictionary:@{
+                                                @"dirty" : @(AWSPinpointClientValidEvent),
+                                                @"rowid" : @(rowId)
+                                                }];
         if (!rs) {
             AWSDDLogError(@"SQLite error. Rolling back... [%@]", db.lastError);
             error = db.lastError;
@@ -591,101 +899,96 @@ NSString *const FAILURE_REASON = @"NSLocalizedFailureReason";
         }
         
         NSMutableDictionary *temporaryEventsWithEventId = [NSMutableDictionary new];
+        NSMutableArray<NSString *> *undecodableEventIds = [NSMutableArray new];
+        NSUInteger emptyRequestByteCount = [self encodedSizeOfPutEventsRequest:[self sizingRequestWithEvents:@{}]];
+        NSUInteger batchByteCount = 0;
+        int64_t lastRowId = rowId;
         while ([rs next]) {
-            [temporaryEventsWithEventId setObject:@{
-                                         @"id": [rs stringForColumn:@"id"],
-                                         @"attributes": [rs dataForColumn:@"attributes"],
-                                         @"eventType": [rs stringForColumn:@"eventType"],
-                                         @"metrics": [rs dataForColumn:@"metrics"],
-                                         @"eventTimestamp": [rs stringForColumn:@"eventTimestamp"],
-                                         @"sessionId": [rs stringForColumn:@"sessionId"],
-                                         @"sessionStartTime": [rs stringForColumn:@"sessionStartTime"],
-                                         @"sessionStopTime": [rs stringForColumn:@"sessionStopTime"]
-                                         } forKey:[rs stringForColumn:@"id"]];
+            NSMutableDictionary *eventRow = [@{
+                                               @"id": [rs stringForColumn:@"id"]
+                                               } mutableCopy];
             
-            NSData *batchData = [NSKeyedArchiver archivedDataWithRootObject:temporaryEventsWithEventId];
-            if ([batchData length] > self.batchRecordsByteLimit) { // if the batch size exceeds `batchRecordsByteLimit`, stop there.
+            // Each event is decoded and built into its service shape once; both travel with the row so that `sendEvents:` reuses them.
+            // An event that cannot be decoded can never be sent, so it is deleted instead of being retried on every submission.
+            AWSPinpointEvent *event = [self eventFromResultSet:rs database:db];
+            if (!event) {
+                [undecodableEventIds addObject:eventRow[@"id"]];
+                lastRowId = [rs longLongIntForColumn:@"rowid"];
+                continue;
+            }
+            AWSPinpointTargetingEvent *serviceEvent = [self buildEventPayload:event];
+            eventRow[@"event"] = event;
+            eventRow[@"serviceEvent"] = serviceEvent;
+            NSUInteger eventByteCount = [self encodedSizeOfServiceEvent:serviceEvent
+                                                                eventId:eventRow[@"id"]
+                                                  emptyRequestByteCount:emptyRequestByteCount];
+            
+            // If the event does not fit in `eventsByteLimit`, stop before it. An event larger than the limit is sent on its own.
+            if ([temporaryEventsWithEventId count] > 0 && batchByteCount + eventByteCount > eventsByteLimit) {
                 break;
             }
+            [temporaryEventsWithEventId setObject:eventRow forKey:eventRow[@"id"]];
+            batchByteCount += eventByteCount;
+            lastRowId = [rs longLongIntForColumn:@"rowid"];
         }
+        [rs close];
         rs = nil;
         
-        result(temporaryEventsWithEventId, error);
+        if ([undecodableEventIds count] > 0) {
+            AWSDDLogWarn(@"Deleting %lu events that cannot be decoded.", (unsigned long)[undecodableEventIds count]);
+            if (![self updateEventsWithIds:undecodableEventIds statement:nil database:db]) {
+                AWSDDLogError(@"SQLite error. Rolling back... [%@]", db.lastError);
+                error = db.lastError;
+                *rollback = YES;
+                result(nil, rowId, error);
+                return;
+            }
+        }
+        
+        result(temporaryEventsWithEventId, lastRowId, error);
     }];
 }
 
-- (AWSTask<NSDictionary <NSString *, NSDictionary *> *> *)submitBatchEvents:(NSDictionary*) eventsWithEventId{
-    AWSFMDatabaseQueue *databaseQueue = self.databaseQueue;
-    NSDictionary *temporaryEvents = [eventsWithEventId copy];
+// The size of the PutEvents body for `putEventsRequest`, serialized the way the targeting service sends it.
+- (NSUInteger)encodedSizeOfPutEventsRequest:(AWSPinpointTargetingPutEventsRequest *)putEventsRequest {
+    NSDictionary *parameters = [[AWSMTLJSONAdapter JSONDictionaryFromModel:putEventsRequest] aws_removeNullValues];
+    NSError *error = nil;
+    NSData *body = [AWSJSONBuilder jsonDataForDictionary:parameters
+                                              actionName:@"PutEvents"
+                                   serviceDefinitionRule:[[AWSPinpointTargetingResources sharedInstance] JSONObject]
+                                                   error:&error];
+    if (!body) {
+        AWSDDLogError(@"Failed to encode the PutEvents request. [%@]", error);
+        return 0;
+    }
+    return [body length];
+}
 
-    return [[AWSTask taskWithResult:nil] continueWithExecutor:[AWSExecutor executorWithDispatchQueue:[AWSPinpointEventRecorder sharedQueue]]
-                                             withSuccessBlock:^id _Nullable(AWSTask * _Nonnull task) {
-        __block NSError *error = nil;
-        __block NSMutableDictionary *events = [NSMutableDictionary new];
-        AWSTask *submitTask = [[self putEvents:temporaryEvents
-                                         error:&error]
-                               continueWithBlock:^id _Nullable(AWSTask * _Nonnull task) {                                   
-                                   if (task.error) {
-                                       error = task.error;
-                                       return [AWSTask taskWithError:task.error];
-                                   }
-                                   [events addEntriesFromDictionary:task.result];
-                                   return [AWSTask taskWithResult:events];
-                               }];
-        
-        return [[AWSTask taskForCompletionOfAllTasksWithResults:@[submitTask]] continueWithBlock:^id _Nullable(AWSTask * _Nonnull t) {
-            AWSTask *failTask = [AWSTask taskFromExecutor:[AWSExecutor executorWithDispatchQueue:[AWSPinpointEventRecorder sharedQueue]] withBlock:^id _Nonnull{
-                // If an event failed three times, mark even as dirty
-                [databaseQueue inTransaction:^(AWSFMDatabase *db, BOOL *rollback) {
-                    BOOL result = [db executeUpdate:[NSString stringWithFormat:
-                                                     @"UPDATE Event "
-                                                     @"SET dirty = %@ "
-                                                     @"WHERE retryCount > 3", [NSNumber numberWithInteger:AWSPinpointClientInvalidEvent]]];
-                    if (!result) {
-                        AWSDDLogError(@"SQLite error. [%@]", db.lastError);
-                        error = db.lastError;
-                    }
-                }];
-                return [AWSTask taskWithResult:nil];
-            }];
-            
-            AWSTask *moveTask = [AWSTask taskFromExecutor:[AWSExecutor executorWithDispatchQueue:[AWSPinpointEventRecorder sharedQueue]] withBlock:^id _Nonnull{
-                //Move dirty events into DirtyEvent table
-                [databaseQueue inTransaction:^(AWSFMDatabase *db, BOOL *rollback) {
-                    BOOL result = [db executeUpdate:[NSString stringWithFormat:
-                                                     @"INSERT INTO DirtyEvent "
-                                                     @"SELECT * FROM Event "
-                                                     @"WHERE dirty = %@ ", [NSNumber numberWithInteger:AWSPinpointClientInvalidEvent]]];
-                    if (!result) {
-                        AWSDDLogError(@"SQLite error. [%@]", db.lastError);
-                        error = db.lastError;
-                    }
-                }];
-                return [AWSTask taskWithResult:nil];
-            }];
-            
-            AWSTask *deleteTask = [AWSTask taskFromExecutor:[AWSExecutor executorWithDispatchQueue:[AWSPinpointEventRecorder sharedQueue]] withBlock:^id _Nonnull{
-                //Delete dirty events
-                [databaseQueue inTransaction:^(AWSFMDatabase *db, BOOL *rollback) {
-                    BOOL result = [db executeUpdate:[NSString stringWithFormat:
-                                                     @"DELETE FROM Event "
-                                                     @"WHERE dirty = %@ ", [NSNumber numberWithInteger:AWSPinpointClientInvalidEvent]]];
-                    if (!result) {
-                        AWSDDLogError(@"SQLite error. [%@]", db.lastError);
-                        error = db.lastError;
-                    }
-                }];
-                return [AWSTask taskWithResult:nil];
-            }];
-            
-            return [[AWSTask taskForCompletionOfAllTasksWithResults:@[failTask, moveTask, deleteTask]] continueWithBlock:^id _Nullable(AWSTask * _Nonnull t) {
-                if (error) {
-                    return [AWSTask taskWithError:error];
-                }
-                return [AWSTask taskWithResult:events];
-            }];
-        }];
-    }];
+// The room `batchRecordsByteLimit` leaves for events once the endpoint and the rest of the request are accounted for.
+- (NSUInteger)eventsByteLimitForEndpointProfile:(AWSPinpointEndpointProfile *)profile
+                                endpointPayload:(AWSPinpointTargetingPublicEndpoint *)endpoint {
+    NSUInteger envelopeByteCount = [self encodedSizeOfPutEventsRequest:[self buildRequestPayload:profile.applicationId
+                                                                                 endpointPayload:endpoint
+                                                                                      endpointId:profile.endpointId
+                                                                                   eventsPayload:@{}]];
+    return self.batchRecordsByteLimit > envelopeByteCount ? self.batchRecordsByteLimit - envelopeByteCount : 0;
+}
+
+// A request without an endpoint, which only serves to measure what events add to a request.
+- (AWSPinpointTargetingPutEventsRequest *)sizingRequestWithEvents:(NSDictionary *)events {
+    return [self buildRequestPayload:self.context.configuration.appId
+                     endpointPayload:nil
+                          endpointId:@""
+                       eventsPayload:events];
+}
+
+// The number of bytes `serviceEvent` adds to the PutEvents body, i.e. its `"eventId":{...}` entry in the events map and
+// the comma separating it from the next one. `emptyRequestByteCount` is the size of `sizingRequestWithEvents:` without events.
+- (NSUInteger)encodedSizeOfServiceEvent:(AWSPinpointTargetingEvent *)serviceEvent
+                                eventId:(NSString *)eventId
+                  emptyRequestByteCount:(NSUInteger)emptyRequestByteCount {
+    NSUInteger requestByteCount = [self encodedSizeOfPutEventsRequest:[self sizingRequestWithEvents:@{eventId : serviceEvent}]];
+    return requestByteCount > emptyRequestByteCount ? requestByteCount - emptyRequestByteCount + 1 : 0;
 }
 
 - (AWSTask *)removeAllEvents {
@@ -693,12 +996,13 @@ NSString *const FAILURE_REASON = @"NSLocalizedFailureReason";
     
     return [[AWSTask taskWithResult:nil] continueWithExecutor:[AWSExecutor executorWithDispatchQueue:[AWSPinpointEventRecorder sharedQueue]] withSuccessBlock:^id _Nullable(AWSTask * _Nonnull task) {
         __block NSError *error = nil;
-        [databaseQueue inDatabase:^(AWSFMDatabase *db) {
-            if (![db executeUpdate:@"DELETE FROM Event"]) {
-                AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+        [databaseQueue inTransaction:^(AWSFMDatabase *db, BOOL *rollback) {
+            if (![self deleteFromTable:@"Event" where:@"1" parameters:@{} database:db]
+                || ![self.codec removeKeysUnreferencedByTables:@[@"Event", @"DirtyEvent"] database:db]) {
                 error = db.lastError;
             }
         }];
+        [self reclaimFreePages];
         
         if (error) {
             return [AWSTask taskWithError:error];
@@ -713,12 +1017,13 @@ NSString *const FAILURE_REASON = @"NSLocalizedFailureReason";
     
     return [[AWSTask taskWithResult:nil] continueWithExecutor:[AWSExecutor executorWithDispatchQueue:[AWSPinpointEventRecorder sharedQueue]] withSuccessBlock:^id _Nullable(AWSTask * _Nonnull task) {
         __block NSError *error = nil;
-        [databaseQueue inDatabase:^(AWSFMDatabase *db) {
-            if (![db executeUpdate:@"DELETE FROM DirtyEvent"]) {
-                AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+        [databaseQueue inTransaction:^(AWSFMDatabase *db, BOOL *rollback) {
+            if (![self deleteFromTable:@"DirtyEvent" where:@"1" parameters:@{} database:db]
+                || ![self.codec removeKeysUnreferencedByTables:@[@"Event", @"DirtyEvent"] database:db]) {
                 error = db.lastError;
             }
         }];
+        [self reclaimFreePages];
         
         if (error) {
             return [AWSTask taskWithError:error];
@@ -729,15 +1034,7 @@ NSString *const FAILURE_REASON = @"NSLocalizedFailureReason";
 }
 
 - (uint64_t)diskBytesUsed {
-    NSError *error = nil;
-    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:self.databasePath
-                                                                                error:&error];
-    if (attributes) {
-        return [attributes fileSize];
-    } else {
-        AWSDDLogError(@"Error [%@]", error);
-        return 0;
-    }
+    return self.storedByteCount + self.codec.keyByteCount;
 }
 
 - (void)setBatchRecordsByteLimit:(NSUInteger)batchRecordsByteLimit {
@@ -824,11 +1121,6 @@ NSString *const FAILURE_REASON = @"NSLocalizedFailureReason";
     return (NSDictionary *)processedEvents;
 }
 
-- (AWSTask *) putEvents:(NSDictionary *) temporaryEvents
-                 error:(NSError* __autoreleasing *) error {
-    return [self putEvents:temporaryEvents error:error endpointProfile:self.profile];
-}
-
 - (NSError *) processError:(NSError *) PinpointError {
     if (PinpointError.domain == AWSPinpointTargetingErrorDomain) {
         if (PinpointError.code == AWSPinpointTargetingErrorBadRequest) {
@@ -845,160 +1137,153 @@ NSString *const FAILURE_REASON = @"NSLocalizedFailureReason";
     }
 }
 
-- (AWSTask *)putEvents:(NSDictionary *) temporaryEvents
-                 error:(NSError* __autoreleasing *) error
-       endpointProfile:(AWSPinpointEndpointProfile *) profile {
-    AWSFMDatabaseQueue *databaseQueue = self.databaseQueue;
+- (AWSTask<AWSPinpointTargetingPutEventsResponse *> *)sendEvents:(NSDictionary *)eventsWithEventId
+                                                 endpointProfile:(AWSPinpointEndpointProfile *)profile
+                                                 endpointPayload:(AWSPinpointTargetingPublicEndpoint *)endpoint {
+    NSMutableDictionary *serviceEvents = [NSMutableDictionary new];
+    for (NSString *eventId in eventsWithEventId) {
+        AWSPinpointTargetingEvent *serviceEvent = eventsWithEventId[eventId][@"serviceEvent"];
+        if (serviceEvent) {
+            [serviceEvents setObject:serviceEvent forKey:eventId];
+        }
+    }
+    
+    AWSPinpointTargetingPutEventsRequest *putEventsRequest = [self buildRequestPayload:profile.applicationId
+                                                                       endpointPayload:endpoint
+                                                                            endpointId:profile.endpointId
+                                                                         eventsPayload:serviceEvents];
     
-    __block NSMutableDictionary *events = [NSMutableDictionary new]; //events to be submitted, and returned back to caller for debugging
-    __block NSDictionary *_temporaryEvents = [temporaryEvents copy]; //aggregate attributes, metrics...
-    for (NSString *eventId in _temporaryEvents) {
-        NSMutableDictionary *attributes;
+    AWSDDLogVerbose(@"PutEventsRequest: [%@]", putEventsRequest);
+    
+    return [self.context.targetingService putEvents:putEventsRequest];
+}
 
-        if ([_temporaryEvents[eventId] objectForKey:@"attributes"]) {
-            attributes = [NSKeyedUnarchiver unarchiveObjectWithData:_temporaryEvents[eventId][@"attributes"]];
-        }
-        NSMutableDictionary *metrics;
-        if ([_temporaryEvents[eventId] objectForKey:@"metrics"]) {
-            metrics = [NSKeyedUnarchiver unarchiveObjectWithData:_temporaryEvents[eventId][@"metrics"]];
+// Applies the outcome of a completed batch to the Event table in a single transaction: accepted events are deleted,
+// retryable ones have their retry count bumped, and rejected ones, along with events retried more than three times,
+// are moved to the DirtyEvent table. Returns the accepted events.
+- (NSArray<AWSPinpointEvent *> *)finishBatch:(AWSPinpointEventRecorderBatch *)batch
+                                retryPending:(BOOL *)retryPending
+                                       error:(NSError * __autoreleasing *)error {
+    NSDictionary *eventsWithEventId = batch.eventsWithEventId;
+    AWSTask<AWSPinpointTargetingPutEventsResponse *> *task = batch.task;
+    NSArray *acceptedEventIds = @[];
+    NSArray *retryableEventIds = @[];
+    NSArray *dirtyEventIds = @[];
+    NSMutableArray<AWSPinpointEvent *> *acceptedEvents = [NSMutableArray new];
+    NSError *submissionError = nil;
+    
+    if (task.error) {
+        //PutEvents encountered an exception
+        AWSDDLogError(@"PutEvents Error: [%@]", task.error);
+        if (![self isRetryable:task.error]) {
+            NSInteger responseCode = [task.error.userInfo[@"responseStatusCode"] integerValue];
+            AWSDDLogError(@"Server rejected submission of %lu events. (Events will be marked dirty.) Response code:%ld, Error Message:%@", (unsigned long)[eventsWithEventId count], (long)responseCode, task.error);
+            dirtyEventIds = [eventsWithEventId allKeys];
+            submissionError = [self processError:task.error];
+        } else {
+            AWSDDLogError(@"Unable to successfully deliver events to server. Events will be retried. Error Message:%@", task.error);
+            retryableEventIds = [eventsWithEventId allKeys];
+            submissionError = task.error;
         }
+    } else {
+        //PutEventsRequest succeeded, parse the PutEventsResponse
+        AWSDDLogVerbose(@"PutEventsResponse received: [%@]", task.result);
         
-        AWSPinpointSession *session;
-        if ([_temporaryEvents[eventId] objectForKey:@"sessionId"] &&
-            [_temporaryEvents[eventId] objectForKey:@"sessionStartTime"] &&
-            [_temporaryEvents[eventId] objectForKey:@"sessionStopTime"]) {
-            session = [[AWSPinpointSession alloc] initWithSessionId:_temporaryEvents[eventId][@"sessionId"]
-                                                      withStartTime:[NSDate aws_dateFromString:_temporaryEvents[eventId][@"sessionStartTime"] format:AWSDateISO8601DateFormat3]
-                                                       withStopTime:[NSDate aws_dateFromString:_temporaryEvents[eventId][@"sessionStopTime"] format:AWSDateISO8601DateFormat3]];
-        }
+        [self processEndpointResponse:self.profile.endpointId
+                       resultResponse:task.result];
         
-        AWSPinpointEvent *event;
-        if ([_temporaryEvents[eventId] objectForKey:@"eventType"] && [_temporaryEvents[eventId] objectForKey:@"eventTimestamp"]) {
-             event = [[AWSPinpointEvent alloc] initWithEventType:_temporaryEvents[eventId][@"eventType"]
-                                                  eventTimestamp:[AWSPinpointDateUtils utcTimeMillisFromISO8061String:_temporaryEvents[eventId][@"eventTimestamp"]]
-                                                         session:session
-                                                      attributes:attributes
-                                                         metrics:metrics];
-            [events setObject:event forKey:eventId];
+        NSMutableDictionary *events = [NSMutableDictionary new];
+        for (NSString *eventId in eventsWithEventId) {
+            if (eventsWithEventId[eventId][@"event"]) {
+                events[eventId] = eventsWithEventId[eventId][@"event"];
+            }
         }
+        NSDictionary *processedEvents = [self processEventsResponse:eventsWithEventId
+                                                         endpointId:self.profile.endpointId
+                                                     resultResponse:task.result
+                                                     returnedEvents:events];
+        acceptedEventIds = [processedEvents[@"acceptedEvents"] allKeys];
+        retryableEventIds = [processedEvents[@"retryableEvents"] allKeys];
+        dirtyEventIds = [processedEvents[@"dirtyEvents"] allKeys];
+        
+        AWSDDLogInfo(@"Successfully put events to server--response code: 202. accepted: %u; retryable: %u; dirty: %u",
+                     (unsigned int)[acceptedEventIds count],
+                     (unsigned int)[retryableEventIds count],
+                     (unsigned int)[dirtyEventIds count]);
         
+        for (NSDictionary *object in [events allValues]) {
+            if ([object isKindOfClass:[NSDictionary class]] && [[object objectForKey:@"statusCode"] intValue] == 202) {
+                [acceptedEvents addObject:[object objectForKey:@"event"]];
+            }
+        }
     }
     
-    AWSPinpointTargetingPutEventsRequest *putEventsRequest = [self putEventsRequestForEvents:events
-                                                                             endpointProfile:profile];
+    *retryPending = [retryableEventIds count] > 0 && !submissionError;
     
-    AWSDDLogVerbose(@"PutEventsRequest: [%@]", putEventsRequest);
+    __block NSError *databaseError = nil;
+    [self.databaseQueue inTransaction:^(AWSFMDatabase *db, BOOL *rollback) {
+        BOOL result = [self updateEventsWithIds:acceptedEventIds
+                                      statement:nil
+                                       database:db]
+        && [self updateEventsWithIds:retryableEventIds
+                           statement:@"UPDATE Event SET retryCount = retryCount + 1"
+                            database:db]
+        && [self updateEventsWithIds:dirtyEventIds
+                           statement:[NSString stringWithFormat:@"UPDATE Event SET dirty = %@", @(AWSPinpointClientInvalidEvent)]
+                            database:db]
+        // If an event failed three times, mark even as dirty
+        && [db executeUpdate:[NSString stringWithFormat:
+                              @"UPDATE Event "
+                              @"SET dirty = %@ "
+                              @"WHERE retryCount > 3", @(AWSPinpointClientInvalidEvent)]]
+        //Move dirty events into DirtyEvent table
+        && [db executeUpdate:[NSString stringWithFormat:
+                              @"INSERT INTO DirtyEvent "
+                              @"SELECT * FROM Event "
+                              @"WHERE dirty = %@ ", @(AWSPinpointClientInvalidEvent)]]
+        && [db executeUpdate:[NSString stringWithFormat:
+                              @"DELETE FROM Event "
+                              @"WHERE dirty = %@ ", @(AWSPinpointClientInvalidEvent)]];
+        if (!result) {
+            AWSDDLogError(@"SQLite error. Rolling back... [%@]", db.lastError);
+            databaseError = db.lastError;
+            *rollback = YES;
+        }
+    }];
     
-    return [[self.context.targetingService putEvents:putEventsRequest] continueWithBlock:^id _Nullable(AWSTask * _Nonnull task) {
-        //PutEvents encountered an exception
-        if (task.error) {
-            AWSDDLogError(@"PutEvents Error: [%@]", task.error);
-            if (![self isRetryable:task.error]) {
-                NSInteger responseCode = [task.error.userInfo[@"responseStatusCode"] integerValue];
-                AWSDDLogError(@"Server rejected submission of %lu events. (Events will be marked dirty.) Response code:%ld, Error Message:%@", (unsigned long)[events count], (long)responseCode, task.error);
-                
-                return [AWSTask taskForCompletionOfAllTasksWithResults:@[[AWSTask taskFromExecutor:[AWSExecutor executorWithDispatchQueue:[AWSPinpointEventRecorder sharedQueue]] withBlock:^id _Nonnull{
-                    for (__block NSString *eventID in _temporaryEvents) {
-                        [databaseQueue inTransaction:^(AWSFMDatabase *db, BOOL *rollback) {
-                            BOOL result = [db executeUpdate:[NSString stringWithFormat:@"UPDATE Event SET dirty = %@ WHERE id = :id", [NSNumber numberWithInteger:AWSPinpointClientInvalidEvent]]
-                                    withParameterDictionary:@{
-                                                              @"id" : eventID
-                                                              }];
-                            if (!result) {
-                                AWSDDLogError(@"SQLite error. [%@]", db.lastError);
-                                *error = db.lastError;
-                            }
-                        }];
-                    }
-                    return [AWSTask taskWithError:[self processError:task.error]];
-                }]]];
-            } else {
-                AWSDDLogError(@"Unable to successfully deliver events to server. Events will be retried. Error Message:%@", task.error);
-                return [AWSTask taskForCompletionOfAllTasksWithResults:@[[AWSTask taskFromExecutor:[AWSExecutor executorWithDispatchQueue:[AWSPinpointEventRecorder sharedQueue]] withBlock:^id _Nonnull{
-                    for (__block NSString *eventID in _temporaryEvents) {
-                        [databaseQueue inTransaction:^(AWSFMDatabase *db, BOOL *rollback) {
-                            BOOL result = [db executeUpdate:@"UPDATE Event SET retryCount = retryCount + 1 WHERE id = :id"
-                                    withParameterDictionary:@{
-                                                              @"id" : eventID
-                                                              }];
-                            if (!result) {
-                                AWSDDLogError(@"SQLite error. [%@]", db.lastError);
-                                *error = db.lastError;
-                            }
-                        }];
-                    }
-                    return task;
-                }]]];
-            }
+    if (submissionError || databaseError) {
+        *error = submissionError ?: databaseError;
+    }
+    return acceptedEvents;
+}
+
+// Runs `statement` for the events with `eventIds`, appending `WHERE id IN (...)`, or deletes them if `statement` is nil.
+- (BOOL)updateEventsWithIds:(NSArray<NSString *> *)eventIds
+                  statement:(NSString *)statement
+                   database:(AWSFMDatabase *)db {
+    for (NSUInteger location = 0; location < [eventIds count]; location += AWSPinpointClientStatementIdLimit) {
+        NSRange range = NSMakeRange(location, MIN(AWSPinpointClientStatementIdLimit, [eventIds count] - location));
+        NSMutableDictionary *parameters = [NSMutableDictionary new];
+        NSMutableArray *placeholders = [NSMutableArray new];
+        for (NSUInteger i = 0; i < range.length; i++) {
+            NSString *name = [NSString stringWithFormat:@"id%lu", (unsigned long)i];
+            parameters[name] = eventIds[range.location + i];
+            [placeholders addObject:[@":" stringByAppendingString:name]];
         }
+        NSString *predicate = [NSString stringWithFormat:@"id IN (%@)", [placeholders componentsJoinedByString:@", "]];
         
-        //PutEventsRequest succeeded, parse the PutEventsResponse
-        if (task.result) {
-            AWSDDLogVerbose(@"PutEventsResponse received: [%@]", task.result);
-            
-            [self processEndpointResponse:self.profile.endpointId
-                           resultResponse:task.result];
-            
-            NSDictionary *_processedEvents = [self processEventsResponse:_temporaryEvents
-                                                              endpointId:self.profile.endpointId
-                                                          resultResponse:task.result
-                                                          returnedEvents:events];
-
-            AWSDDLogInfo(@"Successfully put events to server--response code: 202. accepted: %u; retryable: %u; dirty: %u",
-                         (unsigned int)[[_processedEvents objectForKey:@"acceptedEvents"] count],
-                         (unsigned int)[[_processedEvents objectForKey:@"retryableEvents"] count],
-                         (unsigned int)[[_processedEvents objectForKey:@"dirtyEvents"] count]);
-
-            return [[AWSTask taskForCompletionOfAllTasksWithResults:@[[AWSTask taskFromExecutor:[AWSExecutor executorWithDispatchQueue:[AWSPinpointEventRecorder sharedQueue]] withBlock:^id _Nonnull{
-                //submitted events, update database
-                for (__block NSString *eventID in [_processedEvents objectForKey:@"acceptedEvents"]) {
-                    [databaseQueue inTransaction:^(AWSFMDatabase *db, BOOL *rollback) {
-                        BOOL result = [db executeUpdate:@"DELETE FROM Event WHERE id = :id"
-                                withParameterDictionary:@{
-                                                          @"id" : eventID
-                                                          }];
-                        if (!result) {
-                            AWSDDLogError(@"SQLite error. [%@]", db.lastError);
-                            *error = db.lastError;
-                        }
-                    }];
-                }
-                //retryable events, update database
-                for (__block NSString *eventID in [_processedEvents objectForKey:@"retryableEvents"]) {
-                    [databaseQueue inTransaction:^(AWSFMDatabase *db, BOOL *rollback) {
-                        BOOL result = [db executeUpdate:@"UPDATE Event SET retryCount = retryCount + 1 WHERE id = :id"
-                                withParameterDictionary:@{
-                                                          @"id" : eventID
-                                                          }];
-                        if (!result) {
-                            AWSDDLogError(@"SQLite error. [%@]", db.lastError);
-                            *error = db.lastError;
-                        }
-                    }];
-                }
-                
-                //rejected events, mark dirty, update database
-                for (__block NSString *eventID in [_processedEvents objectForKey:@"dirtyEvents"]) {
-                    [databaseQueue inTransaction:^(AWSFMDatabase *db, BOOL *rollback) {
-                        BOOL result = [db executeUpdate:[NSString stringWithFormat:@"UPDATE Event SET dirty = %@ WHERE id = :id", [NSNumber numberWithInteger:AWSPinpointClientInvalidEvent]]
-                                withParameterDictionary:@{
-                                                          @"id" : eventID
-                                                          }];
-                        if (!result) {
-                            AWSDDLogError(@"SQLite error. [%@]", db.lastError);
-                            *error = db.lastError;
-                        }
-                    }];
-                }
-                
-                return task;
-            }]]] continueWithBlock:^id _Nullable(AWSTask * _Nonnull t) {
-                return [AWSTask taskWithResult:events];
-            }];
+        BOOL result;
+        if (statement) {
+            result = [db executeUpdate:[NSString stringWithFormat:@"%@ WHERE %@", statement, predicate]
+               withParameterDictionary:parameters];
+        } else {
+            result = [self deleteFromTable:@"Event" where:predicate parameters:parameters database:db];
         }
-        
-        return task;
-    }];
+        if (!result) {
+            return NO;
+        }
+    }
+    return YES;
 }
 
 - (AWSPinpointTargetingPublicEndpoint*) buildEndpointRequestPayload:(AWSPinpointEndpointProfile *) profile {
@@ -1110,26 +1395,4 @@ NSString *const FAILURE_REASON = @"NSLocalizedFailureReason";
     return putEventsRequest;
 }
 
-- (AWSPinpointTargetingPutEventsRequest*) putEventsRequestForEvents:(NSDictionary*) events
-                                                    endpointProfile:(AWSPinpointEndpointProfile*) profile {
-    //build endpoint payload
-    AWSPinpointTargetingPublicEndpoint *endpoint = [self buildEndpointRequestPayload:profile];
-    
-    //build events payload
-    NSMutableDictionary *parsedEventsDictionary = [NSMutableDictionary new];
-    for (NSString *eventId in events) {
-        AWSPinpointTargetingEvent *serviceEvent = [self buildEventPayload:events[eventId]];
-        [parsedEventsDictionary setObject:serviceEvent forKey:eventId];
-    }
-    
-    //build the PutEventsRequest that contains the endpoint and the events
-    AWSPinpointTargetingPutEventsRequest *putEventRequest = [self
-                            buildRequestPayload:profile.applicationId
-                                endpointPayload:endpoint
-                                     endpointId:profile.endpointId
-                                  eventsPayload:parsedEventsDictionary];
-    
-    return putEventRequest;
-}
-
 @end
@@ -21,6 +21,16 @@ NS_ASSUME_NONNULL_BEGIN
 
 @interface AWSPinpointTargetingClient : NSObject
 
+/**
+ * The number of endpoint updates skipped because the profile matched the last one the service acknowledged.
+ */
+@property (atomic, readonly) NSUInteger skippedUpdateCount;
+
+/**
+ * The number of endpoint updates that sent only the attributes and metrics changed since the last acknowledged profile.
+ */
+@property (atomic, readonly) NSUInteger reducedUpdateCount;
+
 /**
  * Returns the current endpoint.
  * @return (id<AWSPinpointEndpoint>)
@@ -28,7 +38,8 @@ NS_ASSUME_NONNULL_BEGIN
 - (AWSPinpointEndpointProfile*) currentEndpointProfile;
 
 /**
- * Sends an update of the current endpoint
+ * Sends an update of the current endpoint. The update is skipped when the endpoint has not changed since the last
+ * update the service acknowledged, in which case the task result is nil.
  */
 - (AWSTask *)updateEndpointProfile;
 
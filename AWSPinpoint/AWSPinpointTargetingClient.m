@@ -27,6 +27,14 @@
 NSString *const AWSPinpointEndpointAttributesKey = @"AWSPinpointEndpointAttributesKey";
 NSString *const AWSPinpointEndpointMetricsKey = @"AWSPinpointEndpointMetricsKey";
 NSString *const AWSPinpointEndpointProfileKey = @"AWSPinpointEndpointProfileKey";
+NSString *const AWSPinpointEndpointAcknowledgedUpdateKey = @"AWSPinpointEndpointAcknowledgedUpdateKey";
+NSString *const AWSPinpointEndpointAcknowledgedUpdateDigestKey = @"digest";
+NSString *const AWSPinpointEndpointAcknowledgedUpdateEndpointIdKey = @"endpointId";
+NSString *const AWSPinpointEndpointAcknowledgedUpdateApplicationIdKey = @"applicationId";
+NSString *const AWSPinpointEndpointAcknowledgedUpdateAttributesKey = @"attributes";
+NSString *const AWSPinpointEndpointAcknowledgedUpdateMetricsKey = @"metrics";
+NSString *const AWSPinpointEndpointAcknowledgedUpdateDateKey = @"date";
+NSTimeInterval const AWSPinpointEndpointProfileRefreshInterval = 24 * 60 * 60; // Sends the full profile at least daily.
 NSString *const AWSPinpointTargetingClientErrorDomain = @"com.amazonaws.AWSPinpointAnalyticsClientErrorDomain";
 NSString *const APNS_CHANNEL_TYPE = @"APNS";
 
@@ -38,6 +46,10 @@ NSString *const APNS_CHANNEL_TYPE = @"APNS";
 @property (nonatomic) NSMutableDictionary* globalMetrics;
 @property (nonatomic, strong) AWSPinpointEventRecorder *eventRecorder;
 @property (nonatomic) AWSPinpointEndpointProfile *endpointProfile;
+@property (atomic, readwrite) NSUInteger skippedUpdateCount;
+@property (atomic, readwrite) NSUInteger reducedUpdateCount;
+// The digests of the last update the service acknowledged and when it was acknowledged, as stored in the user defaults.
+@property (nonatomic, strong) NSDictionary *acknowledgedUpdate;
 
 @end
 
@@ -56,9 +68,6 @@ NSString *const APNS_CHANNEL_TYPE = @"APNS";
 @interface AWSPinpointEventRecorder ()
 - (instancetype) initWithContext:(AWSPinpointContext *) context;
 - (AWSTask*) updateSessionStartWithCampaignAttributes:(NSDictionary*) attributes;
-- (AWSTask *) putEvents:(NSDictionary *)temporaryEvents
-                  error:(NSError* __autoreleasing *) error
-        endpointProfile:(AWSPinpointEndpointProfile *) profile;
 @end
 
 @implementation AWSPinpointTargetingClient
@@ -77,6 +86,15 @@ NSString *const APNS_CHANNEL_TYPE = @"APNS";
         NSDictionary *customMetrics = [context.configuration.userDefaults objectForKey:AWSPinpointEndpointMetricsKey];
         _globalMetrics = [[NSMutableDictionary alloc] initWithDictionary:customMetrics];
         _eventRecorder = [[AWSPinpointEventRecorder alloc] initWithContext:context];
+        NSDictionary *acknowledgedUpdate = [context.configuration.userDefaults objectForKey:AWSPinpointEndpointAcknowledgedUpdateKey];
+        if ([acknowledgedUpdate isKindOfClass:[NSDictionary class]]
+            && [acknowledgedUpdate[AWSPinpointEndpointAcknowledgedUpdateDigestKey] isKindOfClass:[NSString class]]
+            && [acknowledgedUpdate[AWSPinpointEndpointAcknowledgedUpdateDateKey] isKindOfClass:[NSDate class]]) {
+            _acknowledgedUpdate = acknowledgedUpdate;
+        } else if (acknowledgedUpdate) {
+            [context.configuration.userDefaults removeObjectForKey:AWSPinpointEndpointAcknowledgedUpdateKey];
+            [context.configuration.userDefaults synchronize];
+        }
     }
     
     return self;
@@ -95,7 +113,9 @@ NSString *const APNS_CHANNEL_TYPE = @"APNS";
             } else {
                 @synchronized (self) {
                     [self.context.configuration.userDefaults removeObjectForKey:AWSPinpointEndpointProfileKey];
+                    [self.context.configuration.userDefaults removeObjectForKey:AWSPinpointEndpointAcknowledgedUpdateKey];
                     [self.context.configuration.userDefaults synchronize];
+                    self.acknowledgedUpdate = nil;
                 }
                 localEndpointProfile = [[AWSPinpointEndpointProfile alloc] initWithContext: self.context];
             }
@@ -164,17 +184,172 @@ NSString *const APNS_CHANNEL_TYPE = @"APNS";
         [self.context.configuration.userDefaults setObject:endpointProfileData forKey:AWSPinpointEndpointProfileKey];
         [self.context.configuration.userDefaults synchronize];
     }
-    return [[self.context.targetingService updateEndpoint:[self updateEndpointRequestForEndpoint:self.endpointProfile]] continueWithBlock:^id _Nullable(AWSTask * _Nonnull task) {
+    
+    AWSPinpointTargetingUpdateEndpointRequest *updateEndpointRequest = [self updateEndpointRequestForEndpoint:self.endpointProfile];
+    NSDictionary *update = [self digestsOfUpdateEndpointRequest:updateEndpointRequest];
+    AWSPinpointTargetingUpdateEndpointRequest *requestToSend = nil;
+    @synchronized (self) {
+        requestToSend = [self requestToSendForUpdateEndpointRequest:updateEndpointRequest
+                                                            digests:update];
+        if (!requestToSend) {
+            self.skippedUpdateCount += 1;
+            AWSDDLogVerbose(@"Endpoint is unchanged since the last update. Skipping the update.");
+            return [AWSTask taskWithResult:nil];
+        }
+        if (requestToSend != updateEndpointRequest) {
+            self.reducedUpdateCount += 1;
+        }
+    }
+    
+    return [[self.context.targetingService updateEndpoint:requestToSend] continueWithBlock:^id _Nullable(AWSTask * _Nonnull task) {
         if (task.error) {
             AWSDDLogError(@"Unable to successfully update endpoint. Error Message:%@", task.error);
             return task;
         } else {
             AWSDDLogVerbose(@"Endpoint Updated Successfully! %@", task.result);
+            [self acknowledgeUpdate:update];
             return task;
         }
     }];
 }
 
+// Dictionaries become arrays of key-value pairs sorted by key, so equal values always serialize to the same JSON.
+static id AWSPinpointCanonicalJSONObject(id object) {
+    if ([object isKindOfClass:[NSDictionary class]]) {
+        NSMutableArray *pairs = [NSMutableArray new];
+        for (NSString *key in [[object allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+            [pairs addObject:@[key, AWSPinpointCanonicalJSONObject([object objectForKey:key])]];
+        }
+        return pairs;
+    }
+    if ([object isKindOfClass:[NSArray class]]) {
+        NSMutableArray *elements = [NSMutableArray new];
+        for (id element in object) {
+            [elements addObject:AWSPinpointCanonicalJSONObject(element)];
+        }
+        return elements;
+    }
+    return object;
+}
+
+// The hex encoded SHA-256 of the canonical JSON of `object`, or nil if it can't be serialized.
+static NSString *AWSPinpointDigestOfJSONObject(id object) {
+    NSError *error = nil;
+    NSData *JSONData = [NSJSONSerialization dataWithJSONObject:@[AWSPinpointCanonicalJSONObject(object)]
+                                                       options:0
+                                                         error:&error];
+    if (!JSONData) {
+        AWSDDLogError(@"Failed to serialize the endpoint update. [%@]", error);
+        return nil;
+    }
+    NSString *hash = [[NSString alloc] initWithData:[AWSSignatureSignerUtility hash:JSONData]
+                                           encoding:NSASCIIStringEncoding];
+    return [AWSSignatureSignerUtility hexEncode:hash];
+}
+
+// The digests of everything in the update request but its effective date, along with a digest of each attribute and
+// metric so that a later update can tell which of them changed. Returns nil if the request can't be serialized.
+- (NSDictionary *)digestsOfUpdateEndpointRequest:(AWSPinpointTargetingUpdateEndpointRequest *)updateEndpointRequest {
+    NSMutableDictionary *JSONDictionary = [[[AWSMTLJSONAdapter JSONDictionaryFromModel:updateEndpointRequest] aws_removeNullValues] mutableCopy];
+    NSMutableDictionary *endpointJSONDictionary = [JSONDictionary[@"EndpointRequest"] mutableCopy];
+    [endpointJSONDictionary removeObjectForKey:@"EffectiveDate"];
+    if (endpointJSONDictionary) {
+        JSONDictionary[@"EndpointRequest"] = endpointJSONDictionary;
+    }
+    NSString *digest = AWSPinpointDigestOfJSONObject(JSONDictionary);
+    if (!digest || !updateEndpointRequest.endpointId || !updateEndpointRequest.applicationId) {
+        return nil;
+    }
+    
+    NSMutableDictionary *attributeDigests = [NSMutableDictionary new];
+    for (NSString *key in updateEndpointRequest.endpointRequest.attributes) {
+        attributeDigests[key] = AWSPinpointDigestOfJSONObject(updateEndpointRequest.endpointRequest.attributes[key]);
+    }
+    NSMutableDictionary *metricDigests = [NSMutableDictionary new];
+    for (NSString *key in updateEndpointRequest.endpointRequest.metrics) {
+        metricDigests[key] = AWSPinpointDigestOfJSONObject(updateEndpointRequest.endpointRequest.metrics[key]);
+    }
+    return @{AWSPinpointEndpointAcknowledgedUpdateDigestKey : digest,
+             AWSPinpointEndpointAcknowledgedUpdateEndpointIdKey : updateEndpointRequest.endpointId,
+             AWSPinpointEndpointAcknowledgedUpdateApplicationIdKey : updateEndpointRequest.applicationId,
+             AWSPinpointEndpointAcknowledgedUpdateAttributesKey : attributeDigests,
+             AWSPinpointEndpointAcknowledgedUpdateMetricsKey : metricDigests};
+}
+
+// Returns nil when the endpoint matches the last acknowledged update, a copy of `updateEndpointRequest` carrying only
+// the changed attributes and metrics when the rest of them were acknowledged, or `updateEndpointRequest` itself.
+// UpdateEndpoint merges attributes and metrics into the stored endpoint, so a removed key always sends the full profile.
+- (AWSPinpointTargetingUpdateEndpointRequest *)requestToSendForUpdateEndpointRequest:(AWSPinpointTargetingUpdateEndpointRequest *)updateEndpointRequest
+                                                                             digests:(NSDictionary *)digests {
+    NSDictionary *acknowledged = self.acknowledgedUpdate;
+    NSDate *acknowledgedDate = acknowledged[AWSPinpointEndpointAcknowledgedUpdateDateKey];
+    if (!digests
+        || !acknowledged
+        || -[acknowledgedDate timeIntervalSinceNow] > AWSPinpointEndpointProfileRefreshInterval) {
+        return updateEndpointRequest;
+    }
+    if ([acknowledged[AWSPinpointEndpointAcknowledgedUpdateDigestKey] isEqual:digests[AWSPinpointEndpointAcknowledgedUpdateDigestKey]]) {
+        return nil;
+    }
+    if (![acknowledged[AWSPinpointEndpointAcknowledgedUpdateEndpointIdKey] isEqual:digests[AWSPinpointEndpointAcknowledgedUpdateEndpointIdKey]]
+        || ![acknowledged[AWSPinpointEndpointAcknowledgedUpdateApplicationIdKey] isEqual:digests[AWSPinpointEndpointAcknowledgedUpdateApplicationIdKey]]) {
+        return updateEndpointRequest;
+    }
+    
+    NSDictionary *changedAttributes = [self changedEntriesOf:updateEndpointRequest.endpointRequest.attributes
+                                                     digests:digests[AWSPinpointEndpointAcknowledgedUpdateAttributesKey]
+                                                        from:acknowledged[AWSPinpointEndpointAcknowledgedUpdateAttributesKey]];
+    NSDictionary *changedMetrics = [self changedEntriesOf:updateEndpointRequest.endpointRequest.metrics
+                                                  digests:digests[AWSPinpointEndpointAcknowledgedUpdateMetricsKey]
+                                                     from:acknowledged[AWSPinpointEndpointAcknowledgedUpdateMetricsKey]];
+    if (!changedAttributes || !changedMetrics
+        || ([changedAttributes count] == [updateEndpointRequest.endpointRequest.attributes count]
+            && [changedMetrics count] == [updateEndpointRequest.endpointRequest.metrics count])) {
+        return updateEndpointRequest;
+    }
+    
+    AWSPinpointTargetingUpdateEndpointRequest *reducedRequest = [updateEndpointRequest copy];
+    reducedRequest.endpointRequest = [updateEndpointRequest.endpointRequest copy];
+    reducedRequest.endpointRequest.attributes = [changedAttributes count] > 0 ? changedAttributes : nil;
+    reducedRequest.endpointRequest.metrics = [changedMetrics count] > 0 ? changedMetrics : nil;
+    return reducedRequest;
+}
+
+// The entries of `current` whose digests are new or differ from `acknowledgedDigests`, or nil if a key of
+// `acknowledgedDigests` was removed.
+- (NSDictionary *)changedEntriesOf:(NSDictionary *)current
+                           digests:(NSDictionary *)currentDigests
+                              from:(NSDictionary *)acknowledgedDigests {
+    if (![acknowledgedDigests isKindOfClass:[NSDictionary class]]) {
+        return nil;
+    }
+    for (NSString *key in acknowledgedDigests) {
+        if (![currentDigests objectForKey:key]) {
+            return nil;
+        }
+    }
+    NSMutableDictionary *changedEntries = [NSMutableDictionary new];
+    for (NSString *key in current) {
+        if (![[acknowledgedDigests objectForKey:key] isEqual:[currentDigests objectForKey:key]]) {
+            [changedEntries setObject:[current objectForKey:key] forKey:key];
+        }
+    }
+    return changedEntries;
+}
+
+- (void)acknowledgeUpdate:(NSDictionary *)digests {
+    if (!digests) {
+        return;
+    }
+    @synchronized (self) {
+        NSMutableDictionary *acknowledgedUpdate = [digests mutableCopy];
+        acknowledgedUpdate[AWSPinpointEndpointAcknowledgedUpdateDateKey] = [NSDate date];
+        self.acknowledgedUpdate = acknowledgedUpdate;
+        [self.context.configuration.userDefaults setObject:acknowledgedUpdate forKey:AWSPinpointEndpointAcknowledgedUpdateKey];
+        [self.context.configuration.userDefaults synchronize];
+    }
+}
+
 - (void) verifyMinimumLengthForKey:(NSString*) key {
     if (key.length < 1) {
         @throw [NSException exceptionWithName:AWSPinpointTargetingClientErrorDomain
@@ -0,0 +1,85 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+#import <AWSCore/AWSCore.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The version of the binary format written by `AWSPinpointEventCodec`. It is the first byte of every encoded value.
+ */
+FOUNDATION_EXPORT const uint8_t AWSPinpointEventCodecFormatVersion;
+
+/**
+ The number of keys interned after which `shouldRemoveUnreferencedKeys` becomes `YES` again.
+ */
+FOUNDATION_EXPORT const NSUInteger AWSPinpointEventCodecKeyRemovalInterval;
+
+/**
+ Encodes event attributes and metrics into the compact binary form stored in the event database.
+
+ An encoded value is a format version byte, a varint entry count and the entries. An attribute entry is a varint key id, a varint byte length and the UTF-8 bytes of the value. A metric entry is a varint key id, a type byte and either a zigzag varint for integral values or an 8-byte little-endian double.
+
+ Keys are interned in the `EventKey` table of the database and referenced by id, so a key is stored once per database instead of once per event. The codec caches the table in memory; it is not thread safe and must only be used from within the database queue.
+ */
+@interface AWSPinpointEventCodec : NSObject
+
+/**
+ The bytes the `EventKey` table accounts for in `diskBytesUsed`: every key plus an estimate of the per-row overhead. It is computed when the table is loaded into the cache, kept up to date as keys are added and removed, and recomputed when the cache is loaded again after `resetKeys`.
+ */
+@property (atomic, assign, readonly) uint64_t keyByteCount;
+
+/**
+ Creates the `EventKey` table if it doesn't exist.
+ */
++ (BOOL)createKeyTableInDatabase:(AWSFMDatabase *)db;
+
+/**
+ Loads the `EventKey` table into the cache unless it is already loaded.
+ */
+- (BOOL)loadKeysFromDatabase:(AWSFMDatabase *)db;
+
+/**
+ Whether `removeKeysUnreferencedByTables:database:` is worth its scan of every stored value. Deleting events only orphans keys that are already in the table, so the table grows only as new keys are interned; the scan is due once per codec and then again after every `AWSPinpointEventCodecKeyRemovalInterval` new keys.
+ */
+@property (nonatomic, assign, readonly) BOOL shouldRemoveUnreferencedKeys;
+
+/**
+ Deletes the keys that none of the encoded `attributes` and `metrics` columns of `tables` refer to. Values that cannot be parsed are skipped, since their keys cannot be decoded anyway. Must be called inside the transaction that deleted the events.
+ */
+- (BOOL)removeKeysUnreferencedByTables:(NSArray<NSString *> *)tables
+                              database:(AWSFMDatabase *)db;
+
+- (nullable NSData *)dataWithAttributes:(NSDictionary<NSString *, NSString *> *)attributes
+                               database:(AWSFMDatabase *)db;
+
+- (nullable NSData *)dataWithMetrics:(NSDictionary<NSString *, NSNumber *> *)metrics
+                            database:(AWSFMDatabase *)db;
+
+- (nullable NSMutableDictionary<NSString *, NSString *> *)attributesWithData:(NSData *)data
+                                                                    database:(AWSFMDatabase *)db;
+
+- (nullable NSMutableDictionary<NSString *, NSNumber *> *)metricsWithData:(NSData *)data
+                                                                 database:(AWSFMDatabase *)db;
+
+/**
+ Drops the cached key table. Must be called after rolling back a transaction in which the codec encoded values, since keys interned in it are gone.
+ */
+- (void)resetKeys;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,391 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import "AWSPinpointEventCodec.h"
+
+const uint8_t AWSPinpointEventCodecFormatVersion = 1;
+
+const NSUInteger AWSPinpointEventCodecKeyRemovalInterval = 64;
+
+// The per-row overhead of a key in `keyByteCount`, for its integer id and the row and index entries.
+static uint64_t const AWSPinpointEventCodecKeyOverheadBytes = 16;
+
+// Deletes at most this many keys per statement, to stay below SQLITE_MAX_VARIABLE_NUMBER.
+static NSUInteger const AWSPinpointEventCodecStatementIdLimit = 500;
+
+typedef NS_ENUM(uint8_t, AWSPinpointEventCodecMetricType) {
+    AWSPinpointEventCodecMetricTypeInteger = 0,
+    AWSPinpointEventCodecMetricTypeDouble = 1,
+};
+
+static void AWSPinpointEventCodecAppendVarint(NSMutableData *data, uint64_t value) {
+    uint8_t buffer[10];
+    size_t length = 0;
+    while (value >= 0x80) {
+        buffer[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    buffer[length++] = (uint8_t)value;
+    [data appendBytes:buffer length:length];
+}
+
+static BOOL AWSPinpointEventCodecReadVarint(const uint8_t *bytes, NSUInteger length, NSUInteger *offset, uint64_t *value) {
+    uint64_t result = 0;
+    for (unsigned shift = 0; shift < 64 && *offset < length; shift += 7) {
+        uint8_t byte = bytes[(*offset)++];
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return YES;
+        }
+    }
+    return NO;
+}
+
+// Adds the key ids an encoded attribute or metric value refers to to `keyIds`. Returns NO if the value is malformed.
+static BOOL AWSPinpointEventCodecCollectKeyIds(NSData *data, BOOL isMetrics, NSMutableIndexSet *keyIds) {
+    const uint8_t *bytes = [data bytes];
+    NSUInteger length = [data length];
+    NSUInteger offset = 0;
+    uint64_t count = 0;
+    if (length < 1 || bytes[offset++] != AWSPinpointEventCodecFormatVersion
+        || !AWSPinpointEventCodecReadVarint(bytes, length, &offset, &count)) {
+        return NO;
+    }
+
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t keyId = 0;
+        if (!AWSPinpointEventCodecReadVarint(bytes, length, &offset, &keyId) || keyId > NSNotFound - 1) {
+            return NO;
+        }
+        [keyIds addIndex:(NSUInteger)keyId];
+
+        uint64_t skipped = 0;
+        if (!isMetrics) {
+            if (!AWSPinpointEventCodecReadVarint(bytes, length, &offset, &skipped) || skipped > length - offset) {
+                return NO;
+            }
+            offset += (NSUInteger)skipped;
+        } else if (offset < length && bytes[offset] == AWSPinpointEventCodecMetricTypeInteger) {
+            offset += 1;
+            if (!AWSPinpointEventCodecReadVarint(bytes, length, &offset, &skipped)) {
+                return NO;
+            }
+        } else if (offset < length && bytes[offset] == AWSPinpointEventCodecMetricTypeDouble && length - offset > 8) {
+            offset += 9;
+        } else {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+@interface AWSPinpointEventCodec()
+
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSNumber *> *keyIds;
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, NSString *> *keys;
+@property (atomic, assign) uint64_t keyByteCount;
+// Keys interned since unreferenced keys were last removed.
+@property (nonatomic, assign) NSUInteger keysInternedSinceRemoval;
+
+@end
+
+@implementation AWSPinpointEventCodec
+
+- (instancetype)init {
+    if (self = [super init]) {
+        // Keys orphaned in a previous run are removed once.
+        _keysInternedSinceRemoval = AWSPinpointEventCodecKeyRemovalInterval;
+    }
+    return self;
+}
+
++ (BOOL)createKeyTableInDatabase:(AWSFMDatabase *)db {
+    return [db executeUpdate:
+            @"CREATE TABLE IF NOT EXISTS EventKey ("
+            @"id INTEGER PRIMARY KEY,"
+            @"key TEXT NOT NULL UNIQUE)"];
+}
+
+- (BOOL)loadKeysFromDatabase:(AWSFMDatabase *)db {
+    if (self.keyIds) {
+        return YES;
+    }
+
+    AWSFMResultSet *rs = [db executeQuery:@"SELECT id, key FROM EventKey"];
+    if (!rs) {
+        AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+        return NO;
+    }
+    NSMutableDictionary *keyIds = [NSMutableDictionary new];
+    NSMutableDictionary *keys = [NSMutableDictionary new];
+    uint64_t keyByteCount = 0;
+    while ([rs next]) {
+        NSNumber *keyId = @([rs unsignedLongLongIntForColumn:@"id"]);
+        NSString *key = [rs stringForColumn:@"key"];
+        keyIds[key] = keyId;
+        keys[keyId] = key;
+        keyByteCount += [self sizeOfKey:key];
+    }
+    [rs close];
+
+    self.keyIds = keyIds;
+    self.keys = keys;
+    self.keyByteCount = keyByteCount;
+    return YES;
+}
+
+- (uint64_t)sizeOfKey:(NSString *)key {
+    return [key lengthOfBytesUsingEncoding:NSUTF8StringEncoding] + AWSPinpointEventCodecKeyOverheadBytes;
+}
+
+- (NSNumber *)idForKey:(NSString *)key
+              database:(AWSFMDatabase *)db {
+    if (![self loadKeysFromDatabase:db]) {
+        return nil;
+    }
+
+    NSNumber *keyId = self.keyIds[key];
+    if (!keyId) {
+        if (![db executeUpdate:@"INSERT INTO EventKey (key) VALUES (?)", key]) {
+            AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+            return nil;
+        }
+        keyId = @([db lastInsertRowId]);
+        self.keyIds[key] = keyId;
+        self.keys[keyId] = key;
+        self.keyByteCount += [self sizeOfKey:key];
+        self.keysInternedSinceRemoval += 1;
+    }
+    return keyId;
+}
+
+- (NSString *)keyForId:(uint64_t)keyId
+              database:(AWSFMDatabase *)db {
+    if (![self loadKeysFromDatabase:db]) {
+        return nil;
+    }
+    return self.keys[@(keyId)];
+}
+
+- (BOOL)shouldRemoveUnreferencedKeys {
+    return self.keysInternedSinceRemoval >= AWSPinpointEventCodecKeyRemovalInterval;
+}
+
+- (void)resetKeys {
+    self.keyIds = nil;
+    self.keys = nil;
+}
+
+- (BOOL)removeKeysUnreferencedByTables:(NSArray<NSString *> *)tables
+                              database:(AWSFMDatabase *)db {
+    if (![self loadKeysFromDatabase:db]) {
+        return NO;
+    }
+    if ([self.keys count] == 0) {
+        self.keysInternedSinceRemoval = 0;
+        return YES;
+    }
+
+    NSMutableIndexSet *referencedKeyIds = [NSMutableIndexSet new];
+    for (NSString *table in tables) {
+        AWSFMResultSet *rs = [db executeQuery:[NSString stringWithFormat:@"SELECT attributes, metrics FROM %@", table]];
+        if (!rs) {
+            AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+            return NO;
+        }
+        while ([rs next]) {
+            AWSPinpointEventCodecCollectKeyIds([rs dataNoCopyForColumn:@"attributes"], NO, referencedKeyIds);
+            AWSPinpointEventCodecCollectKeyIds([rs dataNoCopyForColumn:@"metrics"], YES, referencedKeyIds);
+        }
+        [rs close];
+    }
+
+    NSMutableArray<NSNumber *> *unreferencedKeyIds = [NSMutableArray new];
+    for (NSNumber *keyId in self.keys) {
+        if (![referencedKeyIds containsIndex:[keyId unsignedIntegerValue]]) {
+            [unreferencedKeyIds addObject:keyId];
+        }
+    }
+
+    for (NSUInteger location = 0; location < [unreferencedKeyIds count]; location += AWSPinpointEventCodecStatementIdLimit) {
+        NSArray *keyIds = [unreferencedKeyIds subarrayWithRange:NSMakeRange(location, MIN(AWSPinpointEventCodecStatementIdLimit, [unreferencedKeyIds count] - location))];
+        NSMutableArray *placeholders = [NSMutableArray new];
+        for (NSUInteger i = 0; i < [keyIds count]; i++) {
+            [placeholders addObject:@"?"];
+        }
+        if (![db executeUpdate:[NSString stringWithFormat:@"DELETE FROM EventKey WHERE id IN (%@)", [placeholders componentsJoinedByString:@", "]]
+          withArgumentsInArray:keyIds]) {
+            AWSDDLogError(@"SQLite error. [%@]", db.lastError);
+            // The keys deleted by earlier statements may be rolled back with the transaction.
+            [self resetKeys];
+            return NO;
+        }
+    }
+
+    for (NSNumber *keyId in unreferencedKeyIds) {
+        NSString *key = self.keys[keyId];
+        [self.keys removeObjectForKey:keyId];
+        [self.keyIds removeObjectForKey:key];
+        self.keyByteCount -= MIN([self sizeOfKey:key], self.keyByteCount);
+    }
+    if ([unreferencedKeyIds count] > 0) {
+        AWSDDLogDebug(@"Removed %lu unreferenced event keys.", (unsigned long)[unreferencedKeyIds count]);
+    }
+    self.keysInternedSinceRemoval = 0;
+    return YES;
+}
+
+#pragma mark - Encoding
+
+- (NSData *)dataWithAttributes:(NSDictionary<NSString *, NSString *> *)attributes
+                      database:(AWSFMDatabase *)db {
+    NSMutableData *data = [NSMutableData dataWithBytes:&AWSPinpointEventCodecFormatVersion length:1];
+    AWSPinpointEventCodecAppendVarint(data, [attributes count]);
+    for (NSString *key in attributes) {
+        NSNumber *keyId = [self idForKey:key database:db];
+        if (!keyId) {
+            return nil;
+        }
+        NSData *value = [[attributes[key] description] dataUsingEncoding:NSUTF8StringEncoding];
+        AWSPinpointEventCodecAppendVarint(data, [keyId unsignedLongLongValue]);
+        AWSPinpointEventCodecAppendVarint(data, [value length]);
+        [data appendData:value];
+    }
+    return data;
+}
+
+- (NSData *)dataWithMetrics:(NSDictionary<NSString *, NSNumber *> *)metrics
+                   database:(AWSFMDatabase *)db {
+    NSMutableData *data = [NSMutableData dataWithBytes:&AWSPinpointEventCodecFormatVersion length:1];
+    AWSPinpointEventCodecAppendVarint(data, [metrics count]);
+    for (NSString *key in metrics) {
+        NSNumber *keyId = [self idForKey:key database:db];
+        if (!keyId) {
+            return nil;
+        }
+        AWSPinpointEventCodecAppendVarint(data, [keyId unsignedLongLongValue]);
+
+        double value = [metrics[key] doubleValue];
+        if (value == floor(value) && fabs(value) < 9007199254740992.0) { // Integral and exactly representable, i.e. |value| < 2^53.
+            int64_t integer = (int64_t)value;
+            uint8_t type = AWSPinpointEventCodecMetricTypeInteger;
+            [data appendBytes:&type length:1];
+            AWSPinpointEventCodecAppendVarint(data, ((uint64_t)integer << 1) ^ (uint64_t)(integer >> 63));
+        } else {
+            uint8_t type = AWSPinpointEventCodecMetricTypeDouble;
+            uint64_t bits = 0;
+            memcpy(&bits, &value, sizeof(bits));
+            uint8_t bytes[8];
+            for (int i = 0; i < 8; i++) {
+                bytes[i] = (uint8_t)(bits >> (8 * i));
+            }
+            [data appendBytes:&type length:1];
+            [data appendBytes:bytes length:sizeof(bytes)];
+        }
+    }
+    return data;
+}
+
+#pragma mark - Decoding
+
+- (NSMutableDictionary<NSString *, NSString *> *)attributesWithData:(NSData *)data
+                                                           database:(AWSFMDatabase *)db {
+    const uint8_t *bytes = [data bytes];
+    NSUInteger length = [data length];
+    NSUInteger offset = 0;
+    uint64_t count = 0;
+    if (length < 1 || bytes[offset++] != AWSPinpointEventCodecFormatVersion
+        || !AWSPinpointEventCodecReadVarint(bytes, length, &offset, &count)) {
+        AWSDDLogError(@"Unsupported attribute encoding.");
+        return nil;
+    }
+
+    NSMutableDictionary *attributes = [NSMutableDictionary new];
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t keyId = 0;
+        uint64_t valueLength = 0;
+        if (!AWSPinpointEventCodecReadVarint(bytes, length, &offset, &keyId)
+            || !AWSPinpointEventCodecReadVarint(bytes, length, &offset, &valueLength)
+            || valueLength > length - offset) {
+            AWSDDLogError(@"Truncated attribute encoding.");
+            return nil;
+        }
+        NSString *key = [self keyForId:keyId database:db];
+        NSString *value = [[NSString alloc] initWithBytes:bytes + offset
+                                                   length:(NSUInteger)valueLength
+                                                 encoding:NSUTF8StringEncoding];
+        offset += (NSUInteger)valueLength;
+        if (!key || !value) {
+            AWSDDLogError(@"Invalid attribute encoding.");
+            return nil;
+        }
+        attributes[key] = value;
+    }
+    return attributes;
+}
+
+- (NSMutableDictionary<NSString *, NSNumber *> *)metricsWithData:(NSData *)data
+                                                        database:(AWSFMDatabase *)db {
+    const uint8_t *bytes = [data bytes];
+    NSUInteger length = [data length];
+    NSUInteger offset = 0;
+    uint64_t count = 0;
+    if (length < 1 || bytes[offset++] != AWSPinpointEventCodecFormatVersion
+        || !AWSPinpointEventCodecReadVarint(bytes, length, &offset, &count)) {
+        AWSDDLogError(@"Unsupported metric encoding.");
+        return nil;
+    }
+
+    NSMutableDictionary *metrics = [NSMutableDictionary new];
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t keyId = 0;
+        if (!AWSPinpointEventCodecReadVarint(bytes, length, &offset, &keyId) || offset >= length) {
+            AWSDDLogError(@"Truncated metric encoding.");
+            return nil;
+        }
+        NSString *key = [self keyForId:keyId database:db];
+        if (!key) {
+            AWSDDLogError(@"Invalid metric encoding.");
+            return nil;
+        }
+
+        uint8_t type = bytes[offset++];
+        if (type == AWSPinpointEventCodecMetricTypeInteger) {
+            uint64_t zigzag = 0;
+            if (!AWSPinpointEventCodecReadVarint(bytes, length, &offset, &zigzag)) {
+                AWSDDLogError(@"Truncated metric encoding.");
+                return nil;
+            }
+            int64_t value = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+            metrics[key] = @(value);
+        } else if (type == AWSPinpointEventCodecMetricTypeDouble && length - offset >= 8) {
+            uint64_t bits = 0;
+            for (int i = 0; i < 8; i++) {
+                bits |= (uint64_t)bytes[offset + i] << (8 * i);
+            }
+            offset += 8;
+            double value = 0;
+            memcpy(&value, &bits, sizeof(value));
+            metrics[key] = @(value);
+        } else {
+            AWSDDLogError(@"Invalid metric encoding.");
+            return nil;
+        }
+    }
+    return metrics;
+}
+
+@end
@@ -0,0 +1,167 @@
+//
+// Copyright 2010-2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License").
+// You may not use this file except in compliance with the License.
+// A copy of the License is located at
+//
+// http://aws.amazon.com/apache2.0
+//
+// or in the "license" file accompanying this file. This file is distributed
+// on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+// express or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+//
+
+#import <XCTest/XCTest.h>
+#import "AWSPinpointEventCodec.h"
+
+@interface AWSPinpointEventCodecTests : XCTestCase
+
+@property (nonatomic, strong) AWSFMDatabase *database;
+@property (nonatomic, strong) AWSPinpointEventCodec *codec;
+
+@end
+
+@implementation AWSPinpointEventCodecTests
+
+- (void)setUp {
+    [super setUp];
+    self.database = [AWSFMDatabase databaseWithPath:nil];
+    XCTAssertTrue([self.database open]);
+    XCTAssertTrue([AWSPinpointEventCodec createKeyTableInDatabase:self.database]);
+    self.codec = [AWSPinpointEventCodec new];
+}
+
+- (void)tearDown {
+    [self.database close];
+    [super tearDown];
+}
+
+- (void)testAttributesRoundTrip {
+    NSDictionary *attributes = @{@"key" : @"value",
+                                 @"empty" : @"",
+                                 @"unicode" : @"éè中文 \U0001F600",
+                                 @"long" : [@"" stringByPaddingToLength:1000 withString:@"abc" startingAtIndex:0]};
+    NSData *data = [self.codec dataWithAttributes:attributes database:self.database];
+    XCTAssertNotNil(data);
+    XCTAssertEqual(((const uint8_t *)[data bytes])[0], AWSPinpointEventCodecFormatVersion);
+    XCTAssertEqualObjects([self.codec attributesWithData:data database:self.database], attributes);
+}
+
+- (void)testMetricsRoundTrip {
+    NSDictionary *metrics = @{@"zero" : @0,
+                              @"integer" : @42,
+                              @"negative" : @(-123456789),
+                              @"large" : @(9007199254740991LL),
+                              @"double" : @(3.14159),
+                              @"negativeDouble" : @(-0.5),
+                              @"huge" : @(1e300)};
+    NSData *data = [self.codec dataWithMetrics:metrics database:self.database];
+    XCTAssertNotNil(data);
+    NSDictionary *decoded = [self.codec metricsWithData:data database:self.database];
+    XCTAssertEqual([decoded count], [metrics count]);
+    for (NSString *key in metrics) {
+        XCTAssertEqual([decoded[key] doubleValue], [metrics[key] doubleValue], @"%@", key);
+    }
+}
+
+- (void)testEmpty {
+    NSData *attributes = [self.codec dataWithAttributes:@{} database:self.database];
+    NSData *metrics = [self.codec dataWithMetrics:@{} database:self.database];
+    XCTAssertEqual([attributes length], 2);
+    XCTAssertEqual([metrics length], 2);
+    XCTAssertEqualObjects([self.codec attributesWithData:attributes database:self.database], @{});
+    XCTAssertEqualObjects([self.codec metricsWithData:metrics database:self.database], @{});
+}
+
+- (void)testKeysAreInterned {
+    NSString *key = @"a_rather_long_attribute_name_that_is_repeated_on_every_event";
+    NSData *first = [self.codec dataWithAttributes:@{key : @"1"} database:self.database];
+    NSData *second = [self.codec dataWithMetrics:@{key : @1} database:self.database];
+    XCTAssertLessThan([first length], [key length]);
+    XCTAssertLessThan([second length], [key length]);
+    XCTAssertEqual([self.database intForQuery:@"SELECT COUNT(*) FROM EventKey"], 1);
+
+    // A new codec reads the keys back from the database.
+    AWSPinpointEventCodec *codec = [AWSPinpointEventCodec new];
+    XCTAssertEqualObjects([codec attributesWithData:first database:self.database], @{key : @"1"});
+    XCTAssertEqualObjects([codec metricsWithData:second database:self.database], @{key : @1});
+}
+
+- (void)testResetKeysAfterRollback {
+    XCTAssertTrue([self.database beginTransaction]);
+    XCTAssertNotNil([self.codec dataWithAttributes:@{@"rolledBack" : @"value"} database:self.database]);
+    XCTAssertTrue([self.database rollback]);
+    [self.codec resetKeys];
+
+    NSData *data = [self.codec dataWithAttributes:@{@"rolledBack" : @"value"} database:self.database];
+    XCTAssertEqualObjects([[AWSPinpointEventCodec new] attributesWithData:data database:self.database], @{@"rolledBack" : @"value"});
+}
+
+- (void)testRemoveKeysUnreferencedByTables {
+    XCTAssertTrue([self.database executeUpdate:@"CREATE TABLE Event (attributes BLOB, metrics BLOB)"]);
+    NSData *keptAttributes = [self.codec dataWithAttributes:@{@"kept" : @"value", @"shared" : @"value"} database:self.database];
+    NSData *keptMetrics = [self.codec dataWithMetrics:@{@"keptMetric" : @1.5, @"shared" : @2} database:self.database];
+    NSData *removedAttributes = [self.codec dataWithAttributes:@{@"removed" : @"value"} database:self.database];
+    NSData *removedMetrics = [self.codec dataWithMetrics:@{@"removedMetric" : @-3} database:self.database];
+    XCTAssertTrue([self.database executeUpdate:@"INSERT INTO Event (attributes, metrics) VALUES (?, ?)", keptAttributes, keptMetrics]);
+    XCTAssertTrue([self.database executeUpdate:@"INSERT INTO Event (attributes, metrics) VALUES (?, ?)", removedAttributes, removedMetrics]);
+    uint64_t keyByteCount = self.codec.keyByteCount;
+    XCTAssertGreaterThan(keyByteCount, 0);
+
+    XCTAssertTrue([self.codec removeKeysUnreferencedByTables:@[@"Event"] database:self.database]);
+    XCTAssertEqual([self.database intForQuery:@"SELECT COUNT(*) FROM EventKey"], 5);
+
+    XCTAssertTrue([self.database executeUpdate:@"DELETE FROM Event WHERE attributes = ?", removedAttributes]);
+    XCTAssertTrue([self.codec removeKeysUnreferencedByTables:@[@"Event"] database:self.database]);
+    XCTAssertEqual([self.database intForQuery:@"SELECT COUNT(*) FROM EventKey"], 3);
+    XCTAssertLessThan(self.codec.keyByteCount, keyByteCount);
+
+    // The byte count matches the one computed from the table, and the remaining values still decode.
+    AWSPinpointEventCodec *codec = [AWSPinpointEventCodec new];
+    XCTAssertTrue([codec loadKeysFromDatabase:self.database]);
+    XCTAssertEqual(codec.keyByteCount, self.codec.keyByteCount);
+    XCTAssertEqualObjects([codec attributesWithData:keptAttributes database:self.database], (@{@"kept" : @"value", @"shared" : @"value"}));
+    XCTAssertEqualObjects([codec metricsWithData:keptMetrics database:self.database], (@{@"keptMetric" : @1.5, @"shared" : @2}));
+
+    XCTAssertTrue([self.database executeUpdate:@"DELETE FROM Event"]);
+    XCTAssertTrue([self.codec removeKeysUnreferencedByTables:@[@"Event"] database:self.database]);
+    XCTAssertEqual([self.database intForQuery:@"SELECT COUNT(*) FROM EventKey"], 0);
+    XCTAssertEqual(self.codec.keyByteCount, 0);
+}
+
+- (void)testShouldRemoveUnreferencedKeys {
+    XCTAssertTrue([self.database executeUpdate:@"CREATE TABLE Event (attributes BLOB, metrics BLOB)"]);
+    XCTAssertTrue(self.codec.shouldRemoveUnreferencedKeys);
+    XCTAssertTrue([self.codec removeKeysUnreferencedByTables:@[@"Event"] database:self.database]);
+    XCTAssertFalse(self.codec.shouldRemoveUnreferencedKeys);
+
+    // Reusing interned keys never makes the scan due.
+    for (NSUInteger i = 0; i < AWSPinpointEventCodecKeyRemovalInterval; i++) {
+        XCTAssertNotNil([self.codec dataWithAttributes:@{@"key" : @"value"} database:self.database]);
+    }
+    XCTAssertFalse(self.codec.shouldRemoveUnreferencedKeys);
+
+    for (NSUInteger i = 1; i < AWSPinpointEventCodecKeyRemovalInterval; i++) {
+        XCTAssertNotNil([self.codec dataWithAttributes:@{[NSString stringWithFormat:@"key%lu", (unsigned long)i] : @"value"} database:self.database]);
+    }
+    XCTAssertTrue(self.codec.shouldRemoveUnreferencedKeys);
+    XCTAssertTrue([self.codec removeKeysUnreferencedByTables:@[@"Event"] database:self.database]);
+    XCTAssertEqual([self.database intForQuery:@"SELECT COUNT(*) FROM EventKey"], 0);
+    XCTAssertFalse(self.codec.shouldRemoveUnreferencedKeys);
+}
+
+- (void)testInvalidData {
+    NSData *data = [self.codec dataWithAttributes:@{@"key" : @"value"} database:self.database];
+    XCTAssertNil([self.codec attributesWithData:[NSData data] database:self.database]);
+    XCTAssertNil([self.codec attributesWithData:[data subdataWithRange:NSMakeRange(0, [data length] - 1)] database:self.database]);
+
+    NSMutableData *unknownVersion = [data mutableCopy];
+    ((uint8_t *)[unknownVersion mutableBytes])[0] = AWSPinpointEventCodecFormatVersion + 1;
+    XCTAssertNil([self.codec attributesWithData:unknownVersion database:self.database]);
+
+    XCTAssertNil([self.codec metricsWithData:[@"not a metric" dataUsingEncoding:NSUTF8StringEncoding] database:self.database]);
+}
+
+@end
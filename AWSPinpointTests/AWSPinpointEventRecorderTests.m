@@ -20,6 +20,7 @@
 #import "AWSPinpoint.h"
 #import "AWSTestUtility.h"
 #import "AWSPinpointContext.h"
+#import "AWSPinpointDateUtils.h"
 #import "OCMock.h"
 
 NSString *const AWSKinesisRecorderTestStream = @"AWSSDKForiOSv2Test";
@@ -61,6 +62,20 @@ static id _mockNSBundle;
                    targetingClient:(AWSPinpointTargetingClient *) targetingClient;
 - (AWSTask*) getCurrentSession: (AWSPinpointSession*) session;
 - (AWSTask*) updateSessionStartWithCampaignAttributes:(NSDictionary*) attributes;
+- (void) getBatchRecords:(void (^)(NSDictionary *eventsWithEventId, NSError *error))result;
+- (AWSPinpointTargetingEvent*) buildEventPayload:(AWSPinpointEvent*) event;
+- (AWSPinpointTargetingPublicEndpoint*) buildEndpointRequestPayload:(AWSPinpointEndpointProfile *) profile;
+- (AWSPinpointTargetingPutEventsRequest*) buildRequestPayload:(NSString*) applicationId
+                                              endpointPayload:(AWSPinpointTargetingPublicEndpoint*) endpoint
+                                                   endpointId:(NSString*) endpointId
+                                                eventsPayload:(NSDictionary*) events;
+- (NSUInteger)encodedSizeOfPutEventsRequest:(AWSPinpointTargetingPutEventsRequest *)putEventsRequest;
+- (NSUInteger)eventsByteLimitForEndpointProfile:(AWSPinpointEndpointProfile *)profile
+                                endpointPayload:(AWSPinpointTargetingPublicEndpoint *)endpoint;
+- (AWSPinpointTargetingPutEventsRequest *)sizingRequestWithEvents:(NSDictionary *)events;
+- (NSUInteger)encodedSizeOfServiceEvent:(AWSPinpointTargetingEvent *)serviceEvent
+                                eventId:(NSString *)eventId
+                  emptyRequestByteCount:(NSUInteger)emptyRequestByteCount;
 @end
 
 @interface AWSPinpointSession()
@@ -91,6 +106,60 @@ targetingServiceConfiguration:(AWSServiceConfiguration*) targetingServiceConfigu
                            URL:(NSURL *)URL;
 @end
 
+// Stands in for the PutEvents endpoint: accepts every event after a fixed latency.
+@interface AWSPinpointEventRecorderTestsEndpointStub : NSObject
+
+@property (nonatomic, assign) NSTimeInterval latency;
+@property (nonatomic, assign) NSUInteger requestCount;
+@property (nonatomic, assign) NSUInteger inFlightCount;
+@property (nonatomic, assign) NSUInteger maxInFlightCount;
+
+- (AWSTask<AWSPinpointTargetingPutEventsResponse *> *)putEvents:(AWSPinpointTargetingPutEventsRequest *)request;
+
+@end
+
+@implementation AWSPinpointEventRecorderTestsEndpointStub
+
+- (AWSTask<AWSPinpointTargetingPutEventsResponse *> *)putEvents:(AWSPinpointTargetingPutEventsRequest *)request {
+    @synchronized(self) {
+        self.requestCount += 1;
+        self.inFlightCount += 1;
+        self.maxInFlightCount = MAX(self.maxInFlightCount, self.inFlightCount);
+    }
+    
+    NSMutableDictionary *results = [NSMutableDictionary new];
+    for (NSString *endpointId in request.eventsRequest.batchItem) {
+        NSMutableDictionary *eventsItemResponse = [NSMutableDictionary new];
+        for (NSString *eventId in request.eventsRequest.batchItem[endpointId].events) {
+            AWSPinpointTargetingEventItemResponse *eventItemResponse = [AWSPinpointTargetingEventItemResponse new];
+            eventItemResponse.statusCode = @202;
+            eventItemResponse.message = @"Accepted";
+            eventsItemResponse[eventId] = eventItemResponse;
+        }
+        AWSPinpointTargetingEndpointItemResponse *endpointItemResponse = [AWSPinpointTargetingEndpointItemResponse new];
+        endpointItemResponse.statusCode = @202;
+        endpointItemResponse.message = @"Accepted";
+        AWSPinpointTargetingItemResponse *itemResponse = [AWSPinpointTargetingItemResponse new];
+        itemResponse.endpointItemResponse = endpointItemResponse;
+        itemResponse.eventsItemResponse = eventsItemResponse;
+        results[endpointId] = itemResponse;
+    }
+    AWSPinpointTargetingPutEventsResponse *response = [AWSPinpointTargetingPutEventsResponse new];
+    response.eventsResponse = [AWSPinpointTargetingEventsResponse new];
+    response.eventsResponse.results = results;
+    
+    AWSTaskCompletionSource *taskCompletionSource = [AWSTaskCompletionSource taskCompletionSource];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.latency * NSEC_PER_SEC)), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        @synchronized(self) {
+            self.inFlightCount -= 1;
+        }
+        taskCompletionSource.result = response;
+    });
+    return taskCompletionSource.task;
+}
+
+@end
+
 @implementation AWSPinpointEventRecorderTests
 
 + (void)setUp {
@@ -1168,6 +1237,367 @@ static AWSPinpointEvent * extracted() {
                                                   object:nil];
 }
 
+- (void)testDiskByteLimitSteadyState {
+    AWSPinpointEventRecorder *eventRecorder = self.pinpointIAD.analyticsClient.eventRecorder;
+    [[eventRecorder removeAllEvents] waitUntilFinished];
+    [[eventRecorder removeAllDirtyEvents] waitUntilFinished];
+    
+    eventRecorder.diskByteLimit = 256 * 1024; // 256KB
+    
+    AWSPinpointEvent *event = [self.pinpointIAD.analyticsClient createEventWithEventType:@"TEST_EVENT"];
+    NSMutableString *value = [NSMutableString new];
+    for (int i = 0; i < 1024; i++) {
+        [value appendString:@"Y"];
+    }
+    [event addAttribute:value forKey:@"key"];
+    
+    // Fills the store past the limit so that every following save runs against a full store.
+    AWSTask *task = [AWSTask taskWithResult:nil];
+    for (int i = 0; i < 500; i++) {
+        task = [task continueWithBlock:^id(AWSTask *task) {
+            return [eventRecorder saveEvent:event];
+        }];
+    }
+    [task waitUntilFinished];
+    XCTAssertNil(task.error);
+    XCTAssertLessThanOrEqual(eventRecorder.diskBytesUsed, eventRecorder.diskByteLimit);
+    
+    NSUInteger steadyStateCount = 1000;
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    task = [AWSTask taskWithResult:nil];
+    for (int i = 0; i < steadyStateCount; i++) {
+        task = [task continueWithBlock:^id(AWSTask *task) {
+            return [eventRecorder saveEvent:event];
+        }];
+    }
+    [task waitUntilFinished];
+    CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+    NSLog(@"Saved %lu events into a full store in %.3f seconds (%.3f ms per event).",
+          (unsigned long)steadyStateCount, elapsed, elapsed * 1000 / steadyStateCount);
+    
+    XCTAssertNil(task.error);
+    XCTAssertGreaterThan(eventRecorder.diskBytesUsed, 0);
+    XCTAssertLessThanOrEqual(eventRecorder.diskBytesUsed, eventRecorder.diskByteLimit);
+    
+    [[[eventRecorder getEventsWithLimit:@1000] continueWithBlock:^id(AWSTask *task) {
+        // Eviction frees down to the low-water mark, so the store holds fewer events than fit under the limit.
+        XCTAssertGreaterThan([task.result count], 0);
+        XCTAssertLessThan([task.result count], 256);
+        return nil;
+    }] waitUntilFinished];
+    
+    [[eventRecorder removeAllEvents] waitUntilFinished];
+    XCTAssertEqual(eventRecorder.diskBytesUsed, 0);
+    
+    eventRecorder.diskByteLimit = AWSPinpointClientByteLimitDefault;
+}
+
+- (void)testGetBatchRecordsByteLimit {
+    AWSPinpointEventRecorder *eventRecorder = self.pinpointIAD.analyticsClient.eventRecorder;
+    [[eventRecorder removeAllEvents] waitUntilFinished];
+    
+    AWSPinpointEvent *event = [self.pinpointIAD.analyticsClient createEventWithEventType:@"TEST_EVENT"];
+    [event addAttribute:@"Attr1" forKey:@"Attr1"];
+    [event addMetric:@(1) forKey:@"Mettr1"];
+    for (int i = 0; i < 20; i++) {
+        [[eventRecorder saveEvent:event] waitUntilFinished];
+    }
+    
+    NSUInteger emptyRequestByteCount = [eventRecorder encodedSizeOfPutEventsRequest:[eventRecorder sizingRequestWithEvents:@{}]];
+    NSUInteger eventByteCount = [eventRecorder encodedSizeOfServiceEvent:[eventRecorder buildEventPayload:event]
+                                                                 eventId:[[NSUUID UUID] UUIDString]
+                                                   emptyRequestByteCount:emptyRequestByteCount];
+    XCTAssertGreaterThan(eventByteCount, 0);
+    
+    // The endpoint and the rest of the request come out of the limit first.
+    AWSPinpointEndpointProfile *profile = [self.pinpointIAD.targetingClient currentEndpointProfile];
+    AWSPinpointTargetingPublicEndpoint *endpoint = [eventRecorder buildEndpointRequestPayload:profile];
+    eventRecorder.batchRecordsByteLimit = AWSPinpointClientBatchRecordByteLimitDefault;
+    NSUInteger envelopeByteCount = AWSPinpointClientBatchRecordByteLimitDefault - [eventRecorder eventsByteLimitForEndpointProfile:profile
+                                                                                                                  endpointPayload:endpoint];
+    XCTAssertGreaterThan(envelopeByteCount, 0);
+    
+    // Room for exactly 5 events, but not for a 6th.
+    eventRecorder.batchRecordsByteLimit = envelopeByteCount + 6 * eventByteCount - 1;
+    __block NSDictionary *batch = nil;
+    [eventRecorder getBatchRecords:^(NSDictionary *eventsWithEventId, NSError *error) {
+        XCTAssertNil(error);
+        batch = eventsWithEventId;
+    }];
+    XCTAssertEqual([batch count], 5);
+    
+    // The request built for the batch fits in the limit.
+    NSMutableDictionary *serviceEvents = [NSMutableDictionary new];
+    for (NSString *eventId in batch) {
+        serviceEvents[eventId] = batch[eventId][@"serviceEvent"];
+    }
+    AWSPinpointTargetingPutEventsRequest *request = [eventRecorder buildRequestPayload:profile.applicationId
+                                                                       endpointPayload:endpoint
+                                                                            endpointId:profile.endpointId
+                                                                         eventsPayload:serviceEvents];
+    XCTAssertLessThanOrEqual([eventRecorder encodedSizeOfPutEventsRequest:request], eventRecorder.batchRecordsByteLimit);
+    
+    // An event larger than the limit is still sent, on its own.
+    eventRecorder.batchRecordsByteLimit = 10;
+    [eventRecorder getBatchRecords:^(NSDictionary *eventsWithEventId, NSError *error) {
+        XCTAssertNil(error);
+        batch = eventsWithEventId;
+    }];
+    XCTAssertEqual([batch count], 1);
+    
+    eventRecorder.batchRecordsByteLimit = AWSPinpointClientBatchRecordByteLimitDefault;
+    [eventRecorder getBatchRecords:^(NSDictionary *eventsWithEventId, NSError *error) {
+        XCTAssertNil(error);
+        batch = eventsWithEventId;
+    }];
+    XCTAssertEqual([batch count], 20);
+    
+    [[eventRecorder removeAllEvents] waitUntilFinished];
+}
+
+- (void)testGetBatchRecordsDeletesUndecodableEvents {
+    AWSPinpointEventRecorder *eventRecorder = self.pinpointIAD.analyticsClient.eventRecorder;
+    [[eventRecorder removeAllEvents] waitUntilFinished];
+    
+    AWSPinpointEvent *event = [self.pinpointIAD.analyticsClient createEventWithEventType:@"TEST_EVENT"];
+    [event addAttribute:@"Attr1" forKey:@"Attr1"];
+    for (int i = 0; i < 3; i++) {
+        [[eventRecorder saveEvent:event] waitUntilFinished];
+    }
+    AWSFMDatabaseQueue *databaseQueue = [eventRecorder valueForKey:@"databaseQueue"];
+    [databaseQueue inDatabase:^(AWSFMDatabase *db) {
+        XCTAssertTrue([db executeUpdate:@"UPDATE Event SET attributes = X'00' WHERE rowid = (SELECT MIN(rowid) FROM Event)"]);
+    }];
+    
+    __block NSDictionary *batch = nil;
+    [eventRecorder getBatchRecords:^(NSDictionary *eventsWithEventId, NSError *error) {
+        XCTAssertNil(error);
+        batch = eventsWithEventId;
+    }];
+    XCTAssertEqual([batch count], 2);
+    for (NSDictionary *eventRow in [batch allValues]) {
+        XCTAssertNotNil(eventRow[@"event"]);
+    }
+    
+    // The undecodable event is gone instead of being read again with every batch.
+    [databaseQueue inDatabase:^(AWSFMDatabase *db) {
+        XCTAssertEqual([db intForQuery:@"SELECT COUNT(*) FROM Event"], 2);
+    }];
+    
+    [[eventRecorder removeAllEvents] waitUntilFinished];
+}
+
+- (void)testGetBatchRecordsPerformance {
+    AWSPinpointEventRecorder *eventRecorder = self.pinpointIAD.analyticsClient.eventRecorder;
+    eventRecorder.batchRecordsByteLimit = 4 * 1024 * 1024;
+    
+    AWSPinpointEvent *event = [self.pinpointIAD.analyticsClient createEventWithEventType:@"TEST_EVENT"];
+    for (int i = 0; i < 10; i++) {
+        [event addAttribute:[NSString stringWithFormat:@"Value%d", i] forKey:[NSString stringWithFormat:@"Attr%d", i]];
+        [event addMetric:@(i) forKey:[NSString stringWithFormat:@"Metric%d", i]];
+    }
+    
+    for (NSNumber *eventCount in @[@10, @100, @1000]) {
+        [[eventRecorder removeAllEvents] waitUntilFinished];
+        AWSTask *task = [AWSTask taskWithResult:nil];
+        for (int i = 0; i < [eventCount intValue]; i++) {
+            task = [task continueWithBlock:^id(AWSTask *task) {
+                return [eventRecorder saveEvent:event];
+            }];
+        }
+        [task waitUntilFinished];
+        
+        __block NSDictionary *batch = nil;
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        [eventRecorder getBatchRecords:^(NSDictionary *eventsWithEventId, NSError *error) {
+            XCTAssertNil(error);
+            batch = eventsWithEventId;
+        }];
+        CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+        NSLog(@"Built a batch of %lu events in %.3f ms.", (unsigned long)[batch count], elapsed * 1000);
+        
+        XCTAssertEqual([batch count], [eventCount unsignedIntegerValue]);
+    }
+    
+    [[eventRecorder removeAllEvents] waitUntilFinished];
+    eventRecorder.batchRecordsByteLimit = AWSPinpointClientBatchRecordByteLimitDefault;
+}
+
+- (void)testSubmitAllEventsThroughput {
+    AWSPinpointEventRecorder *eventRecorder = self.pinpointIAD.analyticsClient.eventRecorder;
+    AWSPinpointContext *context = self.pinpointIAD.pinpointContext;
+    AWSPinpointTargeting *targetingService = context.targetingService;
+    AWSPinpointEventRecorderTestsEndpointStub *endpoint = [AWSPinpointEventRecorderTestsEndpointStub new];
+    endpoint.latency = 0.05;
+    context.targetingService = (AWSPinpointTargeting *)endpoint;
+    // A small batch limit spreads the events over many PutEvents requests.
+    eventRecorder.batchRecordsByteLimit = 4 * 1024;
+    
+    AWSPinpointEvent *event = [self.pinpointIAD.analyticsClient createEventWithEventType:@"TEST_EVENT"];
+    for (int i = 0; i < 10; i++) {
+        [event addAttribute:[NSString stringWithFormat:@"Value%d", i] forKey:[NSString stringWithFormat:@"Attr%d", i]];
+        [event addMetric:@(i) forKey:[NSString stringWithFormat:@"Metric%d", i]];
+    }
+    
+    NSUInteger numberOfEvents = 1000;
+    for (NSNumber *concurrencyLimit in @[@1, @4]) {
+        [[eventRecorder removeAllEvents] waitUntilFinished];
+        AWSTask *task = [AWSTask taskWithResult:nil];
+        for (NSUInteger i = 0; i < numberOfEvents; i++) {
+            task = [task continueWithBlock:^id(AWSTask *task) {
+                return [eventRecorder saveEvent:event];
+            }];
+        }
+        [task waitUntilFinished];
+        
+        eventRecorder.submissionConcurrencyLimit = [concurrencyLimit unsignedIntegerValue];
+        endpoint.requestCount = 0;
+        endpoint.maxInFlightCount = 0;
+        
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        AWSTask *submitTask = [eventRecorder submitAllEvents];
+        [submitTask waitUntilFinished];
+        CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+        NSLog(@"Submitted %lu events in %lu requests with %@ in flight in %.3f s (%.0f events/s).",
+              (unsigned long)[submitTask.result count], (unsigned long)endpoint.requestCount, concurrencyLimit, elapsed, [submitTask.result count] / elapsed);
+        
+        XCTAssertNil(submitTask.error);
+        XCTAssertEqual([submitTask.result count], numberOfEvents);
+        XCTAssertGreaterThan(endpoint.requestCount, 1);
+        XCTAssertEqual(endpoint.maxInFlightCount, MIN([concurrencyLimit unsignedIntegerValue], endpoint.requestCount));
+        XCTAssertFalse(eventRecorder.submissionInProgress);
+        AWSTask *eventsTask = [eventRecorder getEventsWithLimit:@1000];
+        [eventsTask waitUntilFinished];
+        XCTAssertEqual([eventsTask.result count], 0);
+        AWSTask *dirtyEventsTask = [eventRecorder getDirtyEventsWithLimit:@1000];
+        [dirtyEventsTask waitUntilFinished];
+        XCTAssertEqual([dirtyEventsTask.result count], 0);
+    }
+    
+    context.targetingService = targetingService;
+    eventRecorder.submissionConcurrencyLimit = 4;
+    eventRecorder.batchRecordsByteLimit = AWSPinpointClientBatchRecordByteLimitDefault;
+}
+
+- (void)testMigrationFromArchivedEvents {
+    NSString *appId = [NSString stringWithFormat:@"%@-migration", self.appIdIAD];
+    NSString *databaseDirectoryPath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"com/amazonaws/AWSPinpointRecorder"];
+    NSString *databasePath = [databaseDirectoryPath stringByAppendingPathComponent:appId];
+    [[NSFileManager defaultManager] createDirectoryAtPath:databaseDirectoryPath withIntermediateDirectories:YES attributes:nil error:nil];
+    [[NSFileManager defaultManager] removeItemAtPath:databasePath error:nil];
+    
+    // Writes an event the way the recorder stored it before the schema was versioned.
+    AWSFMDatabase *db = [AWSFMDatabase databaseWithPath:databasePath];
+    XCTAssertTrue([db open]);
+    for (NSString *table in @[@"Event", @"DirtyEvent"]) {
+        XCTAssertTrue([db executeUpdate:[NSString stringWithFormat:
+                                         @"CREATE TABLE %@ ("
+                                         @"id TEXT NOT NULL, attributes BLOB NOT NULL, eventType TEXT NOT NULL, metrics BLOB NOT NULL, "
+                                         @"eventTimestamp TEXT NOT NULL, sessionId TEXT NOT NULL, sessionStartTime TEXT NOT NULL, sessionStopTime TEXT NOT NULL, "
+                                         @"timestamp REAL NOT NULL, dirty INTEGER NOT NULL, retryCount INTEGER NOT NULL)", table]]);
+    }
+    UTCTimeMillis eventTimestamp = 1500000000123;
+    NSDate *startTime = [NSDate dateWithTimeIntervalSince1970:1500000000.456];
+    XCTAssertTrue([db executeUpdate:
+                   @"INSERT INTO Event VALUES ("
+                   @":id, :attributes, :eventType, :metrics, :eventTimestamp, :sessionId, :sessionStartTime, :sessionStopTime, :timestamp, :dirty, :retryCount)"
+            withParameterDictionary:@{
+                                      @"id" : [[NSUUID UUID] UUIDString],
+                                      @"attributes" : [NSKeyedArchiver archivedDataWithRootObject:@{@"Attr1" : @"Value1"}],
+                                      @"eventType" : @"TEST_MIGRATION",
+                                      @"metrics" : [NSKeyedArchiver archivedDataWithRootObject:@{@"Metric1" : @(2.5)}],
+                                      @"eventTimestamp" : [AWSPinpointDateUtils isoDateTimeWithTimestamp:eventTimestamp],
+                                      @"sessionId" : @"MIGRATED-SESSION",
+                                      @"sessionStartTime" : [startTime aws_stringValue:AWSDateISO8601DateFormat3],
+                                      @"sessionStopTime" : @"",
+                                      @"timestamp" : @([[NSDate date] timeIntervalSince1970]),
+                                      @"dirty" : @(AWSPinpointClientValidEvent),
+                                      @"retryCount" : @1
+                                      }]);
+    XCTAssertTrue([db executeUpdate:@"INSERT INTO Event (id, attributes, eventType, metrics, eventTimestamp, sessionId, sessionStartTime, sessionStopTime, timestamp, dirty, retryCount) "
+                                    @"VALUES ('corrupt', X'00', 'TEST_MIGRATION', X'00', '', 'MIGRATED-SESSION', '', '', 0, 0, 0)"]);
+    [db close];
+    
+    AWSPinpointConfiguration *config = [[AWSPinpointConfiguration alloc] initWithAppId:appId
+                                                                         launchOptions:nil
+                                                                        maxStorageSize:AWSPinpointClientByteLimitDefault
+                                                                        sessionTimeout:0];
+    config.userDefaults = self.userDefaults;
+    AWSPinpoint *pinpoint = [AWSPinpoint pinpointWithConfiguration:config];
+    
+    [[[pinpoint.analyticsClient.eventRecorder getEvents] continueWithBlock:^id(AWSTask *task) {
+        XCTAssertNil(task.error);
+        XCTAssertEqual([task.result count], 1); // The event that cannot be unarchived is dropped.
+        AWSPinpointEvent *event = [task.result firstObject];
+        XCTAssertEqualObjects(event.eventType, @"TEST_MIGRATION");
+        XCTAssertEqual(event.eventTimestamp, eventTimestamp);
+        XCTAssertEqualObjects(event.allAttributes, @{@"Attr1" : @"Value1"});
+        XCTAssertEqualObjects(event.allMetrics, @{@"Metric1" : @(2.5)});
+        XCTAssertEqualObjects(event.session.sessionId, @"MIGRATED-SESSION");
+        XCTAssertEqualWithAccuracy([event.session.startTime timeIntervalSince1970], [startTime timeIntervalSince1970], 0.001);
+        XCTAssertNil(event.session.stopTime);
+        return nil;
+    }] waitUntilFinished];
+    XCTAssertGreaterThan(pinpoint.analyticsClient.eventRecorder.diskBytesUsed, 0);
+    
+    [[pinpoint.analyticsClient.eventRecorder removeAllEvents] waitUntilFinished];
+}
+
+- (void)testStoredBytesPerEvent {
+    AWSPinpointEventRecorder *eventRecorder = self.pinpointIAD.analyticsClient.eventRecorder;
+    [[eventRecorder removeAllEvents] waitUntilFinished];
+    
+    AWSPinpointEvent *event = [self.pinpointIAD.analyticsClient createEventWithEventType:@"TEST_EVENT"];
+    for (int i = 0; i < 10; i++) {
+        [event addAttribute:[NSString stringWithFormat:@"Value%d", i] forKey:[NSString stringWithFormat:@"Attribute%d", i]];
+        [event addMetric:@(i) forKey:[NSString stringWithFormat:@"Metric%d", i]];
+    }
+    
+    // The columns the same event occupied when it was stored with NSKeyedArchiver and ISO-8601 timestamps.
+    NSString *isoTimestamp = [AWSPinpointDateUtils isoDateTimeWithTimestamp:event.eventTimestamp];
+    NSUInteger archivedByteCount = [[NSKeyedArchiver archivedDataWithRootObject:event.allAttributes] length]
+    + [[NSKeyedArchiver archivedDataWithRootObject:event.allMetrics] length]
+    + 3 * [isoTimestamp lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    for (int i = 0; i < 1000; i++) {
+        @autoreleasepool {
+            [NSKeyedUnarchiver unarchiveObjectWithData:[NSKeyedArchiver archivedDataWithRootObject:event.allAttributes]];
+            [NSKeyedUnarchiver unarchiveObjectWithData:[NSKeyedArchiver archivedDataWithRootObject:event.allMetrics]];
+        }
+    }
+    CFAbsoluteTime archiverElapsed = CFAbsoluteTimeGetCurrent() - start;
+    
+    NSUInteger eventCount = 1000;
+    start = CFAbsoluteTimeGetCurrent();
+    AWSTask *task = [AWSTask taskWithResult:nil];
+    for (int i = 0; i < eventCount; i++) {
+        task = [task continueWithBlock:^id(AWSTask *task) {
+            return [eventRecorder saveEvent:event];
+        }];
+    }
+    [task waitUntilFinished];
+    CFAbsoluteTime saveElapsed = CFAbsoluteTimeGetCurrent() - start;
+    
+    start = CFAbsoluteTimeGetCurrent();
+    [[[eventRecorder getEventsWithLimit:@(eventCount)] continueWithBlock:^id(AWSTask *task) {
+        XCTAssertEqual([task.result count], eventCount);
+        XCTAssertEqualObjects([[task.result firstObject] allAttributes], event.allAttributes);
+        return nil;
+    }] waitUntilFinished];
+    CFAbsoluteTime readElapsed = CFAbsoluteTimeGetCurrent() - start;
+    
+    // Everything but the attributes, metrics and timestamps is stored the same way in both formats.
+    NSUInteger encodedByteCount = (NSUInteger)(eventRecorder.diskBytesUsed / eventCount) - 32
+    - [[[NSUUID UUID] UUIDString] length] - [@"TEST_EVENT" length] - [event.session.sessionId length];
+    NSLog(@"Attributes, metrics and timestamps: %lu bytes per event encoded, %lu bytes per event archived.",
+          (unsigned long)encodedByteCount, (unsigned long)archivedByteCount);
+    NSLog(@"Saved %lu events in %.3f seconds and read them back in %.3f seconds; archiving and unarchiving them took %.3f seconds.",
+          (unsigned long)eventCount, saveElapsed, readElapsed, archiverElapsed);
+    XCTAssertLessThan(encodedByteCount * 4, archivedByteCount);
+    
+    [[eventRecorder removeAllEvents] waitUntilFinished];
+}
+
 - (void)testDiskAgeLimit {
     [[self.pinpointIAD.analyticsClient.eventRecorder removeAllEvents] waitUntilFinished];
     [[self.pinpointIAD.analyticsClient.eventRecorder removeAllDirtyEvents] waitUntilFinished];
@@ -1178,9 +1608,13 @@ static AWSPinpointEvent * extracted() {
     
     self.pinpointIAD.analyticsClient.eventRecorder.diskAgeLimit = 1;
     
+    __block uint64_t singleEventSize = 0;
     AWSTask *task = [AWSTask taskWithResult:nil];
     for (int i = 0; i < 10; i++) {
         task = [task continueWithBlock:^id(AWSTask *task) {
+            if (i == 1) {
+                singleEventSize = self.pinpointIAD.analyticsClient.eventRecorder.diskBytesUsed - baseline;
+            }
             if (i == 9) {
                 sleep(1);
             }
@@ -1189,8 +1623,10 @@ static AWSPinpointEvent * extracted() {
     }
     
     [[[task continueWithBlock:^id(AWSTask *task) {
+        // Only the event saved after the sleep is left.
         uint64_t newSize = self.pinpointIAD.analyticsClient.eventRecorder.diskBytesUsed;
-        XCTAssertEqual(newSize, baseline);
+        XCTAssertGreaterThan(singleEventSize, 0);
+        XCTAssertEqual(newSize, baseline + singleEventSize);
         [self.pinpointIAD.analyticsClient.eventRecorder removeAllEvents];
         return nil;
     }] continueWithBlock:^id(AWSTask *task) {
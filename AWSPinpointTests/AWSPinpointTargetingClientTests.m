@@ -37,6 +37,37 @@ static NSString *userId;
 - (AWSPinpointTargetingUpdateEndpointRequest*) updateEndpointRequestForEndpoint:(AWSPinpointEndpointProfile *) endpoint;
 @end
 
+@interface AWSPinpoint()
+@property (nonatomic, strong) AWSPinpointContext *pinpointContext;
+@end
+
+// Stands in for the UpdateEndpoint endpoint: records every request and acknowledges it.
+@interface AWSPinpointTargetingClientTestsEndpointStub : NSObject
+
+@property (nonatomic, strong) NSMutableArray<AWSPinpointTargetingUpdateEndpointRequest *> *requests;
+
+- (AWSTask<AWSPinpointTargetingUpdateEndpointResponse *> *)updateEndpoint:(AWSPinpointTargetingUpdateEndpointRequest *)request;
+
+@end
+
+@implementation AWSPinpointTargetingClientTestsEndpointStub
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _requests = [NSMutableArray new];
+    }
+    return self;
+}
+
+- (AWSTask<AWSPinpointTargetingUpdateEndpointResponse *> *)updateEndpoint:(AWSPinpointTargetingUpdateEndpointRequest *)request {
+    @synchronized(self) {
+        [self.requests addObject:request];
+    }
+    return [AWSTask taskWithResult:[AWSPinpointTargetingUpdateEndpointResponse new]];
+}
+
+@end
+
 @interface AWSPinpointConfiguration()
 @property (nonnull, strong) NSUserDefaults *userDefaults;
 @end
@@ -369,6 +400,59 @@ static NSString *userId;
     XCTAssertNotNil(profile.demographic.platformVersion);
 }
 
+- (void)testUpdateEndpointProfileDelta {
+    [self initializePinpointWithConfiguration:[self getDefaultAWSPinpointConfiguration] forceCreate:YES];
+    AWSPinpointTargetingClient *targetingClient = self.pinpoint.targetingClient;
+    AWSPinpointTargetingClientTestsEndpointStub *endpoint = [AWSPinpointTargetingClientTestsEndpointStub new];
+    self.pinpoint.pinpointContext.targetingService = (AWSPinpointTargeting *)endpoint;
+    
+    [targetingClient addAttribute:@[@"Value1"] forKey:@"Attr1"];
+    [targetingClient addAttribute:@[@"Value2"] forKey:@"Attr2"];
+    [targetingClient addMetric:@1 forKey:@"Metric1"];
+    
+    // The first update sends the full profile.
+    [[targetingClient updateEndpointProfile] waitUntilFinished];
+    XCTAssertEqual([endpoint.requests count], 1);
+    XCTAssertEqual([endpoint.requests[0].endpointRequest.attributes count], 2);
+    XCTAssertEqual([endpoint.requests[0].endpointRequest.metrics count], 1);
+    XCTAssertNotNil(endpoint.requests[0].endpointRequest.demographic);
+    
+    // Only property list values are stored for the acknowledged update.
+    NSDictionary *acknowledgedUpdate = [self.userDefaults objectForKey:@"AWSPinpointEndpointAcknowledgedUpdateKey"];
+    XCTAssertTrue([NSPropertyListSerialization propertyList:acknowledgedUpdate isValidForFormat:NSPropertyListBinaryFormat_v1_0]);
+    XCTAssertEqual([acknowledgedUpdate[@"digest"] length], 64);
+    XCTAssertNotNil(acknowledgedUpdate[@"date"]);
+    
+    // An unchanged profile is not sent again.
+    AWSTask *task = [targetingClient updateEndpointProfile];
+    [task waitUntilFinished];
+    XCTAssertNil(task.error);
+    XCTAssertNil(task.result);
+    XCTAssertEqual([endpoint.requests count], 1);
+    XCTAssertEqual(targetingClient.skippedUpdateCount, 1);
+    
+    // Only the changed attribute is sent, along with the rest of the endpoint.
+    [targetingClient addAttribute:@[@"Value3"] forKey:@"Attr2"];
+    [[targetingClient updateEndpointProfile] waitUntilFinished];
+    XCTAssertEqual([endpoint.requests count], 2);
+    XCTAssertEqualObjects(endpoint.requests[1].endpointRequest.attributes, @{@"Attr2" : @[@"Value3"]});
+    XCTAssertNil(endpoint.requests[1].endpointRequest.metrics);
+    XCTAssertNotNil(endpoint.requests[1].endpointRequest.demographic);
+    XCTAssertNotNil(endpoint.requests[1].endpointRequest.effectiveDate);
+    XCTAssertEqual(targetingClient.reducedUpdateCount, 1);
+    
+    // Removing a key sends the full profile.
+    [targetingClient removeMetricForKey:@"Metric1"];
+    [[targetingClient updateEndpointProfile] waitUntilFinished];
+    XCTAssertEqual([endpoint.requests count], 3);
+    XCTAssertEqual([endpoint.requests[2].endpointRequest.attributes count], 2);
+    XCTAssertEqual([endpoint.requests[2].endpointRequest.metrics count], 0);
+    XCTAssertEqual(targetingClient.reducedUpdateCount, 1);
+    
+    [targetingClient removeAttributeForKey:@"Attr1"];
+    [targetingClient removeAttributeForKey:@"Attr2"];
+}
+
 - (void) testGlobalAttribute {
     [[NSUserDefaults standardUserDefaults] removeSuiteNamed:@"AWSPinpointTargetingClientTests"];
     AWSPinpointConfiguration *config = [[AWSPinpointConfiguration alloc] initWithAppId:@"testGlobalAttribute" launchOptions:nil];